@@ -48,23 +48,22 @@ endforeach()
 file(GLOB_RECURSE oneflow_all_src "${PROJECT_SOURCE_DIR}/oneflow/core/*.*" "${PROJECT_SOURCE_DIR}/oneflow/python/*.*"
  "${PROJECT_SOURCE_DIR}/oneflow/user/*.*" "${PROJECT_SOURCE_DIR}/oneflow/api/python/*.*"
  "${PROJECT_SOURCE_DIR}/oneflow/extension/python/*.*")
-if (WITH_XLA OR WITH_TENSORRT)
-  file(GLOB_RECURSE oneflow_xrt_src "${PROJECT_SOURCE_DIR}/oneflow/xrt/*.*")
-  if (NOT WITH_XLA)
-    file(GLOB_RECURSE xla_removing_src "${PROJECT_SOURCE_DIR}/oneflow/xrt/xla/*.*")
-  endif ()
-  if (NOT WITH_TENSORRT)
-    file(GLOB_RECURSE trt_removing_src "${PROJECT_SOURCE_DIR}/oneflow/xrt/tensorrt/*.*")
-  endif ()
-
-  list(APPEND xrt_removing_srcs ${xla_removing_src})
-  list(APPEND xrt_removing_srcs ${trt_removing_src})
-  # message(STATUS "removing_srcs: ${xrt_removing_srcs}")
-  foreach (removing_file ${xrt_removing_srcs})
-    list(REMOVE_ITEM oneflow_xrt_src ${removing_file})
-  endforeach ()
-  list(APPEND oneflow_all_src ${oneflow_xrt_src})
-endif()
+# xrt and its native engine are always built, the third party engines are optional
+file(GLOB_RECURSE oneflow_xrt_src "${PROJECT_SOURCE_DIR}/oneflow/xrt/*.*")
+if (NOT WITH_XLA)
+  file(GLOB_RECURSE xla_removing_src "${PROJECT_SOURCE_DIR}/oneflow/xrt/xla/*.*")
+endif ()
+if (NOT WITH_TENSORRT)
+  file(GLOB_RECURSE trt_removing_src "${PROJECT_SOURCE_DIR}/oneflow/xrt/tensorrt/*.*")
+endif ()
+
+list(APPEND xrt_removing_srcs ${xla_removing_src})
+list(APPEND xrt_removing_srcs ${trt_removing_src})
+# message(STATUS "removing_srcs: ${xrt_removing_srcs}")
+foreach (removing_file ${xrt_removing_srcs})
+  list(REMOVE_ITEM oneflow_xrt_src ${removing_file})
+endforeach ()
+list(APPEND oneflow_all_src ${oneflow_xrt_src})
 
 foreach(oneflow_single_file ${oneflow_all_src})
   # Verify whether this file is for other platforms
@@ -139,6 +138,8 @@ foreach(oneflow_single_file ${oneflow_all_src})
   if("${oneflow_single_file}" MATCHES "^${PROJECT_SOURCE_DIR}/oneflow/(core|user|xrt)/.*\\.cpp$")
     if("${oneflow_single_file}" MATCHES "^${PROJECT_SOURCE_DIR}/oneflow/core/transport/transport_test_main\\.cpp$")
       list(APPEND of_transport_test_cc ${oneflow_single_file})
+    elseif("${oneflow_single_file}" MATCHES "^${PROJECT_SOURCE_DIR}/oneflow/core/serving/oneflow_serving\\.cpp$")
+      list(APPEND of_serving_main_cc ${oneflow_single_file})
     elseif("${oneflow_single_file}" MATCHES "^${PROJECT_SOURCE_DIR}/oneflow/(core|user|xrt)/.*_test\\.cpp$")
       # test file
       list(APPEND of_all_test_cc ${oneflow_single_file})
@@ -329,6 +330,13 @@ foreach(cc ${of_transport_test_cc})
   set_target_properties(${transport_test_exe_name} PROPERTIES RUNTIME_OUTPUT_DIRECTORY "${PROJECT_BINARY_DIR}/bin")
 endforeach()
 
+# build serving
+foreach(cc ${of_serving_main_cc})
+  get_filename_component(serving_main_name ${cc} NAME_WE)
+  oneflow_add_executable(${serving_main_name} ${cc})
+  target_link_libraries(${serving_main_name} ${of_libs} ${oneflow_third_party_libs} ${oneflow_exe_third_party_libs})
+  set_target_properties(${serving_main_name} PROPERTIES RUNTIME_OUTPUT_DIRECTORY "${PROJECT_BINARY_DIR}/bin")
+endforeach()
 
 # build include
 set(ONEFLOW_INCLUDE_DIR "${PROJECT_BINARY_DIR}/python_scripts/oneflow/include")
@@ -0,0 +1,227 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/actor/act_event_tracer.h"
+#include "oneflow/core/persistence/persistent_in_stream.h"
+#include "oneflow/core/persistence/persistent_out_stream.h"
+#include "oneflow/core/common/str_util.h"
+#include <json.hpp>
+
+namespace oneflow {
+
+namespace {
+
+enum ActRecordState : int32_t { kEmpty = 0, kRecording = 1, kDone = 2 };
+
+std::atomic<int64_t> tracer_generation(0);
+
+double NanosecondsToMicroseconds(double ns) { return ns / 1000.0; }
+
+}  // namespace
+
+// Only the thread that owns the ring claims its slots, the stream callbacks then finish them
+class ActRecordRing final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ActRecordRing);
+  explicit ActRecordRing(int64_t capacity)
+      : capacity_(capacity), slots_(new ActRecordSlot[capacity]), next_(0), dropped_cnt_(0) {
+    FOR_RANGE(int64_t, i, 0, capacity_) { slots_[i].state.store(kEmpty); }
+  }
+  ~ActRecordRing() = default;
+
+  ActRecordSlot* Claim() {
+    ActRecordSlot* slot = &slots_[next_];
+    if (slot->state.load(std::memory_order_acquire) == kRecording) {
+      dropped_cnt_ += 1;
+      return nullptr;
+    }
+    next_ = (next_ + 1) % capacity_;
+    return slot;
+  }
+
+  void ForEachDoneRecord(const std::function<void(const ActRecord&)>& Handler) const {
+    FOR_RANGE(int64_t, i, 0, capacity_) {
+      if (slots_[i].state.load(std::memory_order_acquire) == kDone) { Handler(slots_[i].record); }
+    }
+  }
+
+  int64_t dropped_cnt() const { return dropped_cnt_; }
+
+ private:
+  const int64_t capacity_;
+  std::unique_ptr<ActRecordSlot[]> slots_;
+  int64_t next_;
+  int64_t dropped_cnt_;
+};
+
+ActEventTracer::ActEventTracer(int64_t sample_interval, int64_t ring_capacity)
+    : sample_interval_(sample_interval),
+      ring_capacity_(ring_capacity),
+      generation_(tracer_generation.fetch_add(1) + 1) {
+  CHECK_GT(sample_interval_, 0);
+  CHECK_GT(ring_capacity_, 0);
+}
+
+ActEventTracer::~ActEventTracer() = default;
+
+ActRecordRing* ActEventTracer::ThisThreadRing() {
+  // a thread may outlive a tracer, so its ring is looked up again for every new tracer
+  thread_local int64_t ring_generation = 0;
+  thread_local ActRecordRing* ring = nullptr;
+  if (ring_generation != generation_) {
+    std::unique_lock<std::mutex> lock(rings_mutex_);
+    rings_.emplace_back(new ActRecordRing(ring_capacity_));
+    ring = rings_.back().get();
+    ring_generation = generation_;
+  }
+  return ring;
+}
+
+ActRecordSlot* ActEventTracer::BeginRecord(int64_t actor_id, int64_t work_stream_id,
+                                           int64_t act_id, double last_dispatch_time) {
+  ActRecordSlot* slot = ThisThreadRing()->Claim();
+  if (slot == nullptr) { return nullptr; }
+  slot->state.store(kRecording, std::memory_order_relaxed);
+  ActRecord* record = &slot->record;
+  record->actor_id = actor_id;
+  record->work_stream_id = work_stream_id;
+  record->act_id = act_id;
+  record->ready_time = GetCurTime();
+  record->last_dispatch_time = last_dispatch_time < 0 ? record->ready_time : last_dispatch_time;
+  record->start_time = record->ready_time;
+  record->stop_time = record->ready_time;
+  return slot;
+}
+
+void ActEventTracer::StartRecord(ActRecordSlot* slot) { slot->record.start_time = GetCurTime(); }
+
+void ActEventTracer::StopRecord(ActRecordSlot* slot) {
+  slot->record.stop_time = GetCurTime();
+  slot->state.store(kDone, std::memory_order_release);
+}
+
+void ActEventTracer::DumpToLogDir() const {
+  PersistentOutStream out_stream(LocalFS(), JoinPath(FLAGS_log_dir, act_record_bin_filename()));
+  int64_t record_cnt = 0;
+  int64_t dropped_cnt = 0;
+  for (const auto& ring : rings_) {
+    ring->ForEachDoneRecord([&](const ActRecord& record) {
+      out_stream.Write(reinterpret_cast<const char*>(&record), sizeof(ActRecord));
+      record_cnt += 1;
+    });
+    dropped_cnt += ring->dropped_cnt();
+  }
+  LOG(INFO) << "act event tracer dumped " << record_cnt << " records of " << rings_.size()
+            << " threads, " << dropped_cnt << " sampled acts were dropped";
+}
+
+std::string ActEventTracer::act_record_bin_filename() { return "act_record.bin"; }
+
+std::string ActEventTracer::chrome_trace_filename() { return "act_trace.json"; }
+
+void ParseActRecords(const std::string& act_record_filepath, std::vector<ActRecord>* act_records) {
+  PersistentInStream in_stream(LocalFS(), act_record_filepath);
+  ActRecord record;
+  while (!in_stream.ReadFully(reinterpret_cast<char*>(&record), sizeof(ActRecord))) {
+    act_records->push_back(record);
+  }
+}
+
+void ExportActRecordsToChromeTrace(const Plan& plan, const std::vector<ActRecord>& act_records,
+                                   const std::string& json_filepath) {
+  HashMap<int64_t, const TaskProto*> task_id2task_proto;
+  for (const TaskProto& task : plan.task()) {
+    CHECK(task_id2task_proto.emplace(task.task_id(), &task).second);
+  }
+  const auto ActorName4TaskProto = [](const TaskProto& task) {
+    std::string name = TaskType_Name(task.task_type());
+    if (task.exec_sequence().exec_node_size() > 0) {
+      name += " " + task.exec_sequence().exec_node(0).kernel_conf().op_attribute().op_conf().name();
+    }
+    return name;
+  };
+  const auto StreamPid = [](int64_t machine_id) { return 2 * machine_id; };
+  const auto ActorPid = [](int64_t machine_id) { return 2 * machine_id + 1; };
+  nlohmann::json trace_events = nlohmann::json::array();
+  const auto AddMetadata = [&](const std::string& name, int64_t pid, int64_t tid,
+                               const std::string& value) {
+    trace_events.push_back({{"name", name},
+                            {"ph", "M"},
+                            {"pid", pid},
+                            {"tid", tid},
+                            {"args", {{"name", value}}}});
+  };
+  HashSet<int64_t> named_machines;
+  HashSet<int64_t> named_streams;
+  HashSet<int64_t> named_actors;
+  const auto Duration = [](double begin, double end) {
+    return NanosecondsToMicroseconds(end - begin);
+  };
+  for (const ActRecord& record : act_records) {
+    const auto task_it = task_id2task_proto.find(record.actor_id);
+    if (task_it == task_id2task_proto.end()) { continue; }
+    const TaskProto& task = *task_it->second;
+    const int64_t machine_id = task.machine_id();
+    const std::string actor_name = ActorName4TaskProto(task);
+    if (named_machines.insert(machine_id).second) {
+      AddMetadata("process_name", StreamPid(machine_id), 0,
+                  "machine " + std::to_string(machine_id) + " streams");
+      AddMetadata("process_name", ActorPid(machine_id), 0,
+                  "machine " + std::to_string(machine_id) + " actors");
+    }
+    if (named_streams.insert(record.work_stream_id).second) {
+      AddMetadata("thread_name", StreamPid(machine_id), record.work_stream_id,
+                  "stream " + std::to_string(record.work_stream_id));
+    }
+    if (named_actors.insert(record.actor_id).second) {
+      AddMetadata("thread_name", ActorPid(machine_id), record.actor_id, actor_name);
+    }
+    const nlohmann::json args = {
+        {"actor_id", record.actor_id},
+        {"act_id", record.act_id},
+        {"regst_wait_us", Duration(record.last_dispatch_time, record.ready_time)},
+        {"stream_wait_us", Duration(record.ready_time, record.start_time)},
+        {"run_us", Duration(record.start_time, record.stop_time)}};
+    trace_events.push_back({{"name", actor_name},
+                            {"cat", "act"},
+                            {"ph", "X"},
+                            {"pid", StreamPid(machine_id)},
+                            {"tid", record.work_stream_id},
+                            {"ts", NanosecondsToMicroseconds(record.start_time)},
+                            {"dur", Duration(record.start_time, record.stop_time)},
+                            {"args", args}});
+    trace_events.push_back(
+        {{"name", "regst wait"},
+         {"cat", "wait"},
+         {"ph", "X"},
+         {"pid", ActorPid(machine_id)},
+         {"tid", record.actor_id},
+         {"ts", NanosecondsToMicroseconds(record.last_dispatch_time)},
+         {"dur", Duration(record.last_dispatch_time, record.ready_time)}});
+    trace_events.push_back({{"name", "act"},
+                            {"cat", "act"},
+                            {"ph", "X"},
+                            {"pid", ActorPid(machine_id)},
+                            {"tid", record.actor_id},
+                            {"ts", NanosecondsToMicroseconds(record.ready_time)},
+                            {"dur", Duration(record.ready_time, record.stop_time)},
+                            {"args", args}});
+  }
+  const nlohmann::json trace = {{"traceEvents", trace_events}, {"displayTimeUnit", "ns"}};
+  PersistentOutStream out_stream(LocalFS(), json_filepath);
+  out_stream << trace.dump();
+}
+
+}  // namespace oneflow
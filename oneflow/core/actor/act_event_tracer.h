@@ -0,0 +1,88 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_ACTOR_ACT_EVENT_TRACER_H_
+#define ONEFLOW_CORE_ACTOR_ACT_EVENT_TRACER_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/job/plan.pb.h"
+
+namespace oneflow {
+
+// Fixed size binary record of one act, times are in nanoseconds as returned by GetCurTime
+struct ActRecord {
+  int64_t actor_id;
+  int64_t work_stream_id;
+  int64_t act_id;
+  // when the actor dispatched its previous act, the actor waited for regsts since then
+  double last_dispatch_time;
+  double ready_time;
+  double start_time;
+  double stop_time;
+};
+
+struct ActRecordSlot {
+  ActRecord record;
+  std::atomic<int32_t> state;
+};
+
+class ActRecordRing;
+
+// Records sampled acts of the runtime into a ring buffer per actor thread. Recording takes no lock
+// and allocates nothing, the start and stop times are filled by the stream callbacks of the act.
+// When a ring is full the oldest finished records are overwritten, so the rings always hold the
+// latest acts.
+class ActEventTracer final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ActEventTracer);
+  ~ActEventTracer();
+
+  bool IsSampled(int64_t act_id) const { return act_id % sample_interval_ == 0; }
+  // Returns nullptr if the next slot of the calling thread is still waiting for its stop time
+  ActRecordSlot* BeginRecord(int64_t actor_id, int64_t work_stream_id, int64_t act_id,
+                             double last_dispatch_time);
+  static void StartRecord(ActRecordSlot* slot);
+  static void StopRecord(ActRecordSlot* slot);
+
+  // Must only be called when no act is running
+  void DumpToLogDir() const;
+
+  static std::string act_record_bin_filename();
+  static std::string chrome_trace_filename();
+
+ private:
+  friend class Global<ActEventTracer>;
+  ActEventTracer(int64_t sample_interval, int64_t ring_capacity);
+
+  ActRecordRing* ThisThreadRing();
+
+  const int64_t sample_interval_;
+  const int64_t ring_capacity_;
+  const int64_t generation_;
+  std::mutex rings_mutex_;
+  std::vector<std::unique_ptr<ActRecordRing>> rings_;
+};
+
+void ParseActRecords(const std::string& act_record_filepath, std::vector<ActRecord>* act_records);
+
+// Writes the records in the chrome trace event format, which chrome://tracing and Perfetto open.
+// Each machine gets a process with a thread per work stream, on which the acts are drawn, and a
+// process with a thread per actor, on which the regst wait before each act is drawn as well.
+void ExportActRecordsToChromeTrace(const Plan& plan, const std::vector<ActRecord>& act_records,
+                                   const std::string& json_filepath);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_ACTOR_ACT_EVENT_TRACER_H_
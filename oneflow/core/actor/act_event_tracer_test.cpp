@@ -0,0 +1,146 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/actor/act_event_tracer.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/file_system.h"
+#include <fstream>
+#include <json.hpp>
+#include <unistd.h>
+
+namespace oneflow {
+
+namespace {
+
+std::string MakeTestDir(const std::string& name) {
+  const std::string dir = JoinPath("/tmp", name + "_" + std::to_string(getpid()));
+  LocalFS()->RecursivelyCreateDirIfNotExist(dir);
+  return dir;
+}
+
+void RecordAct(ActEventTracer* tracer, int64_t act_id) {
+  ActRecordSlot* slot = tracer->BeginRecord(1, 2, act_id, -1);
+  ASSERT_TRUE(slot != nullptr);
+  ActEventTracer::StartRecord(slot);
+  ActEventTracer::StopRecord(slot);
+}
+
+std::vector<int64_t> DumpedActIds(const std::string& log_dir) {
+  const std::string log_dir_before = FLAGS_log_dir;
+  FLAGS_log_dir = log_dir;
+  Global<ActEventTracer>::Get()->DumpToLogDir();
+  FLAGS_log_dir = log_dir_before;
+  std::vector<ActRecord> act_records;
+  ParseActRecords(JoinPath(log_dir, ActEventTracer::act_record_bin_filename()), &act_records);
+  std::vector<int64_t> act_ids;
+  for (const ActRecord& record : act_records) {
+    EXPECT_EQ(record.actor_id, 1);
+    EXPECT_EQ(record.work_stream_id, 2);
+    EXPECT_LE(record.ready_time, record.start_time);
+    EXPECT_LE(record.start_time, record.stop_time);
+    act_ids.push_back(record.act_id);
+  }
+  std::sort(act_ids.begin(), act_ids.end());
+  return act_ids;
+}
+
+}  // namespace
+
+TEST(ActEventTracer, ring_wraparound) {
+  const std::string dir = MakeTestDir("act_event_tracer_test_ring");
+  Global<ActEventTracer>::New(1, 4);
+  ActEventTracer* tracer = Global<ActEventTracer>::Get();
+  FOR_RANGE(int64_t, act_id, 0, 6) { RecordAct(tracer, act_id); }
+  // the ring holds the latest acts only
+  ASSERT_EQ(DumpedActIds(dir), std::vector<int64_t>({2, 3, 4, 5}));
+  // a slot waiting for its stop time is neither overwritten nor dumped
+  ActRecordSlot* pending = tracer->BeginRecord(1, 2, 6, -1);
+  ASSERT_TRUE(pending != nullptr);
+  FOR_RANGE(int64_t, act_id, 7, 10) { RecordAct(tracer, act_id); }
+  ASSERT_TRUE(tracer->BeginRecord(1, 2, 10, -1) == nullptr);
+  ASSERT_EQ(DumpedActIds(dir), std::vector<int64_t>({7, 8, 9}));
+  ActEventTracer::StopRecord(pending);
+  ASSERT_EQ(DumpedActIds(dir), std::vector<int64_t>({6, 7, 8, 9}));
+  Global<ActEventTracer>::Delete();
+  LocalFS()->RecursivelyDeleteDir(dir);
+}
+
+TEST(ActEventTracer, chrome_trace) {
+  const std::string dir = MakeTestDir("act_event_tracer_test_trace");
+  Plan plan;
+  TaskProto* task = plan.add_task();
+  task->set_task_type(TaskType::kNormalForward);
+  task->set_machine_id(1);
+  task->set_task_id(7);
+  KernelConf* kernel_conf = task->mutable_exec_sequence()->add_exec_node()->mutable_kernel_conf();
+  kernel_conf->mutable_op_attribute()->mutable_op_conf()->set_name("conv");
+  ActRecord record;
+  record.actor_id = 7;
+  record.work_stream_id = 3;
+  record.act_id = 5;
+  record.last_dispatch_time = 1000;
+  record.ready_time = 3000;
+  record.start_time = 4000;
+  record.stop_time = 10000;
+  ActRecord unknown_actor_record = record;
+  unknown_actor_record.actor_id = 8;
+  const std::string json_filepath = JoinPath(dir, ActEventTracer::chrome_trace_filename());
+  ExportActRecordsToChromeTrace(plan, {record, unknown_actor_record}, json_filepath);
+
+  std::ifstream in(json_filepath);
+  const nlohmann::json trace = nlohmann::json::parse(in);
+  const nlohmann::json& events = trace.at("traceEvents");
+  // the names of the two processes of the machine, of the stream and of the actor, then the act
+  // on the stream and the regst wait and the act on the actor, the unknown actor is skipped
+  ASSERT_EQ(events.size(), 7);
+  int64_t metadata_cnt = 0;
+  int64_t stream_act_cnt = 0;
+  for (const nlohmann::json& event : events) {
+    if (event.at("ph") == "M") {
+      metadata_cnt += 1;
+      continue;
+    }
+    ASSERT_EQ(event.at("ph"), "X");
+    if (event.at("pid") == 2) {
+      // the stream process of machine 1
+      stream_act_cnt += 1;
+      ASSERT_EQ(event.at("name"), "kNormalForward conv");
+      ASSERT_EQ(event.at("tid"), 3);
+      ASSERT_DOUBLE_EQ(event.at("ts").get<double>(), 4);
+      ASSERT_DOUBLE_EQ(event.at("dur").get<double>(), 6);
+      ASSERT_EQ(event.at("args").at("act_id"), 5);
+      ASSERT_DOUBLE_EQ(event.at("args").at("regst_wait_us").get<double>(), 2);
+      ASSERT_DOUBLE_EQ(event.at("args").at("stream_wait_us").get<double>(), 1);
+      ASSERT_DOUBLE_EQ(event.at("args").at("run_us").get<double>(), 6);
+    } else {
+      // the actor process of machine 1
+      ASSERT_EQ(event.at("pid"), 3);
+      ASSERT_EQ(event.at("tid"), 7);
+      if (event.at("name") == "regst wait") {
+        ASSERT_DOUBLE_EQ(event.at("ts").get<double>(), 1);
+        ASSERT_DOUBLE_EQ(event.at("dur").get<double>(), 2);
+      } else {
+        ASSERT_EQ(event.at("name"), "act");
+        ASSERT_DOUBLE_EQ(event.at("ts").get<double>(), 3);
+        ASSERT_DOUBLE_EQ(event.at("dur").get<double>(), 7);
+      }
+    }
+  }
+  ASSERT_EQ(metadata_cnt, 4);
+  ASSERT_EQ(stream_act_cnt, 1);
+  LocalFS()->RecursivelyDeleteDir(dir);
+}
+
+}  // namespace oneflow
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/actor/actor.h"
+#include "oneflow/core/actor/act_event_tracer.h"
 #include "oneflow/core/thread/thread_manager.h"
 #include "oneflow/core/job/runtime_job_descs.h"
 #include "oneflow/core/job/machine_context.h"
@@ -41,6 +42,7 @@ void Actor::Init(const JobDesc* job_desc, const TaskProto& task_proto,
   job_desc_ = job_desc;
   actor_id_ = task_proto.task_id();
   act_id_ = -1;
+  last_act_dispatch_time_ = -1;
   InitDeviceCtx(thread_ctx);
   if (task_proto.has_parallel_ctx()) {
     parallel_ctx_.reset(new ParallelContext(task_proto.parallel_ctx()));
@@ -380,8 +382,24 @@ int Actor::HandlerZombie(const ActorMsg& msg) {
   return 0;
 }
 
-void Actor::TryLogActEvent(const std::function<void()>& DoAct) const {
-  if (Global<RuntimeCtx>::Get()->is_experiment_phase() || NeedCollectActEvent()) {
+void Actor::TryLogActEvent(const std::function<void()>& DoAct) {
+  ActEventTracer* tracer = Global<ActEventTracer>::Get();
+  if (tracer != nullptr) {
+    ActRecordSlot* slot = nullptr;
+    if (NeedCollectActEvent() && tracer->IsSampled(act_id_)) {
+      slot = tracer->BeginRecord(actor_id(), GetGlobalWorkStreamId(), act_id_,
+                                 last_act_dispatch_time_);
+    }
+    if (slot == nullptr) {
+      DoAct();
+    } else {
+      device_ctx_->AddCallBack([slot]() { ActEventTracer::StartRecord(slot); });
+      DoAct();
+      device_ctx_->AddCallBack([slot]() { ActEventTracer::StopRecord(slot); });
+    }
+    // the regst wait of the next act is only measured if it is sampled
+    if (tracer->IsSampled(act_id_ + 1)) { last_act_dispatch_time_ = GetCurTime(); }
+  } else if (Global<RuntimeCtx>::Get()->is_experiment_phase() || NeedCollectActEvent()) {
     auto act_event = std::make_shared<ActEvent>();
     act_event->set_is_experiment_phase(Global<RuntimeCtx>::Get()->is_experiment_phase());
     act_event->set_actor_id(actor_id());
@@ -172,7 +172,7 @@ class Actor {
     return true;  // TODO(jiyuan): figure out the ActNumForEachOutput of the model regsts to MdSave
                   // area
   }
-  void TryLogActEvent(const std::function<void()>& Callback) const;
+  void TryLogActEvent(const std::function<void()>& Callback);
 
   // Ready
   bool IsReadReady() const;
@@ -221,6 +221,7 @@ class Actor {
   const JobDesc* job_desc_;
   int64_t actor_id_;
   int64_t act_id_;
+  double last_act_dispatch_time_;
   std::unique_ptr<ParallelContext> parallel_ctx_;
   std::vector<ExecKernel> exec_kernel_vec_;
   HashMap<std::string, std::vector<int64_t>> name2regst_desc_id_;
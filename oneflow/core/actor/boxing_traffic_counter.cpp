@@ -0,0 +1,57 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/actor/boxing_traffic_counter.h"
+#include "oneflow/core/job/machine_context.h"
+#include "oneflow/core/persistence/tee_persistent_log_stream.h"
+#include "oneflow/core/register/logical_blob_id.h"
+
+namespace oneflow {
+
+BoxingTrafficCount* BoxingTrafficCounter::NewCount(const std::string& kind,
+                                                   const std::string& op_name,
+                                                   const LogicalBlobId& lbi) {
+  std::unique_ptr<BoxingTrafficCount> count(new BoxingTrafficCount());
+  count->kind = kind;
+  count->op_name = op_name;
+  count->lbi = lbi;
+  count->act_cnt.store(0);
+  count->byte_size.store(0);
+  std::unique_lock<std::mutex> lock(counts_mutex_);
+  counts_.emplace_back(std::move(count));
+  return counts_.back().get();
+}
+
+void BoxingTrafficCounter::DumpToLogDir() const {
+  const int64_t machine_id = Global<MachineCtx>::Get()->this_machine_id();
+  auto log_stream = TeePersistentLogStream::Create("boxing/traffic/machine_"
+                                                    + std::to_string(machine_id) + ".csv");
+  log_stream << "kind,op_name,lbi,act_cnt,byte_size,byte_size_per_act\n";
+  for (const auto& count : counts_) {
+    const int64_t act_cnt = count->act_cnt.load();
+    const int64_t byte_size = count->byte_size.load();
+    std::string row;
+    row += count->kind + ",";
+    row += count->op_name + ",";
+    row += GenLogicalBlobName(count->lbi) + ",";
+    row += std::to_string(act_cnt) + ",";
+    row += std::to_string(byte_size) + ",";
+    row += std::to_string(act_cnt == 0 ? 0 : byte_size / act_cnt) + "\n";
+    log_stream << row;
+  }
+  log_stream->Flush();
+}
+
+}  // namespace oneflow
@@ -0,0 +1,62 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_ACTOR_BOXING_TRAFFIC_COUNTER_H_
+#define ONEFLOW_CORE_ACTOR_BOXING_TRAFFIC_COUNTER_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/register/logical_blob_id.pb.h"
+
+namespace oneflow {
+
+struct BoxingTrafficCount {
+  std::string kind;
+  std::string op_name;
+  LogicalBlobId lbi;
+  std::atomic<int64_t> act_cnt;
+  std::atomic<int64_t> byte_size;
+
+  void Add(int64_t act_byte_size) {
+    act_cnt.fetch_add(1, std::memory_order_relaxed);
+    byte_size.fetch_add(act_byte_size, std::memory_order_relaxed);
+  }
+};
+
+// Counts the bytes the boxing actors and kernels of this machine move, so the estimate of the
+// boxing log can be checked against a run. The slice boxing rows of a blob add up to the local,
+// intra-node and inter-node bytes of the log, the comm net rows to the inter-node bytes.
+class BoxingTrafficCounter final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(BoxingTrafficCounter);
+  ~BoxingTrafficCounter() = default;
+
+  // The count lives as long as the counter
+  BoxingTrafficCount* NewCount(const std::string& kind, const std::string& op_name,
+                               const LogicalBlobId& lbi);
+
+  // Must only be called when no act is running
+  void DumpToLogDir() const;
+
+ private:
+  friend class Global<BoxingTrafficCounter>;
+  BoxingTrafficCounter() = default;
+
+  std::mutex counts_mutex_;
+  std::vector<std::unique_ptr<BoxingTrafficCount>> counts_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_ACTOR_BOXING_TRAFFIC_COUNTER_H_
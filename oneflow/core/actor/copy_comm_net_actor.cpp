@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/actor/copy_comm_net_actor.h"
+#include "oneflow/core/actor/boxing_traffic_counter.h"
 #include "oneflow/core/comm_network/comm_network.h"
 #include "oneflow/core/job/machine_context.h"
 #include "oneflow/core/register/register.h"
@@ -43,6 +44,17 @@ void CopyCommNetActor::VirtualActorInit(const TaskProto& task_proto) {
   is_in_eord_ = false;
   next_piece_id_ = 0;
   in_regst_desc_id_ = Name2SoleRegstDescId("copy_in");
+  traffic_count_ = nullptr;
+  if (Global<BoxingTrafficCounter>::Get() != nullptr) {
+    const RegstDescProto& out_regst_desc = task_proto.produced_regst_desc().at("copy_out");
+    const std::string op_name =
+        task_proto.exec_sequence().exec_node_size() > 0
+            ? task_proto.exec_sequence().exec_node(0).kernel_conf().op_attribute().op_conf().name()
+            : "";
+    traffic_count_ = Global<BoxingTrafficCounter>::Get()->NewCount(
+        "copy_comm_net", op_name,
+        out_regst_desc.regst_desc_type().data_regst_desc().lbi2blob_desc(0).lbi());
+  }
   OF_SET_MSG_HANDLER(&CopyCommNetActor::HandlerNormal);
 }
 
@@ -97,6 +109,9 @@ void CopyCommNetActor::Act() {
     void* writeable_token = writeable_regst->comm_net_token();
     // Async
     Global<CommNet>::Get()->Read(actor_read_id_, src_machine_id, readable_token, writeable_token);
+    if (traffic_count_ != nullptr) {
+      traffic_count_->Add(writeable_regst->regst_desc()->MainByteSize4OneRegst());
+    }
   }
 }
 
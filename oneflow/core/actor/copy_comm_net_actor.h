@@ -20,6 +20,8 @@ limitations under the License.
 
 namespace oneflow {
 
+struct BoxingTrafficCount;
+
 class CopyCommNetActor final : public Actor {
  public:
   OF_DISALLOW_COPY_AND_MOVE(CopyCommNetActor);
@@ -60,6 +62,7 @@ class CopyCommNetActor final : public Actor {
   CommNetDeviceCtx* comm_net_device_ctx_;
   int64_t next_piece_id_;
   int64_t in_regst_desc_id_;
+  BoxingTrafficCount* traffic_count_;
 };
 
 }  // namespace oneflow
@@ -59,4 +59,32 @@ TEST(Channel, 30sender40receiver) {
   }
 }
 
+TEST(Channel, 30sender1spinning_receiver) {
+  Channel<int> channel;
+  std::vector<std::thread> senders;
+  int sender_num = 30;
+  int range_num = 200;
+  std::vector<int> visit(range_num, 0);
+  int64_t spun_to_item_cnt = 0;
+  std::thread receiver([&]() {
+    std::queue<int> items;
+    bool spun_to_item = false;
+    while (channel.SpinThenReceiveMany(&items, 10000, &spun_to_item) == kChannelStatusSuccess) {
+      if (spun_to_item) { ++spun_to_item_cnt; }
+      while (!items.empty()) {
+        ++visit.at(items.front());
+        items.pop();
+      }
+    }
+  });
+  for (int i = 0; i < sender_num; ++i) {
+    senders.push_back(std::thread(CallFromSenderThread, &channel, Range(0, range_num)));
+  }
+  for (std::thread& this_thread : senders) { this_thread.join(); }
+  channel.Close();
+  receiver.join();
+  for (int i = 0; i < range_num; ++i) { ASSERT_EQ(visit.at(i), sender_num); }
+  LOG(INFO) << spun_to_item_cnt << " receives got their items while spinning";
+}
+
 }  // namespace oneflow
@@ -0,0 +1,67 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_CPU_ISA_H_
+#define ONEFLOW_CORE_COMMON_CPU_ISA_H_
+
+#include "oneflow/core/common/platform.h"
+
+// The project is built without -mavx*, so SIMD code paths are compiled per function with target
+// attributes and selected at runtime. OF_CPU_ISA_DISPATCH is defined when that is possible.
+#if defined(OF_PLATFORM_IS_X86) && defined(__GNUC__)
+#define OF_CPU_ISA_DISPATCH
+#define OF_CPU_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define OF_CPU_TARGET_AVX512 __attribute__((target("avx512f")))
+#include <immintrin.h>
+#if defined(__clang__) || __GNUC__ >= 8
+#define OF_CPU_ISA_VNNI_DISPATCH
+#define OF_CPU_TARGET_AVX512_VNNI __attribute__((target("avx512f,avx512bw,avx512vnni")))
+#endif
+#endif
+
+namespace oneflow {
+
+inline bool CpuSupportsAvx2() {
+#ifdef OF_CPU_ISA_DISPATCH
+  static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  return supported;
+#else
+  return false;
+#endif
+}
+
+inline bool CpuSupportsAvx512() {
+#ifdef OF_CPU_ISA_DISPATCH
+  static const bool supported = __builtin_cpu_supports("avx512f");
+  return supported;
+#else
+  return false;
+#endif
+}
+
+inline bool CpuSupportsAvx512Vnni() {
+#ifdef OF_CPU_ISA_VNNI_DISPATCH
+  static const bool supported = __builtin_cpu_supports("avx512f")
+                                && __builtin_cpu_supports("avx512bw")
+                                && __builtin_cpu_supports("avx512vnni");
+  return supported;
+#else
+  return false;
+#endif
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_CPU_ISA_H_
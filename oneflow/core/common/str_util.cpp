@@ -139,6 +139,15 @@ bool TryGetPrefixAndIndex(const std::string& prefix_and_idx, std::string* prefix
   return *index >= 0;
 }
 
+uint64_t StableHash(const std::string& str, uint64_t seed) {
+  uint64_t hash_val = seed;
+  for (const char c : str) {
+    hash_val ^= static_cast<uint8_t>(c);
+    hash_val *= 1099511628211ULL;
+  }
+  return hash_val;
+}
+
 namespace internal {
 
 std::string JoinPathImpl(std::initializer_list<std::string> paths) {
@@ -57,6 +57,9 @@ void GetPrefixAndIndex(const std::string& prefix_and_idx, std::string* prefix, i
 
 bool TryGetPrefixAndIndex(const std::string& prefix_and_idx, std::string* prefix, int32_t* index);
 
+// FNV-1a, which unlike std::hash gives the same value in every process
+uint64_t StableHash(const std::string& str, uint64_t seed = 14695981039346656037ULL);
+
 namespace internal {
 
 std::string JoinPathImpl(std::initializer_list<std::string> paths);
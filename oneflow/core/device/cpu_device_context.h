@@ -17,7 +17,7 @@ limitations under the License.
 #define ONEFLOW_CORE_DEVICE_CPU_DEVICE_CONTEXT_H_
 
 #include "oneflow/core/kernel/kernel_context.h"
-#include "oneflow/core/vm/cpu_allocator.h"
+#include "oneflow/core/vm/cpu_caching_allocator.h"
 
 namespace oneflow {
 
@@ -32,7 +32,7 @@ class CpuDeviceCtx final : public DeviceCtx {
   void SyncDevice() override {}
   void AddCallBack(std::function<void()> callback) const override { callback(); }
 
-  vm::Allocator* mut_allocator() override { return Global<vm::CpuAllocator>::Get(); }
+  vm::Allocator* mut_allocator() override { return Global<vm::CpuCachingAllocator>::Get(); }
 
  private:
 };  // namespace oneflow
@@ -15,7 +15,12 @@ limitations under the License.
 */
 #include "oneflow/core/device/memory_copier.h"
 #include "oneflow/core/common/auto_registration_factory.h"
-#include "oneflow/core/common/nd_index_offset_helper.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/common/blocking_counter.h"
+#include "oneflow/core/thread/thread_pool.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace oneflow {
 
@@ -75,28 +80,130 @@ MemoryCopyNdDesc GetDescInBytes(const MemoryCopyNdDesc& desc) {
   return desc_in_bytes;
 }
 
+// Host copies smaller than this are always done by the calling thread, larger ones are split into
+// tasks of at least kMinHostCopyBytesPerTask for the thread pool
+constexpr int64_t kMinHostCopyBytesToSplit = 1024 * 1024;
+constexpr int64_t kMinHostCopyBytesPerTask = 256 * 1024;
+// Host copies larger than this are unlikely to be read back from cache soon, so rows that are long
+// enough are written with non-temporal stores to avoid evicting the working set of other actors
+constexpr int64_t kNonTemporalCopyThreshold = 8 * 1024 * 1024;
+constexpr int64_t kMinNonTemporalCopyRowBytes = 256;
+
+bool IsNonTemporalCopy(int64_t total_bytes, int64_t row_bytes) {
+#if defined(__SSE2__)
+  return total_bytes >= kNonTemporalCopyThreshold && row_bytes >= kMinNonTemporalCopyRowBytes;
+#else
+  return false;
+#endif
+}
+
+void NonTemporalCopyFence() {
+#if defined(__SSE2__)
+  _mm_sfence();
+#endif
+}
+
+void CopyContiguous(unsigned char* dst, const unsigned char* src, size_t count,
+                    bool non_temporal) {
+#if defined(__SSE2__)
+  constexpr size_t kVecSize = sizeof(__m128i);
+  const size_t head = (kVecSize - reinterpret_cast<uintptr_t>(dst) % kVecSize) % kVecSize;
+  if (non_temporal && count >= head + 4 * kVecSize) {
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    count -= head;
+    for (; count >= 4 * kVecSize; count -= 4 * kVecSize) {
+      const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+      const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + kVecSize));
+      const __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * kVecSize));
+      const __m128i v3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * kVecSize));
+      _mm_stream_si128(reinterpret_cast<__m128i*>(dst), v0);
+      _mm_stream_si128(reinterpret_cast<__m128i*>(dst + kVecSize), v1);
+      _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 2 * kVecSize), v2);
+      _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 3 * kVecSize), v3);
+      dst += 4 * kVecSize;
+      src += 4 * kVecSize;
+    }
+  }
+#endif
+  memcpy(dst, src, count);
+}
+
+int64_t NumCopyTasks(int64_t total_bytes, int64_t num_units) {
+  ThreadPool* thread_pool = Global<ThreadPool>::Get();
+  if (thread_pool == nullptr || total_bytes < kMinHostCopyBytesToSplit) { return 1; }
+  // e.g. a copy inside MultiThreadLoop, whose worker would wait for tasks queued behind itself
+  if (ThreadPool::IsCurrentThreadWorker()) { return 1; }
+  const int64_t max_num_tasks = std::max<int64_t>(total_bytes / kMinHostCopyBytesPerTask, 1);
+  return std::min<int64_t>({max_num_tasks, num_units, thread_pool->thread_num()});
+}
+
+// Runs the first task on the calling thread and the others on the global thread pool
+void ForEachCopyTask(int64_t num_tasks, const std::function<void(int64_t)>& Task) {
+  if (num_tasks <= 1) {
+    Task(0);
+    return;
+  }
+  BlockingCounter bc(num_tasks - 1);
+  FOR_RANGE(int64_t, i, 1, num_tasks) {
+    Global<ThreadPool>::Get()->AddWork([&Task, &bc, i]() {
+      Task(i);
+      bc.Decrease();
+    });
+  }
+  Task(0);
+  bc.WaitUntilCntEqualZero();
+}
+
 }  // namespace
 
 template<int32_t NDIMS>
 void CopyNDCpuImpl(DeviceCtx* ctx, void* dst, const void* src, const MemoryCopyNdDesc& desc) {
-  NdIndexOffsetHelper<int64_t, NDIMS> src_helper(desc.src_shape.dim_vec().data());
-  NdIndexOffsetHelper<int64_t, NDIMS> dst_helper(desc.dst_shape.dim_vec().data());
-  NdIndexOffsetHelper<int64_t, NDIMS> copy_helper(desc.extent.dim_vec().data());
-  FOR_RANGE(int64_t, i, 0, desc.extent.elem_cnt()) {
-    int64_t copy_idx[NDIMS];
-    int64_t src_idx[NDIMS];
-    int64_t dst_idx[NDIMS];
-    copy_helper.OffsetToNdIndex(i, copy_idx);
-    FOR_RANGE(int64_t, j, 0, NDIMS) {
-      src_idx[j] = desc.src_pos.At(j) + copy_idx[j];
-      dst_idx[j] = desc.dst_pos.At(j) + copy_idx[j];
-    }
-    const int64_t src_offset = src_helper.NdIndexToOffset(src_idx);
-    const int64_t dst_offset = dst_helper.NdIndexToOffset(dst_idx);
-    unsigned char* dst_ptr = reinterpret_cast<unsigned char*>(dst) + dst_offset;
-    const unsigned char* src_ptr = reinterpret_cast<const unsigned char*>(src) + src_offset;
-    *dst_ptr = *src_ptr;
+  const int64_t row_size = desc.extent.At(NDIMS - 1);
+  const int64_t num_rows = desc.extent.elem_cnt() / row_size;
+  int64_t src_strides[NDIMS];
+  int64_t dst_strides[NDIMS];
+  int64_t src_base = 0;
+  int64_t dst_base = 0;
+  FOR_RANGE(int32_t, i, 0, NDIMS) {
+    src_strides[i] = desc.src_shape.Count(i + 1);
+    dst_strides[i] = desc.dst_shape.Count(i + 1);
+    src_base += desc.src_pos.At(i) * src_strides[i];
+    dst_base += desc.dst_pos.At(i) * dst_strides[i];
   }
+  const bool non_temporal = IsNonTemporalCopy(desc.extent.elem_cnt(), row_size);
+  const int64_t num_tasks = NumCopyTasks(desc.extent.elem_cnt(), num_rows);
+  ForEachCopyTask(num_tasks, [&](int64_t task) {
+    const Range range = BalancedSplitter(num_rows, num_tasks).At(task);
+    if (range.size() == 0) { return; }
+    // the outer index of the first row is decomposed once, later rows step it like an odometer
+    int64_t idx[NDIMS];
+    int64_t src_offset = src_base;
+    int64_t dst_offset = dst_base;
+    int64_t remaining = range.begin();
+    for (int32_t i = NDIMS - 2; i >= 0; --i) {
+      idx[i] = remaining % desc.extent.At(i);
+      remaining /= desc.extent.At(i);
+      src_offset += idx[i] * src_strides[i];
+      dst_offset += idx[i] * dst_strides[i];
+    }
+    FOR_RANGE(int64_t, row, range.begin(), range.end()) {
+      CopyContiguous(reinterpret_cast<unsigned char*>(dst) + dst_offset,
+                     reinterpret_cast<const unsigned char*>(src) + src_offset, row_size,
+                     non_temporal);
+      for (int32_t i = NDIMS - 2; i >= 0; --i) {
+        idx[i] += 1;
+        src_offset += src_strides[i];
+        dst_offset += dst_strides[i];
+        if (idx[i] < desc.extent.At(i)) { break; }
+        idx[i] = 0;
+        src_offset -= desc.extent.At(i) * src_strides[i];
+        dst_offset -= desc.extent.At(i) * dst_strides[i];
+      }
+    }
+    if (non_temporal) { NonTemporalCopyFence(); }
+  });
 }
 
 MemoryCopyNdDesc MemoryCopyNdDesc::CreateDimReducedDesc() const {
@@ -194,14 +301,39 @@ void MemoryCopier::CopyND(DeviceCtx* ctx, void* dst, const void* src,
   UNIMPLEMENTED();
 }
 
+void HostMemoryCopier::Copy(DeviceCtx* ctx, void* dst, const void* src,
+                            const MemoryCopyNdDesc& desc) const {
+  CheckMemoryCopyNdDesc(desc);
+  // merging whole axes into their outer axis makes the innermost contiguous extent as long as
+  // possible, and every copy with more than one axis goes through the row based nd copy
+  const MemoryCopyNdDesc reduced = desc.CreateDimReducedDesc();
+  if (MemoryCopyNdDescGetNumAxes(reduced) == 1) {
+    Copy1D(ctx, (unsigned char*)dst + reduced.dst_pos.At(0),
+           (const unsigned char*)src + reduced.src_pos.At(0), reduced.extent.At(0));
+  } else {
+    CopyND(ctx, dst, src, reduced);
+  }
+}
+
 void HostMemoryCopier::Copy1D(DeviceCtx* ctx, void* dst, const void* src, size_t count) const {
-  memcpy(dst, src, count);
+  const int64_t num_tasks = NumCopyTasks(count, count);
+  const bool non_temporal = IsNonTemporalCopy(count, count);
+  ForEachCopyTask(num_tasks, [&](int64_t task) {
+    const Range range = BalancedSplitter(count, num_tasks).At(task);
+    CopyContiguous((unsigned char*)dst + range.begin(), (const unsigned char*)src + range.begin(),
+                   range.size(), non_temporal);
+    if (non_temporal) { NonTemporalCopyFence(); }
+  });
 }
 
 void HostMemoryCopier::CopyND(DeviceCtx* ctx, void* dst, const void* src,
                               const MemoryCopyNdDesc& desc) const {
   const int32_t num_axes = desc.src_shape.NumAxes();
-  if (num_axes == 4) {
+  if (num_axes == 2) {
+    CopyNDCpuImpl<2>(ctx, dst, src, desc);
+  } else if (num_axes == 3) {
+    CopyNDCpuImpl<3>(ctx, dst, src, desc);
+  } else if (num_axes == 4) {
     CopyNDCpuImpl<4>(ctx, dst, src, desc);
   } else if (num_axes == 5) {
     CopyNDCpuImpl<5>(ctx, dst, src, desc);
@@ -323,6 +455,8 @@ SPECIALIZE_COPY_ELEM(int8_t)
 #define SPECIALIZE_COPY_ND_CPU_IMPL(NDIMS)                                        \
   template void CopyNDCpuImpl<NDIMS>(DeviceCtx * ctx, void* dst, const void* src, \
                                      const MemoryCopyNdDesc& desc);
+SPECIALIZE_COPY_ND_CPU_IMPL(2)
+SPECIALIZE_COPY_ND_CPU_IMPL(3)
 SPECIALIZE_COPY_ND_CPU_IMPL(4)
 SPECIALIZE_COPY_ND_CPU_IMPL(5)
 SPECIALIZE_COPY_ND_CPU_IMPL(6)
@@ -68,6 +68,8 @@ class HostMemoryCopier final : public MemoryCopier {
   ~HostMemoryCopier() override = default;
 
  private:
+  void Copy(DeviceCtx* ctx, void* dst, const void* src,
+            const MemoryCopyNdDesc& desc) const override;
   void Copy1D(DeviceCtx* ctx, void* dst, const void* src, size_t count) const override;
   void CopyND(DeviceCtx* ctx, void* dst, const void* src,
               const MemoryCopyNdDesc& desc) const override;
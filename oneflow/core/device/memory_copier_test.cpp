@@ -0,0 +1,148 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <chrono>
+#include "oneflow/core/device/memory_copier.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/core/common/blocking_counter.h"
+
+namespace oneflow {
+
+namespace {
+
+MemoryCopyNdDesc MakeSliceDesc(const DimVector& dst_shape, const DimVector& dst_pos,
+                               const DimVector& src_shape, const DimVector& src_pos,
+                               const DimVector& extent) {
+  MemoryCopyNdDesc desc;
+  desc.dst_shape = Shape(dst_shape);
+  desc.dst_pos = NdIndex(dst_pos);
+  desc.src_shape = Shape(src_shape);
+  desc.src_pos = NdIndex(src_pos);
+  desc.extent = Shape(extent);
+  return desc;
+}
+
+void ReferenceCopy(std::vector<int32_t>* dst, const std::vector<int32_t>& src,
+                   const MemoryCopyNdDesc& desc) {
+  const int64_t num_axes = desc.extent.NumAxes();
+  FOR_RANGE(int64_t, i, 0, desc.extent.elem_cnt()) {
+    int64_t remaining = i;
+    int64_t src_offset = 0;
+    int64_t dst_offset = 0;
+    int64_t src_stride = 1;
+    int64_t dst_stride = 1;
+    for (int64_t axis = num_axes - 1; axis >= 0; --axis) {
+      const int64_t idx = remaining % desc.extent.At(axis);
+      remaining /= desc.extent.At(axis);
+      src_offset += (desc.src_pos.At(axis) + idx) * src_stride;
+      dst_offset += (desc.dst_pos.At(axis) + idx) * dst_stride;
+      src_stride *= desc.src_shape.At(axis);
+      dst_stride *= desc.dst_shape.At(axis);
+    }
+    dst->at(dst_offset) = src.at(src_offset);
+  }
+}
+
+void TestHostCopy(const MemoryCopyNdDesc& desc) {
+  std::vector<int32_t> src(desc.src_shape.elem_cnt());
+  FOR_RANGE(size_t, i, 0, src.size()) { src.at(i) = i; }
+  std::vector<int32_t> dst(desc.dst_shape.elem_cnt(), -1);
+  std::vector<int32_t> expected(dst);
+  std::unique_ptr<MemoryCopier> copier(NewDefaultMemoryCopier(DeviceType::kCPU));
+  copier->CopyElem<int32_t>(nullptr, dst.data(), src.data(), desc);
+  ReferenceCopy(&expected, src, desc);
+  ASSERT_TRUE(dst == expected);
+}
+
+void TestHostCopyOfAllRanks() {
+  TestHostCopy(MakeSliceDesc({37}, {5}, {64}, {20}, {30}));
+  TestHostCopy(MakeSliceDesc({8, 33}, {0, 3}, {8, 64}, {0, 11}, {8, 30}));
+  TestHostCopy(MakeSliceDesc({6, 7, 9}, {1, 0, 2}, {5, 7, 9}, {0, 0, 1}, {4, 7, 6}));
+  TestHostCopy(MakeSliceDesc({4, 6, 5, 7}, {1, 2, 0, 0}, {3, 8, 5, 7}, {0, 1, 0, 0}, {3, 4, 5, 7}));
+  TestHostCopy(
+      MakeSliceDesc({2, 3, 4, 5, 6}, {0, 1, 0, 2, 1}, {2, 4, 4, 6, 6}, {0, 0, 0, 1, 0},
+                    {2, 2, 4, 3, 5}));
+  TestHostCopy(MakeSliceDesc({2, 3, 2, 3, 4, 5}, {1, 0, 1, 0, 1, 0}, {3, 3, 2, 4, 4, 5},
+                             {0, 0, 0, 1, 0, 0}, {1, 3, 1, 3, 3, 5}));
+  // large enough to be split across threads and written with non-temporal stores
+  TestHostCopy(MakeSliceDesc({4, 512, 2048}, {0, 0, 0}, {4, 1024, 2048}, {0, 256, 0},
+                             {4, 512, 2048}));
+  TestHostCopy(MakeSliceDesc({2, 64, 56, 56}, {0, 0, 0, 0}, {2, 256, 56, 56}, {0, 64, 0, 0},
+                             {2, 64, 56, 56}));
+}
+
+}  // namespace
+
+TEST(HostMemoryCopier, copy_nd) { TestHostCopyOfAllRanks(); }
+
+TEST(HostMemoryCopier, copy_nd_multi_thread) {
+  Global<ThreadPool>::New(4);
+  TestHostCopyOfAllRanks();
+  Global<ThreadPool>::Delete();
+}
+
+TEST(HostMemoryCopier, copy_nd_in_thread_pool) {
+  Global<ThreadPool>::New(2);
+  // every worker copies at once, a copy fanned out to the pool again would never finish
+  BlockingCounter bc(Global<ThreadPool>::Get()->thread_num());
+  FOR_RANGE(int32_t, i, 0, Global<ThreadPool>::Get()->thread_num()) {
+    Global<ThreadPool>::Get()->AddWork([&bc]() {
+      TestHostCopyOfAllRanks();
+      bc.Decrease();
+    });
+  }
+  bc.WaitUntilCntEqualZero();
+  Global<ThreadPool>::Delete();
+}
+
+// Throughput of typical boxing slices, run with --gtest_also_run_disabled_tests
+TEST(HostMemoryCopier, DISABLED_copy_nd_benchmark) {
+  Global<ThreadPool>::New(std::thread::hardware_concurrency());
+  std::unique_ptr<MemoryCopier> copier(NewDefaultMemoryCopier(DeviceType::kCPU));
+  const std::vector<std::pair<std::string, MemoryCopyNdDesc>> cases = {
+      {"S(0)->S(1) of (1024, 4096) into 4 parts",
+       MakeSliceDesc({256, 1024}, {0, 0}, {1024, 4096}, {0, 1024}, {256, 1024})},
+      {"S(1) slice of (64, 256, 56, 56) into 8 parts",
+       MakeSliceDesc({64, 32, 56, 56}, {0, 0, 0, 0}, {64, 256, 56, 56}, {0, 96, 0, 0},
+                     {64, 32, 56, 56})},
+      {"S(3) slice of (32, 128, 28, 28) into 4 parts",
+       MakeSliceDesc({32, 128, 28, 7}, {0, 0, 0, 0}, {32, 128, 28, 28}, {0, 0, 0, 14},
+                     {32, 128, 28, 7})},
+      {"S(2) slice of (8, 16, 64, 32, 32) into 4 parts",
+       MakeSliceDesc({8, 16, 16, 32, 32}, {0, 0, 0, 0, 0}, {8, 16, 64, 32, 32},
+                     {0, 0, 32, 0, 0}, {8, 16, 16, 32, 32})},
+      {"S(1)->S(4) of (4, 8, 16, 32, 64, 8)",
+       MakeSliceDesc({4, 2, 16, 32, 16, 8}, {0, 0, 0, 0, 0, 0}, {4, 8, 16, 32, 64, 8},
+                     {0, 2, 0, 0, 16, 0}, {4, 2, 16, 32, 16, 8})},
+  };
+  const int32_t kIters = 20;
+  for (const auto& pair : cases) {
+    const MemoryCopyNdDesc& desc = pair.second;
+    std::vector<float> src(desc.src_shape.elem_cnt(), 1.f);
+    std::vector<float> dst(desc.dst_shape.elem_cnt());
+    copier->CopyElem<float>(nullptr, dst.data(), src.data(), desc);
+    const auto start = std::chrono::steady_clock::now();
+    FOR_RANGE(int32_t, i, 0, kIters) {
+      copier->CopyElem<float>(nullptr, dst.data(), src.data(), desc);
+    }
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double bytes = static_cast<double>(desc.extent.elem_cnt()) * sizeof(float) * kIters;
+    LOG(INFO) << pair.first << ": " << bytes / seconds / 1e9 << " GB/s";
+  }
+  Global<ThreadPool>::Delete();
+}
+
+}  // namespace oneflow
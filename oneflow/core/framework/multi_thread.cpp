@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/framework/multi_thread.h"
+#include "oneflow/core/common/balanced_splitter.h"
 #include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
@@ -24,6 +25,28 @@ void MultiThreadLoopInOpKernel(size_t num, std::function<void(size_t i)> Callbac
   MultiThreadLoop(num, Callback);
 }
 
+void ParallelForEachTask(int64_t num_tasks, int64_t work_per_task,
+                         const std::function<void(int64_t i)>& Task) {
+  if (num_tasks > 1 && num_tasks * work_per_task >= kParallelWorkThreshold) {
+    MultiThreadLoop(num_tasks, [&](size_t i) { Task(i); });
+  } else {
+    FOR_RANGE(int64_t, i, 0, num_tasks) { Task(i); }
+  }
+}
+
+void ParallelForEachRange(int64_t num_units, int64_t work_per_unit,
+                          const std::function<void(int64_t begin, int64_t end)>& Fn) {
+  ThreadPool* thread_pool = Global<ThreadPool>::Get();
+  const int64_t num_tasks =
+      thread_pool == nullptr ? 1 : std::min<int64_t>(num_units, thread_pool->thread_num());
+  if (num_tasks <= 1 || num_units * work_per_unit < kParallelWorkThreshold) {
+    if (num_units > 0) { Fn(0, num_units); }
+    return;
+  }
+  const BalancedSplitter bs(num_units, num_tasks);
+  MultiThreadLoop(num_tasks, [&](size_t i) { Fn(bs.At(i).begin(), bs.At(i).end()); });
+}
+
 }  // namespace user_op
 
 }  // namespace oneflow
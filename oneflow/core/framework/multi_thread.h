@@ -24,6 +24,19 @@ namespace user_op {
 
 void MultiThreadLoopInOpKernel(size_t num, std::function<void(size_t i)> Callback);
 
+// Work below this, counted in elements touched, is not worth dispatching to the thread pool
+constexpr int64_t kParallelWorkThreshold = 1 << 15;
+
+// Runs Task(i) for every i in [0, num_tasks), on the thread pool only if the total work reaches
+// kParallelWorkThreshold
+void ParallelForEachTask(int64_t num_tasks, int64_t work_per_task,
+                         const std::function<void(int64_t i)>& Task);
+
+// Same as ParallelForEachTask, but hands each thread of the pool one balanced range of the units
+// instead of dispatching every unit on its own
+void ParallelForEachRange(int64_t num_units, int64_t work_per_unit,
+                          const std::function<void(int64_t begin, int64_t end)>& Fn);
+
 }  // namespace user_op
 
 }  // namespace oneflow
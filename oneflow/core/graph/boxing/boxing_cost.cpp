@@ -0,0 +1,166 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/graph/boxing/boxing_cost.h"
+#include "oneflow/core/graph/boxing/sub_task_graph_builder_util.h"
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+namespace {
+
+const double kGpuMemoryBytesPerSecond = 5e11;
+const double kCpuMemoryBytesPerSecond = 2e10;
+const double kIntraMachineBoxingBytesPerSecond = 1e10;
+const double kInterMachineBoxingBytesPerSecond = 1.25e9;
+
+struct DeviceTraffic {
+  double local_byte_size = 0;
+  double intra_node_byte_size = 0;
+  double inter_node_byte_size = 0;
+};
+
+double ElemCnt4SliceView(const TensorSliceView& view) {
+  return view.IsEmpty() ? 0 : static_cast<double>(view.shape().elem_cnt());
+}
+
+// The part of the blob each device sends in a ring collective, 0 if the builder is none of them
+double RingCollectiveBlobRatio(const std::string& builder_name, int64_t parallel_num) {
+  const double n = static_cast<double>(parallel_num);
+  if (builder_name == "NcclCollectiveBoxingAllReduceSubTskGphBuilder") {
+    return 2 * (n - 1) / n;
+  } else if (builder_name == "NcclCollectiveBoxingReduceScatterSubTskGphBuilder"
+             || builder_name == "NcclCollectiveBoxingAllGatherSubTskGphBuilder") {
+    return (n - 1) / n;
+  } else {
+    return 0;
+  }
+}
+
+BoxingCost EstimateRingCollectiveCost(const ParallelDesc& parallel_desc,
+                                      double per_device_byte_size, double logical_byte_size) {
+  BoxingCost cost;
+  cost.logical_byte_size = logical_byte_size;
+  const int64_t parallel_num = parallel_desc.parallel_num();
+  const int64_t machine_num = parallel_desc.sorted_machine_ids().size();
+  const double total_byte_size = per_device_byte_size * parallel_num;
+  // one link of the ring leaves each machine
+  if (machine_num > 1) {
+    cost.inter_node_byte_size = total_byte_size * machine_num / parallel_num;
+    cost.estimated_time = per_device_byte_size / BoxingBytesPerSecond(true);
+  } else {
+    cost.estimated_time = per_device_byte_size / BoxingBytesPerSecond(false);
+  }
+  cost.intra_node_byte_size = total_byte_size - cost.inter_node_byte_size;
+  return cost;
+}
+
+}  // namespace
+
+double MemoryBytesPerSecond(DeviceType device_type) {
+  return device_type == DeviceType::kGPU ? kGpuMemoryBytesPerSecond : kCpuMemoryBytesPerSecond;
+}
+
+double BoxingBytesPerSecond(bool is_inter_machine) {
+  return is_inter_machine ? kInterMachineBoxingBytesPerSecond : kIntraMachineBoxingBytesPerSecond;
+}
+
+BoxingCost EstimateBoxingCost(const std::string& builder_name,
+                              const ParallelDesc& src_parallel_desc,
+                              const ParallelDesc& dst_parallel_desc,
+                              const SbpParallel& src_sbp_parallel,
+                              const SbpParallel& dst_sbp_parallel,
+                              const BlobDesc& logical_blob_desc) {
+  const double elem_byte_size = GetSizeOfDataType(logical_blob_desc.data_type());
+  const double logical_byte_size = logical_blob_desc.shape().elem_cnt() * elem_byte_size;
+  const double ring_blob_ratio =
+      RingCollectiveBlobRatio(builder_name, src_parallel_desc.parallel_num());
+  if (src_parallel_desc == dst_parallel_desc && ring_blob_ratio > 0) {
+    return EstimateRingCollectiveCost(src_parallel_desc, ring_blob_ratio * logical_byte_size,
+                                      logical_byte_size);
+  }
+  const int64_t src_parallel_num = src_parallel_desc.parallel_num();
+  const int64_t dst_parallel_num = dst_parallel_desc.parallel_num();
+  // a scalar has no axis to be split, every device holds the whole of it
+  const bool is_scalar = logical_blob_desc.shape().NumAxes() == 0;
+  const bool src_is_partial = src_sbp_parallel.has_partial_sum_parallel();
+  const bool dst_is_partial = dst_sbp_parallel.has_partial_sum_parallel();
+  std::vector<TensorSliceView> src_views(src_parallel_num);
+  std::vector<TensorSliceView> dst_views(dst_parallel_num);
+  std::vector<double> dst_elem_cnts(dst_parallel_num, 0);
+  // the other devices of a partial sum are filled with zeros, which needs no transfer
+  const bool is_first_dst_only = dst_is_partial && !src_is_partial;
+  if (is_scalar) {
+    FOR_RANGE(int64_t, dst_id, 0, dst_parallel_num) {
+      dst_elem_cnts.at(dst_id) = (dst_id == 0 || !is_first_dst_only) ? 1 : 0;
+    }
+  } else {
+    src_views = SubTskGphBuilderUtil::GetTensorSliceView(src_parallel_num, src_sbp_parallel,
+                                                         logical_blob_desc);
+    if (is_first_dst_only) {
+      dst_views.at(0) = SubTskGphBuilderUtil::GetBroadcastTensorSliceView(logical_blob_desc);
+    } else {
+      dst_views = SubTskGphBuilderUtil::GetTensorSliceView(dst_parallel_num, dst_sbp_parallel,
+                                                           logical_blob_desc);
+    }
+    FOR_RANGE(int64_t, dst_id, 0, dst_parallel_num) {
+      dst_elem_cnts.at(dst_id) = ElemCnt4SliceView(dst_views.at(dst_id));
+    }
+  }
+  BoxingCost cost;
+  cost.logical_byte_size = logical_byte_size;
+  FOR_RANGE(int64_t, dst_id, 0, dst_parallel_num) {
+    if (dst_elem_cnts.at(dst_id) == 0) { continue; }
+    DeviceTraffic traffic;
+    const auto AddTraffic = [&](int64_t src_id, double elem_cnt) {
+      const double byte_size = elem_cnt * elem_byte_size;
+      const int64_t distance =
+          SubTskGphBuilderUtil::GetDistance(src_parallel_desc, src_id, dst_parallel_desc, dst_id);
+      if (distance == SubTskGphBuilderUtil::kDistanceSameDevice) {
+        traffic.local_byte_size += byte_size;
+      } else if (distance == SubTskGphBuilderUtil::kDistanceSameMachine) {
+        traffic.intra_node_byte_size += byte_size;
+      } else {
+        traffic.inter_node_byte_size += byte_size;
+      }
+    };
+    if (is_scalar || src_sbp_parallel.has_broadcast_parallel()
+        || (src_is_partial && dst_is_partial)) {
+      AddTraffic(SubTskGphBuilderUtil::FindNearestSrcParallelId(src_parallel_desc,
+                                                                 dst_parallel_desc, dst_id),
+                 dst_elem_cnts.at(dst_id));
+    } else if (src_is_partial) {
+      // every partial value of the slice has to be summed up
+      FOR_RANGE(int64_t, src_id, 0, src_parallel_num) {
+        AddTraffic(src_id, dst_elem_cnts.at(dst_id));
+      }
+    } else {
+      FOR_RANGE(int64_t, src_id, 0, src_parallel_num) {
+        AddTraffic(src_id, ElemCnt4SliceView(src_views.at(src_id).Intersect(dst_views.at(dst_id))));
+      }
+    }
+    cost.local_byte_size += traffic.local_byte_size;
+    cost.intra_node_byte_size += traffic.intra_node_byte_size;
+    cost.inter_node_byte_size += traffic.inter_node_byte_size;
+    const double time =
+        traffic.local_byte_size / MemoryBytesPerSecond(dst_parallel_desc.device_type())
+        + traffic.intra_node_byte_size / BoxingBytesPerSecond(false)
+        + traffic.inter_node_byte_size / BoxingBytesPerSecond(true);
+    cost.estimated_time = std::max(cost.estimated_time, time);
+  }
+  return cost;
+}
+
+}  // namespace oneflow
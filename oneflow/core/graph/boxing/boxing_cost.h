@@ -0,0 +1,53 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_GRAPH_BOXING_BOXING_COST_H_
+#define ONEFLOW_CORE_GRAPH_BOXING_BOXING_COST_H_
+
+#include "oneflow/core/job/parallel_desc.h"
+#include "oneflow/core/job/sbp_parallel.pb.h"
+#include "oneflow/core/register/blob_desc.h"
+
+namespace oneflow {
+
+// Bytes a boxing moves per step, split by how far they travel, all devices summed up
+struct BoxingCost {
+  double logical_byte_size = 0;
+  // copies between regsts of the same device
+  double local_byte_size = 0;
+  double intra_node_byte_size = 0;
+  double inter_node_byte_size = 0;
+  // the time of the device that receives the most, in seconds
+  double estimated_time = 0;
+};
+
+// Rough throughputs of the memory of a device and of the links between devices, only their ratios
+// matter. EstimateBoxingCost and the cost model of AutoParallelPass both use them.
+double MemoryBytesPerSecond(DeviceType device_type);
+double BoxingBytesPerSecond(bool is_inter_machine);
+
+// Estimates the traffic of the boxing from the slices each out device needs of each in device.
+// The nccl collective builders are estimated with the ring algorithm instead, so the estimate of
+// an all-reduce is 2 * (n - 1) / n of the blob per device rather than (n - 1) whole blobs.
+BoxingCost EstimateBoxingCost(const std::string& builder_name,
+                              const ParallelDesc& src_parallel_desc,
+                              const ParallelDesc& dst_parallel_desc,
+                              const SbpParallel& src_sbp_parallel,
+                              const SbpParallel& dst_sbp_parallel,
+                              const BlobDesc& logical_blob_desc);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_GRAPH_BOXING_BOXING_COST_H_
@@ -0,0 +1,110 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/graph/boxing/boxing_cost.h"
+
+namespace oneflow {
+namespace test {
+
+namespace {
+
+// two machines with two cpu devices each, the devices of a machine share the host memory
+ParallelDesc Make2n4dParallelDesc() {
+  ParallelConf parallel_conf;
+  parallel_conf.set_device_tag("cpu");
+  parallel_conf.add_device_name("0:0-1");
+  parallel_conf.add_device_name("1:0-1");
+  return ParallelDesc(parallel_conf);
+}
+
+SbpParallel MakeSplitSbp(int64_t axis) {
+  SbpParallel sbp;
+  sbp.mutable_split_parallel()->set_axis(axis);
+  return sbp;
+}
+
+SbpParallel MakeBroadcastSbp() {
+  SbpParallel sbp;
+  sbp.mutable_broadcast_parallel();
+  return sbp;
+}
+
+SbpParallel MakePartialSumSbp() {
+  SbpParallel sbp;
+  sbp.mutable_partial_sum_parallel();
+  return sbp;
+}
+
+}  // namespace
+
+TEST(BoxingCost, split_to_broadcast) {
+  const ParallelDesc parallel_desc = Make2n4dParallelDesc();
+  // 128 bytes, a split slice of the 4 devices is 32 bytes
+  const BlobDesc blob_desc(Shape({8, 4}), DataType::kFloat);
+  const BoxingCost cost = EstimateBoxingCost("", parallel_desc, parallel_desc, MakeSplitSbp(0),
+                                             MakeBroadcastSbp(), blob_desc);
+  ASSERT_DOUBLE_EQ(cost.logical_byte_size, 128);
+  // every device gathers the two slices of its machine and the two of the other one
+  ASSERT_DOUBLE_EQ(cost.local_byte_size, 4 * 64);
+  ASSERT_DOUBLE_EQ(cost.intra_node_byte_size, 0);
+  ASSERT_DOUBLE_EQ(cost.inter_node_byte_size, 4 * 64);
+  ASSERT_DOUBLE_EQ(cost.estimated_time,
+                   64 / MemoryBytesPerSecond(DeviceType::kCPU) + 64 / BoxingBytesPerSecond(true));
+}
+
+TEST(BoxingCost, partial_sum_to_split) {
+  const ParallelDesc parallel_desc = Make2n4dParallelDesc();
+  // 128 bytes, a split slice of the 4 devices is 32 bytes
+  const BlobDesc blob_desc(Shape({8, 4}), DataType::kFloat);
+  const BoxingCost cost = EstimateBoxingCost("", parallel_desc, parallel_desc,
+                                             MakePartialSumSbp(), MakeSplitSbp(0), blob_desc);
+  // every device sums up its slice of all four partial values
+  ASSERT_DOUBLE_EQ(cost.local_byte_size, 4 * 64);
+  ASSERT_DOUBLE_EQ(cost.intra_node_byte_size, 0);
+  ASSERT_DOUBLE_EQ(cost.inter_node_byte_size, 4 * 64);
+  ASSERT_DOUBLE_EQ(cost.estimated_time,
+                   64 / MemoryBytesPerSecond(DeviceType::kCPU) + 64 / BoxingBytesPerSecond(true));
+}
+
+TEST(BoxingCost, broadcast_to_split) {
+  const ParallelDesc parallel_desc = Make2n4dParallelDesc();
+  // 128 bytes, a split slice of the 4 devices is 32 bytes
+  const BlobDesc blob_desc(Shape({8, 4}), DataType::kFloat);
+  const BoxingCost cost = EstimateBoxingCost("", parallel_desc, parallel_desc, MakeBroadcastSbp(),
+                                             MakeSplitSbp(0), blob_desc);
+  // every device takes its slice of its own copy
+  ASSERT_DOUBLE_EQ(cost.local_byte_size, 4 * 32);
+  ASSERT_DOUBLE_EQ(cost.intra_node_byte_size, 0);
+  ASSERT_DOUBLE_EQ(cost.inter_node_byte_size, 0);
+  ASSERT_DOUBLE_EQ(cost.estimated_time, 32 / MemoryBytesPerSecond(DeviceType::kCPU));
+}
+
+TEST(BoxingCost, ring_all_reduce) {
+  const ParallelDesc parallel_desc = Make2n4dParallelDesc();
+  // 128 bytes, a split slice of the 4 devices is 32 bytes
+  const BlobDesc blob_desc(Shape({8, 4}), DataType::kFloat);
+  const BoxingCost cost = EstimateBoxingCost("NcclCollectiveBoxingAllReduceSubTskGphBuilder",
+                                             parallel_desc, parallel_desc, MakePartialSumSbp(),
+                                             MakeBroadcastSbp(), blob_desc);
+  ASSERT_DOUBLE_EQ(cost.logical_byte_size, 128);
+  // each device sends 2 * (4 - 1) / 4 of the blob, one of the four links crosses each machine
+  ASSERT_DOUBLE_EQ(cost.local_byte_size, 0);
+  ASSERT_DOUBLE_EQ(cost.intra_node_byte_size, 2 * 192);
+  ASSERT_DOUBLE_EQ(cost.inter_node_byte_size, 2 * 192);
+  ASSERT_DOUBLE_EQ(cost.estimated_time, 192 / BoxingBytesPerSecond(true));
+}
+
+}  // namespace test
+}  // namespace oneflow
@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/graph/boxing/boxing_logger.h"
 #include "oneflow/core/job/sbp_parallel.h"
+#include "oneflow/core/graph/boxing/boxing_cost.h"
 
 namespace oneflow {
 
@@ -22,7 +23,9 @@ namespace {
 
 #define OF_BOXING_LOGGER_CSV_COLNUM_NAME_FIELD                   \
   "src_op_name,dst_op_name,src_parallel_conf,dst_parallel_conf," \
-  "src_sbp_conf,dst_sbp_conf,lbi,dtype,shape,builder,comment\n"
+  "src_sbp_conf,dst_sbp_conf,lbi,dtype,shape,builder,comment,"    \
+  "logical_byte_size,local_byte_size,intra_node_byte_size,"       \
+  "inter_node_byte_size,estimated_time_us\n"
 
 std::string ParallelDescToString(const ParallelDesc& parallel_desc) {
   std::string serialized_parallel_desc;
@@ -64,7 +67,7 @@ std::string MakeBoxingLoggerCsvRow(const SubTskGphBuilderStatus& status,
                                    const ParallelDesc& dst_parallel_desc,
                                    const SbpParallel& src_sbp_parallel,
                                    const SbpParallel& dst_sbp_parallel, const LogicalBlobId& lbi,
-                                   const BlobDesc& logical_blob_desc) {
+                                   const BlobDesc& logical_blob_desc, const BoxingCost& cost) {
   std::string serialized_status;
   serialized_status += src_op_name + ",";
   serialized_status += dst_op_name + ",";
@@ -81,27 +84,56 @@ std::string MakeBoxingLoggerCsvRow(const SubTskGphBuilderStatus& status,
   } else {
     serialized_status += status.comment();
   }
+  serialized_status += "," + std::to_string(static_cast<int64_t>(cost.logical_byte_size));
+  serialized_status += "," + std::to_string(static_cast<int64_t>(cost.local_byte_size));
+  serialized_status += "," + std::to_string(static_cast<int64_t>(cost.intra_node_byte_size));
+  serialized_status += "," + std::to_string(static_cast<int64_t>(cost.inter_node_byte_size));
+  serialized_status += "," + std::to_string(cost.estimated_time * 1e6);
   serialized_status += "\n";
   return serialized_status;
 }
 
 }  // namespace
 
-CsvBoxingLogger::CsvBoxingLogger(std::string path) {
+CsvBoxingLogger::CsvBoxingLogger(std::string path)
+    : path_(path), edge_cnt_(0), slowest_edge_time_(0) {
   log_stream_ = TeePersistentLogStream::Create(path);
   log_stream_ << OF_BOXING_LOGGER_CSV_COLNUM_NAME_FIELD;
 }
 
-CsvBoxingLogger::~CsvBoxingLogger() { log_stream_->Flush(); }
+CsvBoxingLogger::~CsvBoxingLogger() {
+  log_stream_->Flush();
+  if (edge_cnt_ == 0) { return; }
+  LOG(INFO) << path_ << ": " << edge_cnt_ << " boxings move "
+            << static_cast<int64_t>(total_cost_.intra_node_byte_size) << " bytes intra-node and "
+            << static_cast<int64_t>(total_cost_.inter_node_byte_size)
+            << " bytes inter-node per step, estimated " << total_cost_.estimated_time * 1e6
+            << " us if serialized, the slowest is " << slowest_edge_ << " estimated "
+            << slowest_edge_time_ * 1e6 << " us";
+}
 
 void CsvBoxingLogger::Log(const SubTskGphBuilderStatus& status, const std::string& src_op_name,
                           const std::string& dst_op_name, const ParallelDesc& src_parallel_desc,
                           const ParallelDesc& dst_parallel_desc,
                           const SbpParallel& src_sbp_parallel, const SbpParallel& dst_sbp_parallel,
                           const LogicalBlobId& lbi, const BlobDesc& logical_blob_desc) {
+  const BoxingCost cost =
+      EstimateBoxingCost(status.builder_name(), src_parallel_desc, dst_parallel_desc,
+                         src_sbp_parallel, dst_sbp_parallel, logical_blob_desc);
   log_stream_ << MakeBoxingLoggerCsvRow(status, src_op_name, dst_op_name, src_parallel_desc,
                                         dst_parallel_desc, src_sbp_parallel, dst_sbp_parallel, lbi,
-                                        logical_blob_desc);
+                                        logical_blob_desc, cost);
+  edge_cnt_ += 1;
+  total_cost_.logical_byte_size += cost.logical_byte_size;
+  total_cost_.local_byte_size += cost.local_byte_size;
+  total_cost_.intra_node_byte_size += cost.intra_node_byte_size;
+  total_cost_.inter_node_byte_size += cost.inter_node_byte_size;
+  total_cost_.estimated_time += cost.estimated_time;
+  if (cost.estimated_time > slowest_edge_time_) {
+    slowest_edge_time_ = cost.estimated_time;
+    slowest_edge_ = GenLogicalBlobName(lbi) + " (" + SbpParallelToString(src_sbp_parallel) + " -> "
+                    + SbpParallelToString(dst_sbp_parallel) + ")";
+  }
 }
 
 }  // namespace oneflow
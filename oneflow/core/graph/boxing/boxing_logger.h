@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "oneflow/core/persistence/tee_persistent_log_stream.h"
 #include "oneflow/core/graph/boxing/sub_task_graph_builder_status_util.h"
+#include "oneflow/core/graph/boxing/boxing_cost.h"
 
 namespace oneflow {
 
@@ -47,6 +48,8 @@ class NullBoxingLogger final : public BoxingLogger {
            const BlobDesc& logical_blob_desc) override{};
 };
 
+// Writes a row per boxing with the builder that handled it and the estimated traffic of it, the
+// runtime counterpart is the BoxingTrafficCounter
 class CsvBoxingLogger final : public BoxingLogger {
  public:
   OF_DISALLOW_COPY_AND_MOVE(CsvBoxingLogger);
@@ -62,6 +65,11 @@ class CsvBoxingLogger final : public BoxingLogger {
 
  private:
   std::unique_ptr<TeePersistentLogStream> log_stream_;
+  std::string path_;
+  int64_t edge_cnt_;
+  BoxingCost total_cost_;
+  std::string slowest_edge_;
+  double slowest_edge_time_;
 };
 
 }  // namespace oneflow
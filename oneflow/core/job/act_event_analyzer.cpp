@@ -0,0 +1,262 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/act_event_analyzer.h"
+#include "oneflow/core/persistence/tee_persistent_log_stream.h"
+#include <json.hpp>
+#include <cmath>
+#include <iomanip>
+
+namespace oneflow {
+
+namespace {
+
+// A produced regst is worth more registers if its producer waits for it this share of its time
+constexpr double kMinOutputWaitRatio = 0.05;
+
+double Clamp(double val, double lo, double hi) { return std::min(std::max(val, lo), hi); }
+
+double NanosecondsToMicroseconds(double ns) { return ns / 1000.0; }
+
+}  // namespace
+
+ActEventAnalyzer::ActEventAnalyzer(const Plan& plan,
+                                   const std::list<std::unique_ptr<ActEvent>>& act_events) {
+  for (const TaskProto& task : plan.task()) {
+    CHECK(task_id2task_proto_.emplace(task.task_id(), &task).second);
+    for (const auto& pair : task.produced_regst_desc()) {
+      CHECK(regst_desc_id2regst_desc_.emplace(pair.second.regst_desc_id(), &pair.second).second);
+    }
+  }
+  for (const auto& act_event : act_events) {
+    if (task_id2task_proto_.find(act_event->actor_id()) == task_id2task_proto_.end()) { continue; }
+    actor_id2act_events_[act_event->actor_id()].push_back(act_event.get());
+    actor_act_id2act_event_[std::make_pair(act_event->actor_id(), act_event->act_id())] =
+        act_event.get();
+    for (const ReadableRegstInfo& info : act_event->readable_regst_infos()) {
+      const ActEvent*& last_consumer =
+          regst_uid2last_consumer_[std::make_pair(info.regst_desc_id(), info.act_id())];
+      if (last_consumer == nullptr || last_consumer->stop_time() < act_event->stop_time()) {
+        last_consumer = act_event.get();
+      }
+    }
+  }
+  for (auto& pair : actor_id2act_events_) {
+    std::sort(pair.second.begin(), pair.second.end(), [](const ActEvent* lhs, const ActEvent* rhs) {
+      return lhs->act_id() < rhs->act_id();
+    });
+  }
+  AnalyzeStalls();
+  AnalyzeCriticalPath();
+}
+
+const ActEvent* ActEventAnalyzer::FindActEvent(int64_t actor_id, int64_t act_id) const {
+  const auto it = actor_act_id2act_event_.find(std::make_pair(actor_id, act_id));
+  return it == actor_act_id2act_event_.end() ? nullptr : it->second;
+}
+
+double ActEventAnalyzer::InputReadyTime(const ActEvent* act_event) const {
+  double ready_time = -1;
+  for (const ReadableRegstInfo& info : act_event->readable_regst_infos()) {
+    const auto regst_desc_it = regst_desc_id2regst_desc_.find(info.regst_desc_id());
+    if (regst_desc_it == regst_desc_id2regst_desc_.end()) { continue; }
+    const ActEvent* producer =
+        FindActEvent(regst_desc_it->second->producer_task_id(), info.act_id());
+    if (producer != nullptr) { ready_time = std::max(ready_time, producer->stop_time()); }
+  }
+  return ready_time;
+}
+
+double ActEventAnalyzer::OutputFreeTime(const ActEvent* act_event,
+                                        int64_t* binding_regst_desc_id) const {
+  double free_time = -1;
+  *binding_regst_desc_id = -1;
+  const TaskProto& task = *task_id2task_proto_.at(act_event->actor_id());
+  for (const auto& pair : task.produced_regst_desc()) {
+    const RegstDescProto& regst_desc = pair.second;
+    // every act writes the next register, the one written by the act register_num acts ago
+    const auto it = regst_uid2last_consumer_.find(std::make_pair(
+        regst_desc.regst_desc_id(), act_event->act_id() - regst_desc.register_num()));
+    if (it == regst_uid2last_consumer_.end()) { continue; }
+    if (it->second->stop_time() > free_time) {
+      free_time = it->second->stop_time();
+      *binding_regst_desc_id = regst_desc.regst_desc_id();
+    }
+  }
+  return free_time;
+}
+
+void ActEventAnalyzer::AnalyzeStalls() {
+  for (const auto& pair : actor_id2act_events_) {
+    ActorStallInfo& stall_info = actor_id2stall_info_[pair.first];
+    const std::vector<const ActEvent*>& act_events = pair.second;
+    FOR_RANGE(size_t, i, 0, act_events.size()) {
+      const ActEvent* act_event = act_events.at(i);
+      stall_info.act_cnt += 1;
+      stall_info.run_time += act_event->stop_time() - act_event->start_time();
+      if (i == 0) { continue; }
+      const double idle_begin = act_events.at(i - 1)->stop_time();
+      const double idle_end = act_event->ready_time();
+      if (idle_end <= idle_begin) { continue; }
+      // the actor waits for its inputs first, then for free output regsts, then for the rest
+      const double input_ready_time = Clamp(InputReadyTime(act_event), idle_begin, idle_end);
+      int64_t binding_regst_desc_id = -1;
+      const double output_free_time = Clamp(OutputFreeTime(act_event, &binding_regst_desc_id),
+                                            input_ready_time, idle_end);
+      const double output_wait_time = output_free_time - input_ready_time;
+      stall_info.input_wait_time += input_ready_time - idle_begin;
+      stall_info.output_wait_time += output_wait_time;
+      stall_info.other_idle_time += idle_end - output_free_time;
+      if (binding_regst_desc_id != -1 && output_wait_time > 0) {
+        regst_desc_id2output_wait_time_[binding_regst_desc_id] += output_wait_time;
+      }
+    }
+  }
+}
+
+void ActEventAnalyzer::AnalyzeCriticalPath() {
+  const ActEvent* cur = nullptr;
+  for (const auto& pair : actor_id2act_events_) {
+    for (const ActEvent* act_event : pair.second) {
+      if (cur == nullptr || act_event->stop_time() > cur->stop_time()) { cur = act_event; }
+    }
+  }
+  // walks back from the last act to the dependency that finished last before each act
+  HashSet<const ActEvent*> visited;
+  while (cur != nullptr && visited.insert(cur).second) {
+    const ActEvent* pred = nullptr;
+    const auto TryUpdatePred = [&](const ActEvent* candidate) {
+      if (candidate == nullptr || visited.find(candidate) != visited.end()) { return; }
+      if (pred == nullptr || candidate->stop_time() > pred->stop_time()) { pred = candidate; }
+    };
+    for (const ReadableRegstInfo& info : cur->readable_regst_infos()) {
+      const auto regst_desc_it = regst_desc_id2regst_desc_.find(info.regst_desc_id());
+      if (regst_desc_it == regst_desc_id2regst_desc_.end()) { continue; }
+      TryUpdatePred(FindActEvent(regst_desc_it->second->producer_task_id(), info.act_id()));
+    }
+    TryUpdatePred(FindActEvent(cur->actor_id(), cur->act_id() - 1));
+    int64_t binding_regst_desc_id = -1;
+    OutputFreeTime(cur, &binding_regst_desc_id);
+    if (binding_regst_desc_id != -1) {
+      const int64_t register_num =
+          regst_desc_id2regst_desc_.at(binding_regst_desc_id)->register_num();
+      TryUpdatePred(regst_uid2last_consumer_.at(
+          std::make_pair(binding_regst_desc_id, cur->act_id() - register_num)));
+    }
+    const double gap_time =
+        pred == nullptr ? 0 : std::max(0.0, cur->start_time() - pred->stop_time());
+    critical_path_.push_back(CriticalPathStep{cur, gap_time});
+    ActorStallInfo& stall_info = actor_id2stall_info_.at(cur->actor_id());
+    stall_info.critical_path_act_cnt += 1;
+    stall_info.critical_path_time += cur->stop_time() - cur->start_time();
+    cur = pred;
+  }
+  std::reverse(critical_path_.begin(), critical_path_.end());
+}
+
+void ActEventAnalyzer::ForEachSuggestedRegstNum(
+    const std::function<void(int64_t, int32_t)>& Handler) const {
+  for (const auto& pair : regst_desc_id2output_wait_time_) {
+    const RegstDescProto& regst_desc = *regst_desc_id2regst_desc_.at(pair.first);
+    const std::vector<const ActEvent*>& act_events =
+        actor_id2act_events_.at(regst_desc.producer_task_id());
+    const double span = act_events.back()->stop_time() - act_events.front()->ready_time();
+    if (span <= 0) { continue; }
+    const double wait_ratio = pair.second / span;
+    if (wait_ratio < kMinOutputWaitRatio) { continue; }
+    const int32_t extra_register_num =
+        static_cast<int32_t>(std::ceil(wait_ratio * regst_desc.register_num()));
+    const int32_t suggested_register_num = std::min<int32_t>(
+        regst_desc.max_register_num(), regst_desc.register_num() + extra_register_num);
+    if (suggested_register_num > regst_desc.register_num()) {
+      Handler(pair.first, suggested_register_num);
+    }
+  }
+}
+
+std::string ActEventAnalyzer::ActorName(int64_t actor_id) const {
+  const TaskProto& task = *task_id2task_proto_.at(actor_id);
+  std::string name = TaskType_Name(task.task_type());
+  if (task.exec_sequence().exec_node_size() > 0) {
+    name += " " + task.exec_sequence().exec_node(0).kernel_conf().op_attribute().op_conf().name();
+  }
+  return name;
+}
+
+void ActEventAnalyzer::Report(const std::string& name) const {
+  std::vector<std::pair<int64_t, const ActorStallInfo*>> actor_stall_infos;
+  for (const auto& pair : actor_id2stall_info_) {
+    actor_stall_infos.emplace_back(pair.first, &pair.second);
+  }
+  std::sort(actor_stall_infos.begin(), actor_stall_infos.end(),
+            [](const std::pair<int64_t, const ActorStallInfo*>& lhs,
+               const std::pair<int64_t, const ActorStallInfo*>& rhs) {
+              if (lhs.second->critical_path_time != rhs.second->critical_path_time) {
+                return lhs.second->critical_path_time > rhs.second->critical_path_time;
+              }
+              return lhs.second->output_wait_time > rhs.second->output_wait_time;
+            });
+  nlohmann::json report;
+  report["actors"] = nlohmann::json::array();
+  std::ostringstream table;
+  table << std::fixed << std::setprecision(3);
+  table << "actor_id\tacts\trun_ms\tinput_wait_ms\toutput_wait_ms\tother_idle_ms\t"
+           "critical_acts\tcritical_ms\tname\n";
+  for (const auto& pair : actor_stall_infos) {
+    const ActorStallInfo& info = *pair.second;
+    report["actors"].push_back(
+        {{"actor_id", pair.first},
+         {"name", ActorName(pair.first)},
+         {"act_cnt", info.act_cnt},
+         {"run_us", NanosecondsToMicroseconds(info.run_time)},
+         {"input_wait_us", NanosecondsToMicroseconds(info.input_wait_time)},
+         {"output_wait_us", NanosecondsToMicroseconds(info.output_wait_time)},
+         {"other_idle_us", NanosecondsToMicroseconds(info.other_idle_time)},
+         {"critical_path_act_cnt", info.critical_path_act_cnt},
+         {"critical_path_us", NanosecondsToMicroseconds(info.critical_path_time)}});
+    table << pair.first << "\t" << info.act_cnt << "\t" << info.run_time / 1e6 << "\t"
+          << info.input_wait_time / 1e6 << "\t" << info.output_wait_time / 1e6 << "\t"
+          << info.other_idle_time / 1e6 << "\t" << info.critical_path_act_cnt << "\t"
+          << info.critical_path_time / 1e6 << "\t" << ActorName(pair.first) << "\n";
+  }
+  report["critical_path"] = nlohmann::json::array();
+  for (const CriticalPathStep& step : critical_path_) {
+    report["critical_path"].push_back(
+        {{"actor_id", step.act_event->actor_id()},
+         {"act_id", step.act_event->act_id()},
+         {"run_us",
+          NanosecondsToMicroseconds(step.act_event->stop_time() - step.act_event->start_time())},
+         {"gap_us", NanosecondsToMicroseconds(step.gap_time)}});
+  }
+  report["regst_num_suggestions"] = nlohmann::json::array();
+  table << "\nregst_desc_id\tregister_num\tsuggested_register_num\toutput_wait_ms\tproducer\n";
+  ForEachSuggestedRegstNum([&](int64_t regst_desc_id, int32_t suggested_register_num) {
+    const RegstDescProto& regst_desc = *regst_desc_id2regst_desc_.at(regst_desc_id);
+    const double output_wait_time = regst_desc_id2output_wait_time_.at(regst_desc_id);
+    report["regst_num_suggestions"].push_back(
+        {{"regst_desc_id", regst_desc_id},
+         {"producer_actor_id", regst_desc.producer_task_id()},
+         {"register_num", regst_desc.register_num()},
+         {"suggested_register_num", suggested_register_num},
+         {"output_wait_us", NanosecondsToMicroseconds(output_wait_time)}});
+    table << regst_desc_id << "\t" << regst_desc.register_num() << "\t" << suggested_register_num
+          << "\t" << output_wait_time / 1e6 << "\t" << ActorName(regst_desc.producer_task_id())
+          << "\n";
+  });
+  TeePersistentLogStream::Create(name)->Write(table.str());
+  TeePersistentLogStream::Create(name + ".json")->Write(report.dump(2));
+}
+
+}  // namespace oneflow
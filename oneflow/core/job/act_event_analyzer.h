@@ -0,0 +1,88 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_ACT_EVENT_ANALYZER_H_
+#define ONEFLOW_CORE_JOB_ACT_EVENT_ANALYZER_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/job/plan.pb.h"
+#include "oneflow/core/actor/act_event.pb.h"
+
+namespace oneflow {
+
+// Times are in the unit of the act events, which is nanoseconds
+struct ActorStallInfo {
+  int64_t act_cnt = 0;
+  double run_time = 0;
+  // the actor had acted and the last input regst of its next act was not produced yet
+  double input_wait_time = 0;
+  // the inputs were ready but a produced regst was still read by the consumers of an earlier act
+  double output_wait_time = 0;
+  double other_idle_time = 0;
+  int64_t critical_path_act_cnt = 0;
+  double critical_path_time = 0;
+};
+
+struct CriticalPathStep {
+  const ActEvent* act_event;
+  // idle time of the critical path between the previous step and this one
+  double gap_time;
+};
+
+// Rebuilds the dependencies between the act events of an experiment run from the regsts they read.
+// The idle time between two acts of an actor is split into waiting for its input regsts and
+// waiting for its own regsts to be released by their consumers, which is a sign that the regst_num
+// of the produced regst is too small.
+class ActEventAnalyzer final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ActEventAnalyzer);
+  ActEventAnalyzer(const Plan& plan, const std::list<std::unique_ptr<ActEvent>>& act_events);
+  ~ActEventAnalyzer() = default;
+
+  const HashMap<int64_t, ActorStallInfo>& actor_id2stall_info() const {
+    return actor_id2stall_info_;
+  }
+  const std::vector<CriticalPathStep>& critical_path() const { return critical_path_; }
+  const HashMap<int64_t, double>& regst_desc_id2output_wait_time() const {
+    return regst_desc_id2output_wait_time_;
+  }
+  void ForEachSuggestedRegstNum(const std::function<void(int64_t, int32_t)>& Handler) const;
+
+  // Writes a summary table to the log dir as name and the full report as name.json
+  void Report(const std::string& name) const;
+
+ private:
+  const ActEvent* FindActEvent(int64_t actor_id, int64_t act_id) const;
+  double InputReadyTime(const ActEvent* act_event) const;
+  double OutputFreeTime(const ActEvent* act_event, int64_t* binding_regst_desc_id) const;
+  void AnalyzeStalls();
+  void AnalyzeCriticalPath();
+  std::string ActorName(int64_t actor_id) const;
+
+  HashMap<int64_t, const TaskProto*> task_id2task_proto_;
+  HashMap<int64_t, const RegstDescProto*> regst_desc_id2regst_desc_;
+  HashMap<int64_t, std::vector<const ActEvent*>> actor_id2act_events_;
+  HashMap<std::pair<int64_t, int64_t>, const ActEvent*> actor_act_id2act_event_;
+  // the consumer that stopped last of each regst, keyed by regst desc id and act id
+  HashMap<std::pair<int64_t, int64_t>, const ActEvent*> regst_uid2last_consumer_;
+
+  HashMap<int64_t, ActorStallInfo> actor_id2stall_info_;
+  HashMap<int64_t, double> regst_desc_id2output_wait_time_;
+  std::vector<CriticalPathStep> critical_path_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_ACT_EVENT_ANALYZER_H_
@@ -0,0 +1,131 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/act_event_analyzer.h"
+
+namespace oneflow {
+
+namespace {
+
+constexpr int64_t kProducerId = 1;
+constexpr int64_t kConsumerId = 2;
+constexpr int64_t kRegstDescId = 10;
+
+// the producer writes a regst of a single register, which the slow consumer holds for most of the
+// time, so the producer mostly waits for the register to be released
+Plan MakePlan() {
+  Plan plan;
+  TaskProto* producer = plan.add_task();
+  producer->set_task_type(TaskType::kNormalForward);
+  producer->set_task_id(kProducerId);
+  RegstDescProto* regst_desc = &(*producer->mutable_produced_regst_desc())["out"];
+  regst_desc->set_regst_desc_id(kRegstDescId);
+  regst_desc->set_producer_task_id(kProducerId);
+  regst_desc->set_register_num(1);
+  regst_desc->set_max_register_num(4);
+  TaskProto* consumer = plan.add_task();
+  consumer->set_task_type(TaskType::kNormalForward);
+  consumer->set_task_id(kConsumerId);
+  return plan;
+}
+
+void AddActEvent(int64_t actor_id, int64_t act_id, double ready_time, double start_time,
+                 double stop_time, std::list<std::unique_ptr<ActEvent>>* act_events) {
+  std::unique_ptr<ActEvent> act_event(new ActEvent);
+  act_event->set_is_experiment_phase(true);
+  act_event->set_actor_id(actor_id);
+  act_event->set_work_stream_id(actor_id);
+  act_event->set_act_id(act_id);
+  act_event->set_ready_time(ready_time);
+  act_event->set_start_time(start_time);
+  act_event->set_stop_time(stop_time);
+  if (actor_id == kConsumerId) {
+    ReadableRegstInfo* info = act_event->add_readable_regst_infos();
+    info->set_regst_desc_id(kRegstDescId);
+    info->set_act_id(act_id);
+  }
+  act_events->emplace_back(std::move(act_event));
+}
+
+std::list<std::unique_ptr<ActEvent>> MakeActEvents() {
+  std::list<std::unique_ptr<ActEvent>> act_events;
+  AddActEvent(kProducerId, 0, 0, 0, 10, &act_events);
+  // the consumer waits 10 for its stream before its first act
+  AddActEvent(kConsumerId, 0, 10, 20, 100, &act_events);
+  AddActEvent(kProducerId, 1, 100, 100, 110, &act_events);
+  AddActEvent(kConsumerId, 1, 110, 110, 200, &act_events);
+  AddActEvent(kProducerId, 2, 200, 200, 210, &act_events);
+  AddActEvent(kConsumerId, 2, 210, 210, 300, &act_events);
+  // acts of actors that are not in the plan are ignored
+  AddActEvent(3, 0, 0, 0, 1000, &act_events);
+  return act_events;
+}
+
+}  // namespace
+
+TEST(ActEventAnalyzer, stalls) {
+  const Plan plan = MakePlan();
+  const std::list<std::unique_ptr<ActEvent>> act_events = MakeActEvents();
+  ActEventAnalyzer analyzer(plan, act_events);
+  ASSERT_EQ(analyzer.actor_id2stall_info().size(), 2);
+  const ActorStallInfo& producer = analyzer.actor_id2stall_info().at(kProducerId);
+  ASSERT_EQ(producer.act_cnt, 3);
+  ASSERT_DOUBLE_EQ(producer.run_time, 30);
+  ASSERT_DOUBLE_EQ(producer.input_wait_time, 0);
+  ASSERT_DOUBLE_EQ(producer.output_wait_time, 180);
+  ASSERT_DOUBLE_EQ(producer.other_idle_time, 0);
+  const ActorStallInfo& consumer = analyzer.actor_id2stall_info().at(kConsumerId);
+  ASSERT_EQ(consumer.act_cnt, 3);
+  ASSERT_DOUBLE_EQ(consumer.run_time, 260);
+  ASSERT_DOUBLE_EQ(consumer.input_wait_time, 20);
+  ASSERT_DOUBLE_EQ(consumer.output_wait_time, 0);
+  ASSERT_DOUBLE_EQ(consumer.other_idle_time, 0);
+  ASSERT_EQ(analyzer.regst_desc_id2output_wait_time().size(), 1);
+  ASSERT_DOUBLE_EQ(analyzer.regst_desc_id2output_wait_time().at(kRegstDescId), 180);
+}
+
+TEST(ActEventAnalyzer, critical_path) {
+  const Plan plan = MakePlan();
+  const std::list<std::unique_ptr<ActEvent>> act_events = MakeActEvents();
+  ActEventAnalyzer analyzer(plan, act_events);
+  // the acts alternate, each waiting for the other actor
+  const std::vector<CriticalPathStep>& critical_path = analyzer.critical_path();
+  ASSERT_EQ(critical_path.size(), 6);
+  FOR_RANGE(int64_t, i, 0, 6) {
+    ASSERT_EQ(critical_path.at(i).act_event->actor_id(), i % 2 == 0 ? kProducerId : kConsumerId);
+    ASSERT_EQ(critical_path.at(i).act_event->act_id(), i / 2);
+    ASSERT_DOUBLE_EQ(critical_path.at(i).gap_time, i == 1 ? 10 : 0);
+  }
+  ASSERT_EQ(analyzer.actor_id2stall_info().at(kProducerId).critical_path_act_cnt, 3);
+  ASSERT_DOUBLE_EQ(analyzer.actor_id2stall_info().at(kProducerId).critical_path_time, 30);
+  ASSERT_EQ(analyzer.actor_id2stall_info().at(kConsumerId).critical_path_act_cnt, 3);
+  ASSERT_DOUBLE_EQ(analyzer.actor_id2stall_info().at(kConsumerId).critical_path_time, 260);
+}
+
+TEST(ActEventAnalyzer, suggested_regst_num) {
+  const Plan plan = MakePlan();
+  const std::list<std::unique_ptr<ActEvent>> act_events = MakeActEvents();
+  ActEventAnalyzer analyzer(plan, act_events);
+  std::vector<std::pair<int64_t, int32_t>> suggestions;
+  analyzer.ForEachSuggestedRegstNum([&](int64_t regst_desc_id, int32_t register_num) {
+    suggestions.emplace_back(regst_desc_id, register_num);
+  });
+  // the producer waits 180 of its 210, one more register is suggested
+  ASSERT_EQ(suggestions.size(), 1);
+  ASSERT_EQ(suggestions.at(0).first, kRegstDescId);
+  ASSERT_EQ(suggestions.at(0).second, 2);
+}
+
+}  // namespace oneflow
@@ -18,6 +18,7 @@ limitations under the License.
 #endif  // WITH_CUDA
 #include <thread>
 #include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/core/thread/numa_util.h"
 #include "oneflow/core/job/env_global_objects_scope.h"
 #include "oneflow/core/control/ctrl_server.h"
 #include "oneflow/core/control/ctrl_client.h"
@@ -87,7 +88,15 @@ Maybe<void> EnvGlobalObjectsScope::Init(const EnvProto& env_proto) {
   Global<MachineCtx>::New(this_mchn_id);
   Global<ResourceDesc, ForEnv>::New(GetDefaultResource(env_proto));
   Global<ResourceDesc, ForSession>::New(GetDefaultResource(env_proto));
-  Global<ThreadPool>::New(Global<ResourceDesc, ForSession>::Get()->ComputeThreadPoolSize());
+  const ResourceDesc* resource_desc = Global<ResourceDesc, ForSession>::Get();
+  const int32_t thread_pool_size = resource_desc->ComputeThreadPoolSize();
+  if (resource_desc->thread_affinity_conf().enable_thread_pool_affinity()) {
+    Global<ThreadPool>::New(thread_pool_size, [thread_pool_size](int32_t thread_idx) {
+      SetThisThreadNumaNodeAffinity(NumaNode4Index(thread_idx, thread_pool_size));
+    });
+  } else {
+    Global<ThreadPool>::New(thread_pool_size);
+  }
   Global<vm::VirtualMachineScope>::New(Global<ResourceDesc, ForSession>::Get()->resource());
   Global<EagerJobBuildAndInferCtxMgr>::New();
 #ifdef WITH_CUDA
@@ -28,7 +28,10 @@ limitations under the License.
 #include "oneflow/core/graph/plan_task_graph.h"
 #include "oneflow/core/graph/regst_lifetime_graph.h"
 #include "oneflow/core/graph/sharable_mem_block_graph.h"
+#include "oneflow/core/job/act_event_analyzer.h"
+#include "oneflow/core/job/regst_num_tuning_util.h"
 #include "oneflow/core/actor/act_event_logger.h"
+#include "oneflow/core/persistence/tee_persistent_log_stream.h"
 #include "oneflow/core/thread/thread_pool.h"
 #include "oneflow/core/common/blocking_counter.h"
 
@@ -247,6 +250,89 @@ uint64_t CalcMemoryConsumed(
   return mem_consuming;
 }
 
+// Memory consumed with the register_num of the regst descs
+uint64_t CalcMemoryConsumed(const std::list<const RegstDescProto*>& regst_descs) {
+  uint64_t mem_consuming = 0;
+  HashMap<int64_t, uint64_t> mem_block_id2max_regst_desc_mem_bytes;
+  for (const RegstDescProto* regst_desc : regst_descs) {
+    uint64_t total_byte_size = RtRegstDesc(*regst_desc).TotalMainByteSize4AllRegst();
+    if (regst_desc->mem_block_id() == -1) {
+      mem_consuming += RoundUp(total_byte_size, kCudaMemAllocAlignSize);
+    } else {
+      total_byte_size += regst_desc->mem_block_offset();
+      auto& max_bytes = mem_block_id2max_regst_desc_mem_bytes[regst_desc->mem_block_id()];
+      max_bytes = std::max(max_bytes, total_byte_size);
+    }
+  }
+  for (const auto& pair : mem_block_id2max_regst_desc_mem_bytes) {
+    mem_consuming += RoundUp(pair.second, kCudaMemAllocAlignSize);
+  }
+  return mem_consuming;
+}
+
+double CalcEstimatedII(
+    const Plan& plan, double base_ii,
+    const std::function<const HashMap<int64_t, double>&(int64_t)>& PathDurations4RegstDescId,
+    const std::function<const HashMap<int64_t, double>&(int64_t)>& PathIIScales4RegstDescId) {
+  double ii = base_ii;
+  for (const auto& task_proto : plan.task()) {
+    for (const auto& pair : task_proto.produced_regst_desc()) {
+      const int64_t regst_desc_id = pair.second.regst_desc_id();
+      const auto& consumer_actor_id2ii_scale = PathIIScales4RegstDescId(regst_desc_id);
+      for (const auto& path : PathDurations4RegstDescId(regst_desc_id)) {
+        ii = std::max(ii, CalcII(path.second, pair.second.register_num(),
+                                 consumer_actor_id2ii_scale.at(path.first)));
+      }
+    }
+  }
+  return ii;
+}
+
+// Regsts whose producers waited for their consumers in the experiment run, the longest wait first
+void CollectStalledRegstNum(const Plan& plan,
+                            const std::list<std::unique_ptr<ActEvent>>& act_events,
+                            std::vector<std::pair<int64_t, int32_t>>* regst_desc_id7register_num) {
+  ActEventAnalyzer analyzer(plan, act_events);
+  analyzer.ForEachSuggestedRegstNum([&](int64_t regst_desc_id, int32_t register_num) {
+    regst_desc_id7register_num->emplace_back(regst_desc_id, register_num);
+  });
+  const auto& regst_desc_id2output_wait_time = analyzer.regst_desc_id2output_wait_time();
+  std::sort(regst_desc_id7register_num->begin(), regst_desc_id7register_num->end(),
+            [&](const std::pair<int64_t, int32_t>& lhs, const std::pair<int64_t, int32_t>& rhs) {
+              return regst_desc_id2output_wait_time.at(lhs.first)
+                     > regst_desc_id2output_wait_time.at(rhs.first);
+            });
+}
+
+void ReportRegstNumTuning(const Plan& plan,
+                          const std::vector<std::pair<int64_t, int32_t>>& raised_regst_desc_id7old,
+                          double experiment_ii, double improved_ii, double tuned_ii) {
+  HashMap<int64_t, std::pair<std::string, int32_t>> regst_desc_id2regst_key7register_num;
+  for (const auto& task_proto : plan.task()) {
+    for (const auto& pair : task_proto.produced_regst_desc()) {
+      regst_desc_id2regst_key7register_num.emplace(
+          pair.second.regst_desc_id(),
+          std::make_pair(RegstNumTuningUtil::RegstKey4RegstDesc(task_proto, pair.first),
+                         pair.second.register_num()));
+    }
+  }
+  std::ostringstream ss;
+  ss << "estimated ii (ms) of the experiment plan: " << experiment_ii / 1e6 << "\n";
+  ss << "estimated ii (ms) after improving: " << improved_ii / 1e6 << "\n";
+  ss << "estimated ii (ms) after tuning stalled regsts: " << tuned_ii / 1e6 << "\n";
+  if (tuned_ii > 0) {
+    ss << "estimated throughput gain over the experiment plan: "
+       << (experiment_ii / tuned_ii - 1) * 100 << "%\n";
+  }
+  ss << "\nregst_desc_id\timproved_register_num\ttuned_register_num\tregst\n";
+  for (const auto& pair : raised_regst_desc_id7old) {
+    const auto& regst_key7register_num = regst_desc_id2regst_key7register_num.at(pair.first);
+    ss << pair.first << "\t" << pair.second << "\t" << regst_key7register_num.second << "\t"
+       << regst_key7register_num.first << "\n";
+  }
+  TeePersistentLogStream::Create("regst_num_tuning")->Write(ss.str());
+}
+
 std::function<uint64_t(int64_t)> MakeGetterGetPlanRegstNum(Plan* plan) {
   auto MutRestDesc4Id = PlanUtil::MakeMutRegstDesc4Id(plan);
   return [MutRestDesc4Id](int64_t regst_desc_id) {
@@ -585,6 +671,41 @@ double Improver::CalcMaxRegstDescDuration(
   return max_duration;
 }
 
+void Improver::RaiseRegstNumOfStalledProducers(
+    const std::vector<std::pair<int64_t, int32_t>>& regst_desc_id7register_num, Plan* plan,
+    std::vector<std::pair<int64_t, int32_t>>* raised_regst_desc_id7register_num) const {
+  MemZoneRegstDescs mz_regst_descs;
+  MakeMemZoneRegstDescs(*plan, &mz_regst_descs);
+  std::vector<std::vector<uint64_t>> mz_mem_consumed(mz_regst_descs.size());
+  FOR_RANGE(int64_t, machine_id, 0, mz_regst_descs.size()) {
+    for (const auto& regst_descs : mz_regst_descs.at(machine_id)) {
+      mz_mem_consumed.at(machine_id).push_back(CalcMemoryConsumed(regst_descs));
+    }
+  }
+  HashMap<int64_t, int64_t> regst_desc_id2machine_id;
+  for (const auto& task_proto : plan->task()) {
+    for (const auto& pair : task_proto.produced_regst_desc()) {
+      regst_desc_id2machine_id.emplace(pair.second.regst_desc_id(), task_proto.machine_id());
+    }
+  }
+  const auto TryReserveMem = [&](const RegstDescProto& regst_desc, int32_t register_num) {
+    const int64_t machine_id = regst_desc_id2machine_id.at(regst_desc.regst_desc_id());
+    const int64_t mem_zone_id = GetMemoryZoneId(regst_desc.mem_case());
+    const uint64_t one_regst_byte_size = RtRegstDesc(regst_desc).MainByteSize4OneRegst();
+    const uint64_t extra_byte_size =
+        RoundUp(one_regst_byte_size * register_num, kCudaMemAllocAlignSize)
+        - RoundUp(one_regst_byte_size * regst_desc.register_num(), kCudaMemAllocAlignSize);
+    uint64_t* mem_consumed = &mz_mem_consumed.at(machine_id).at(mem_zone_id);
+    if (*mem_consumed + extra_byte_size >= AvailableMemSize(machine_id, mem_zone_id)) {
+      return false;
+    }
+    *mem_consumed += extra_byte_size;
+    return true;
+  };
+  RegstNumTuningUtil::RaiseRegstNum(regst_desc_id7register_num, TryReserveMem, plan,
+                                    raised_regst_desc_id7register_num);
+}
+
 Maybe<double> Improver::BinarySearchII(
     double base_ii,
     const std::function<const HashMap<int64_t, double>&(int64_t)>& PathDurations4RegstDescId,
@@ -694,6 +815,10 @@ Maybe<Plan> Improver::Improve(const AvailableMemDesc& amd, const Plan& naive_pla
   Init(amd, naive_plan);
   std::list<std::unique_ptr<ActEvent>> act_events;
   ParseActEvents(act_event_filepath, &act_events);
+  std::vector<std::pair<int64_t, int32_t>> stalled_regst_desc_id7register_num;
+  if (GlobalJobDesc().enable_regst_num_tuning()) {
+    CollectStalledRegstNum(naive_plan, act_events, &stalled_regst_desc_id7register_num);
+  }
   ChainActGraph chain_act_graph(naive_plan, std::move(act_events));
 
   auto PathDurations4RegstDescId = MakeGetterPathDurations4RegstDescId(chain_act_graph);
@@ -707,6 +832,20 @@ Maybe<Plan> Improver::Improve(const AvailableMemDesc& amd, const Plan& naive_pla
   Plan plan(complete_plan);
   JUST(ForEachImprovedRegstNum(complete_plan, true, base_ii, PathDurations4RegstDescId,
                                PathIIScales4RegstDescId, MakeSetterSetPlanRegstNum(&plan)));
+  estimated_ii_before_tuning_ =
+      CalcEstimatedII(naive_plan, base_ii, PathDurations4RegstDescId, PathIIScales4RegstDescId);
+  const double improved_ii =
+      CalcEstimatedII(plan, base_ii, PathDurations4RegstDescId, PathIIScales4RegstDescId);
+  // the act events show stalls the path durations miss, e.g. a producer blocked by a slow consumer
+  std::vector<std::pair<int64_t, int32_t>> raised_regst_desc_id7register_num;
+  RaiseRegstNumOfStalledProducers(stalled_regst_desc_id7register_num, &plan,
+                                  &raised_regst_desc_id7register_num);
+  estimated_ii_after_tuning_ =
+      CalcEstimatedII(plan, base_ii, PathDurations4RegstDescId, PathIIScales4RegstDescId);
+  if (GlobalJobDesc().enable_regst_num_tuning()) {
+    ReportRegstNumTuning(plan, raised_regst_desc_id7register_num, estimated_ii_before_tuning_,
+                         improved_ii, estimated_ii_after_tuning_);
+  }
   FixReliantCtrlRegstNum(plan, MakeGetterGetPlanRegstNum(&plan), MakeSetterSetPlanRegstNum(&plan));
   SetUniqueMemBlockId4UnreusedMemRegst(&plan);
   GenMemBlockAndChunk4Plan(&plan);
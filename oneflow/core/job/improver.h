@@ -27,12 +27,16 @@ namespace oneflow {
 class Improver final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(Improver);
-  Improver() : start_mem_block_id_(-1) {}
+  Improver()
+      : start_mem_block_id_(-1), estimated_ii_before_tuning_(0), estimated_ii_after_tuning_(0) {}
   ~Improver() = default;
 
   Maybe<Plan> Improve(const AvailableMemDesc& amd, const Plan& naive_plan,
                       const std::string& act_event_filepath);
   Maybe<Plan> GenAndInferMemBlockIdOnly(const AvailableMemDesc& amd, const Plan& naive_plan);
+  // ii of the experiment plan and the improved plan, estimated from the act events by Improve
+  double estimated_ii_before_tuning() const { return estimated_ii_before_tuning_; }
+  double estimated_ii_after_tuning() const { return estimated_ii_after_tuning_; }
 
  private:
   Plan GenAndInferMemBlockId(const Plan& naive_plan) const;
@@ -64,9 +68,14 @@ class Improver final {
   double CalcMaxRegstDescDuration(
       const std::function<const HashMap<int64_t, double>&(int64_t)>& Duration4RegstDescId,
       const MemZoneRegstDescs& mz_regst_descs) const;
+  void RaiseRegstNumOfStalledProducers(
+      const std::vector<std::pair<int64_t, int32_t>>& regst_desc_id7register_num, Plan* plan,
+      std::vector<std::pair<int64_t, int32_t>>* raised_regst_desc_id7register_num) const;
 
   int32_t start_mem_block_id_;
   AvailableMemDesc amd_;
+  double estimated_ii_before_tuning_;
+  double estimated_ii_after_tuning_;
 };
 
 }  // namespace oneflow
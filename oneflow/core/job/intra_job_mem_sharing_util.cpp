@@ -699,6 +699,7 @@ void IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(Plan* plan,
   }
 
   // step 3: choose best one for each mem chain and set offset for inplace consumer regst
+  size_t total_mem_block_size = 0;
   for (const auto& pair : mem_chain2algo2result) {
     const MemBlockResultInfo* best_result = nullptr;
     for (const auto& algo_result_pair : pair.second) {
@@ -707,6 +708,11 @@ void IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(Plan* plan,
       }
     }
     CHECK(best_result != nullptr);
+    // the peak memory of the activations of this chain
+    LOG(INFO) << "mem chain " << pair.first << " shares a mem block of "
+              << best_result->mem_block_size << " bytes among "
+              << mem_chain2mem_reused_regsts.at(pair.first).size() << " regsts";
+    total_mem_block_size += best_result->mem_block_size;
     int64_t mem_block_id = Global<IDMgr>::Get()->NewMemBlockId();
     CHECK_EQ(mem_chain2mem_reused_regsts.at(pair.first).size(),
              (best_result->regst_desc2offset.size()
@@ -728,6 +734,8 @@ void IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(Plan* plan,
       consumer_regst_desc->set_mem_block_offset(inplaced_regst_desc->mem_block_offset());
     }
   }
+  LOG(INFO) << "mem reused regsts of " << mem_chain2algo2result.size()
+            << " mem chains take " << total_mem_block_size << " bytes";
 }
 
 }  // namespace oneflow
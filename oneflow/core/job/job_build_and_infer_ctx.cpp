@@ -959,10 +959,13 @@ Maybe<void> LazyJobBuildAndInferCtx::Complete() {
     JUST(DoPass("AutoTrainStep"));
     JUST(DoPass("AutoLearningRate"));
     JUST(DoPass("QuantAwareTraining"));
+    JUST(DoPass("QuantizedInferenceLowering"));
+    JUST(DoPass("FoldNormalizationIntoConvPass"));
     JUST(DoPass("GenerateBackwardAndOptimizerOpConfs"));
     JUST(DoPass("AddSspVariableProxy"));
     JUST(DoPass("CheckpointingPass"));
     JUST(DoPass("CudnnFusedNormalizationAddReluPass"));
+    JUST(DoPass("CpuMaxPoolArgmaxPass"));
     JUST(DoPass("PruneCastToStaticShapeOpsPass"));
     JUST(DoPass("FuseAddToOutputPass"));
     JUST(DoPass("IndexedSlicesOptimizerRewritePass"));
@@ -970,8 +973,11 @@ Maybe<void> LazyJobBuildAndInferCtx::Complete() {
     JUST(DoPass("DoParallelCastBeforeWideningTypeCast"));
     JUST(DoPass("AddLbiDiffWatcherOpConfs"));
     JUST(DoPass("FuseCastScalePass"));
+    JUST(DoPass("FuseElementwisePass"));
     JUST(DoPass("PruneParallelCastOpsPass"));
+    JUST(DoPass("CpuGemmWeightPrepackPass"));
     JUST(DoPass("FuseUpdateOpsPass"));
+    JUST(DoPass("AutoParallelPass"));
     JUST(DoPass("DumpVariableInfoPass"));
   }
   JUST(DoPass("DumpTimeShapeAndBlobParallelConfPass"));
@@ -58,6 +58,12 @@ class JobDesc final {
     return job_conf_.use_memory_allocation_algorithm_v2();
   }
   bool enable_experiment_run() const;
+  bool enable_regst_num_tuning() const {
+    return job_conf_.exp_run_conf().enable_regst_num_tuning();
+  }
+  const std::string& regst_num_tuning_cache_dir() const {
+    return job_conf_.exp_run_conf().regst_num_tuning_cache_dir();
+  }
   bool enable_reuse_mem() const { return job_conf_.enable_reuse_mem(); }
   bool enable_inplace() const { return job_conf_.enable_inplace(); }
   bool enable_auto_mixed_precision() const { return job_conf_.enable_auto_mixed_precision(); }
@@ -24,11 +24,14 @@ limitations under the License.
 #include "oneflow/core/job/job_set.pb.h"
 #include "oneflow/core/job/machine_context.h"
 #include "oneflow/core/job/profiler.h"
+#include "oneflow/core/job/act_event_analyzer.h"
+#include "oneflow/core/job/regst_num_tuning_util.h"
 #include "oneflow/core/job/sub_plan.pb.h"
 #include "oneflow/core/job/plan.pb.h"
 #include "oneflow/core/job/available_memory_desc.pb.h"
 #include "oneflow/core/persistence/tee_persistent_log_stream.h"
 #include "oneflow/core/actor/act_event_logger.h"
+#include "oneflow/core/actor/act_event_tracer.h"
 #include "oneflow/core/job/oneflow.h"
 #include "oneflow/core/job/model_io_v2_job.h"
 #include "oneflow/core/job/model_io_job.h"
@@ -296,12 +299,20 @@ void GenCollectiveBoxingPlan(Job* job, Plan* plan) {
 
 Maybe<void> CompileCurJobOnMaster(Job* job, Plan* improved_plan, bool need_job_complete) {
   const JobDesc& job_desc = GlobalJobDesc();
+  const std::string& regst_num_tuning_cache_dir = job_desc.regst_num_tuning_cache_dir();
   Plan naive_plan;
   Plan complete_plan;
+  std::string job_fingerprint;
+  bool use_cached_regst_num = false;
   double start = GetCurTime();
   if (Global<MachineCtx>::Get()->IsThisMachineMaster()) {
     Compiler().Compile(job, &naive_plan, need_job_complete);
     LOG(INFO) << "compile time: " << GetCurTime() - start;
+    if (!regst_num_tuning_cache_dir.empty()) {
+      job_fingerprint = RegstNumTuningUtil::JobFingerprint(*job);
+      use_cached_regst_num = JUST(RegstNumTuningUtil::TryApplyCachedRegstNum(
+          regst_num_tuning_cache_dir, job_fingerprint, &naive_plan));
+    }
     complete_plan =
         *JUST(Improver().GenAndInferMemBlockIdOnly(*Global<AvailableMemDesc>::Get(), naive_plan));
     if (Global<ResourceDesc, ForSession>::Get()->enable_debug_mode()) {
@@ -310,7 +321,18 @@ Maybe<void> CompileCurJobOnMaster(Job* job, Plan* improved_plan, bool need_job_c
     }
     LOG(INFO) << "push_pull_plan:" << GetCurTime() - start;
   }
-  if (job_desc.enable_experiment_run()) {
+  if (job_desc.enable_experiment_run() && !regst_num_tuning_cache_dir.empty()) {
+    // the register_num cached by an earlier launch make the experiment run of all machines needless
+    const std::string key = "use_cached_regst_num_" + std::to_string(job_desc.job_id());
+    if (Global<MachineCtx>::Get()->IsThisMachineMaster()) {
+      Global<CtrlClient>::Get()->PushKVT(key, static_cast<int32_t>(use_cached_regst_num));
+    } else {
+      int32_t use_cached = 0;
+      Global<CtrlClient>::Get()->PullKVT(key, &use_cached);
+      use_cached_regst_num = (use_cached != 0);
+    }
+  }
+  if (job_desc.enable_experiment_run() && !use_cached_regst_num) {
     if (Global<MachineCtx>::Get()->IsThisMachineMaster()) {
       PushPlan("complete_plan", complete_plan);
     } else {
@@ -323,9 +345,21 @@ Maybe<void> CompileCurJobOnMaster(Job* job, Plan* improved_plan, bool need_job_c
     if (Global<MachineCtx>::Get()->IsThisMachineMaster()) {
       TeePersistentLogStream::Create("available_mem_desc")->Write(*Global<AvailableMemDesc>::Get());
       CHECK_GT(Global<AvailableMemDesc>::Get()->machine_amd_size(), 0);
-      *improved_plan = *JUST(Improver().Improve(
-          *Global<AvailableMemDesc>::Get(), naive_plan,
-          JoinPath(FLAGS_log_dir, ActEventLogger::experiment_act_event_bin_filename())));
+      const std::string act_event_filepath =
+          JoinPath(FLAGS_log_dir, ActEventLogger::experiment_act_event_bin_filename());
+      if (Global<const ProfilerConf>::Get()->collect_act_event()) {
+        std::list<std::unique_ptr<ActEvent>> act_events;
+        ParseActEvents(act_event_filepath, &act_events);
+        ActEventAnalyzer(complete_plan, act_events).Report("experiment_act_event_analysis");
+      }
+      Improver improver;
+      *improved_plan =
+          *JUST(improver.Improve(*Global<AvailableMemDesc>::Get(), naive_plan, act_event_filepath));
+      if (!regst_num_tuning_cache_dir.empty()) {
+        RegstNumTuningUtil::SaveTunedRegstNum(regst_num_tuning_cache_dir, job_fingerprint,
+                                              *improved_plan, improver.estimated_ii_before_tuning(),
+                                              improver.estimated_ii_after_tuning());
+      }
       OF_SESSION_BARRIER();
       TeePersistentLogStream::Create("improved_plan")->Write(*improved_plan);
     }
@@ -1005,9 +1039,15 @@ Maybe<void> Oneflow::Init(const oneflow::JobSet& job_set) {
 Oneflow::~Oneflow() {
   if (Global<MachineCtx>::Get()->IsThisMachineMaster()) { runtime_buffers_scope_.reset(); }
   runtime_.reset();
-  if (Global<Profiler>::Get() != nullptr) {
-    Global<Profiler>::Get()->Profile(
-        plan_, JoinPath(FLAGS_log_dir, ActEventLogger::act_event_bin_filename()));
+  if (Global<const ProfilerConf>::Get()->collect_act_event()) {
+    std::vector<ActRecord> act_records;
+    ParseActRecords(JoinPath(FLAGS_log_dir, ActEventTracer::act_record_bin_filename()),
+                    &act_records);
+    ExportActRecordsToChromeTrace(
+        plan_, act_records, JoinPath(FLAGS_log_dir, ActEventTracer::chrome_trace_filename()));
+    if (Global<Profiler>::Get() != nullptr) {
+      Global<Profiler>::Get()->Profile(plan_, act_records);
+    }
   }
 }
 
@@ -17,7 +17,6 @@ limitations under the License.
 #include "oneflow/core/job/job_desc.h"
 #include "oneflow/core/persistence/tee_persistent_log_stream.h"
 #include "oneflow/core/common/str_util.h"
-#include "oneflow/core/actor/act_event_logger.h"
 
 namespace oneflow {
 
@@ -49,21 +48,16 @@ class ActorProfileInfo {
 };
 }  // namespace
 
-void Profiler::Profile(const Plan& plan, const std::string& act_event_filepath) {
+void Profiler::Profile(const Plan& plan, const std::vector<ActRecord>& act_records) {
   HashMap<int64_t, TaskType> task_id2task_type;
   for (const TaskProto& task : plan.task()) {
     CHECK(task_id2task_type.emplace(task.task_id(), task.task_type()).second);
   }
 
-  std::list<std::unique_ptr<ActEvent>> act_events;
-  ParseActEvents(act_event_filepath, &act_events);
-
   HashMap<int64_t, std::vector<ActTimeInfo>> actor_id2act_time_info;
-  for (const auto& act_event : act_events) {
-    int64_t actor_id = act_event->actor_id();
-    ActTimeInfo act_time_info(
-        {act_event->ready_time(), act_event->start_time(), act_event->stop_time()});
-    actor_id2act_time_info[actor_id].emplace_back(act_time_info);
+  for (const ActRecord& act_record : act_records) {
+    ActTimeInfo act_time_info({act_record.ready_time, act_record.start_time, act_record.stop_time});
+    actor_id2act_time_info[act_record.actor_id].emplace_back(act_time_info);
   }
 
   using ProfileInfoPair = std::pair<int64_t, ActorProfileInfo>;
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/job/plan.pb.h"
+#include "oneflow/core/actor/act_event_tracer.h"
 
 namespace oneflow {
 
@@ -27,7 +28,7 @@ class Profiler final {
   Profiler() = default;
   ~Profiler() = default;
 
-  void Profile(const Plan& plan, const std::string& act_event_filepath);
+  void Profile(const Plan& plan, const std::vector<ActRecord>& act_records);
 
  private:
 };
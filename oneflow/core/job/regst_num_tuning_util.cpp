@@ -0,0 +1,137 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/regst_num_tuning_util.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/plan_util.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/common/protobuf.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/file_system.h"
+#include <iomanip>
+
+namespace oneflow {
+
+namespace {
+
+void ForEachKeyedRegstDesc(
+    const Plan& plan,
+    const std::function<void(const std::string&, const RegstDescProto&)>& Handler) {
+  // regsts that happen to share a key are left out, nothing tells them apart on the next launch
+  HashMap<std::string, std::vector<const RegstDescProto*>> regst_key2regst_descs;
+  for (const TaskProto& task : plan.task()) {
+    for (const auto& pair : task.produced_regst_desc()) {
+      const std::string key = RegstNumTuningUtil::RegstKey4RegstDesc(task, pair.first);
+      regst_key2regst_descs[key].push_back(&pair.second);
+    }
+  }
+  for (const auto& pair : regst_key2regst_descs) {
+    if (pair.second.size() == 1) { Handler(pair.first, *pair.second.front()); }
+  }
+}
+
+}  // namespace
+
+std::string RegstNumTuningUtil::JobFingerprint(const Job& job) {
+  const ResourceDesc* resource_desc = Global<ResourceDesc, ForSession>::Get();
+  const std::string str = PbMessage2TxtString(job) + PbMessage2TxtString(resource_desc->resource());
+  std::ostringstream ss;
+  // the fingerprint names a file reused by later launches, so std::hash would not do
+  ss << job.job_conf().job_name() << "-" << std::hex << std::setw(16) << std::setfill('0')
+     << StableHash(str);
+  return ss.str();
+}
+
+std::string RegstNumTuningUtil::RegstKey4RegstDesc(const TaskProto& task,
+                                                   const std::string& regst_name) {
+  std::string op_name;
+  if (task.exec_sequence().exec_node_size() > 0) {
+    op_name = task.exec_sequence().exec_node(0).kernel_conf().op_attribute().op_conf().name();
+  }
+  return TaskType_Name(task.task_type()) + ":" + op_name + ":" + regst_name + "@"
+         + std::to_string(task.machine_id()) + ":" + std::to_string(task.thrd_id());
+}
+
+std::string RegstNumTuningUtil::CacheFilePath(const std::string& cache_dir,
+                                              const std::string& fingerprint) {
+  return JoinPath(cache_dir, "tuned_regst_num_" + fingerprint + ".prototxt");
+}
+
+Maybe<bool> RegstNumTuningUtil::TryApplyCachedRegstNum(const std::string& cache_dir,
+                                                       const std::string& fingerprint,
+                                                       Plan* naive_plan) {
+  const std::string file_path = CacheFilePath(cache_dir, fingerprint);
+  if (!LocalFS()->FileExists(file_path)) { return false; }
+  TunedRegstNum tuned_regst_num;
+  CHECK_OR_RETURN(TryParseProtoFromTextFile(file_path, &tuned_regst_num))
+      << "failed to parse " << file_path;
+  if (tuned_regst_num.job_fingerprint() != fingerprint) { return false; }
+  const auto& regst_key2register_num = tuned_regst_num.regst_key2register_num();
+  HashMap<int64_t, int32_t> regst_desc_id2register_num;
+  ForEachKeyedRegstDesc(*naive_plan, [&](const std::string& key, const RegstDescProto& regst_desc) {
+    const auto it = regst_key2register_num.find(key);
+    if (it == regst_key2register_num.end()) { return; }
+    int32_t register_num = std::max(it->second, regst_desc.min_register_num());
+    register_num = std::min(register_num, regst_desc.max_register_num());
+    regst_desc_id2register_num.emplace(regst_desc.regst_desc_id(), register_num);
+  });
+  const auto MutRegstDesc4Id = PlanUtil::MakeMutRegstDesc4Id(naive_plan);
+  for (const auto& pair : regst_desc_id2register_num) {
+    MutRegstDesc4Id(pair.first)->set_register_num(pair.second);
+  }
+  LOG(INFO) << "applied " << regst_desc_id2register_num.size() << " of "
+            << regst_key2register_num.size() << " tuned register_num from " << file_path
+            << ", estimated ii " << tuned_regst_num.estimated_ii_before_tuning() << " -> "
+            << tuned_regst_num.estimated_ii_after_tuning();
+  return true;
+}
+
+void RegstNumTuningUtil::SaveTunedRegstNum(const std::string& cache_dir,
+                                           const std::string& fingerprint,
+                                           const Plan& improved_plan,
+                                           double estimated_ii_before_tuning,
+                                           double estimated_ii_after_tuning) {
+  TunedRegstNum tuned_regst_num;
+  tuned_regst_num.set_job_fingerprint(fingerprint);
+  tuned_regst_num.set_estimated_ii_before_tuning(estimated_ii_before_tuning);
+  tuned_regst_num.set_estimated_ii_after_tuning(estimated_ii_after_tuning);
+  auto* regst_key2register_num = tuned_regst_num.mutable_regst_key2register_num();
+  ForEachKeyedRegstDesc(improved_plan,
+                        [&](const std::string& key, const RegstDescProto& regst_desc) {
+                          (*regst_key2register_num)[key] = regst_desc.register_num();
+                        });
+  LocalFS()->RecursivelyCreateDirIfNotExist(cache_dir);
+  PrintProtoToTextFile(tuned_regst_num, CacheFilePath(cache_dir, fingerprint));
+}
+
+void RegstNumTuningUtil::RaiseRegstNum(
+    const std::vector<std::pair<int64_t, int32_t>>& regst_desc_id7register_num,
+    const std::function<bool(const RegstDescProto&, int32_t)>& TryReserveMem, Plan* plan,
+    std::vector<std::pair<int64_t, int32_t>>* raised_regst_desc_id7register_num) {
+  const auto MutRegstDesc4Id = PlanUtil::MakeMutRegstDesc4Id(plan);
+  for (const auto& pair : regst_desc_id7register_num) {
+    RegstDescProto* regst_desc = MutRegstDesc4Id(pair.first);
+    // regsts sharing memory with others keep a single register
+    if (regst_desc->mem_block_id() != -1) { continue; }
+    if (regst_desc->has_inplace_consumed_regst_desc_id()) { continue; }
+    const int32_t register_num = regst_desc->register_num();
+    if (pair.second <= register_num) { continue; }
+    if (!TryReserveMem(*regst_desc, pair.second)) { continue; }
+    regst_desc->set_register_num(pair.second);
+    raised_regst_desc_id7register_num->emplace_back(pair.first, register_num);
+  }
+}
+
+}  // namespace oneflow
@@ -0,0 +1,50 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_REGST_NUM_TUNING_UTIL_H_
+#define ONEFLOW_CORE_JOB_REGST_NUM_TUNING_UTIL_H_
+
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/job/job.pb.h"
+#include "oneflow/core/job/plan.pb.h"
+#include "oneflow/core/job/regst_num_tuning.pb.h"
+
+namespace oneflow {
+
+// The register_num tuned by Improver for a job are saved in a cache dir, keyed by a fingerprint of
+// the job and the resource. Regst desc ids change from launch to launch, so the regsts are keyed by
+// their producer ops and names instead.
+struct RegstNumTuningUtil {
+  static std::string JobFingerprint(const Job& job);
+  static std::string RegstKey4RegstDesc(const TaskProto& task, const std::string& regst_name);
+  static std::string CacheFilePath(const std::string& cache_dir, const std::string& fingerprint);
+  // Returns false if the cache dir has no tuned register_num of the job
+  static Maybe<bool> TryApplyCachedRegstNum(const std::string& cache_dir,
+                                            const std::string& fingerprint, Plan* naive_plan);
+  static void SaveTunedRegstNum(const std::string& cache_dir, const std::string& fingerprint,
+                                const Plan& improved_plan, double estimated_ii_before_tuning,
+                                double estimated_ii_after_tuning);
+  // Raises the register_num of the regsts to the given ones, except for regsts sharing memory with
+  // others and raises TryReserveMem refuses. The raised regsts are appended with their register_num
+  // before the raise.
+  static void RaiseRegstNum(
+      const std::vector<std::pair<int64_t, int32_t>>& regst_desc_id7register_num,
+      const std::function<bool(const RegstDescProto&, int32_t)>& TryReserveMem, Plan* plan,
+      std::vector<std::pair<int64_t, int32_t>>* raised_regst_desc_id7register_num);
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_REGST_NUM_TUNING_UTIL_H_
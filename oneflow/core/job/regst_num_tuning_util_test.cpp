@@ -0,0 +1,143 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/regst_num_tuning_util.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/file_system.h"
+#include <unistd.h>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+RegstDescProto* AddTaskWithRegst(Plan* plan, const std::string& op_name, int64_t regst_desc_id,
+                                 int32_t register_num, int32_t max_register_num) {
+  TaskProto* task = plan->add_task();
+  task->set_task_type(TaskType::kNormalForward);
+  task->set_machine_id(0);
+  task->set_thrd_id(1);
+  task->set_task_id(regst_desc_id);
+  task->mutable_exec_sequence()
+      ->add_exec_node()
+      ->mutable_kernel_conf()
+      ->mutable_op_attribute()
+      ->mutable_op_conf()
+      ->set_name(op_name);
+  RegstDescProto* regst_desc = &(*task->mutable_produced_regst_desc())["out"];
+  regst_desc->set_regst_desc_id(regst_desc_id);
+  regst_desc->set_producer_task_id(regst_desc_id);
+  regst_desc->set_min_register_num(1);
+  regst_desc->set_max_register_num(max_register_num);
+  regst_desc->set_register_num(register_num);
+  regst_desc->set_mem_block_id(-1);
+  return regst_desc;
+}
+
+int32_t RegisterNum4OpName(const Plan& plan, const std::string& op_name) {
+  for (const TaskProto& task : plan.task()) {
+    const auto& exec_node = task.exec_sequence().exec_node(0);
+    if (exec_node.kernel_conf().op_attribute().op_conf().name() == op_name) {
+      return task.produced_regst_desc().at("out").register_num();
+    }
+  }
+  return -1;
+}
+
+std::string TmpCacheDir() { return "/tmp/regst_num_tuning_util_test_" + std::to_string(getpid()); }
+
+}  // namespace
+
+TEST(RegstNumTuningUtil, stable_hash) {
+  ASSERT_EQ(StableHash(""), 14695981039346656037ULL);
+  ASSERT_EQ(StableHash("a"), 0xaf63dc4c8601ec8cULL);
+}
+
+TEST(RegstNumTuningUtil, job_fingerprint) {
+  Resource resource;
+  resource.set_machine_num(1);
+  resource.set_gpu_device_num(1);
+  Global<ResourceDesc, ForSession>::New(resource);
+  Job job;
+  job.mutable_job_conf()->set_job_name("train");
+  const std::string fingerprint = RegstNumTuningUtil::JobFingerprint(job);
+  ASSERT_EQ(fingerprint.size(), std::string("train-").size() + 16);
+  ASSERT_EQ(fingerprint.substr(0, 6), "train-");
+  ASSERT_EQ(RegstNumTuningUtil::JobFingerprint(job), fingerprint);
+  job.mutable_job_conf()->set_total_batch_num(2);
+  ASSERT_NE(RegstNumTuningUtil::JobFingerprint(job), fingerprint);
+  Global<ResourceDesc, ForSession>::Delete();
+}
+
+TEST(RegstNumTuningUtil, raise_regst_num) {
+  Plan plan;
+  AddTaskWithRegst(&plan, "a", 1, 1, 4);
+  AddTaskWithRegst(&plan, "b", 2, 1, 4)->set_mem_block_id(7);
+  AddTaskWithRegst(&plan, "c", 3, 1, 4)->set_inplace_consumed_regst_desc_id(1);
+  AddTaskWithRegst(&plan, "d", 4, 3, 4);
+  AddTaskWithRegst(&plan, "e", 5, 1, 4);
+  std::vector<std::pair<int64_t, int32_t>> raised;
+  RegstNumTuningUtil::RaiseRegstNum(
+      {{1, 3}, {2, 3}, {3, 3}, {4, 2}, {5, 3}},
+      [](const RegstDescProto& regst_desc, int32_t) { return regst_desc.regst_desc_id() != 5; },
+      &plan, &raised);
+  ASSERT_EQ(RegisterNum4OpName(plan, "a"), 3);
+  ASSERT_EQ(RegisterNum4OpName(plan, "b"), 1);
+  ASSERT_EQ(RegisterNum4OpName(plan, "c"), 1);
+  ASSERT_EQ(RegisterNum4OpName(plan, "d"), 3);
+  ASSERT_EQ(RegisterNum4OpName(plan, "e"), 1);
+  ASSERT_EQ(raised.size(), 1);
+  ASSERT_EQ(raised.at(0).first, 1);
+  ASSERT_EQ(raised.at(0).second, 1);
+}
+
+TEST(RegstNumTuningUtil, cache_round_trip) {
+  const std::string cache_dir = TmpCacheDir();
+  Plan improved_plan;
+  AddTaskWithRegst(&improved_plan, "conv", 5, 4, 4);
+  AddTaskWithRegst(&improved_plan, "fc", 6, 3, 4);
+  RegstNumTuningUtil::SaveTunedRegstNum(cache_dir, "job-0", improved_plan, 20, 10);
+
+  // regst desc ids differ on the next launch
+  Plan naive_plan;
+  AddTaskWithRegst(&naive_plan, "conv", 50, 1, 3);
+  AddTaskWithRegst(&naive_plan, "fc", 60, 1, 4);
+  AddTaskWithRegst(&naive_plan, "relu", 70, 1, 4);
+  ASSERT_TRUE(CHECK_JUST(
+      RegstNumTuningUtil::TryApplyCachedRegstNum(cache_dir, "job-0", &naive_plan)));
+  ASSERT_EQ(RegisterNum4OpName(naive_plan, "conv"), 3);
+  ASSERT_EQ(RegisterNum4OpName(naive_plan, "fc"), 3);
+  ASSERT_EQ(RegisterNum4OpName(naive_plan, "relu"), 1);
+
+  Plan other_plan;
+  AddTaskWithRegst(&other_plan, "conv", 50, 1, 3);
+  ASSERT_FALSE(CHECK_JUST(
+      RegstNumTuningUtil::TryApplyCachedRegstNum(cache_dir, "job-1", &other_plan)));
+  ASSERT_EQ(RegisterNum4OpName(other_plan, "conv"), 1);
+  // a file whose content belongs to another fingerprint is not applied either
+  LocalFS()->RenameFile(RegstNumTuningUtil::CacheFilePath(cache_dir, "job-0"),
+                        RegstNumTuningUtil::CacheFilePath(cache_dir, "job-1"));
+  ASSERT_FALSE(CHECK_JUST(
+      RegstNumTuningUtil::TryApplyCachedRegstNum(cache_dir, "job-1", &other_plan)));
+  ASSERT_EQ(RegisterNum4OpName(other_plan, "conv"), 1);
+  LocalFS()->RecursivelyDeleteDir(cache_dir);
+}
+
+}  // namespace test
+
+}  // namespace oneflow
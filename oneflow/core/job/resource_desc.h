@@ -48,11 +48,19 @@ class ResourceDesc final {
   bool thread_enable_local_message_queue() const {
     return resource_.thread_enable_local_message_queue();
   }
+  bool thread_enable_busy_poll() const { return resource_.thread_enable_busy_poll(); }
+  int64_t thread_busy_poll_max_spin_us() const { return resource_.thread_busy_poll_max_spin_us(); }
+  bool thread_enable_wake_latency_histogram() const {
+    return resource_.thread_enable_wake_latency_histogram();
+  }
   bool enable_thread_local_cache() const { return resource_.enable_thread_local_cache(); }
   size_t thread_local_cache_max_size() const { return resource_.thread_local_cache_max_size(); }
   int32_t ComputeThreadPoolSize() const;
   bool enable_debug_mode() const;
   CollectiveBoxingConf collective_boxing_conf() const;
+  const ThreadAffinityConf& thread_affinity_conf() const {
+    return resource_.thread_affinity_conf();
+  }
 
   void SetMachineNum(int32_t val) { resource_.set_machine_num(val); }
   void SetCpuDeviceNum(int32_t val) { resource_.set_cpu_device_num(val); }
@@ -24,6 +24,8 @@ limitations under the License.
 #include "oneflow/core/job/runtime_job_descs.h"
 #include "oneflow/core/thread/thread_manager.h"
 #include "oneflow/core/actor/act_event_logger.h"
+#include "oneflow/core/actor/act_event_tracer.h"
+#include "oneflow/core/actor/boxing_traffic_counter.h"
 #include "oneflow/core/graph/task_node.h"
 #include "oneflow/core/device/cuda_util.h"
 #include "oneflow/core/memory/memory_allocator.h"
@@ -96,9 +98,14 @@ Runtime::~Runtime() {
 
 void Runtime::NewAllGlobal(const Plan& plan, size_t total_piece_num, bool is_experiment_phase) {
   Global<RuntimeCtx>::New(total_piece_num, is_experiment_phase);
-  if (Global<MachineCtx>::Get()->IsThisMachineMaster()
-      && Global<RuntimeCtx>::Get()->NeedCollectActEvent()) {
-    Global<ActEventLogger>::New(is_experiment_phase);
+  if (is_experiment_phase) {
+    if (Global<MachineCtx>::Get()->IsThisMachineMaster()) {
+      Global<ActEventLogger>::New(is_experiment_phase);
+    }
+  } else if (Global<RuntimeCtx>::Get()->NeedCollectActEvent()) {
+    const ProfilerConf& profiler_conf = *Global<const ProfilerConf>::Get();
+    Global<ActEventTracer>::New(profiler_conf.act_event_sample_interval(),
+                                profiler_conf.act_event_buffer_size());
   }
   // TODO(chengcheng)
   // this code should be called before Runtime::NewAllGlobal, maybe after Eager ENV init
@@ -123,6 +130,9 @@ void Runtime::NewAllGlobal(const Plan& plan, size_t total_piece_num, bool is_exp
     }
 #endif
   }
+  if (Global<ResourceDesc, ForSession>::Get()->enable_debug_mode()) {
+    Global<BoxingTrafficCounter>::New();
+  }
   Global<boxing::collective::CollectiveBoxingExecutor>::New(plan);
   Global<MemoryAllocator>::New();
   Global<RegstMgr>::New(plan);
@@ -167,6 +177,14 @@ void Runtime::DeleteAllGlobal() {
   }
 
   Global<ActEventLogger>::Delete();
+  if (Global<ActEventTracer>::Get() != nullptr) {
+    Global<ActEventTracer>::Get()->DumpToLogDir();
+    Global<ActEventTracer>::Delete();
+  }
+  if (Global<BoxingTrafficCounter>::Get() != nullptr) {
+    Global<BoxingTrafficCounter>::Get()->DumpToLogDir();
+    Global<BoxingTrafficCounter>::Delete();
+  }
   Global<RuntimeCtx>::Delete();
   Global<summary::EventsWriter>::Delete();
 }
@@ -0,0 +1,150 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/auto_checkpointing_planner.h"
+
+namespace oneflow {
+
+int64_t AutoCheckpointingPlanner::AddBlob(int64_t byte_size, bool is_read_by_backward) {
+  CHECK_GE(byte_size, 0);
+  BlobInfo blob;
+  blob.byte_size = byte_size;
+  blob.is_read_by_backward = is_read_by_backward;
+  blob.producer_op_id = -1;
+  blobs_.push_back(blob);
+  return blobs_.size() - 1;
+}
+
+int64_t AutoCheckpointingPlanner::AddOp(RecomputePolicy policy, double cost,
+                                        const std::vector<int64_t>& in_blob_ids,
+                                        const std::vector<int64_t>& out_blob_ids) {
+  const int64_t op_id = ops_.size();
+  OpInfo op;
+  op.policy = policy;
+  op.cost = cost;
+  // an op may read the same blob more than once
+  op.in_blob_ids = in_blob_ids;
+  std::sort(op.in_blob_ids.begin(), op.in_blob_ids.end());
+  op.in_blob_ids.erase(std::unique(op.in_blob_ids.begin(), op.in_blob_ids.end()),
+                       op.in_blob_ids.end());
+  op.out_blob_ids = out_blob_ids;
+  for (int64_t blob_id : op.in_blob_ids) {
+    CHECK_LT(blob_id, static_cast<int64_t>(blobs_.size()));
+    blobs_.at(blob_id).consumer_op_ids.push_back(op_id);
+  }
+  for (int64_t blob_id : op.out_blob_ids) {
+    CHECK_LT(blob_id, static_cast<int64_t>(blobs_.size()));
+    CHECK_EQ(blobs_.at(blob_id).producer_op_id, -1);
+    blobs_.at(blob_id).producer_op_id = op_id;
+  }
+  ops_.push_back(op);
+  return op_id;
+}
+
+bool AutoCheckpointingPlanner::IsKept(int64_t blob_id,
+                                      const std::vector<bool>& is_recomputed) const {
+  const BlobInfo& blob = blobs_.at(blob_id);
+  if (blob.producer_op_id != -1 && is_recomputed.at(blob.producer_op_id)) { return false; }
+  if (blob.is_read_by_backward) { return true; }
+  for (int64_t op_id : blob.consumer_op_ids) {
+    if (is_recomputed.at(op_id)) { return true; }
+  }
+  return false;
+}
+
+int64_t AutoCheckpointingPlanner::KeptBytes(const std::vector<bool>& is_recomputed) const {
+  int64_t kept_bytes = 0;
+  FOR_RANGE(int64_t, blob_id, 0, blobs_.size()) {
+    if (IsKept(blob_id, is_recomputed)) { kept_bytes += blobs_.at(blob_id).byte_size; }
+  }
+  return kept_bytes;
+}
+
+int64_t AutoCheckpointingPlanner::SavedBytes(int64_t op_id,
+                                             const std::vector<bool>& is_recomputed) const {
+  const OpInfo& op = ops_.at(op_id);
+  int64_t saved_bytes = 0;
+  for (int64_t blob_id : op.out_blob_ids) {
+    if (IsKept(blob_id, is_recomputed)) { saved_bytes += blobs_.at(blob_id).byte_size; }
+  }
+  for (int64_t blob_id : op.in_blob_ids) {
+    const int64_t producer_op_id = blobs_.at(blob_id).producer_op_id;
+    if (producer_op_id != -1 && is_recomputed.at(producer_op_id)) { continue; }
+    if (!IsKept(blob_id, is_recomputed)) { saved_bytes -= blobs_.at(blob_id).byte_size; }
+  }
+  return saved_bytes;
+}
+
+void AutoCheckpointingPlanner::Plan(int64_t memory_budget, std::vector<int64_t>* recomputed_op_ids,
+                                    AutoCheckpointingReport* report) const {
+  CHECK_GE(memory_budget, 0);
+  std::vector<bool> is_recomputed(ops_.size(), false);
+  *report = AutoCheckpointingReport();
+  report->kept_bytes_before = KeptBytes(is_recomputed);
+  FOR_RANGE(int64_t, op_id, 0, ops_.size()) {
+    report->forward_cost += ops_.at(op_id).cost;
+    if (ops_.at(op_id).policy == kAlwaysRecompute) { is_recomputed.at(op_id) = true; }
+  }
+  int64_t kept_bytes = KeptBytes(is_recomputed);
+  // only the ops sharing a blob with the last recomputed op need their saved bytes updated
+  std::vector<int64_t> op_id2saved_bytes(ops_.size(), 0);
+  FOR_RANGE(int64_t, op_id, 0, ops_.size()) {
+    if (ops_.at(op_id).policy == kMayRecompute) {
+      op_id2saved_bytes.at(op_id) = SavedBytes(op_id, is_recomputed);
+    }
+  }
+  while (memory_budget == 0 || kept_bytes > memory_budget) {
+    int64_t best_op_id = -1;
+    double best_saved_bytes_per_cost = 0;
+    FOR_RANGE(int64_t, op_id, 0, ops_.size()) {
+      if (ops_.at(op_id).policy != kMayRecompute || is_recomputed.at(op_id)) { continue; }
+      if (op_id2saved_bytes.at(op_id) <= 0) { continue; }
+      const double saved_bytes_per_cost =
+          op_id2saved_bytes.at(op_id) / std::max(ops_.at(op_id).cost, 1.0);
+      if (best_op_id == -1 || saved_bytes_per_cost > best_saved_bytes_per_cost) {
+        best_op_id = op_id;
+        best_saved_bytes_per_cost = saved_bytes_per_cost;
+      }
+    }
+    if (best_op_id == -1) { break; }
+    kept_bytes -= op_id2saved_bytes.at(best_op_id);
+    is_recomputed.at(best_op_id) = true;
+    const OpInfo& best_op = ops_.at(best_op_id);
+    HashSet<int64_t> affected_op_ids;
+    for (const auto* blob_ids : {&best_op.in_blob_ids, &best_op.out_blob_ids}) {
+      for (int64_t blob_id : *blob_ids) {
+        const BlobInfo& blob = blobs_.at(blob_id);
+        if (blob.producer_op_id != -1) { affected_op_ids.insert(blob.producer_op_id); }
+        affected_op_ids.insert(blob.consumer_op_ids.begin(), blob.consumer_op_ids.end());
+      }
+    }
+    for (int64_t op_id : affected_op_ids) {
+      if (ops_.at(op_id).policy == kMayRecompute && !is_recomputed.at(op_id)) {
+        op_id2saved_bytes.at(op_id) = SavedBytes(op_id, is_recomputed);
+      }
+    }
+  }
+  CHECK_EQ(kept_bytes, KeptBytes(is_recomputed));
+  recomputed_op_ids->clear();
+  FOR_RANGE(int64_t, op_id, 0, ops_.size()) {
+    if (!is_recomputed.at(op_id)) { continue; }
+    recomputed_op_ids->push_back(op_id);
+    report->recompute_cost += ops_.at(op_id).cost;
+  }
+  report->kept_bytes_after = kept_bytes;
+  report->recomputed_op_num = recomputed_op_ids->size();
+}
+
+}  // namespace oneflow
@@ -0,0 +1,80 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_REWRITER_AUTO_CHECKPOINTING_PLANNER_H_
+#define ONEFLOW_CORE_JOB_REWRITER_AUTO_CHECKPOINTING_PLANNER_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+enum RecomputePolicy { kNeverRecompute = 0, kMayRecompute = 1, kAlwaysRecompute = 2 };
+
+// Byte sizes are per device and costs are in flops
+struct AutoCheckpointingReport {
+  // activations of the forward pass which are kept alive until the backward pass reads them
+  int64_t kept_bytes_before = 0;
+  int64_t kept_bytes_after = 0;
+  double forward_cost = 0;
+  double recompute_cost = 0;
+  int64_t recomputed_op_num = 0;
+};
+
+// Chooses the forward ops whose outputs are dropped after the forward pass and recomputed for the
+// backward pass. A blob is kept until the backward pass if its producer is not recomputed and it
+// is either read by the backward pass or read by a recomputed op. The ops are added greedily by
+// the bytes they save per flop they add until the kept bytes fit the memory budget.
+class AutoCheckpointingPlanner final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(AutoCheckpointingPlanner);
+  AutoCheckpointingPlanner() = default;
+  ~AutoCheckpointingPlanner() = default;
+
+  // Returns the id of the new blob
+  int64_t AddBlob(int64_t byte_size, bool is_read_by_backward);
+  // Returns the id of the new op, each blob has at most one producer
+  int64_t AddOp(RecomputePolicy policy, double cost, const std::vector<int64_t>& in_blob_ids,
+                const std::vector<int64_t>& out_blob_ids);
+
+  // A memory_budget of 0 recomputes every op which reduces the kept bytes
+  void Plan(int64_t memory_budget, std::vector<int64_t>* recomputed_op_ids,
+            AutoCheckpointingReport* report) const;
+
+ private:
+  struct BlobInfo {
+    int64_t byte_size;
+    bool is_read_by_backward;
+    int64_t producer_op_id;
+    std::vector<int64_t> consumer_op_ids;
+  };
+  struct OpInfo {
+    RecomputePolicy policy;
+    double cost;
+    std::vector<int64_t> in_blob_ids;
+    std::vector<int64_t> out_blob_ids;
+  };
+
+  bool IsKept(int64_t blob_id, const std::vector<bool>& is_recomputed) const;
+  int64_t KeptBytes(const std::vector<bool>& is_recomputed) const;
+  // the kept bytes which are freed minus the kept bytes which are added if op_id is recomputed
+  int64_t SavedBytes(int64_t op_id, const std::vector<bool>& is_recomputed) const;
+
+  std::vector<BlobInfo> blobs_;
+  std::vector<OpInfo> ops_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_REWRITER_AUTO_CHECKPOINTING_PLANNER_H_
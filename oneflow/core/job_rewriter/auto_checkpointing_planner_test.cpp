@@ -0,0 +1,89 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/auto_checkpointing_planner.h"
+
+namespace oneflow {
+
+namespace {
+
+// x -> conv -> y0 -> relu -> y1 -> relu -> y2, every blob is read by the backward pass
+void BuildConvReluChain(AutoCheckpointingPlanner* planner) {
+  int64_t x = planner->AddBlob(100, true);
+  int64_t y0 = planner->AddBlob(100, true);
+  int64_t y1 = planner->AddBlob(100, true);
+  int64_t y2 = planner->AddBlob(100, true);
+  planner->AddOp(kMayRecompute, 1000, {x}, {y0});
+  planner->AddOp(kMayRecompute, 10, {y0}, {y1});
+  planner->AddOp(kMayRecompute, 10, {y1}, {y2});
+}
+
+}  // namespace
+
+TEST(AutoCheckpointingPlanner, recompute_all_beneficial) {
+  AutoCheckpointingPlanner planner;
+  BuildConvReluChain(&planner);
+  std::vector<int64_t> recomputed_op_ids;
+  AutoCheckpointingReport report;
+  planner.Plan(0, &recomputed_op_ids, &report);
+  ASSERT_EQ(recomputed_op_ids, std::vector<int64_t>({0, 1, 2}));
+  ASSERT_EQ(report.kept_bytes_before, 400);
+  ASSERT_EQ(report.kept_bytes_after, 100);
+  ASSERT_EQ(report.recomputed_op_num, 3);
+  ASSERT_DOUBLE_EQ(report.forward_cost, 1020);
+  ASSERT_DOUBLE_EQ(report.recompute_cost, 1020);
+}
+
+TEST(AutoCheckpointingPlanner, cheap_ops_first) {
+  AutoCheckpointingPlanner planner;
+  BuildConvReluChain(&planner);
+  std::vector<int64_t> recomputed_op_ids;
+  AutoCheckpointingReport report;
+  planner.Plan(250, &recomputed_op_ids, &report);
+  ASSERT_EQ(recomputed_op_ids, std::vector<int64_t>({1, 2}));
+  ASSERT_EQ(report.kept_bytes_after, 200);
+  ASSERT_DOUBLE_EQ(report.recompute_cost, 20);
+}
+
+TEST(AutoCheckpointingPlanner, never_keep_more) {
+  AutoCheckpointingPlanner planner;
+  // the big input is only read in the forward pass, recomputing the op would keep it alive
+  int64_t x = planner.AddBlob(1000, false);
+  int64_t y = planner.AddBlob(10, true);
+  planner.AddOp(kMayRecompute, 1, {x, x}, {y});
+  std::vector<int64_t> recomputed_op_ids;
+  AutoCheckpointingReport report;
+  planner.Plan(0, &recomputed_op_ids, &report);
+  ASSERT_TRUE(recomputed_op_ids.empty());
+  ASSERT_EQ(report.kept_bytes_after, 10);
+}
+
+TEST(AutoCheckpointingPlanner, policy) {
+  AutoCheckpointingPlanner planner;
+  int64_t x = planner.AddBlob(100, true);
+  int64_t y0 = planner.AddBlob(100, true);
+  int64_t y1 = planner.AddBlob(100, true);
+  planner.AddOp(kNeverRecompute, 1, {x}, {y0});
+  planner.AddOp(kAlwaysRecompute, 1, {y0}, {y1});
+  std::vector<int64_t> recomputed_op_ids;
+  AutoCheckpointingReport report;
+  // the budget is not reachable since the random op 0 must not be recomputed
+  planner.Plan(50, &recomputed_op_ids, &report);
+  ASSERT_EQ(recomputed_op_ids, std::vector<int64_t>({1}));
+  ASSERT_EQ(report.kept_bytes_before, 300);
+  ASSERT_EQ(report.kept_bytes_after, 200);
+}
+
+}  // namespace oneflow
@@ -0,0 +1,382 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <sstream>
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/job_rewriter/auto_parallel_searcher.h"
+#include "oneflow/core/job_rewriter/pass_util.h"
+#include "oneflow/core/graph/boxing/boxing_cost.h"
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/job/sbp_parallel.h"
+#include "oneflow/core/persistence/tee_persistent_log_stream.h"
+
+namespace oneflow {
+
+namespace {
+
+// Rough throughputs of the devices, only their ratios to the bandwidths of boxing_cost.h matter for
+// the search
+const double kGpuFlopsPerSecond = 1e13;
+const double kCpuFlopsPerSecond = 1e11;
+const int32_t kMaxSearchRoundNum = 16;
+
+struct SbpCandidate {
+  SbpSignature sbp_signature;
+  double compute_time;
+  double memory_time;
+};
+
+struct BoxingEdge {
+  int64_t src_node_id;
+  int64_t dst_node_id;
+  std::vector<double> candidate_pair2bytes;
+  std::vector<double> candidate_pair2time;
+};
+
+struct PlanCost {
+  double compute_time = 0;
+  double memory_time = 0;
+  double boxing_time = 0;
+  // sent to each device of the consumers
+  double boxing_bytes = 0;
+  double step_time() const { return compute_time + memory_time + boxing_time; }
+};
+
+// The greedy inference of OpGraph picks the signature of each op from the signatures of its
+// producers. This pass estimates the step time of the whole job for the signatures of every op
+// and searches the signatures with AutoParallelSearcher. The plan is only taken if it is
+// estimated to be faster than the greedy one, by fixing the signatures in the job parallel view
+// conf.
+class AutoParallelPass final : public JobPass {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(AutoParallelPass);
+  AutoParallelPass() = default;
+  ~AutoParallelPass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    return ctx.job_desc().job_conf().enable_auto_parallel();
+  }
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, &job_builder);
+  }
+
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+};
+
+double FlopsPerSecond(const ParallelDesc& parallel_desc) {
+  return parallel_desc.device_type() == DeviceType::kGPU ? kGpuFlopsPerSecond : kCpuFlopsPerSecond;
+}
+
+double BoxingBytesPerSecond4ParallelDescs(const ParallelDesc& src_parallel_desc,
+                                          const ParallelDesc& dst_parallel_desc) {
+  HashSet<int64_t> machine_ids(src_parallel_desc.sorted_machine_ids().begin(),
+                               src_parallel_desc.sorted_machine_ids().end());
+  machine_ids.insert(dst_parallel_desc.sorted_machine_ids().begin(),
+                     dst_parallel_desc.sorted_machine_ids().end());
+  return BoxingBytesPerSecond(machine_ids.size() > 1);
+}
+
+double LogicalByteSize(const BlobDesc& logical_blob_desc) {
+  return static_cast<double>(logical_blob_desc.shape().elem_cnt())
+         * GetSizeOfDataType(logical_blob_desc.data_type());
+}
+
+double ByteSizePerDevice(const BlobDesc& logical_blob_desc, const SbpParallel& sbp_parallel,
+                         int64_t parallel_num) {
+  const double byte_size = LogicalByteSize(logical_blob_desc);
+  return sbp_parallel.has_split_parallel() ? byte_size / parallel_num : byte_size;
+}
+
+// bytes received by each consumer device, e.g. 2 * (n - 1) / n of the blob for an all-reduce
+double BoxingBytes(const BlobDesc& logical_blob_desc, const SbpParallel& src_sbp_parallel,
+                   const ParallelDesc& src_parallel_desc, const SbpParallel& dst_sbp_parallel,
+                   const ParallelDesc& dst_parallel_desc) {
+  const double byte_size = LogicalByteSize(logical_blob_desc);
+  if (src_parallel_desc == dst_parallel_desc) {
+    if (src_sbp_parallel == dst_sbp_parallel) { return 0; }
+    // the consumers can not get a partial sum out of a boxing
+    if (dst_sbp_parallel.has_partial_sum_parallel()) {
+      return std::numeric_limits<double>::infinity();
+    }
+    if (src_sbp_parallel.has_broadcast_parallel()) { return 0; }
+    const int64_t parallel_num = dst_parallel_desc.parallel_num();
+    const double remote_ratio = static_cast<double>(parallel_num - 1) / parallel_num;
+    if (src_sbp_parallel.has_split_parallel()) {
+      if (dst_sbp_parallel.has_broadcast_parallel()) { return byte_size * remote_ratio; }
+      return byte_size / parallel_num * remote_ratio;
+    }
+    CHECK(src_sbp_parallel.has_partial_sum_parallel());
+    if (dst_sbp_parallel.has_broadcast_parallel()) { return 2 * byte_size * remote_ratio; }
+    return byte_size * remote_ratio;
+  }
+  if (dst_sbp_parallel.has_partial_sum_parallel()) {
+    return std::numeric_limits<double>::infinity();
+  }
+  double bytes = dst_sbp_parallel.has_split_parallel()
+                     ? byte_size / dst_parallel_desc.parallel_num()
+                     : byte_size;
+  if (src_sbp_parallel.has_partial_sum_parallel()) { bytes *= src_parallel_desc.parallel_num(); }
+  return bytes;
+}
+
+bool IsSbpSignatureSearchable(const OpNode* op_node, const HashSet<std::string>& fixed_op_names) {
+  const Operator& op = op_node->op();
+  if (op_node->parallel_desc().parallel_num() <= 1) { return false; }
+  if (!op.op_conf().has_user_conf()) { return false; }
+  if (fixed_op_names.find(op.op_name()) != fixed_op_names.end()) { return false; }
+  const std::string& op_type_name = op.op_conf().user_conf().op_type_name();
+  const auto* op_reg_result = user_op::UserOpRegistryMgr::Get().GetOpRegistryResult(op_type_name);
+  if (op_reg_result == nullptr || op_reg_result->infer_sbp_signature_fn) { return false; }
+  for (const auto* bns : {&op.input_bns(), &op.output_bns()}) {
+    for (const std::string& bn : *bns) {
+      if (CHECK_JUST(op.OptMirroredParallel4BnInOp(bn))->has_mirrored_parallel()) { return false; }
+    }
+  }
+  // e.g. the model update ops, which have to write into the variable itself instead of a boxed
+  // slice of it
+  for (const std::string& ibn : op.input_bns()) {
+    if (op.InputBlobModifier4Ibn(ibn).is_mutable()) { return false; }
+  }
+  return true;
+}
+
+bool IsSbpSignatureApplicable(const OpNode* op_node, const SbpSignature& sbp_signature) {
+  const Operator& op = op_node->op();
+  const auto& bn2sbp = sbp_signature.bn_in_op2sbp_parallel();
+  const int64_t parallel_num = op_node->parallel_desc().parallel_num();
+  for (const auto* bns : {&op.input_bns(), &op.output_bns()}) {
+    for (const std::string& bn : *bns) {
+      const auto it = bn2sbp.find(bn);
+      if (it == bn2sbp.end()) { return false; }
+      if (!it->second.has_split_parallel()) { continue; }
+      const Shape& shape = op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(bn)).shape();
+      const int64_t axis = it->second.split_parallel().axis();
+      if (axis >= shape.NumAxes() || shape.At(axis) < parallel_num) { return false; }
+    }
+  }
+  return true;
+}
+
+SbpCandidate MakeSbpCandidate(const OpNode* op_node, const SbpSignature& sbp_signature,
+                              double flops) {
+  const Operator& op = op_node->op();
+  const ParallelDesc& parallel_desc = op_node->parallel_desc();
+  const int64_t parallel_num = parallel_desc.parallel_num();
+  SbpCandidate candidate;
+  candidate.sbp_signature = sbp_signature;
+  // the work is divided among the devices unless every blob is broadcast
+  bool is_work_divided = false;
+  double bytes = 0;
+  for (const auto* bns : {&op.input_bns(), &op.output_bns()}) {
+    for (const std::string& bn : *bns) {
+      const SbpParallel& sbp_parallel = sbp_signature.bn_in_op2sbp_parallel().at(bn);
+      if (!sbp_parallel.has_broadcast_parallel()) { is_work_divided = true; }
+      bytes += ByteSizePerDevice(op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(bn)), sbp_parallel,
+                                 parallel_num);
+    }
+  }
+  candidate.compute_time =
+      flops / (is_work_divided ? parallel_num : 1) / FlopsPerSecond(parallel_desc);
+  candidate.memory_time = bytes / MemoryBytesPerSecond(parallel_desc.device_type());
+  return candidate;
+}
+
+// The first candidate is the signature of the greedy inference
+Maybe<void> GenSbpCandidates(const OpNode* op_node, bool is_searchable,
+                             std::vector<SbpCandidate>* candidates) {
+  const Operator& op = op_node->op();
+  const SbpSignature& greedy_sbp_signature = op_node->sbp_signature();
+  const double flops = LogicalFlops4OpNode(op_node);
+  candidates->push_back(MakeSbpCandidate(op_node, greedy_sbp_signature, flops));
+  if (!is_searchable) { return Maybe<void>::Ok(); }
+  const auto LogicalBlobDesc4Ibn = [&](const std::string& ibn) -> Maybe<const BlobDesc&> {
+    return Maybe<const BlobDesc&>(op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(ibn)));
+  };
+  SbpSignatureList sbp_sig_list;
+  JUST(op.GetSbpSignaturesIf(LogicalBlobDesc4Ibn, op_node->parallel_desc(), &sbp_sig_list));
+  HashSet<SbpSignature> visited_sbp_signatures = {greedy_sbp_signature};
+  for (const SbpSignature& sbp_signature : sbp_sig_list.sbp_signature()) {
+    if (!visited_sbp_signatures.insert(sbp_signature).second) { continue; }
+    if (!IsSbpSignatureApplicable(op_node, sbp_signature)) { continue; }
+    candidates->push_back(MakeSbpCandidate(op_node, sbp_signature, flops));
+  }
+  return Maybe<void>::Ok();
+}
+
+BoxingEdge MakeBoxingEdge(const OpNode* src_node, int64_t src_node_id,
+                          const std::vector<SbpCandidate>& src_candidates, const OpNode* dst_node,
+                          int64_t dst_node_id, const std::vector<SbpCandidate>& dst_candidates,
+                          const std::string& ibn) {
+  const LogicalBlobId& lbi = dst_node->op().BnInOp2Lbi(ibn);
+  const std::string& obn = *CHECK_JUST(src_node->op().obn4lbi(lbi));
+  const BlobDesc& logical_blob_desc = src_node->LogicalBlobDesc4Lbi(lbi);
+  const double bytes_per_second =
+      BoxingBytesPerSecond4ParallelDescs(src_node->parallel_desc(), dst_node->parallel_desc());
+  BoxingEdge edge;
+  edge.src_node_id = src_node_id;
+  edge.dst_node_id = dst_node_id;
+  for (const SbpCandidate& src_candidate : src_candidates) {
+    for (const SbpCandidate& dst_candidate : dst_candidates) {
+      const double bytes = BoxingBytes(
+          logical_blob_desc, src_candidate.sbp_signature.bn_in_op2sbp_parallel().at(obn),
+          src_node->parallel_desc(), dst_candidate.sbp_signature.bn_in_op2sbp_parallel().at(ibn),
+          dst_node->parallel_desc());
+      edge.candidate_pair2bytes.push_back(bytes);
+      edge.candidate_pair2time.push_back(bytes / bytes_per_second);
+    }
+  }
+  return edge;
+}
+
+PlanCost EstimatePlanCost(const std::vector<std::vector<SbpCandidate>>& node_id2candidates,
+                          const std::vector<BoxingEdge>& edges,
+                          const std::vector<int64_t>& node_id2candidate) {
+  PlanCost cost;
+  FOR_RANGE(int64_t, node_id, 0, node_id2candidates.size()) {
+    const auto& candidates = node_id2candidates.at(node_id);
+    const SbpCandidate& candidate = candidates.at(node_id2candidate.at(node_id));
+    cost.compute_time += candidate.compute_time;
+    cost.memory_time += candidate.memory_time;
+  }
+  for (const BoxingEdge& edge : edges) {
+    const int64_t index = node_id2candidate.at(edge.src_node_id)
+                              * node_id2candidates.at(edge.dst_node_id).size()
+                          + node_id2candidate.at(edge.dst_node_id);
+    cost.boxing_time += edge.candidate_pair2time.at(index);
+    cost.boxing_bytes += edge.candidate_pair2bytes.at(index);
+  }
+  return cost;
+}
+
+std::string SbpSignatureToString(const Operator& op, const SbpSignature& sbp_signature) {
+  std::string str;
+  for (const auto* bns : {&op.input_bns(), &op.output_bns()}) {
+    for (const std::string& bn : *bns) {
+      if (!str.empty()) { str += ", "; }
+      str += bn + ":" + SbpParallelToString(sbp_signature.bn_in_op2sbp_parallel().at(bn));
+    }
+  }
+  return str;
+}
+
+void DumpAutoParallelReport(const std::string& job_name, const PlanCost& greedy_cost,
+                            const PlanCost& searched_cost, bool is_applied,
+                            const std::vector<std::string>& changed_op_lines) {
+  const double ms = 1e3;
+  const double mbyte = 1024.0 * 1024.0;
+  std::ostringstream ss;
+  ss << "auto parallel plan of job " << job_name << "\n";
+  ss << "estimated\tgreedy\tsearched\n";
+  ss << "compute(ms)\t" << greedy_cost.compute_time * ms << "\t"
+     << searched_cost.compute_time * ms << "\n";
+  ss << "memory(ms)\t" << greedy_cost.memory_time * ms << "\t" << searched_cost.memory_time * ms
+     << "\n";
+  ss << "boxing(ms)\t" << greedy_cost.boxing_time * ms << "\t" << searched_cost.boxing_time * ms
+     << "\n";
+  ss << "step(ms)\t" << greedy_cost.step_time() * ms << "\t" << searched_cost.step_time() * ms
+     << "\n";
+  ss << "boxing(MB)\t" << greedy_cost.boxing_bytes / mbyte << "\t"
+     << searched_cost.boxing_bytes / mbyte << "\n";
+  ss << (is_applied ? "the searched plan is applied" : "the greedy plan is kept") << ", "
+     << changed_op_lines.size() << " ops change their sbp signature\n";
+  for (const std::string& line : changed_op_lines) { ss << line << "\n"; }
+  TeePersistentLogStream::Create("auto_parallel_report_" + job_name)->Write(ss.str());
+}
+
+Maybe<void> AutoParallelPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+  HashSet<std::string> fixed_op_names;
+  const Job& job = job_builder->job();
+  for (const auto& pair : job.job_parallel_view_conf().op_name2sbp_signature_conf()) {
+    fixed_op_names.insert(pair.first);
+  }
+  for (const auto& pair : job.helper().identical_sbp_oba_pairs().pair()) {
+    fixed_op_names.insert(pair.first().op_name());
+    fixed_op_names.insert(pair.second().op_name());
+  }
+  std::vector<const OpNode*> node_id2op_node;
+  HashMap<const OpNode*, int64_t> op_node2node_id;
+  std::vector<std::vector<SbpCandidate>> node_id2candidates;
+  std::vector<bool> node_id2is_searchable;
+  AutoParallelSearcher searcher;
+  std::vector<BoxingEdge> edges;
+  JUST(op_graph.TopoForEachNodeWithErrorCaptured([&](OpNode* op_node) -> Maybe<void> {
+    const int64_t node_id = node_id2op_node.size();
+    const bool is_searchable = IsSbpSignatureSearchable(op_node, fixed_op_names);
+    std::vector<SbpCandidate> candidates;
+    JUST(GenSbpCandidates(op_node, is_searchable, &candidates));
+    std::vector<double> candidate2cost;
+    for (const SbpCandidate& candidate : candidates) {
+      candidate2cost.push_back(candidate.compute_time + candidate.memory_time);
+    }
+    CHECK_EQ_OR_RETURN(searcher.AddNode(candidate2cost), node_id);
+    node_id2op_node.push_back(op_node);
+    op_node2node_id.emplace(op_node, node_id);
+    node_id2candidates.push_back(candidates);
+    node_id2is_searchable.push_back(is_searchable);
+    for (const std::string& ibn : op_node->op().input_bns()) {
+      const OpNode* src_node = &op_node->SrcNode4Ibn(ibn);
+      const int64_t src_node_id = op_node2node_id.at(src_node);
+      edges.push_back(MakeBoxingEdge(src_node, src_node_id, node_id2candidates.at(src_node_id),
+                                     op_node, node_id, node_id2candidates.at(node_id), ibn));
+      searcher.AddEdge(src_node_id, node_id, edges.back().candidate_pair2time);
+    }
+    return Maybe<void>::Ok();
+  }));
+  const std::vector<int64_t> greedy_node_id2candidate(node_id2op_node.size(), 0);
+  std::vector<int64_t> node_id2candidate(greedy_node_id2candidate);
+  searcher.Search(kMaxSearchRoundNum, &node_id2candidate);
+  const PlanCost greedy_cost =
+      EstimatePlanCost(node_id2candidates, edges, greedy_node_id2candidate);
+  const PlanCost searched_cost = EstimatePlanCost(node_id2candidates, edges, node_id2candidate);
+  const bool is_applied = node_id2candidate != greedy_node_id2candidate
+                          && searched_cost.step_time() < greedy_cost.step_time();
+  std::vector<std::string> changed_op_lines;
+  FOR_RANGE(int64_t, node_id, 0, node_id2op_node.size()) {
+    const int64_t candidate = node_id2candidate.at(node_id);
+    if (candidate == 0) { continue; }
+    const Operator& op = node_id2op_node.at(node_id)->op();
+    const auto& candidates = node_id2candidates.at(node_id);
+    changed_op_lines.push_back(op.op_name() + "\t"
+                               + SbpSignatureToString(op, candidates.at(0).sbp_signature) + "\t->\t"
+                               + SbpSignatureToString(op, candidates.at(candidate).sbp_signature));
+  }
+  if (is_applied) {
+    // the signatures of all the searched ops are fixed, since the greedy inference of an op
+    // depends on the signatures of its producers
+    FOR_RANGE(int64_t, node_id, 0, node_id2op_node.size()) {
+      if (!node_id2is_searchable.at(node_id)) { continue; }
+      job_builder->AddSbpSignature4OpName(
+          node_id2op_node.at(node_id)->op().op_name(),
+          node_id2candidates.at(node_id).at(node_id2candidate.at(node_id)).sbp_signature);
+    }
+  }
+  LOG(INFO) << "auto parallel estimates a step time of " << searched_cost.step_time() * 1e3
+            << " ms against " << greedy_cost.step_time() * 1e3 << " ms of the greedy plan, "
+            << changed_op_lines.size() << " ops change their sbp signature"
+            << (is_applied ? "" : ", the greedy plan is kept");
+  DumpAutoParallelReport(job.job_conf().job_name(), greedy_cost, searched_cost, is_applied,
+                         changed_op_lines);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("AutoParallelPass", AutoParallelPass);
+
+}  // namespace oneflow
@@ -0,0 +1,209 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <cmath>
+#include <limits>
+#include "oneflow/core/job_rewriter/auto_parallel_searcher.h"
+
+namespace oneflow {
+
+namespace {
+
+bool IsBetterCost(double new_cost, double old_cost) {
+  if (std::isinf(old_cost)) { return !std::isinf(new_cost); }
+  return new_cost < old_cost - 1e-9 * std::max(std::abs(old_cost), 1.0);
+}
+
+}  // namespace
+
+int64_t AutoParallelSearcher::AddNode(const std::vector<double>& candidate2cost) {
+  CHECK(!candidate2cost.empty());
+  node_id2candidate2cost_.push_back(candidate2cost);
+  node_id2in_edge_ids_.emplace_back();
+  node_id2out_edge_ids_.emplace_back();
+  return node_id2candidate2cost_.size() - 1;
+}
+
+void AutoParallelSearcher::AddEdge(int64_t src_node_id, int64_t dst_node_id,
+                                   const std::vector<double>& candidate_pair2cost) {
+  CHECK_NE(src_node_id, dst_node_id);
+  CHECK_EQ(static_cast<int64_t>(candidate_pair2cost.size()),
+           CandidateNum(src_node_id) * CandidateNum(dst_node_id));
+  EdgeInfo edge;
+  edge.src_node_id = src_node_id;
+  edge.dst_node_id = dst_node_id;
+  edge.candidate_pair2cost = candidate_pair2cost;
+  node_id2out_edge_ids_.at(src_node_id).push_back(edges_.size());
+  node_id2in_edge_ids_.at(dst_node_id).push_back(edges_.size());
+  edges_.push_back(edge);
+}
+
+double AutoParallelSearcher::EdgeCost(const EdgeInfo& edge, int64_t src_candidate,
+                                      int64_t dst_candidate) const {
+  return edge.candidate_pair2cost.at(src_candidate * CandidateNum(edge.dst_node_id)
+                                     + dst_candidate);
+}
+
+double AutoParallelSearcher::TotalCost(const std::vector<int64_t>& node_id2candidate) const {
+  CHECK_EQ(node_id2candidate.size(), node_id2candidate2cost_.size());
+  double cost = 0;
+  FOR_RANGE(int64_t, node_id, 0, node_id2candidate.size()) {
+    cost += node_id2candidate2cost_.at(node_id).at(node_id2candidate.at(node_id));
+  }
+  for (const EdgeInfo& edge : edges_) {
+    cost += EdgeCost(edge, node_id2candidate.at(edge.src_node_id),
+                     node_id2candidate.at(edge.dst_node_id));
+  }
+  return cost;
+}
+
+double AutoParallelSearcher::LocalCost(int64_t node_id, int64_t candidate,
+                                       const std::vector<int64_t>& node_id2candidate,
+                                       const HashSet<int64_t>& ignored_node_ids) const {
+  double cost = node_id2candidate2cost_.at(node_id).at(candidate);
+  for (int64_t edge_id : node_id2out_edge_ids_.at(node_id)) {
+    const EdgeInfo& edge = edges_.at(edge_id);
+    if (ignored_node_ids.find(edge.dst_node_id) != ignored_node_ids.end()) { continue; }
+    cost += EdgeCost(edge, candidate, node_id2candidate.at(edge.dst_node_id));
+  }
+  for (int64_t edge_id : node_id2in_edge_ids_.at(node_id)) {
+    const EdgeInfo& edge = edges_.at(edge_id);
+    if (ignored_node_ids.find(edge.src_node_id) != ignored_node_ids.end()) { continue; }
+    cost += EdgeCost(edge, node_id2candidate.at(edge.src_node_id), candidate);
+  }
+  return cost;
+}
+
+void AutoParallelSearcher::GenChains(std::vector<std::vector<int64_t>>* chains) const {
+  const int64_t node_num = node_id2candidate2cost_.size();
+  std::vector<HashSet<int64_t>> node_id2in_node_ids(node_num);
+  std::vector<HashSet<int64_t>> node_id2out_node_ids(node_num);
+  for (const EdgeInfo& edge : edges_) {
+    node_id2in_node_ids.at(edge.dst_node_id).insert(edge.src_node_id);
+    node_id2out_node_ids.at(edge.src_node_id).insert(edge.dst_node_id);
+  }
+  // a node continues a chain if it is the only consumer of the only producer
+  std::vector<int64_t> node_id2next(node_num, -1);
+  std::vector<bool> has_prev(node_num, false);
+  FOR_RANGE(int64_t, node_id, 0, node_num) {
+    if (node_id2out_node_ids.at(node_id).size() != 1) { continue; }
+    const int64_t next_node_id = *node_id2out_node_ids.at(node_id).begin();
+    if (node_id2in_node_ids.at(next_node_id).size() != 1) { continue; }
+    node_id2next.at(node_id) = next_node_id;
+    has_prev.at(next_node_id) = true;
+  }
+  chains->clear();
+  FOR_RANGE(int64_t, node_id, 0, node_num) {
+    if (has_prev.at(node_id) || node_id2next.at(node_id) == -1) { continue; }
+    std::vector<int64_t> chain;
+    for (int64_t cur = node_id; cur != -1; cur = node_id2next.at(cur)) { chain.push_back(cur); }
+    chains->push_back(chain);
+  }
+}
+
+bool AutoParallelSearcher::SearchChain(const std::vector<int64_t>& chain,
+                                       std::vector<int64_t>* node_id2candidate) const {
+  const HashSet<int64_t> chain_node_ids(chain.begin(), chain.end());
+  const int64_t chain_size = chain.size();
+  // the edges inside a chain only connect neighbors
+  const auto PairCost = [&](int64_t index, int64_t src_candidate, int64_t dst_candidate) {
+    double cost = 0;
+    for (int64_t edge_id : node_id2out_edge_ids_.at(chain.at(index))) {
+      cost += EdgeCost(edges_.at(edge_id), src_candidate, dst_candidate);
+    }
+    return cost;
+  };
+  std::vector<std::vector<double>> index2candidate2cost(chain_size);
+  std::vector<std::vector<int64_t>> index2candidate2prev_candidate(chain_size);
+  double old_cost = 0;
+  FOR_RANGE(int64_t, index, 0, chain_size) {
+    const int64_t node_id = chain.at(index);
+    const int64_t candidate_num = CandidateNum(node_id);
+    index2candidate2cost.at(index).resize(candidate_num);
+    index2candidate2prev_candidate.at(index).resize(candidate_num, -1);
+    old_cost += LocalCost(node_id, node_id2candidate->at(node_id), *node_id2candidate,
+                          chain_node_ids);
+    if (index > 0) {
+      old_cost += PairCost(index - 1, node_id2candidate->at(chain.at(index - 1)),
+                           node_id2candidate->at(node_id));
+    }
+    FOR_RANGE(int64_t, candidate, 0, candidate_num) {
+      double cost = LocalCost(node_id, candidate, *node_id2candidate, chain_node_ids);
+      if (index > 0) {
+        double best_prev_cost = std::numeric_limits<double>::infinity();
+        FOR_RANGE(int64_t, prev_candidate, 0, CandidateNum(chain.at(index - 1))) {
+          const double prev_cost = index2candidate2cost.at(index - 1).at(prev_candidate)
+                                   + PairCost(index - 1, prev_candidate, candidate);
+          if (index2candidate2prev_candidate.at(index).at(candidate) == -1
+              || prev_cost < best_prev_cost) {
+            best_prev_cost = prev_cost;
+            index2candidate2prev_candidate.at(index).at(candidate) = prev_candidate;
+          }
+        }
+        cost += best_prev_cost;
+      }
+      index2candidate2cost.at(index).at(candidate) = cost;
+    }
+  }
+  const std::vector<double>& last_candidate2cost = index2candidate2cost.back();
+  int64_t candidate =
+      std::min_element(last_candidate2cost.begin(), last_candidate2cost.end())
+      - last_candidate2cost.begin();
+  if (!IsBetterCost(last_candidate2cost.at(candidate), old_cost)) { return false; }
+  for (int64_t index = chain_size - 1; index >= 0; --index) {
+    node_id2candidate->at(chain.at(index)) = candidate;
+    candidate = index2candidate2prev_candidate.at(index).at(candidate);
+  }
+  return true;
+}
+
+bool AutoParallelSearcher::RefineNode(int64_t node_id,
+                                      std::vector<int64_t>* node_id2candidate) const {
+  const HashSet<int64_t> no_ignored_node_ids;
+  const int64_t old_candidate = node_id2candidate->at(node_id);
+  int64_t best_candidate = old_candidate;
+  double best_cost = LocalCost(node_id, old_candidate, *node_id2candidate, no_ignored_node_ids);
+  FOR_RANGE(int64_t, candidate, 0, CandidateNum(node_id)) {
+    const double cost = LocalCost(node_id, candidate, *node_id2candidate, no_ignored_node_ids);
+    if (IsBetterCost(cost, best_cost)) {
+      best_candidate = candidate;
+      best_cost = cost;
+    }
+  }
+  node_id2candidate->at(node_id) = best_candidate;
+  return best_candidate != old_candidate;
+}
+
+void AutoParallelSearcher::Search(int32_t max_round_num,
+                                  std::vector<int64_t>* node_id2candidate) const {
+  const int64_t node_num = node_id2candidate2cost_.size();
+  CHECK_EQ(static_cast<int64_t>(node_id2candidate->size()), node_num);
+  FOR_RANGE(int64_t, node_id, 0, node_num) {
+    CHECK_GE(node_id2candidate->at(node_id), 0);
+    CHECK_LT(node_id2candidate->at(node_id), CandidateNum(node_id));
+  }
+  std::vector<std::vector<int64_t>> chains;
+  GenChains(&chains);
+  FOR_RANGE(int32_t, round, 0, max_round_num) {
+    bool is_improved = false;
+    for (const auto& chain : chains) { is_improved |= SearchChain(chain, node_id2candidate); }
+    FOR_RANGE(int64_t, node_id, 0, node_num) {
+      is_improved |= RefineNode(node_id, node_id2candidate);
+    }
+    if (!is_improved) { break; }
+  }
+}
+
+}  // namespace oneflow
@@ -0,0 +1,70 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_REWRITER_AUTO_PARALLEL_SEARCHER_H_
+#define ONEFLOW_CORE_JOB_REWRITER_AUTO_PARALLEL_SEARCHER_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// Chooses one candidate for each node of a graph to minimize the sum of the node costs and the
+// edge costs, which depend on the candidates of both ends of an edge. Starting from a given
+// assignment, the chains of the graph are solved exactly by dynamic programming and every node is
+// then refined alone with its neighbors fixed, until neither step improves the cost.
+class AutoParallelSearcher final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(AutoParallelSearcher);
+  AutoParallelSearcher() = default;
+  ~AutoParallelSearcher() = default;
+
+  // Returns the id of the new node, a forbidden candidate costs infinity
+  int64_t AddNode(const std::vector<double>& candidate2cost);
+  // The cost of the src candidate i and the dst candidate j is at i * dst_candidate_num + j
+  void AddEdge(int64_t src_node_id, int64_t dst_node_id,
+               const std::vector<double>& candidate_pair2cost);
+
+  double TotalCost(const std::vector<int64_t>& node_id2candidate) const;
+  // node_id2candidate holds the initial assignment and is never made worse
+  void Search(int32_t max_round_num, std::vector<int64_t>* node_id2candidate) const;
+
+ private:
+  struct EdgeInfo {
+    int64_t src_node_id;
+    int64_t dst_node_id;
+    std::vector<double> candidate_pair2cost;
+  };
+
+  int64_t CandidateNum(int64_t node_id) const { return node_id2candidate2cost_.at(node_id).size(); }
+  double EdgeCost(const EdgeInfo& edge, int64_t src_candidate, int64_t dst_candidate) const;
+  // the cost of a candidate of the node with all the other nodes fixed, skipping the edges to
+  // ignored_node_ids
+  double LocalCost(int64_t node_id, int64_t candidate,
+                   const std::vector<int64_t>& node_id2candidate,
+                   const HashSet<int64_t>& ignored_node_ids) const;
+  void GenChains(std::vector<std::vector<int64_t>>* chains) const;
+  bool SearchChain(const std::vector<int64_t>& chain,
+                   std::vector<int64_t>* node_id2candidate) const;
+  bool RefineNode(int64_t node_id, std::vector<int64_t>* node_id2candidate) const;
+
+  std::vector<std::vector<double>> node_id2candidate2cost_;
+  std::vector<EdgeInfo> edges_;
+  std::vector<std::vector<int64_t>> node_id2in_edge_ids_;
+  std::vector<std::vector<int64_t>> node_id2out_edge_ids_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_REWRITER_AUTO_PARALLEL_SEARCHER_H_
@@ -0,0 +1,86 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/auto_parallel_searcher.h"
+
+namespace oneflow {
+
+namespace {
+
+const double kInf = std::numeric_limits<double>::infinity();
+
+// candidate 0 is cheap locally, candidate 1 is cheap to pass between neighbors
+std::vector<double> PairCosts(double same_cost, double switch_cost) {
+  return {same_cost, switch_cost, switch_cost, same_cost};
+}
+
+}  // namespace
+
+TEST(AutoParallelSearcher, chain) {
+  AutoParallelSearcher searcher;
+  // a greedy choice of each node alone picks candidate 0 and pays for the edges
+  FOR_RANGE(int32_t, i, 0, 4) { searcher.AddNode({1, 2}); }
+  searcher.AddEdge(0, 1, {10, 10, 10, 0});
+  searcher.AddEdge(1, 2, {10, 10, 10, 0});
+  searcher.AddEdge(2, 3, {10, 10, 10, 0});
+  std::vector<int64_t> node_id2candidate = {0, 0, 0, 0};
+  ASSERT_DOUBLE_EQ(searcher.TotalCost(node_id2candidate), 34);
+  searcher.Search(8, &node_id2candidate);
+  ASSERT_EQ(node_id2candidate, std::vector<int64_t>({1, 1, 1, 1}));
+  ASSERT_DOUBLE_EQ(searcher.TotalCost(node_id2candidate), 8);
+}
+
+TEST(AutoParallelSearcher, refine_branches) {
+  AutoParallelSearcher searcher;
+  // 0 -> {1, 2} -> 3 has no chain, each node is refined alone
+  searcher.AddNode({0, 0});
+  searcher.AddNode({0, 1});
+  searcher.AddNode({0, 1});
+  searcher.AddNode({7, 0});
+  searcher.AddEdge(0, 1, PairCosts(0, 3));
+  searcher.AddEdge(0, 2, PairCosts(0, 3));
+  searcher.AddEdge(1, 3, PairCosts(0, 3));
+  searcher.AddEdge(2, 3, PairCosts(0, 3));
+  std::vector<int64_t> node_id2candidate = {0, 0, 0, 0};
+  searcher.Search(8, &node_id2candidate);
+  ASSERT_EQ(node_id2candidate, std::vector<int64_t>({0, 0, 0, 1}));
+  ASSERT_DOUBLE_EQ(searcher.TotalCost(node_id2candidate), 6);
+}
+
+TEST(AutoParallelSearcher, fixed_and_forbidden) {
+  AutoParallelSearcher searcher;
+  // node 0 has a single candidate, candidate 0 of node 2 is forbidden
+  searcher.AddNode({0});
+  searcher.AddNode({1, 1});
+  searcher.AddNode({kInf, 1});
+  searcher.AddEdge(0, 1, {0, 4});
+  searcher.AddEdge(1, 2, PairCosts(0, 2));
+  std::vector<int64_t> node_id2candidate = {0, 0, 0};
+  searcher.Search(8, &node_id2candidate);
+  ASSERT_EQ(node_id2candidate, std::vector<int64_t>({0, 0, 1}));
+  ASSERT_DOUBLE_EQ(searcher.TotalCost(node_id2candidate), 4);
+}
+
+TEST(AutoParallelSearcher, never_worse) {
+  AutoParallelSearcher searcher;
+  searcher.AddNode({1, 3});
+  searcher.AddNode({1, 3});
+  searcher.AddEdge(0, 1, PairCosts(0, 1));
+  std::vector<int64_t> node_id2candidate = {0, 0};
+  searcher.Search(8, &node_id2candidate);
+  ASSERT_EQ(node_id2candidate, std::vector<int64_t>({0, 0}));
+}
+
+}  // namespace oneflow
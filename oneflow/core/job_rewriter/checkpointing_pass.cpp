@@ -14,6 +14,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/job_rewriter/auto_checkpointing_planner.h"
+#include "oneflow/core/job_rewriter/pass_util.h"
 #include "oneflow/core/job/job.pb.h"
 #include "oneflow/core/job/scope.h"
 #include "oneflow/core/job_rewriter/calculation_pass.h"
@@ -36,12 +38,13 @@ class CheckpointingPass final : public JobPass {
     if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
     const OpGraph op_graph(*job);
     JobBuilder job_builder(job);
-    return Apply(op_graph, &job_builder);
+    return Apply(ctx->job_desc(), op_graph, &job_builder);
   }
 
   bool IsEnabled(const JobPassCtx& ctx) const { return ctx.job_desc().IsTrain(); }
 
-  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+  Maybe<void> Apply(const JobDesc& job_desc, const OpGraph& op_graph,
+                    JobBuilder* job_builder) const;
 };
 
 const std::string kCheckpointingFakeOpNamePrefix = "OneFlow-System-Checkpointing-Fake-Fw-Op_";
@@ -61,27 +64,137 @@ bool IsForwardPass7CheckpointingScope(const Scope& scope) {
   return IsForwardPassScope(scope) && scope.Bool("checkpointing");
 }
 
-void CollectAllCheckpointingOpsInForwardPass(
-    const OpGraph& op_graph, HashMap<std::string, const OpNode*>* checkpointing_op_name2op_node) {
+bool IsIgnoredOpTypeName(const std::string& op_type_name) {
   // NOTE(chengcheng):
   //   ignore batch_norm ops because of recompute bn will repeat the calculation of 'm' and 'v'.
   //   in the future, we need to support the recomputation version of batch_norm which do NOT
   //   update forward variables.
-  HashSet<std::string> ignore_op_type_names = {"normalization", "normalization_add_relu",
-                                               "cudnn_fused_normalization_add_relu"};
+  static const HashSet<std::string> ignore_op_type_names = {
+      "normalization", "normalization_add_relu", "cudnn_fused_normalization_add_relu"};
+  return ignore_op_type_names.find(op_type_name) != ignore_op_type_names.end();
+}
+
+// a recomputed random op would not reproduce the blobs its backward consumers were built for
+bool IsRandomOpTypeName(const std::string& op_type_name) {
+  static const HashSet<std::string> random_op_type_names = {
+      "random_mask_like",
+      "generate_random_batch_permutation_indices",
+      "distributed_partial_fc_sample",
+      "distributed_partial_fc_sample_disable_boxing",
+      "coin_flip",
+      "image_random_crop",
+      "ofrecord_image_decoder_random_crop",
+      "image_decode_random_crop_resize_normalize"};
+  return random_op_type_names.find(op_type_name) != random_op_type_names.end();
+}
+
+void CollectAllCheckpointingOpsInForwardPass(
+    const OpGraph& op_graph, HashMap<std::string, const OpNode*>* checkpointing_op_name2op_node) {
   op_graph.ForEachNode([&](const OpNode* op_node) {
     const OperatorConf& op_conf = op_node->op().op_conf();
     if (!op_conf.has_user_conf()) { return; }
-    if (ignore_op_type_names.find(op_conf.user_conf().op_type_name())
-        != ignore_op_type_names.end()) {
-      return;
-    }
+    if (IsIgnoredOpTypeName(op_conf.user_conf().op_type_name())) { return; }
     if (IsForwardPass7CheckpointingScope(Scope4OpNode(op_node))) {
       CHECK(checkpointing_op_name2op_node->emplace(op_conf.name(), op_node).second);
     }
   });
 }
 
+// per device, the variables are not counted since they are alive anyway
+int64_t ByteSize4Lbi(const OpNode* producer, const LogicalBlobId& lbi) {
+  if (producer->op().op_conf().has_variable_conf()) { return 0; }
+  const BlobDesc& blob_desc = producer->LogicalBlobDesc4Lbi(lbi);
+  int64_t byte_size = blob_desc.shape().elem_cnt() * GetSizeOfDataType(blob_desc.data_type());
+  if (producer->SbpParallel4Lbi(lbi).has_split_parallel()) {
+    byte_size /= producer->parallel_desc().parallel_num();
+  }
+  return byte_size;
+}
+
+RecomputePolicy RecomputePolicy4OpNode(
+    const OpNode* op_node,
+    const HashMap<std::string, const OpNode*>& checkpointing_op_name2op_node) {
+  if (checkpointing_op_name2op_node.find(op_node->op().op_name())
+      != checkpointing_op_name2op_node.end()) {
+    return kAlwaysRecompute;
+  }
+  const OperatorConf& op_conf = op_node->op().op_conf();
+  if (!op_conf.has_user_conf() || op_node->op().input_bns().empty()) { return kNeverRecompute; }
+  const std::string& op_type_name = op_conf.user_conf().op_type_name();
+  if (IsIgnoredOpTypeName(op_type_name) || IsRandomOpTypeName(op_type_name)) {
+    return kNeverRecompute;
+  }
+  // e.g. assign and the moving average observer of quantization aware training, whose state
+  // update would be applied a second time by the recomputation
+  for (const std::string& ibn : op_node->op().input_bns()) {
+    if (op_node->op().InputBlobModifier4Ibn(ibn).is_mutable()) { return kNeverRecompute; }
+  }
+  return kMayRecompute;
+}
+
+// Adds the forward ops chosen by AutoCheckpointingPlanner to the checkpointing ops, so that the
+// activations kept for the backward pass fit memory_budget bytes per device.
+void CollectAutoCheckpointingOpsInForwardPass(
+    const OpGraph& op_graph, int64_t memory_budget,
+    HashMap<std::string, const OpNode*>* checkpointing_op_name2op_node) {
+  AutoCheckpointingPlanner planner;
+  HashMap<LogicalBlobId, int64_t> lbi2blob_id;
+  std::vector<const OpNode*> op_id2op_node;
+  op_graph.TopoForEachNode([&](const OpNode* op_node) {
+    if (!IsForwardPassScope(Scope4OpNode(op_node))) { return; }
+    std::vector<int64_t> in_blob_ids;
+    for (const std::string& ibn : op_node->op().input_bns()) {
+      const LogicalBlobId& lbi = op_node->op().BnInOp2Lbi(ibn);
+      const auto it = lbi2blob_id.find(lbi);
+      if (it == lbi2blob_id.end()) { continue; }
+      const OpNode& producer = op_node->ProducerOpNode4Lbi(lbi);
+      if (producer.parallel_desc() == op_node->parallel_desc()) {
+        in_blob_ids.push_back(it->second);
+      } else {
+        // the recomputed subgraphs never cross placements, so this op reads the original blob
+        // whenever it is recomputed
+        in_blob_ids.push_back(planner.AddBlob(ByteSize4Lbi(&producer, lbi), false));
+      }
+    }
+    HashSet<LogicalBlobId> lbis_read_by_backward;
+    for (const OpEdge* edge : op_node->out_edges()) {
+      if (IsForwardPassScope(Scope4OpNode(edge->dst_node()))) { continue; }
+      lbis_read_by_backward.insert(edge->lbis().begin(), edge->lbis().end());
+    }
+    std::vector<int64_t> out_blob_ids;
+    for (const std::string& obn : op_node->op().output_bns()) {
+      const LogicalBlobId& lbi = op_node->op().BnInOp2Lbi(obn);
+      const bool is_read_by_backward =
+          lbis_read_by_backward.find(lbi) != lbis_read_by_backward.end();
+      const int64_t blob_id = planner.AddBlob(ByteSize4Lbi(op_node, lbi), is_read_by_backward);
+      CHECK(lbi2blob_id.emplace(lbi, blob_id).second);
+      out_blob_ids.push_back(blob_id);
+    }
+    const RecomputePolicy policy = RecomputePolicy4OpNode(op_node, *checkpointing_op_name2op_node);
+    const double cost = op_node->op().op_conf().has_user_conf() ? LogicalFlops4OpNode(op_node) : 0;
+    planner.AddOp(policy, cost, in_blob_ids, out_blob_ids);
+    op_id2op_node.push_back(op_node);
+  });
+  std::vector<int64_t> recomputed_op_ids;
+  AutoCheckpointingReport report;
+  planner.Plan(memory_budget, &recomputed_op_ids, &report);
+  for (int64_t op_id : recomputed_op_ids) {
+    const OpNode* op_node = op_id2op_node.at(op_id);
+    checkpointing_op_name2op_node->emplace(op_node->op().op_name(), op_node);
+  }
+  const double mbyte = 1024.0 * 1024.0;
+  LOG(INFO) << "auto checkpointing recomputes " << report.recomputed_op_num << " of "
+            << op_id2op_node.size() << " forward ops, activations kept for backward per device: "
+            << report.kept_bytes_before / mbyte << " MB -> " << report.kept_bytes_after / mbyte
+            << " MB, compute added: " << report.recompute_cost / 1e9 << " GFLOP ("
+            << 100.0 * report.recompute_cost / std::max(report.forward_cost, 1.0)
+            << "% of the forward pass)";
+  if (memory_budget > 0 && report.kept_bytes_after > memory_budget) {
+    LOG(WARNING) << "auto checkpointing can not fit the activations into the memory budget of "
+                 << memory_budget / mbyte << " MB";
+  }
+}
+
 void GenConnectedCheckpointingSubgraphs(
     const HashMap<std::string, const OpNode*>& checkpointing_op_name2op_node,
     std::vector<HashSet<const OpNode*>>* checkpointing_subgraphs) {
@@ -119,10 +232,17 @@ void GenConnectedCheckpointingSubgraphs(
   }
 }
 
-Maybe<void> CheckpointingPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+Maybe<void> CheckpointingPass::Apply(const JobDesc& job_desc, const OpGraph& op_graph,
+                                     JobBuilder* job_builder) const {
   // step 1. collect all checkpointing ops in forwardpass.
   HashMap<std::string, const OpNode*> checkpointing_op_name2op_node;
   CollectAllCheckpointingOpsInForwardPass(op_graph, &checkpointing_op_name2op_node);
+  if (job_desc.job_conf().enable_auto_checkpointing()) {
+    const int64_t memory_budget =
+        job_desc.job_conf().auto_checkpointing_memory_budget_mbyte() * 1024 * 1024;
+    CollectAutoCheckpointingOpsInForwardPass(op_graph, memory_budget,
+                                             &checkpointing_op_name2op_node);
+  }
   if (checkpointing_op_name2op_node.empty()) { return Maybe<void>::Ok(); }
 
   // step 2. get all connected subgraphs in checkpointing ops.
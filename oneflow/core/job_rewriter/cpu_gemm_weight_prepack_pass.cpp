@@ -0,0 +1,70 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/register/runtime_blob_desc.h"
+
+namespace oneflow {
+
+namespace {
+
+// Marks cpu matmul/batch_matmul whose b is read directly from a variable, so that the kernel packs
+// b once and reuses it across iterations. Only predict jobs qualify since their variables are not
+// updated by the job itself, updates by other jobs bump the variable version, which re-packs b.
+class CpuGemmWeightPrepackPass final : public JobPass {
+ public:
+  CpuGemmWeightPrepackPass() = default;
+  ~CpuGemmWeightPrepackPass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    return ctx.job_desc().job_conf().enable_cpu_gemm_weight_prepack() && !ctx.job_desc().IsTrain();
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, &job_builder);
+  }
+};
+
+Maybe<void> CpuGemmWeightPrepackPass::Apply(const OpGraph& op_graph,
+                                            JobBuilder* job_builder) const {
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    const OperatorConf& op_conf = op_node->op().op_conf();
+    if (!op_conf.has_user_conf()) { return; }
+    const std::string& op_type_name = op_conf.user_conf().op_type_name();
+    if (op_type_name != "matmul" && op_type_name != "batch_matmul") { return; }
+    if (op_node->parallel_desc().device_type() != DeviceType::kCPU) { return; }
+    const user_op::UserOpConfWrapper user_op_conf(op_conf);
+    const LogicalBlobId b_lbi = GenLogicalBlobId(user_op_conf.input("b", 0));
+    const DataType b_data_type = op_node->LogicalBlobDesc4Lbi(b_lbi).data_type();
+    if (b_data_type != DataType::kFloat && b_data_type != DataType::kDouble) { return; }
+    const OpNode* b_producer = op_graph.OpNode4OpName(b_lbi.op_name());
+    if (!b_producer->op().op_conf().has_variable_conf()) { return; }
+    OperatorConf new_op_conf = op_conf;
+    (*new_op_conf.mutable_user_conf()->mutable_attr())["_prepack_b"].set_at_bool(true);
+    job_builder->MutOpsOnlyOnce({new_op_conf});
+  });
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("CpuGemmWeightPrepackPass", CpuGemmWeightPrepackPass);
+
+}  // namespace oneflow
@@ -0,0 +1,87 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+bool IsCpuUserOp(const OpNode* op_node, const std::string& op_type_name) {
+  const OperatorConf& op_conf = op_node->op().op_conf();
+  return op_conf.has_user_conf() && op_conf.user_conf().op_type_name() == op_type_name
+         && op_node->parallel_desc().device_type() == DeviceType::kCPU;
+}
+
+// Lets cpu max_pool_Nd output the position of every max, and the max_pool_Nd_grad consuming its y
+// read it, so that the backward scatters dy directly instead of comparing x with y again over every
+// window. The recorded max is the first one of its window, so unlike the comparison the backward
+// leaves the other maxes tied with it without gradient, which is why the pass is opt-in.
+class CpuMaxPoolArgmaxPass final : public JobPass {
+ public:
+  CpuMaxPoolArgmaxPass() = default;
+  ~CpuMaxPoolArgmaxPass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    return ctx.job_desc().IsTrain() && ctx.job_desc().job_conf().enable_cpu_max_pool_argmax();
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, &job_builder);
+  }
+};
+
+Maybe<void> CpuMaxPoolArgmaxPass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+  HashMap<std::string, OperatorConf> op_name2op_conf;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    FOR_RANGE(int32_t, dim, 1, 4) {
+      const std::string op_type_name = "max_pool_" + std::to_string(dim) + "d";
+      if (!IsCpuUserOp(op_node, op_type_name + "_grad")) { continue; }
+      const user_op::UserOpConfWrapper grad_op_conf(op_node->op().op_conf());
+      if (grad_op_conf.has_input("_argmax", 0)) { return; }
+      const std::string& y_lbn = grad_op_conf.input("y", 0);
+      const OpNode* pool_node = op_graph.OpNode4OpName(GenLogicalBlobId(y_lbn).op_name());
+      if (!IsCpuUserOp(pool_node, op_type_name)) { return; }
+      const std::string& pool_op_name = pool_node->op().op_name();
+      if (op_name2op_conf.find(pool_op_name) == op_name2op_conf.end()) {
+        OperatorConf pool_op_conf = pool_node->op().op_conf();
+        if (!user_op::UserOpConfWrapper(pool_op_conf).has_output("_argmax", 0)) {
+          *(*pool_op_conf.mutable_user_conf()->mutable_output())["_argmax"].mutable_s()->Add() =
+              GenLogicalBlobName(pool_op_name, GenRepeatedBn("_argmax", 0));
+        }
+        op_name2op_conf.emplace(pool_op_name, pool_op_conf);
+      }
+      const user_op::UserOpConfWrapper pool_op_conf(op_name2op_conf.at(pool_op_name));
+      OperatorConf new_grad_op_conf = op_node->op().op_conf();
+      *(*new_grad_op_conf.mutable_user_conf()->mutable_input())["_argmax"].mutable_s()->Add() =
+          pool_op_conf.output("_argmax", 0);
+      op_name2op_conf.emplace(new_grad_op_conf.name(), new_grad_op_conf);
+      return;
+    }
+  });
+  for (const auto& pair : op_name2op_conf) { job_builder->MutOpsOnlyOnce({pair.second}); }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("CpuMaxPoolArgmaxPass", CpuMaxPoolArgmaxPass);
+
+}  // namespace oneflow
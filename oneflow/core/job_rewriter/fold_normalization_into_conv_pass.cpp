@@ -0,0 +1,165 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+bool IsCpuUserOp(const OpNode* op_node, const std::string& op_type_name) {
+  const OperatorConf& op_conf = op_node->op().op_conf();
+  return op_conf.has_user_conf() && op_conf.user_conf().op_type_name() == op_type_name
+         && op_node->parallel_desc().device_type() == DeviceType::kCPU;
+}
+
+bool IsCpuConv(const OpNode* op_node) {
+  return IsCpuUserOp(op_node, "conv1d") || IsCpuUserOp(op_node, "conv2d")
+         || IsCpuUserOp(op_node, "conv3d");
+}
+
+bool IsOnlyConsumedBy(const OpNode* producer, const OpNode* consumer) {
+  for (const OpEdge* edge : producer->out_edges()) {
+    if (edge->dst_node() != consumer) { return false; }
+  }
+  return true;
+}
+
+const OpNode* ProducerOpNode4Input(const OpGraph& op_graph, const user_op::UserOpConfWrapper& conf,
+                                   const std::string& arg_name) {
+  return op_graph.OpNode4OpName(GenLogicalBlobId(conf.input(arg_name, 0)).op_name());
+}
+
+// Removes every inference mode normalization of a cpu predict job that directly follows a
+// convolution, optionally through a bias_add, by convolving with the folded weight and bias:
+//   weight' = weight * gamma / sqrt(moving_variance + epsilon)
+//   bias' = (bias - moving_mean) * gamma / sqrt(moving_variance + epsilon) + beta
+// The folded parameters are computed by fold_normalization_params, which only reads variables and
+// is cheap compared with the convolution.
+class FoldNormalizationIntoConvPass final : public JobPass {
+ public:
+  FoldNormalizationIntoConvPass() = default;
+  ~FoldNormalizationIntoConvPass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    return !ctx.job_desc().IsTrain()
+           && ctx.job_desc().job_conf().enable_fold_normalization_into_conv();
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, &job_builder);
+  }
+};
+
+Maybe<void> FoldNormalizationIntoConvPass::Apply(const OpGraph& op_graph,
+                                                 JobBuilder* job_builder) const {
+  HashMap<std::string, OperatorConf> op_name2op_conf;
+  const auto MutOpConf4OpNode = [&](const OpNode* op_node) -> OperatorConf* {
+    const std::string& op_name = op_node->op().op_name();
+    auto it = op_name2op_conf.find(op_name);
+    if (it == op_name2op_conf.end()) {
+      it = op_name2op_conf.emplace(op_name, op_node->op().op_conf()).first;
+    }
+    return &it->second;
+  };
+  std::vector<std::string> del_op_names;
+  op_graph.ForEachNode([&](const OpNode* bn_node) {
+    if (!IsCpuUserOp(bn_node, "normalization")) { return; }
+    const user_op::UserOpConfWrapper bn_conf(bn_node->op().op_conf());
+    if (bn_conf.attr<bool>("training")) { return; }
+    if (bn_conf.has_input("_add_to_output", 0) || bn_conf.has_output("mean", 0)
+        || bn_conf.has_output("inv_variance", 0)) {
+      return;
+    }
+    const OpNode* bias_add_node = nullptr;
+    const OpNode* conv_node = ProducerOpNode4Input(op_graph, bn_conf, "x");
+    if (IsCpuUserOp(conv_node, "bias_add")) {
+      bias_add_node = conv_node;
+      if (!IsOnlyConsumedBy(bias_add_node, bn_node)) { return; }
+      conv_node = ProducerOpNode4Input(
+          op_graph, user_op::UserOpConfWrapper(bias_add_node->op().op_conf()), "a");
+    }
+    if (!IsCpuConv(conv_node)) { return; }
+    if (!IsOnlyConsumedBy(conv_node, bias_add_node == nullptr ? bn_node : bias_add_node)) {
+      return;
+    }
+    const user_op::UserOpConfWrapper conv_conf(conv_node->op().op_conf());
+    const int64_t num_axes =
+        conv_node->LogicalBlobDesc4Lbi(GenLogicalBlobId(conv_conf.output("out", 0)))
+            .shape()
+            .NumAxes();
+    const int32_t channel_axis =
+        conv_conf.attr<std::string>("data_format") == "channels_first" ? 1 : num_axes - 1;
+    if (bn_conf.attr<int32_t>("axis") != channel_axis) { return; }
+
+    user_op::UserOpConfWrapperBuilder fold_builder(bn_conf.op_name() + "-fold_params");
+    fold_builder.Op("fold_normalization_params")
+        .Input("weight", conv_conf.input("weight", 0))
+        .Input("gamma", bn_conf.input("gamma", 0))
+        .Input("beta", bn_conf.input("beta", 0))
+        .Input("moving_mean", bn_conf.input("moving_mean", 0))
+        .Input("moving_variance", bn_conf.input("moving_variance", 0))
+        .Output("folded_weight")
+        .Output("folded_bias")
+        .Attr<float>("epsilon", bn_conf.attr<float>("epsilon"))
+        .ScopeSymbolId(conv_node->op().op_conf().scope_symbol_id());
+    if (bias_add_node != nullptr) {
+      const user_op::UserOpConfWrapper bias_add_conf(bias_add_node->op().op_conf());
+      if (conv_conf.has_input("bias", 0)) { return; }
+      if (bias_add_conf.attr<int32_t>("axis") != channel_axis) { return; }
+      fold_builder.Input("bias", bias_add_conf.input("b", 0));
+      del_op_names.push_back(bias_add_conf.op_name());
+    } else if (conv_conf.has_input("bias", 0)) {
+      fold_builder.Input("bias", conv_conf.input("bias", 0));
+    }
+    OperatorConf fold_op_conf = fold_builder.Build().op_conf();
+    fold_op_conf.set_device_tag(conv_node->op().op_conf().device_tag());
+    job_builder->AddOps(conv_node->parallel_desc().parallel_conf(), {fold_op_conf});
+    const user_op::UserOpConfWrapper fold_conf(fold_op_conf);
+
+    OperatorConf* new_conv_op_conf = MutOpConf4OpNode(conv_node);
+    ReplaceInputLbnInOpCustomizedConf(new_conv_op_conf, GenRepeatedBn("weight", 0),
+                                      fold_conf.output("folded_weight", 0));
+    auto* conv_inputs = new_conv_op_conf->mutable_user_conf()->mutable_input();
+    (*conv_inputs)["bias"].clear_s();
+    (*conv_inputs)["bias"].add_s(fold_conf.output("folded_bias", 0));
+
+    // consumers of the normalization read the convolution instead
+    const LogicalBlobId bn_out_lbi = GenLogicalBlobId(bn_conf.output("y", 0));
+    for (const OpEdge* edge : bn_node->out_edges()) {
+      const OpNode* consumer = edge->dst_node();
+      OperatorConf* consumer_op_conf = MutOpConf4OpNode(consumer);
+      for (const std::string& ibn : consumer->op().input_bns()) {
+        if (consumer->op().BnInOp2Lbi(ibn) != bn_out_lbi) { continue; }
+        ReplaceInputLbnInOpCustomizedConf(consumer_op_conf, ibn, conv_conf.output("out", 0));
+      }
+    }
+    del_op_names.push_back(bn_conf.op_name());
+  });
+  for (const auto& pair : op_name2op_conf) { job_builder->MutOpsOnlyOnce({pair.second}); }
+  job_builder->DelOps(del_op_names);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("FoldNormalizationIntoConvPass", FoldNormalizationIntoConvPass);
+
+}  // namespace oneflow
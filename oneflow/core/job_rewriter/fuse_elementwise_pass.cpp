@@ -0,0 +1,249 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/kernels/fused_elementwise_util.h"
+
+namespace oneflow {
+
+namespace {
+
+struct ChainArgs {
+  std::string input;
+  std::string output;
+};
+
+// The arguments of each fusible op that carry the value along the chain
+const HashMap<std::string, ChainArgs>& ChainArgs4OpTypeName() {
+  static const HashMap<std::string, ChainArgs> chain_args4op_type_name = {
+      {"relu", {"in", "out"}},       {"leaky_relu", {"x", "y"}},    {"gelu", {"in", "out"}},
+      {"sigmoid", {"in", "out"}},    {"scalar_add", {"in", "out"}}, {"scalar_mul", {"in", "out"}},
+      {"bias_add", {"a", "out"}},    {"abs", {"x", "y"}},           {"erf", {"x", "y"}},
+      {"exp", {"x", "y"}},           {"log", {"x", "y"}},           {"negative", {"x", "y"}},
+      {"reciprocal", {"x", "y"}},    {"rsqrt", {"x", "y"}},         {"sigmoid_v2", {"x", "y"}},
+      {"softplus", {"x", "y"}},      {"sqrt", {"x", "y"}},          {"square", {"x", "y"}},
+      {"tanh", {"x", "y"}}};
+  return chain_args4op_type_name;
+}
+
+bool IsDataTypeSupported(DeviceType device_type, DataType data_type) {
+  if (data_type == DataType::kFloat || data_type == DataType::kDouble) { return true; }
+  return device_type == DeviceType::kGPU && data_type == DataType::kFloat16;
+}
+
+// The fused op keeps the scalars as float, which must not change the result of the op
+bool GetScalar(const user_op::UserOpConfWrapper& conf, DataType data_type, float* scalar) {
+  if (conf.attr<bool>("has_float_operand")) {
+    const double operand = conf.attr<double>("float_operand");
+    *scalar = static_cast<float>(operand);
+    // the scalar ops of float and half cast the operand to float or lower as well
+    return data_type != DataType::kDouble || static_cast<double>(*scalar) == operand;
+  } else {
+    const int64_t operand = conf.attr<int64_t>("int_operand");
+    *scalar = static_cast<float>(operand);
+    return static_cast<int64_t>(*scalar) == operand;
+  }
+}
+
+class FuseElementwisePass final : public JobPass {
+ public:
+  FuseElementwisePass() = default;
+  ~FuseElementwisePass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    return ctx.job_desc().job_conf().enable_fuse_elementwise();
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, &job_builder);
+  }
+};
+
+Maybe<void> FuseElementwisePass::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
+  HashSet<std::string> ctrl_in_op_names;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    for (const std::string& ctrl_in_op_name : op_node->op().op_conf().ctrl_in_op_name()) {
+      ctrl_in_op_names.insert(ctrl_in_op_name);
+    }
+  });
+  const auto ChainArgs4OpNode = [](const OpNode* op_node) -> const ChainArgs* {
+    const OperatorConf& op_conf = op_node->op().op_conf();
+    if (!op_conf.has_user_conf()) { return nullptr; }
+    const auto it = ChainArgs4OpTypeName().find(op_conf.user_conf().op_type_name());
+    if (it == ChainArgs4OpTypeName().end()) { return nullptr; }
+    return &it->second;
+  };
+  const auto ChainInput = [&](const OpNode* op_node) {
+    const user_op::UserOpConfWrapper conf(op_node->op().op_conf());
+    return GenLogicalBlobId(conf.input(ChainArgs4OpNode(op_node)->input, 0));
+  };
+  const auto ChainOutput = [&](const OpNode* op_node) {
+    const user_op::UserOpConfWrapper conf(op_node->op().op_conf());
+    return GenLogicalBlobId(conf.output(ChainArgs4OpNode(op_node)->output, 0));
+  };
+  const auto IsFusible = [&](const OpNode* op_node) -> bool {
+    if (ChainArgs4OpNode(op_node) == nullptr) { return false; }
+    const OperatorConf& op_conf = op_node->op().op_conf();
+    if (!op_conf.ctrl_in_op_name().empty()) { return false; }
+    if (ctrl_in_op_names.find(op_conf.name()) != ctrl_in_op_names.end()) { return false; }
+    const DataType data_type = op_node->LogicalBlobDesc4Lbi(ChainOutput(op_node)).data_type();
+    if (!IsDataTypeSupported(op_node->parallel_desc().device_type(), data_type)) { return false; }
+    const user_op::UserOpConfWrapper conf(op_conf);
+    if (conf.op_type_name() == "scalar_add" || conf.op_type_name() == "scalar_mul") {
+      float scalar = 0;
+      if (!GetScalar(conf, data_type, &scalar)) { return false; }
+    }
+    if (conf.op_type_name() == "bias_add" && conf.input("b", 0) == conf.input("a", 0)) {
+      return false;
+    }
+    return true;
+  };
+  // The chain value produced by `op_node` is only read by the next op, as its chain value, on the
+  // same devices and with the same sbp, so that it needs not be kept in a blob
+  const auto NextInChain = [&](const OpNode* op_node) -> const OpNode* {
+    if (op_node->out_edges().size() != 1) { return nullptr; }
+    const OpEdge* out_edge = op_node->SoleOutEdge();
+    const LogicalBlobId lbi = ChainOutput(op_node);
+    if (out_edge->lbis().size() != 1 || out_edge->lbis().front() != lbi) { return nullptr; }
+    const OpNode* next = out_edge->dst_node();
+    if (!IsFusible(next)) { return nullptr; }
+    if (ChainInput(next) != lbi) { return nullptr; }
+    int64_t read_cnt = 0;
+    for (const std::string& ibn : next->op().input_bns()) {
+      if (next->op().BnInOp2Lbi(ibn) == lbi) { read_cnt += 1; }
+    }
+    if (read_cnt != 1) { return nullptr; }
+    if (next->parallel_desc() != op_node->parallel_desc()) { return nullptr; }
+    const SbpParallel& sbp_parallel = op_node->SbpParallel4Lbi(lbi);
+    if (next->SbpParallel4Lbi(lbi) != sbp_parallel) { return nullptr; }
+    if (next->SbpParallel4Lbi(ChainOutput(next)) != sbp_parallel) { return nullptr; }
+    const BlobDesc& blob_desc = op_node->LogicalBlobDesc4Lbi(lbi);
+    const BlobDesc& next_blob_desc = next->LogicalBlobDesc4Lbi(ChainOutput(next));
+    if (blob_desc.shape() != next_blob_desc.shape()) { return nullptr; }
+    if (blob_desc.data_type() != next_blob_desc.data_type()) { return nullptr; }
+    return next;
+  };
+  HashSet<const OpNode*> nexts;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    if (!IsFusible(op_node)) { return; }
+    const OpNode* next = NextInChain(op_node);
+    if (next != nullptr) { nexts.insert(next); }
+  });
+
+  std::vector<std::vector<const OpNode*>> groups;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    if (!IsFusible(op_node) || nexts.find(op_node) != nexts.end()) { return; }
+    // `op_node` heads a chain, which is cut into groups within the limits of the kernels
+    std::vector<const OpNode*> group;
+    int32_t num_operands = 0;
+    for (const OpNode* node = op_node; node != nullptr; node = NextInChain(node)) {
+      const bool is_bias_add = node->op().op_conf().user_conf().op_type_name() == "bias_add";
+      if (group.size() == kFusedElementwiseMaxNumSteps
+          || (is_bias_add && num_operands == kFusedElementwiseMaxNumOperands)) {
+        if (group.size() > 1) { groups.push_back(group); }
+        group.clear();
+        num_operands = 0;
+      }
+      group.push_back(node);
+      if (is_bias_add) { num_operands += 1; }
+    }
+    if (group.size() > 1) { groups.push_back(group); }
+  });
+  if (groups.empty()) { return Maybe<void>::Ok(); }
+
+  // The fused op takes the name of the last op of its group, consumers of the last op are
+  // rewired if its output was not named out
+  HashMap<std::string, std::string> old_lbn2new_lbn;
+  std::vector<OperatorConf> fused_op_confs;
+  std::vector<OperatorConf> del_op_confs;
+  HashSet<std::string> rewritten_op_names;
+  for (const auto& group : groups) {
+    const OpNode* tail = group.back();
+    const DataType data_type = tail->LogicalBlobDesc4Lbi(ChainOutput(tail)).data_type();
+    user_op::UserOpConfWrapperBuilder fused_op_builder(tail->op().op_name());
+    fused_op_builder.OpTypeName("fused_elementwise")
+        .Input("in", GenLogicalBlobName(ChainInput(group.front())));
+    std::vector<std::string> op_type_names;
+    std::vector<float> scalars;
+    std::vector<int32_t> axes;
+    for (const OpNode* node : group) {
+      const user_op::UserOpConfWrapper conf(node->op().op_conf());
+      float scalar = 0;
+      int32_t axis = -1;
+      if (conf.op_type_name() == "scalar_add" || conf.op_type_name() == "scalar_mul") {
+        CHECK(GetScalar(conf, data_type, &scalar));
+      } else if (conf.op_type_name() == "leaky_relu") {
+        scalar = conf.attr<float>("alpha");
+      } else if (conf.op_type_name() == "bias_add") {
+        axis = conf.attr<int32_t>("axis");
+        fused_op_builder.Input("in", conf.input("b", 0));
+      }
+      op_type_names.push_back(conf.op_type_name());
+      scalars.push_back(scalar);
+      axes.push_back(axis);
+      rewritten_op_names.insert(conf.op_name());
+      if (node != tail) { del_op_confs.push_back(node->op().op_conf()); }
+    }
+    const user_op::UserOpConfWrapper fused_op = fused_op_builder.Output("out")
+                                                    .Attr("op_type_names", op_type_names)
+                                                    .Attr("scalars", scalars)
+                                                    .Attr("axes", axes)
+                                                    .Build();
+    const std::string old_lbn = GenLogicalBlobName(ChainOutput(tail));
+    if (fused_op.output("out", 0) != old_lbn) {
+      old_lbn2new_lbn[old_lbn] = fused_op.output("out", 0);
+    }
+    OperatorConf fused_op_conf = tail->op().op_conf();
+    *fused_op_conf.mutable_user_conf() = fused_op.op_conf().user_conf();
+    fused_op_confs.push_back(fused_op_conf);
+  }
+  for (OperatorConf& fused_op_conf : fused_op_confs) {
+    auto* in = (*fused_op_conf.mutable_user_conf()->mutable_input())["in"].mutable_s();
+    FOR_RANGE(int32_t, i, 0, in->size()) {
+      const auto it = old_lbn2new_lbn.find(in->Get(i));
+      if (it != old_lbn2new_lbn.end()) { *in->Mutable(i) = it->second; }
+    }
+  }
+  HashMap<std::string, OperatorConf> op_name2op_conf;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    const std::string& op_name = op_node->op().op_name();
+    if (rewritten_op_names.find(op_name) != rewritten_op_names.end()) { return; }
+    for (const std::string& ibn : op_node->op().input_bns()) {
+      const auto it = old_lbn2new_lbn.find(GenLogicalBlobName(op_node->op().BnInOp2Lbi(ibn)));
+      if (it == old_lbn2new_lbn.end()) { continue; }
+      if (op_name2op_conf.find(op_name) == op_name2op_conf.end()) {
+        op_name2op_conf[op_name] = op_node->op().op_conf();
+      }
+      const auto& old_val =
+          ReplaceInputLbnInOpCustomizedConf(&op_name2op_conf.at(op_name), ibn, it->second);
+      CHECK_EQ(it->first, old_val);
+    }
+  });
+  job_builder->DelOps(del_op_confs);
+  job_builder->MutOpsOnlyOnce(fused_op_confs);
+  for (const auto& pair : op_name2op_conf) { job_builder->MutOpsOnlyOnce({pair.second}); }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("FuseElementwisePass", FuseElementwisePass);
+
+}  // namespace oneflow
@@ -110,12 +110,7 @@ void JobCompleter::Complete(Job* job) const {
   WithOpGraphAndMutJobBuilder(job, &AddGlobalOutputCriticalSections);
   JobPass4Name("DumpTimeShapeAndBlobParallelConfPass")(job, &job_pass_ctx);
   if (XrtCompilationEnabled(GlobalJobDesc())) {
-#ifdef OF_WITH_XRT
     WithOpGraphAndMutJob(job, &RebuildXrtCompiledJob);
-#else
-    LOG(WARNING) << "It will not use XLA or TensorRT since WITH_XLA or "
-                    "WITH_TENSORRT was not enabled when compiling the project.";
-#endif  // OF_WITH_XRT
   }
   CheckOpGraph(OpGraph(*job));
 }
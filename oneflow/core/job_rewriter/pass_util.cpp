@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/job_rewriter/pass_util.h"
+#include "oneflow/core/framework/framework.h"
 
 namespace oneflow {
 
@@ -23,6 +24,37 @@ bool IsNodeInList(const HashSet<std::string>& op_list, OpNode* node) {
   return IsKeyFound(op_list, op_type);
 }
 
+double LogicalFlops4OpNode(const OpNode* op_node) {
+  const Operator& op = op_node->op();
+  const auto ElemCnt4Bn = [&](const std::string& bn) -> double {
+    return op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(bn)).shape().elem_cnt();
+  };
+  const auto Shape4Bn = [&](const std::string& bn) -> const Shape& {
+    return op_node->LogicalBlobDesc4Lbi(op.BnInOp2Lbi(bn)).shape();
+  };
+  const std::string op_type_name =
+      op.op_conf().has_user_conf() ? op.op_conf().user_conf().op_type_name() : "";
+  if (op_type_name == "matmul" || op_type_name == "batch_matmul"
+      || op_type_name == "broadcast_matmul") {
+    const Shape& a_shape = Shape4Bn(GenRepeatedBn("a", 0));
+    const bool transpose_a = user_op::UserOpConfWrapper(op.op_conf()).attr<bool>("transpose_a");
+    const int64_t k = a_shape.At(a_shape.NumAxes() - (transpose_a ? 2 : 1));
+    return 2.0 * ElemCnt4Bn(GenRepeatedBn("out", 0)) * k;
+  }
+  if (op_type_name == "conv1d" || op_type_name == "conv2d" || op_type_name == "conv3d") {
+    const Shape& weight_shape = Shape4Bn(GenRepeatedBn("weight", 0));
+    return 2.0 * ElemCnt4Bn(GenRepeatedBn("out", 0)) * weight_shape.Count(1);
+  }
+  if (op_type_name == "deconv1d" || op_type_name == "deconv2d" || op_type_name == "deconv3d") {
+    const Shape& weight_shape = Shape4Bn(GenRepeatedBn("weight", 0));
+    return 2.0 * ElemCnt4Bn(GenRepeatedBn("in", 0)) * weight_shape.Count(1);
+  }
+  double cost = 0;
+  for (const std::string& ibn : op.input_bns()) { cost += ElemCnt4Bn(ibn); }
+  for (const std::string& obn : op.output_bns()) { cost += ElemCnt4Bn(obn); }
+  return cost;
+}
+
 std::string ReplaceSlashToDash4Lbn(std::string lbn) {
   std::replace(lbn.begin(), lbn.end(), '/', '-');
   return lbn;
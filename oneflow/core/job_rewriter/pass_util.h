@@ -46,6 +46,9 @@ std::string Container2Str(const ContainerT& container,
 
 std::string ReplaceSlashToDash4Lbn(std::string lbn);
 
+// flops of the logical op, elementwise ops are charged the number of elements they touch
+double LogicalFlops4OpNode(const OpNode* op_node);
+
 void DfsTopoGraphTraversal(const OpGraph& graph, bool reversed,
                            std::function<bool(OpNode*)> IsCurNodeStartNode,
                            std::function<bool(OpNode*)> IsCurNodeSatisfied,
@@ -40,6 +40,7 @@ const std::string MOVING_MAX_SUFFIX = "-fake-quant-moving-max";
 const std::string MOVING_MIN_SUFFIX = "-fake-quant-moving-min";
 const std::string MUL_BIAS_SUFFIX = "-fake-quant-mul-bias";
 const std::string OBSERVER_SUFFIX = "-fake-quant-observer";
+const std::string TRAIN_STEP_SUFFIX = "-fake-quant-train-step";
 
 void VerifyQATList(const OpTypeSet& op_list) {
   for (const auto& op_type : op_list) {
@@ -198,6 +199,23 @@ user_op::UserOpConfWrapper MovingMinMaxObserver(const std::string& name, const s
                                                 OpConfMap* inserted_ops) {
   const std::string moving_max_name = name + MOVING_MAX_SUFFIX;
   const std::string moving_min_name = name + MOVING_MIN_SUFFIX;
+  std::string current_train_step_lbn = train_step_lbn;
+  if (current_train_step_lbn.empty()) {
+    // NOTE: predict jobs have no train step, the observer does not read it when not training
+    const std::string train_step_name = name + TRAIN_STEP_SUFFIX;
+    const auto train_step_op = user_op::UserOpConfWrapperBuilder(train_step_name)
+                                   .Op("constant")
+                                   .Output("out")
+                                   .Attr<double>("floating_value", 0)
+                                   .Attr<int64_t>("integer_value", 0)
+                                   .Attr<bool>("is_floating_value", false)
+                                   .Attr<DataType>("dtype", DataType::kInt64)
+                                   .Attr<Shape>("shape", Shape({1}))
+                                   .ScopeSymbolId(scope_symbol_id)
+                                   .Build();
+    (*inserted_ops)[train_step_name] = train_step_op.op_conf();
+    current_train_step_lbn = train_step_op.output("out", 0);
+  }
   const auto moving_max_var =
       Get1DZeroVariableOpConf(moving_max_name, scope_symbol_id, 1, inserted_ops);
   const auto moving_min_var =
@@ -206,7 +224,7 @@ user_op::UserOpConfWrapper MovingMinMaxObserver(const std::string& name, const s
       user_op::UserOpConfWrapperBuilder(name)
           .Op("moving_average_min_max_observer")
           .Input("in", input)
-          .Input("current_train_step", train_step_lbn)
+          .Input("current_train_step", current_train_step_lbn)
           .Input("moving_max",
                  GenLogicalBlobName(moving_max_var.name(), moving_max_var.variable_conf().out()))
           .Input("moving_min",
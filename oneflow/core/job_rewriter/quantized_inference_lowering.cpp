@@ -0,0 +1,166 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/job_rewriter/job_pass.h"
+
+namespace oneflow {
+
+namespace {
+
+// Returns the fake_quantization op producing the input, or nullptr
+const OpNode* FakeQuantNode4Input(const OpGraph& op_graph, const std::string& lbn) {
+  const OpNode* producer = op_graph.OpNode4OpName(GenLogicalBlobId(lbn).op_name());
+  const OperatorConf& op_conf = producer->op().op_conf();
+  if (!op_conf.has_user_conf() || op_conf.user_conf().op_type_name() != "fake_quantization") {
+    return nullptr;
+  }
+  return producer;
+}
+
+bool IsVariableFakeQuant(const OpGraph& op_graph, const user_op::UserOpConfWrapper& fake_quant) {
+  const std::string& in_op_name = GenLogicalBlobId(fake_quant.input("in", 0)).op_name();
+  return op_graph.OpNode4OpName(in_op_name)->op().op_conf().has_variable_conf();
+}
+
+int64_t ScaleElemCnt(const OpNode* fake_quant_node, const user_op::UserOpConfWrapper& fake_quant) {
+  return fake_quant_node->LogicalBlobDesc4Lbi(GenLogicalBlobId(fake_quant.input("scale", 0)))
+      .shape()
+      .elem_cnt();
+}
+
+// Replaces cpu matmul and conv2d of a QAT predict job, whose inputs are fake quantized activations
+// and variables, with quantized_matmul and quantized_conv2d. The int8 kernels quantize the same
+// way as fake_quantization, but compute in int32 and fold scales and zero points when
+// dequantizing. Fake quant ops that have no other consumers are removed.
+class QuantizedInferenceLowering final : public JobPass {
+ public:
+  QuantizedInferenceLowering() = default;
+  ~QuantizedInferenceLowering() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    const JobConfigProto& job_conf = ctx.job_desc().job_conf();
+    return job_conf.enable_quantization_aware_training()
+           && job_conf.qat_config().lower_to_int8_kernels() && !ctx.job_desc().IsTrain();
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, &job_builder);
+  }
+};
+
+Maybe<void> QuantizedInferenceLowering::Apply(const OpGraph& op_graph,
+                                              JobBuilder* job_builder) const {
+  HashSet<const OpNode*> lowered_nodes;
+  HashSet<const OpNode*> fake_quant_nodes;
+  std::vector<OperatorConf> lowered_op_confs;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    const OperatorConf& op_conf = op_node->op().op_conf();
+    if (!op_conf.has_user_conf()) { return; }
+    const std::string& op_type_name = op_conf.user_conf().op_type_name();
+    if (op_type_name != "matmul" && op_type_name != "conv2d") { return; }
+    if (op_node->parallel_desc().device_type() != DeviceType::kCPU) { return; }
+    const user_op::UserOpConfWrapper user_op_conf(op_conf);
+    const bool is_matmul = op_type_name == "matmul";
+    const std::string in_arg_name = is_matmul ? "a" : "in";
+    const std::string weight_arg_name = is_matmul ? "b" : "weight";
+
+    const OpNode* in_fq_node = FakeQuantNode4Input(op_graph, user_op_conf.input(in_arg_name, 0));
+    const OpNode* weight_fq_node =
+        FakeQuantNode4Input(op_graph, user_op_conf.input(weight_arg_name, 0));
+    if (in_fq_node == nullptr || weight_fq_node == nullptr) { return; }
+    const user_op::UserOpConfWrapper in_fq(in_fq_node->op().op_conf());
+    const user_op::UserOpConfWrapper weight_fq(weight_fq_node->op().op_conf());
+    if (!IsVariableFakeQuant(op_graph, weight_fq)) { return; }
+    if (weight_fq.attr<std::string>("quantization_scheme") != "symmetric") { return; }
+    const int32_t quantization_bit = in_fq.attr<int32_t>("quantization_bit");
+    if (weight_fq.attr<int32_t>("quantization_bit") != quantization_bit) { return; }
+    const LogicalBlobId in_lbi = GenLogicalBlobId(in_fq.input("in", 0));
+    if (in_fq_node->LogicalBlobDesc4Lbi(in_lbi).data_type() != DataType::kFloat) { return; }
+    if (ScaleElemCnt(in_fq_node, in_fq) != 1) { return; }
+    const bool weight_per_channel = ScaleElemCnt(weight_fq_node, weight_fq) > 1;
+
+    user_op::UserOpConfWrapperBuilder builder(op_conf.name());
+    if (is_matmul) {
+      if (user_op_conf.attr<bool>("transpose_a")) { return; }
+      if (user_op_conf.has_input("_add_to_output", 0)) { return; }
+      if (in_fq_node->LogicalBlobDesc4Lbi(in_lbi).shape().NumAxes() != 2) { return; }
+      const bool transpose_b = user_op_conf.attr<bool>("transpose_b");
+      if (weight_per_channel && !transpose_b) { return; }
+      builder.Op("quantized_matmul")
+          .Input("a", in_fq.input("in", 0))
+          .Input("a_scale", in_fq.input("scale", 0))
+          .Input("a_zero_point", in_fq.input("zero_point", 0))
+          .Input("b", weight_fq.input("in", 0))
+          .Input("b_scale", weight_fq.input("scale", 0))
+          .Attr<bool>("transpose_b", transpose_b);
+    } else {
+      if (user_op_conf.attr<std::string>("data_format") != "channels_first") { return; }
+      if (user_op_conf.attr<int32_t>("groups") != 1) { return; }
+      builder.Op("quantized_conv2d")
+          .Input("in", in_fq.input("in", 0))
+          .Input("in_scale", in_fq.input("scale", 0))
+          .Input("in_zero_point", in_fq.input("zero_point", 0))
+          .Input("weight", weight_fq.input("in", 0))
+          .Input("weight_scale", weight_fq.input("scale", 0))
+          .Attr<int32_t>("filters", user_op_conf.attr<int32_t>("filters"))
+          .Attr<std::vector<int32_t>>("padding_before",
+                                      user_op_conf.attr<std::vector<int32_t>>("padding_before"))
+          .Attr<std::vector<int32_t>>("kernel_size",
+                                      user_op_conf.attr<std::vector<int32_t>>("kernel_size"))
+          .Attr<std::vector<int32_t>>("strides", user_op_conf.attr<std::vector<int32_t>>("strides"))
+          .Attr<std::vector<int32_t>>("dilation_rate",
+                                      user_op_conf.attr<std::vector<int32_t>>("dilation_rate"));
+      if (user_op_conf.has_input("bias", 0)) {
+        builder.Input("bias", user_op_conf.input("bias", 0));
+      }
+    }
+    OperatorConf new_op_conf =
+        builder.Output("out")
+            .Attr<int32_t>("quantization_bit", quantization_bit)
+            .Attr<std::string>("quantization_scheme",
+                               in_fq.attr<std::string>("quantization_scheme"))
+            .ScopeSymbolId(op_conf.scope_symbol_id())
+            .Build()
+            .op_conf();
+    new_op_conf.set_device_tag(op_conf.device_tag());
+    lowered_op_confs.push_back(new_op_conf);
+    lowered_nodes.insert(op_node);
+    fake_quant_nodes.insert(in_fq_node);
+    fake_quant_nodes.insert(weight_fq_node);
+  });
+  job_builder->MutOpsOnlyOnce(lowered_op_confs);
+
+  std::vector<std::string> del_op_names;
+  for (const OpNode* fake_quant_node : fake_quant_nodes) {
+    bool all_consumers_lowered = true;
+    for (const OpEdge* edge : fake_quant_node->out_edges()) {
+      if (!IsKeyFound(lowered_nodes, edge->dst_node())) { all_consumers_lowered = false; }
+    }
+    if (all_consumers_lowered) { del_op_names.push_back(fake_quant_node->op().op_name()); }
+  }
+  job_builder->DelOps(del_op_names);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("QuantizedInferenceLowering", QuantizedInferenceLowering);
+
+}  // namespace oneflow
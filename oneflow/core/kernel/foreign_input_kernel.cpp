@@ -28,8 +28,18 @@ void ForeignInputKernel::ForwardDataContent(
                                    ->Get(buffer_name)
                                    ->TryReceive(&foreign_job_instance);
   CHECK_NE(buffer_status, kBufferStatusEmpty);
+  Blob* out_blob = BnInOp2Blob("out");
+  char* body = static_cast<char*>(out_blob->ForceMutDptr());
+  auto regst_body_it = out_blob2regst_body_.find(out_blob);
+  if (regst_body_it == out_blob2regst_body_.end()) {
+    regst_body_it = out_blob2regst_body_.emplace(out_blob, body).first;
+  } else if (body != regst_body_it->second) {
+    // the buffer lent by the previous job instance is not valid any more
+    out_blob->reset_dptr(regst_body_it->second);
+  }
   if (buffer_status == kBufferStatusSuccess) {
-    OfBlob ofblob(ctx.device_ctx, BnInOp2Blob("out"));
+    OfBlob ofblob(ctx.device_ctx, out_blob);
+    ofblob.set_is_host_body_lendable(true);
     foreign_job_instance->PushBlob(reinterpret_cast<uint64_t>(&ofblob));
   }
 }
@@ -34,6 +34,9 @@ class ForeignInputKernel final : public KernelIf<DeviceType::kCPU> {
  private:
   void ForwardDataContent(const KernelCtx& ctx,
                           std::function<Blob*(const std::string&)> BnInOp2Blob) const override;
+
+  // the regst memory of each out blob, whose body may have been lent a caller buffer
+  mutable HashMap<const Blob*, char*> out_blob2regst_body_;
 };
 
 }  // namespace oneflow
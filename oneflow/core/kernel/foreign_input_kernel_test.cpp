@@ -0,0 +1,120 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/kernel/foreign_input_kernel.h"
+#include "oneflow/core/common/buffer_manager.h"
+#include "oneflow/core/register/ofblob.h"
+#include "oneflow/core/register/runtime_blob_desc.h"
+#include "oneflow/core/job/foreign_job_instance.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/global_for.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+const std::string kOfBlobBufferName = "ForeignInput-test";
+constexpr int64_t kElemCnt = 4;
+
+class LendingJobInstance final : public ForeignJobInstance {
+ public:
+  // lends buf as the body, or copies it into the regst if not lendable
+  LendingJobInstance(std::vector<float>* buf, bool lend) : buf_(buf), lend_(lend) {}
+  ~LendingJobInstance() override = default;
+
+  void PushBlob(uint64_t ofblob_ptr) const override {
+    auto* of_blob = reinterpret_cast<OfBlob*>(ofblob_ptr);
+    ASSERT_TRUE(of_blob->is_host_body_lendable());
+    if (lend_) {
+      of_blob->LendHostBody(reinterpret_cast<char*>(buf_->data()), buf_->size() * sizeof(float));
+    } else {
+      of_blob->StaticTensorAutoMemCopyFrom(buf_->data(), buf_->size());
+    }
+  }
+
+ private:
+  std::vector<float>* buf_;
+  bool lend_;
+};
+
+KernelConf ForeignInputKernelConf() {
+  KernelConf kernel_conf;
+  OperatorConf* op_conf = kernel_conf.mutable_op_attribute()->mutable_op_conf();
+  op_conf->set_name("foreign_input");
+  op_conf->set_device_tag("cpu");
+  ForeignInputOpConf* conf = op_conf->mutable_foreign_input_conf();
+  conf->set_out("out");
+  conf->set_ofblob_buffer_name(kOfBlobBufferName);
+  conf->mutable_blob_conf()->mutable_shape()->add_dim(kElemCnt);
+  conf->mutable_blob_conf()->set_data_type(DataType::kFloat);
+  return kernel_conf;
+}
+
+void PushAndLaunch(const Kernel& kernel, Blob* out_blob, std::vector<float>* buf, bool lend) {
+  auto* buffer_mgr = Global<BufferMgr<std::shared_ptr<ForeignJobInstance>>>::Get();
+  buffer_mgr->Get(kOfBlobBufferName)->Send(std::make_shared<LendingJobInstance>(buf, lend));
+  KernelCtx ctx;
+  kernel.Launch(ctx, [&](const std::string& bn_in_op) -> Blob* {
+    return bn_in_op == "out" ? out_blob : nullptr;
+  });
+}
+
+}  // namespace
+
+TEST(ForeignInputKernel, lend_host_body_back_to_back) {
+  Resource resource;
+  resource.set_machine_num(1);
+  resource.set_cpu_device_num(1);
+  Global<ResourceDesc, ForSession>::New(resource);
+  Global<BufferMgr<std::shared_ptr<ForeignJobInstance>>>::New();
+  Global<BufferMgr<std::shared_ptr<ForeignJobInstance>>>::Get()->NewBuffer(kOfBlobBufferName, 2);
+  {
+    JobDesc job_desc(JobConfigProto{});
+    const auto kernel = ConstructKernel(&job_desc, ForeignInputKernelConf(), nullptr);
+
+    const BlobDesc blob_desc(Shape({kElemCnt}), DataType::kFloat);
+    const RtBlobDesc rt_blob_desc(blob_desc);
+    std::vector<char> header(rt_blob_desc.ByteSizeOfBlobHeader());
+    std::vector<float> regst_body(kElemCnt, 0);
+    MemoryCase mem_case;
+    mem_case.mutable_host_mem();
+    Blob out_blob(mem_case, &rt_blob_desc, header.data(),
+                  reinterpret_cast<char*>(regst_body.data()));
+
+    std::vector<float> first(kElemCnt, 1);
+    std::vector<float> second(kElemCnt, 2);
+    PushAndLaunch(*kernel, &out_blob, &first, true);
+    ASSERT_EQ(out_blob.dptr<float>(), first.data());
+    PushAndLaunch(*kernel, &out_blob, &second, true);
+    ASSERT_EQ(out_blob.dptr<float>(), second.data());
+    FOR_RANGE(int64_t, i, 0, kElemCnt) { ASSERT_EQ(out_blob.dptr<float>()[i], 2); }
+    ASSERT_EQ(first, std::vector<float>(kElemCnt, 1));
+
+    // a job instance copying its input gets the regst memory back
+    std::vector<float> third(kElemCnt, 3);
+    PushAndLaunch(*kernel, &out_blob, &third, false);
+    ASSERT_EQ(out_blob.dptr<float>(), regst_body.data());
+    ASSERT_EQ(regst_body, third);
+    ASSERT_EQ(second, std::vector<float>(kElemCnt, 2));
+  }
+  Global<BufferMgr<std::shared_ptr<ForeignJobInstance>>>::Delete();
+  Global<ResourceDesc, ForSession>::Delete();
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/kernel.h"
+#include "oneflow/user/kernels/variable_version.h"
 
 namespace oneflow {
 
@@ -84,6 +85,7 @@ class ModelInitKernel final : public KernelIf<DeviceType::kCPU> {
         UNIMPLEMENTED();
       }
     }
+    IncreaseVariableVersion();
   }
 };
 
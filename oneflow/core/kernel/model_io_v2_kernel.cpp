@@ -17,6 +17,7 @@ limitations under the License.
 #include "oneflow/core/register/tensor_slice_copier.h"
 #include "oneflow/core/device/cpu_device_context.h"
 #include "oneflow/core/job/machine_context.h"
+#include "oneflow/user/kernels/variable_version.h"
 
 namespace oneflow {
 
@@ -258,6 +259,7 @@ class ModelInitV2Kernel final : public KernelIf<device_type> {
       UNIMPLEMENTED();
     }
     *counter_ += 1;
+    IncreaseVariableVersion();
   }
 
   std::unique_ptr<int64_t> counter_;
@@ -300,6 +302,7 @@ class ModelLoadV2Kernel final : public KernelIf<device_type> {
     const std::string snapshot_path = SyncReadStringFromBlob<device_type>(ctx.device_ctx, path);
     SnapshotReader reader(snapshot_path);
     reader.Read(var_lbn, logical_blob_shape, slice, ref_accessor.host_blob());
+    IncreaseVariableVersion();
   }
 };
 
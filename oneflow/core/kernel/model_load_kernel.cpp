@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/kernel/kernel.h"
 #include "oneflow/core/common/str_util.h"
+#include "oneflow/user/kernels/variable_version.h"
 #include <iostream>
 
 namespace oneflow {
@@ -70,6 +71,7 @@ class ModelLoadKernel final : public KernelIf<DeviceType::kCPU> {
                                                          random_seed_gen(), out_i);
       }
     }
+    IncreaseVariableVersion();
   }
 };
 
@@ -18,6 +18,7 @@ limitations under the License.
 #include "oneflow/core/device/memory_copier.h"
 #include "oneflow/core/kernel/kernel_util.h"
 #include "oneflow/core/kernel/slice_boxing_kernel_util.h"
+#include "oneflow/core/actor/boxing_traffic_counter.h"
 
 namespace oneflow {
 
@@ -32,12 +33,16 @@ class SliceBoxingKernel : public KernelIf<device_type> {
   virtual const SliceBoxingConf& GetCustomizedBoxingConf() const = 0;
   MemoryCopier* memory_copier() const;
   const std::vector<std::shared_ptr<TensorSliceCopier>>& tensor_slice_copier_vec() const;
+  void CountTraffic() const;
 
  private:
   void VirtualKernelInit() override;
 
   std::vector<std::shared_ptr<TensorSliceCopier>> tensor_slice_copier_vec_;
   std::unique_ptr<MemoryCopier> memory_copier_;
+  BoxingTrafficCount* traffic_count_;
+  // bytes the copiers move, i.e. the intersections of the in slices with the out slice
+  int64_t traffic_byte_size_;
 };
 
 template<DeviceType device_type, typename T>
@@ -76,6 +81,26 @@ void SliceBoxingKernel<device_type, T>::VirtualKernelInit() {
     tensor_slice_copier_vec_.emplace_back(
         new TensorSliceCopier(out_slice, in_slice, this->kernel_conf().data_type()));
   }
+  traffic_count_ = nullptr;
+  traffic_byte_size_ = 0;
+  if (Global<BoxingTrafficCounter>::Get() != nullptr) {
+    const std::string kind =
+        this->op_conf().has_slice_boxing_add_conf() ? "slice_boxing_add" : "slice_boxing_copy";
+    traffic_count_ =
+        Global<BoxingTrafficCounter>::Get()->NewCount(kind, this->op_conf().name(), conf.lbi());
+    for (const TensorSliceViewProto& in_slice_proto : conf.in_slice()) {
+      const TensorSliceView intersection = out_slice.Intersect(TensorSliceView(in_slice_proto));
+      if (intersection.IsEmpty()) { continue; }
+      traffic_byte_size_ += intersection.shape().elem_cnt()
+                            * GetSizeOfDataType(this->kernel_conf().data_type());
+    }
+  }
+}
+
+template<DeviceType device_type, typename T>
+void SliceBoxingKernel<device_type, T>::CountTraffic() const {
+  if (traffic_count_ == nullptr) { return; }
+  traffic_count_->Add(traffic_byte_size_);
 }
 
 template<DeviceType device_type, typename T>
@@ -102,6 +127,7 @@ void SliceBoxingCopyKernel<device_type, T>::ForwardDataContent(
     const Blob* in_i = BnInOp2Blob(GenRepeatedBn("in", i));
     this->tensor_slice_copier_vec().at(i)->Copy(ctx.device_ctx, *this->memory_copier(), out, in_i);
   }
+  this->CountTraffic();
 }
 
 template<DeviceType device_type, typename T>
@@ -145,6 +171,7 @@ void SliceBoxingAddKernel<device_type, T>::ForwardDataContent(
       }
     }
   }
+  this->CountTraffic();
 }
 
 ADD_DEFAULT_KERNEL_CREATOR(OperatorConf::kSliceBoxingCopyConf, SliceBoxingCopyKernel,
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/util/host_arithemetic_interface.h"
+#include "oneflow/core/kernel/util/host_transpose.h"
 #include "oneflow/core/register/blob.h"
 #include "oneflow/core/operator/op_conf_util.h"
 
@@ -21,60 +22,6 @@ namespace oneflow {
 
 namespace {
 
-void ComputeOffset(const int32_t num_axes, const int64_t* shape, const int32_t* permutation,
-                   DimVector& offset) {
-  offset.resize(num_axes);
-  DimVector buff(num_axes);
-  int64_t cur_offset = 1;
-  for (int32_t i = num_axes - 1; i >= 0; --i) {
-    buff[i] = cur_offset;
-    cur_offset *= shape[i];
-  }
-  for (int32_t i = 0; i < num_axes; ++i) { offset[permutation[i]] = buff[i]; }
-}
-
-void IncreaseIndex(const int64_t* shape, DimVector& index) {
-  for (int32_t i = index.size() - 1; i >= 0; --i) {
-    ++index[i];
-    if (index[i] >= shape[i]) {
-      index[i] -= shape[i];
-    } else {
-      break;
-    }
-  }
-}
-
-template<typename T>
-void TransposeImpl(DeviceCtx* ctx, const int32_t num_axis, const ShapeView& x_shape,
-                   const ShapeView& y_shape, const std::vector<int32_t>& permutation,
-                   const int64_t elem_cnt, const T* x, T* y) {
-  int64_t block_size = 1;
-  int32_t shared_idxs_num = 0;
-  for (int32_t i = num_axis - 1; i >= 0 && permutation[i] == i; --i) {
-    block_size *= y_shape.At(i);
-    ++shared_idxs_num;
-  }
-  if (num_axis < 2 || shared_idxs_num == num_axis) {
-    memcpy(y, x, elem_cnt * sizeof(T));
-    return;
-  }
-  int32_t trans_axis = num_axis - shared_idxs_num;
-  DimVector x_to_y_offset;
-  ComputeOffset(trans_axis, y_shape.ptr(), permutation.data(), x_to_y_offset);
-  DimVector x_index_digits(trans_axis, 0);
-  int64_t num_blocks = elem_cnt / block_size;
-  FOR_RANGE(int64_t, x_idx, 0, num_blocks) {
-    int64_t y_idx = std::inner_product(x_to_y_offset.cbegin(), x_to_y_offset.cend(),
-                                       x_index_digits.cbegin(), 0);
-    if (block_size == 1) {
-      y[y_idx] = x[x_idx];
-    } else {
-      memcpy(y + block_size * y_idx, x + block_size * x_idx, block_size * sizeof(T));
-    }
-    IncreaseIndex(x_shape.ptr(), x_index_digits);
-  }
-}
-
 template<typename T>
 void ConstantInitializer(const T& value, Blob* blob) {
   T* dptr = blob->mut_dptr<T>();
@@ -89,7 +36,7 @@ void ArithemeticIf<DeviceType::kCPU>::Transpose(DeviceCtx* ctx, const int32_t nu
                                                 const ShapeView& x_shape, const ShapeView& y_shape,
                                                 const std::vector<int32_t>& permutation,
                                                 const int64_t elem_cnt, const float* x, float* y) {
-  TransposeImpl<float>(ctx, num_axis, x_shape, y_shape, permutation, elem_cnt, x, y);
+  HostTranspose<float>(x_shape, permutation, x, y);
 }
 
 void ArithemeticIf<DeviceType::kCPU>::Transpose(DeviceCtx* ctx, const int32_t num_axis,
@@ -97,7 +44,7 @@ void ArithemeticIf<DeviceType::kCPU>::Transpose(DeviceCtx* ctx, const int32_t nu
                                                 const std::vector<int32_t>& permutation,
                                                 const int64_t elem_cnt, const double* x,
                                                 double* y) {
-  TransposeImpl<double>(ctx, num_axis, x_shape, y_shape, permutation, elem_cnt, x, y);
+  HostTranspose<double>(x_shape, permutation, x, y);
 }
 
 void ArithemeticIf<DeviceType::kCPU>::Transpose(DeviceCtx* ctx, const int32_t num_axis,
@@ -105,7 +52,7 @@ void ArithemeticIf<DeviceType::kCPU>::Transpose(DeviceCtx* ctx, const int32_t nu
                                                 const std::vector<int32_t>& permutation,
                                                 const int64_t elem_cnt, const int8_t* x,
                                                 int8_t* y) {
-  TransposeImpl<int8_t>(ctx, num_axis, x_shape, y_shape, permutation, elem_cnt, x, y);
+  HostTranspose<int8_t>(x_shape, permutation, x, y);
 }
 
 void ArithemeticIf<DeviceType::kCPU>::Transpose(DeviceCtx* ctx, const int32_t num_axis,
@@ -113,7 +60,7 @@ void ArithemeticIf<DeviceType::kCPU>::Transpose(DeviceCtx* ctx, const int32_t nu
                                                 const std::vector<int32_t>& permutation,
                                                 const int64_t elem_cnt, const int32_t* x,
                                                 int32_t* y) {
-  TransposeImpl<int32_t>(ctx, num_axis, x_shape, y_shape, permutation, elem_cnt, x, y);
+  HostTranspose<int32_t>(x_shape, permutation, x, y);
 }
 
 void ArithemeticIf<DeviceType::kCPU>::Transpose(DeviceCtx* ctx, const int32_t num_axis,
@@ -121,15 +68,14 @@ void ArithemeticIf<DeviceType::kCPU>::Transpose(DeviceCtx* ctx, const int32_t nu
                                                 const std::vector<int32_t>& permutation,
                                                 const int64_t elem_cnt, const int64_t* x,
                                                 int64_t* y) {
-  TransposeImpl<int64_t>(ctx, num_axis, x_shape, y_shape, permutation, elem_cnt, x, y);
+  HostTranspose<int64_t>(x_shape, permutation, x, y);
 }
 
 void ArithemeticIf<DeviceType::kCPU>::Transpose(DeviceCtx* ctx, const int32_t num_axis,
                                                 const ShapeView& x_shape, const ShapeView& y_shape,
                                                 const PbRf<int32_t>& permutation,
                                                 const int64_t elem_cnt, const float* x, float* y) {
-  TransposeImpl<float>(ctx, num_axis, x_shape, y_shape,
-                       std::vector<int32_t>({permutation.cbegin(), permutation.cend()}), elem_cnt,
+  HostTranspose<float>(x_shape, std::vector<int32_t>({permutation.cbegin(), permutation.cend()}),
                        x, y);
 }
 
@@ -138,8 +84,7 @@ void ArithemeticIf<DeviceType::kCPU>::Transpose(DeviceCtx* ctx, const int32_t nu
                                                 const PbRf<int32_t>& permutation,
                                                 const int64_t elem_cnt, const double* x,
                                                 double* y) {
-  TransposeImpl<double>(ctx, num_axis, x_shape, y_shape,
-                        std::vector<int32_t>({permutation.cbegin(), permutation.cend()}), elem_cnt,
+  HostTranspose<double>(x_shape, std::vector<int32_t>({permutation.cbegin(), permutation.cend()}),
                         x, y);
 }
 
@@ -148,8 +93,7 @@ void ArithemeticIf<DeviceType::kCPU>::Transpose(DeviceCtx* ctx, const int32_t nu
                                                 const PbRf<int32_t>& permutation,
                                                 const int64_t elem_cnt, const int8_t* x,
                                                 int8_t* y) {
-  TransposeImpl<int8_t>(ctx, num_axis, x_shape, y_shape,
-                        std::vector<int32_t>({permutation.cbegin(), permutation.cend()}), elem_cnt,
+  HostTranspose<int8_t>(x_shape, std::vector<int32_t>({permutation.cbegin(), permutation.cend()}),
                         x, y);
 }
 
@@ -158,8 +102,7 @@ void ArithemeticIf<DeviceType::kCPU>::Transpose(DeviceCtx* ctx, const int32_t nu
                                                 const PbRf<int32_t>& permutation,
                                                 const int64_t elem_cnt, const int32_t* x,
                                                 int32_t* y) {
-  TransposeImpl<int32_t>(ctx, num_axis, x_shape, y_shape,
-                         std::vector<int32_t>({permutation.cbegin(), permutation.cend()}), elem_cnt,
+  HostTranspose<int32_t>(x_shape, std::vector<int32_t>({permutation.cbegin(), permutation.cend()}),
                          x, y);
 }
 
@@ -168,8 +111,7 @@ void ArithemeticIf<DeviceType::kCPU>::Transpose(DeviceCtx* ctx, const int32_t nu
                                                 const PbRf<int32_t>& permutation,
                                                 const int64_t elem_cnt, const int64_t* x,
                                                 int64_t* y) {
-  TransposeImpl<int64_t>(ctx, num_axis, x_shape, y_shape,
-                         std::vector<int32_t>({permutation.cbegin(), permutation.cend()}), elem_cnt,
+  HostTranspose<int64_t>(x_shape, std::vector<int32_t>({permutation.cbegin(), permutation.cend()}),
                          x, y);
 }
 
@@ -0,0 +1,270 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/kernel/util/host_transpose.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/framework/multi_thread.h"
+#include <numeric>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#endif
+
+namespace oneflow {
+
+namespace {
+
+// Side of the square tiles the swapped axes are cut into, so that a tile of the source and of the
+// destination both stay in L1
+constexpr int64_t kTransposeTileSize = 32;
+
+// Drops unit axes and merges runs of x axes that are also adjacent and in order in y
+void SimplifyTranspose(const ShapeView& x_shape, const std::vector<int32_t>& permutation,
+                       DimVector* dims, std::vector<int32_t>* perm) {
+  const int32_t num_axes = x_shape.NumAxes();
+  std::vector<int32_t> squeezed_axis(num_axes, -1);
+  DimVector squeezed_dims;
+  FOR_RANGE(int32_t, i, 0, num_axes) {
+    if (x_shape.At(i) == 1) { continue; }
+    squeezed_axis.at(i) = squeezed_dims.size();
+    squeezed_dims.push_back(x_shape.At(i));
+  }
+  std::vector<int32_t> squeezed_perm;
+  for (int32_t axis : permutation) {
+    if (squeezed_axis.at(axis) >= 0) { squeezed_perm.push_back(squeezed_axis.at(axis)); }
+  }
+  // runs of consecutive x axes in y order, as [first, last]
+  std::vector<std::pair<int32_t, int32_t>> runs;
+  for (int32_t axis : squeezed_perm) {
+    if (!runs.empty() && runs.back().second + 1 == axis) {
+      runs.back().second = axis;
+    } else {
+      runs.emplace_back(axis, axis);
+    }
+  }
+  std::vector<int32_t> run_ids(runs.size());
+  std::iota(run_ids.begin(), run_ids.end(), 0);
+  std::sort(run_ids.begin(), run_ids.end(),
+            [&](int32_t lhs, int32_t rhs) { return runs.at(lhs).first < runs.at(rhs).first; });
+  std::vector<int32_t> merged_axis(runs.size());
+  dims->clear();
+  for (int32_t run_id : run_ids) {
+    merged_axis.at(run_id) = dims->size();
+    int64_t dim = 1;
+    FOR_RANGE(int32_t, i, runs.at(run_id).first, runs.at(run_id).second + 1) {
+      dim *= squeezed_dims.at(i);
+    }
+    dims->push_back(dim);
+  }
+  perm->clear();
+  FOR_RANGE(int32_t, i, 0, runs.size()) { perm->push_back(merged_axis.at(i)); }
+}
+
+// Offsets in x and y of an index over some of the outer y axes, stepped like an odometer
+struct OuterIndex {
+  DimVector dims;
+  DimVector x_strides;
+  DimVector y_strides;
+  DimVector idx;
+  int64_t x_offset;
+  int64_t y_offset;
+
+  void Reset(int64_t flat_idx) {
+    idx.assign(dims.size(), 0);
+    x_offset = 0;
+    y_offset = 0;
+    for (int32_t i = dims.size() - 1; i >= 0; --i) {
+      idx.at(i) = flat_idx % dims.at(i);
+      flat_idx /= dims.at(i);
+      x_offset += idx.at(i) * x_strides.at(i);
+      y_offset += idx.at(i) * y_strides.at(i);
+    }
+  }
+  void Next() {
+    for (int32_t i = dims.size() - 1; i >= 0; --i) {
+      idx.at(i) += 1;
+      x_offset += x_strides.at(i);
+      y_offset += y_strides.at(i);
+      if (idx.at(i) < dims.at(i)) { return; }
+      idx.at(i) = 0;
+      x_offset -= dims.at(i) * x_strides.at(i);
+      y_offset -= dims.at(i) * y_strides.at(i);
+    }
+  }
+};
+
+template<typename T>
+void TransposeTileByElem(const T* src, int64_t src_stride, T* dst, int64_t dst_stride,
+                         int64_t rows, int64_t cols) {
+  FOR_RANGE(int64_t, i, 0, rows) {
+    FOR_RANGE(int64_t, j, 0, cols) { dst[j * dst_stride + i] = src[i * src_stride + j]; }
+  }
+}
+
+template<typename T>
+void TransposeTile(const T* src, int64_t src_stride, T* dst, int64_t dst_stride, int64_t rows,
+                   int64_t cols) {
+  TransposeTileByElem(src, src_stride, dst, dst_stride, rows, cols);
+}
+
+#if defined(__SSE2__)
+// 4 byte elements are transposed 4x4 at a time in registers, only their bits are moved
+void TransposeTile4Bytes(const float* src, int64_t src_stride, float* dst, int64_t dst_stride,
+                         int64_t rows, int64_t cols) {
+  const int64_t vec_rows = rows / 4 * 4;
+  const int64_t vec_cols = cols / 4 * 4;
+  for (int64_t i = 0; i < vec_rows; i += 4) {
+    for (int64_t j = 0; j < vec_cols; j += 4) {
+      const float* s = src + i * src_stride + j;
+      __m128 r0 = _mm_loadu_ps(s);
+      __m128 r1 = _mm_loadu_ps(s + src_stride);
+      __m128 r2 = _mm_loadu_ps(s + 2 * src_stride);
+      __m128 r3 = _mm_loadu_ps(s + 3 * src_stride);
+      _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+      float* d = dst + j * dst_stride + i;
+      _mm_storeu_ps(d, r0);
+      _mm_storeu_ps(d + dst_stride, r1);
+      _mm_storeu_ps(d + 2 * dst_stride, r2);
+      _mm_storeu_ps(d + 3 * dst_stride, r3);
+    }
+  }
+  TransposeTileByElem(src + vec_cols, src_stride, dst + vec_cols * dst_stride, dst_stride, rows,
+                      cols - vec_cols);
+  TransposeTileByElem(src + vec_rows * src_stride, src_stride, dst + vec_rows, dst_stride,
+                      rows - vec_rows, vec_cols);
+}
+
+template<>
+void TransposeTile<float>(const float* src, int64_t src_stride, float* dst, int64_t dst_stride,
+                          int64_t rows, int64_t cols) {
+  TransposeTile4Bytes(src, src_stride, dst, dst_stride, rows, cols);
+}
+
+template<>
+void TransposeTile<int32_t>(const int32_t* src, int64_t src_stride, int32_t* dst,
+                            int64_t dst_stride, int64_t rows, int64_t cols) {
+  TransposeTile4Bytes(reinterpret_cast<const float*>(src), src_stride,
+                      reinterpret_cast<float*>(dst), dst_stride, rows, cols);
+}
+#endif
+
+// y[..., j, ..., i] = x[..., i, ..., j], where i is the x axis that becomes the innermost one of y
+// and j is the innermost axis of x
+template<typename T>
+void TransposeInnermost(const DimVector& dims, const std::vector<int32_t>& perm,
+                        const DimVector& x_strides, const DimVector& y_strides, const T* x, T* y) {
+  const int32_t num_axes = dims.size();
+  const int32_t row_axis = perm.back();
+  const int32_t col_y_axis = std::find(perm.begin(), perm.end(), num_axes - 1) - perm.begin();
+  const int64_t rows = dims.at(row_axis);
+  const int64_t cols = dims.at(num_axes - 1);
+  const int64_t x_row_stride = x_strides.at(row_axis);
+  const int64_t y_col_stride = y_strides.at(col_y_axis);
+  OuterIndex outer;
+  int64_t num_outer = 1;
+  FOR_RANGE(int32_t, i, 0, num_axes - 1) {
+    if (i == col_y_axis) { continue; }
+    outer.dims.push_back(dims.at(perm.at(i)));
+    outer.x_strides.push_back(x_strides.at(perm.at(i)));
+    outer.y_strides.push_back(y_strides.at(i));
+    num_outer *= dims.at(perm.at(i));
+  }
+  // a unit is a band of kTransposeTileSize rows of one outer index
+  const int64_t bands_per_outer = RoundUp(rows, kTransposeTileSize) / kTransposeTileSize;
+  user_op::ParallelForEachRange(
+      num_outer * bands_per_outer, kTransposeTileSize * cols, [&](int64_t begin, int64_t end) {
+        OuterIndex index = outer;
+        FOR_RANGE(int64_t, unit, begin, end) {
+          const int64_t band = unit % bands_per_outer;
+          if (unit == begin) {
+            index.Reset(unit / bands_per_outer);
+          } else if (band == 0) {
+            index.Next();
+          }
+          const int64_t row_begin = band * kTransposeTileSize;
+          const int64_t band_rows = std::min(kTransposeTileSize, rows - row_begin);
+          const T* src = x + index.x_offset + row_begin * x_row_stride;
+          T* dst = y + index.y_offset + row_begin;
+          for (int64_t col_begin = 0; col_begin < cols; col_begin += kTransposeTileSize) {
+            TransposeTile<T>(src + col_begin, x_row_stride, dst + col_begin * y_col_stride,
+                             y_col_stride, band_rows,
+                             std::min(kTransposeTileSize, cols - col_begin));
+          }
+        }
+      });
+}
+
+// The innermost axis stays in place, so contiguous rows of y are copied from rows of x
+template<typename T>
+void TransposeRows(const DimVector& dims, const std::vector<int32_t>& perm,
+                   const DimVector& x_strides, const DimVector& y_strides, const T* x, T* y) {
+  const int32_t num_axes = dims.size();
+  const int64_t row_size = dims.back();
+  OuterIndex outer;
+  int64_t num_rows = 1;
+  FOR_RANGE(int32_t, i, 0, num_axes - 1) {
+    outer.dims.push_back(dims.at(perm.at(i)));
+    outer.x_strides.push_back(x_strides.at(perm.at(i)));
+    outer.y_strides.push_back(y_strides.at(i));
+    num_rows *= dims.at(perm.at(i));
+  }
+  user_op::ParallelForEachRange(num_rows, row_size, [&](int64_t begin, int64_t end) {
+    OuterIndex index = outer;
+    index.Reset(begin);
+    FOR_RANGE(int64_t, row, begin, end) {
+      memcpy(y + index.y_offset, x + index.x_offset, row_size * sizeof(T));
+      index.Next();
+    }
+  });
+}
+
+}  // namespace
+
+template<typename T>
+void HostTranspose(const ShapeView& x_shape, const std::vector<int32_t>& permutation, const T* x,
+                   T* y) {
+  CHECK_EQ(x_shape.NumAxes(), permutation.size());
+  const int64_t elem_cnt = x_shape.elem_cnt();
+  if (elem_cnt == 0) { return; }
+  DimVector dims;
+  std::vector<int32_t> perm;
+  SimplifyTranspose(x_shape, permutation, &dims, &perm);
+  const int32_t num_axes = dims.size();
+  if (num_axes <= 1) {
+    memcpy(y, x, elem_cnt * sizeof(T));
+    return;
+  }
+  DimVector x_strides(num_axes);
+  DimVector y_strides(num_axes);
+  x_strides.back() = 1;
+  y_strides.back() = 1;
+  for (int32_t i = num_axes - 2; i >= 0; --i) {
+    x_strides.at(i) = x_strides.at(i + 1) * dims.at(i + 1);
+    y_strides.at(i) = y_strides.at(i + 1) * dims.at(perm.at(i + 1));
+  }
+  if (perm.back() == num_axes - 1) {
+    TransposeRows<T>(dims, perm, x_strides, y_strides, x, y);
+  } else {
+    TransposeInnermost<T>(dims, perm, x_strides, y_strides, x, y);
+  }
+}
+
+#define INSTANTIATE_HOST_TRANSPOSE(type_cpp, type_proto)                         \
+  template void HostTranspose<type_cpp>(const ShapeView& x_shape,                \
+                                        const std::vector<int32_t>& permutation, \
+                                        const type_cpp* x, type_cpp* y);
+OF_PP_FOR_EACH_TUPLE(INSTANTIATE_HOST_TRANSPOSE, ARITHMETIC_DATA_TYPE_SEQ);
+
+}  // namespace oneflow
@@ -0,0 +1,33 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_KERNEL_UTIL_HOST_TRANSPOSE_H_
+#define ONEFLOW_CORE_KERNEL_UTIL_HOST_TRANSPOSE_H_
+
+#include "oneflow/core/common/shape_view.h"
+
+namespace oneflow {
+
+// Writes y with y_shape.At(i) == x_shape.At(permutation[i]). Unit axes are dropped and axes that
+// stay adjacent are merged first. When the last axis stays in place whole rows are copied,
+// otherwise the two axes that swap with the innermost one are transposed in cache sized tiles.
+// Large transposes are split across the global thread pool.
+template<typename T>
+void HostTranspose(const ShapeView& x_shape, const std::vector<int32_t>& permutation, const T* x,
+                   T* y);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_KERNEL_UTIL_HOST_TRANSPOSE_H_
@@ -0,0 +1,131 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <chrono>
+#include "oneflow/core/kernel/util/host_transpose.h"
+#include "oneflow/core/common/shape.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+namespace {
+
+template<typename T>
+void ReferenceTranspose(const Shape& x_shape, const std::vector<int32_t>& permutation, const T* x,
+                        T* y) {
+  const int64_t num_axes = x_shape.NumAxes();
+  DimVector y_dims(num_axes);
+  DimVector x_strides(num_axes);
+  int64_t stride = 1;
+  for (int64_t axis = num_axes - 1; axis >= 0; --axis) {
+    y_dims.at(axis) = x_shape.At(permutation.at(axis));
+    x_strides.at(axis) = stride;
+    stride *= x_shape.At(axis);
+  }
+  FOR_RANGE(int64_t, i, 0, x_shape.elem_cnt()) {
+    int64_t remaining = i;
+    int64_t x_offset = 0;
+    for (int64_t axis = num_axes - 1; axis >= 0; --axis) {
+      x_offset += remaining % y_dims.at(axis) * x_strides.at(permutation.at(axis));
+      remaining /= y_dims.at(axis);
+    }
+    y[i] = x[x_offset];
+  }
+}
+
+template<typename T>
+void TestHostTranspose(const DimVector& x_dims, const std::vector<int32_t>& permutation) {
+  const Shape x_shape(x_dims);
+  std::vector<T> x(x_shape.elem_cnt());
+  FOR_RANGE(size_t, i, 0, x.size()) { x.at(i) = static_cast<T>(i % 113); }
+  std::vector<T> y(x.size(), static_cast<T>(-1));
+  std::vector<T> expected(x.size());
+  HostTranspose<T>(ShapeView(x_shape), permutation, x.data(), y.data());
+  ReferenceTranspose<T>(x_shape, permutation, x.data(), expected.data());
+  ASSERT_TRUE(y == expected);
+}
+
+template<typename T>
+void TestHostTransposeOfAllKinds() {
+  TestHostTranspose<T>({7}, {0});
+  TestHostTranspose<T>({33, 70}, {1, 0});
+  TestHostTranspose<T>({1, 5, 1, 9}, {3, 2, 0, 1});
+  TestHostTranspose<T>({4, 6, 10}, {1, 0, 2});
+  TestHostTranspose<T>({4, 6, 10}, {2, 1, 0});
+  TestHostTranspose<T>({3, 5, 7, 9, 2}, {4, 0, 3, 1, 2});
+  // NCHW <-> NHWC
+  TestHostTranspose<T>({2, 19, 14, 14}, {0, 2, 3, 1});
+  TestHostTranspose<T>({2, 14, 14, 19}, {0, 3, 1, 2});
+  // attention heads
+  TestHostTranspose<T>({2, 37, 4, 16}, {0, 2, 1, 3});
+  TestHostTranspose<T>({2, 4, 37, 16}, {0, 1, 3, 2});
+  // large enough to be split across threads
+  TestHostTranspose<T>({8, 64, 28, 28}, {0, 2, 3, 1});
+  TestHostTranspose<T>({600, 300}, {1, 0});
+}
+
+void TestHostTransposeOfAllDataTypes() {
+  TestHostTransposeOfAllKinds<float>();
+  TestHostTransposeOfAllKinds<double>();
+  TestHostTransposeOfAllKinds<int8_t>();
+  TestHostTransposeOfAllKinds<int32_t>();
+  TestHostTransposeOfAllKinds<int64_t>();
+}
+
+}  // namespace
+
+TEST(HostTranspose, transpose) { TestHostTransposeOfAllDataTypes(); }
+
+TEST(HostTranspose, transpose_multi_thread) {
+  Global<ThreadPool>::New(4);
+  TestHostTransposeOfAllDataTypes();
+  Global<ThreadPool>::Delete();
+}
+
+// Throughput of typical layout changes, run with --gtest_also_run_disabled_tests
+TEST(HostTranspose, DISABLED_transpose_benchmark) {
+  Global<ThreadPool>::New(std::thread::hardware_concurrency());
+  const std::vector<std::tuple<std::string, DimVector, std::vector<int32_t>>> cases = {
+      std::make_tuple("NCHW -> NHWC of (32, 64, 56, 56)", DimVector({32, 64, 56, 56}),
+                      std::vector<int32_t>({0, 2, 3, 1})),
+      std::make_tuple("NHWC -> NCHW of (32, 56, 56, 64)", DimVector({32, 56, 56, 64}),
+                      std::vector<int32_t>({0, 3, 1, 2})),
+      std::make_tuple("split heads of (64, 128, 16, 64)", DimVector({64, 128, 16, 64}),
+                      std::vector<int32_t>({0, 2, 1, 3})),
+      std::make_tuple("transpose keys of (64, 16, 128, 64)", DimVector({64, 16, 128, 64}),
+                      std::vector<int32_t>({0, 1, 3, 2})),
+      std::make_tuple("matrix of (4096, 4096)", DimVector({4096, 4096}),
+                      std::vector<int32_t>({1, 0})),
+  };
+  const int32_t kIters = 20;
+  for (const auto& test_case : cases) {
+    const Shape x_shape(std::get<1>(test_case));
+    const std::vector<int32_t>& permutation = std::get<2>(test_case);
+    std::vector<float> x(x_shape.elem_cnt(), 1.f);
+    std::vector<float> y(x.size());
+    HostTranspose<float>(ShapeView(x_shape), permutation, x.data(), y.data());
+    const auto start = std::chrono::steady_clock::now();
+    FOR_RANGE(int32_t, i, 0, kIters) {
+      HostTranspose<float>(ShapeView(x_shape), permutation, x.data(), y.data());
+    }
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double bytes = static_cast<double>(x.size()) * sizeof(float) * kIters;
+    LOG(INFO) << std::get<0>(test_case) << ": " << bytes / seconds / 1e9 << " GB/s";
+  }
+  Global<ThreadPool>::Delete();
+}
+
+}  // namespace oneflow
@@ -0,0 +1,184 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_OBJECT_MSG_MPSC_LIST_H_
+#define ONEFLOW_CORE_OBJECT_MSG_MPSC_LIST_H_
+
+#include <atomic>
+#include "oneflow/core/object_msg/object_msg_list.h"
+
+namespace oneflow {
+
+#define OBJECT_MSG_DEFINE_MPSC_LIST_HEAD(elem_type, elem_field_name, field_name)                \
+  static_assert(__is_object_message_type__, "this struct is not a object message");             \
+  static_assert(!std::is_same<self_type, elem_type>::value, "self loop link is not supported"); \
+  OF_PRIVATE INCREASE_STATIC_COUNTER(field_counter);                                            \
+  _OBJECT_MSG_DEFINE_MPSC_LIST_HEAD(STATIC_COUNTER(field_counter), elem_type, elem_field_name,  \
+                                    field_name);
+
+#define OBJECT_MSG_MPSC_LIST(obj_msg_type, obj_msg_field)                              \
+  ObjectMsgMpscList<StructField<OBJECT_MSG_TYPE_CHECK(obj_msg_type), EmbeddedListLink, \
+                                OBJECT_MSG_TYPE_CHECK(obj_msg_type)::OF_PP_CAT(        \
+                                    obj_msg_field, _kDssFieldOffset)>>
+
+// details
+
+#define _OBJECT_MSG_DEFINE_MPSC_LIST_HEAD(field_counter, elem_type, elem_field_name, field_name) \
+  _OBJECT_MSG_DEFINE_MPSC_LIST_HEAD_FIELD(elem_type, elem_field_name, field_name)                \
+  OBJECT_MSG_DEFINE_MPSC_LIST_ELEM_STRUCT(field_counter, elem_type, elem_field_name,             \
+                                          field_name);                                           \
+  OBJECT_MSG_DEFINE_MPSC_LIST_LINK_EDGES(field_counter, elem_type, elem_field_name, field_name); \
+  OBJECT_MSG_OVERLOAD_INIT(field_counter, ObjectMsgEmbeddedMpscListHeadInit);                    \
+  OBJECT_MSG_OVERLOAD_DELETE(field_counter, ObjectMsgEmbeddedMpscListHeadDelete);                \
+  DSS_DEFINE_FIELD(field_counter, "object message", OF_PP_CAT(field_name, _ObjectMsgListType),   \
+                   OF_PP_CAT(field_name, _));
+
+#define _OBJECT_MSG_DEFINE_MPSC_LIST_HEAD_FIELD(elem_type, elem_field_name, field_name)        \
+ public:                                                                                       \
+  using OF_PP_CAT(field_name, _ObjectMsgListType) =                                            \
+      TrivialObjectMsgMpscList<StructField<OBJECT_MSG_TYPE_CHECK(elem_type), EmbeddedListLink, \
+                                           OBJECT_MSG_TYPE_CHECK(elem_type)::OF_PP_CAT(        \
+                                               elem_field_name, _kDssFieldOffset)>>;           \
+  const OF_PP_CAT(field_name, _ObjectMsgListType) & field_name() const {                       \
+    return OF_PP_CAT(field_name, _);                                                           \
+  }                                                                                            \
+  OF_PP_CAT(field_name, _ObjectMsgListType) * OF_PP_CAT(mut_, field_name)() {                  \
+    return &OF_PP_CAT(field_name, _);                                                          \
+  }                                                                                            \
+  OF_PP_CAT(field_name, _ObjectMsgListType) * OF_PP_CAT(mutable_, field_name)() {              \
+    return &OF_PP_CAT(field_name, _);                                                          \
+  }                                                                                            \
+                                                                                               \
+ private:                                                                                      \
+  OF_PP_CAT(field_name, _ObjectMsgListType) OF_PP_CAT(field_name, _);
+
+#define OBJECT_MSG_DEFINE_MPSC_LIST_ELEM_STRUCT(field_counter, elem_type, elem_field_name, \
+                                                field_name)                                \
+ public:                                                                                   \
+  template<typename Enabled>                                                               \
+  struct ContainerElemStruct<field_counter, Enabled> final {                               \
+    using type = elem_type;                                                                \
+  };
+
+#define OBJECT_MSG_DEFINE_MPSC_LIST_LINK_EDGES(field_counter, elem_type, elem_field_name, \
+                                               field_name)                                \
+ public:                                                                                  \
+  template<typename Enable>                                                               \
+  struct LinkEdgesGetter<field_counter, Enable> final {                                   \
+    static void Call(std::set<ObjectMsgContainerLinkEdge>* edges) {                       \
+      ObjectMsgContainerLinkEdge edge;                                                    \
+      edge.container_type_name = typeid(self_type).name();                                \
+      edge.container_field_name = OF_PP_STRINGIZE(field_name) "_";                        \
+      edge.elem_type_name = typeid(elem_type).name();                                     \
+      edge.elem_link_name = OF_PP_STRINGIZE(elem_field_name) "_";                         \
+      edges->insert(edge);                                                                \
+    }                                                                                     \
+  };
+
+template<typename WalkCtxType, typename PtrFieldType>
+struct ObjectMsgEmbeddedMpscListHeadInit {
+  static void Call(WalkCtxType* ctx, PtrFieldType* field) { field->__Init__(); }
+};
+
+template<typename WalkCtxType, typename PtrFieldType>
+struct ObjectMsgEmbeddedMpscListHeadDelete {
+  static void Call(WalkCtxType* ctx, PtrFieldType* field) { field->Clear(); }
+};
+
+// Any number of threads may push elements while a single thread moves them out. Each push links a
+// batch of elements onto a lock-free stack, the consumer takes the whole stack with one exchange
+// and splices the batches into its own list in the order they were pushed.
+template<typename LinkField>
+class TrivialObjectMsgMpscList {
+ public:
+  using value_type = typename LinkField::struct_type;
+
+  std::size_t size() const { return size_.load(std::memory_order_acquire); }
+  bool empty() const { return size() == 0; }
+
+  void __Init__() {
+    top_.store(nullptr, std::memory_order_relaxed);
+    size_.store(0, std::memory_order_relaxed);
+  }
+
+  void EmplaceBack(ObjectMsgPtr<value_type>&& ptr) {
+    Batch* batch = new Batch();
+    batch->list.EmplaceBack(std::move(ptr));
+    PushBatch(batch, 1);
+  }
+  void PushBack(value_type* ptr) { EmplaceBack(ObjectMsgPtr<value_type>(ptr)); }
+
+  void MoveFrom(TrivialObjectMsgList<kDisableSelfLoopLink, LinkField>* src) {
+    const std::size_t src_size = src->size();
+    if (src_size == 0) { return; }
+    Batch* batch = new Batch();
+    src->MoveToDstBack(&batch->list);
+    PushBatch(batch, src_size);
+  }
+
+  // Must only be called by the consumer thread
+  void MoveTo(TrivialObjectMsgList<kDisableSelfLoopLink, LinkField>* dst) {
+    Batch* batch = top_.exchange(nullptr, std::memory_order_acquire);
+    Batch* reversed = nullptr;
+    while (batch != nullptr) {
+      Batch* next = batch->next;
+      batch->next = reversed;
+      reversed = batch;
+      batch = next;
+    }
+    while (reversed != nullptr) {
+      Batch* next = reversed->next;
+      const std::size_t batch_size = reversed->list.size();
+      reversed->list.MoveToDstBack(dst);
+      delete reversed;
+      size_.fetch_sub(batch_size, std::memory_order_release);
+      reversed = next;
+    }
+  }
+
+  void Clear() {
+    ObjectMsgList<LinkField> tmp_list;
+    MoveTo(&tmp_list);
+  }
+
+ private:
+  struct Batch final {
+    ObjectMsgList<LinkField> list;
+    Batch* next;
+  };
+
+  void PushBatch(Batch* batch, std::size_t batch_size) {
+    // counted before it is visible, so size() never underflows when the consumer takes it
+    size_.fetch_add(batch_size, std::memory_order_relaxed);
+    batch->next = top_.load(std::memory_order_relaxed);
+    while (!top_.compare_exchange_weak(batch->next, batch, std::memory_order_release,
+                                       std::memory_order_relaxed)) {}
+  }
+
+  std::atomic<Batch*> top_;
+  std::atomic<std::size_t> size_;
+};
+
+template<typename LinkField>
+class ObjectMsgMpscList : public TrivialObjectMsgMpscList<LinkField> {
+ public:
+  ObjectMsgMpscList(const ObjectMsgMpscList&) = delete;
+  ObjectMsgMpscList(ObjectMsgMpscList&&) = delete;
+  ObjectMsgMpscList() { this->__Init__(); }
+  ~ObjectMsgMpscList() { this->Clear(); }
+};
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_OBJECT_MSG_MPSC_LIST_H_
@@ -0,0 +1,123 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/object_msg/object_msg.h"
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/range.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+// clang-format off
+OBJECT_MSG_BEGIN(Foo);
+  // fields
+  OBJECT_MSG_DEFINE_OPTIONAL(int, x);
+
+  // links
+  OBJECT_MSG_DEFINE_LIST_LINK(link);
+OBJECT_MSG_END(Foo);
+// clang-format on
+
+// clang-format off
+OBJECT_MSG_BEGIN(FooList);
+  // links
+  OBJECT_MSG_DEFINE_MPSC_LIST_HEAD(Foo, link, list);
+OBJECT_MSG_END(FooList);
+// clang-format on
+
+using MpscListFoo = OBJECT_MSG_MPSC_LIST(Foo, link);
+
+TEST(ObjectMsgMpscList, move_to_keeps_push_order) {
+  MpscListFoo mpsc_list;
+  ASSERT_TRUE(mpsc_list.empty());
+  OBJECT_MSG_LIST(Foo, link) src;
+  for (int i = 0; i < 3; ++i) {
+    auto foo = ObjectMsgPtr<Foo>::New();
+    foo->set_x(i);
+    src.EmplaceBack(std::move(foo));
+  }
+  mpsc_list.MoveFrom(&src);
+  ASSERT_TRUE(src.empty());
+  auto foo = ObjectMsgPtr<Foo>::New();
+  foo->set_x(3);
+  mpsc_list.EmplaceBack(std::move(foo));
+  ASSERT_EQ(mpsc_list.size(), 4);
+  OBJECT_MSG_LIST(Foo, link) dst;
+  mpsc_list.MoveTo(&dst);
+  ASSERT_TRUE(mpsc_list.empty());
+  int expected = 0;
+  OBJECT_MSG_LIST_FOR_EACH_PTR(&dst, elem) { ASSERT_EQ(elem->x(), expected++); }
+  ASSERT_EQ(expected, 4);
+}
+
+TEST(ObjectMsgMpscList, object_msg_field) {
+  auto foo_list = ObjectMsgPtr<FooList>::New();
+  auto foo = ObjectMsgPtr<Foo>::New();
+  foo_list->mut_list()->PushBack(foo.Mutable());
+  ASSERT_EQ(foo->ref_cnt(), 2);
+  ASSERT_EQ(foo_list->list().size(), 1);
+  foo_list.Reset();
+  ASSERT_EQ(foo->ref_cnt(), 1);
+}
+
+void CallFromSenderThread(MpscListFoo* mpsc_list, int sender_id, Range range) {
+  for (int i = range.begin(); i < range.end(); i += 2) {
+    OBJECT_MSG_LIST(Foo, link) batch;
+    for (int j = i; j < std::min<int>(i + 2, range.end()); ++j) {
+      auto foo = ObjectMsgPtr<Foo>::New();
+      foo->set_x(sender_id * range.size() + j);
+      batch.EmplaceBack(std::move(foo));
+    }
+    mpsc_list->MoveFrom(&batch);
+  }
+}
+
+TEST(ObjectMsgMpscList, 30sender1receiver) {
+  MpscListFoo mpsc_list;
+  const int sender_num = 30;
+  const int range_num = 200;
+  std::vector<std::thread> senders;
+  for (int i = 0; i < sender_num; ++i) {
+    senders.push_back(std::thread(CallFromSenderThread, &mpsc_list, i, Range(0, range_num)));
+  }
+  std::vector<int> visit(sender_num * range_num, 0);
+  // the elements of each sender are received in the order they were sent
+  std::vector<int> last_x(sender_num, -1);
+  int received_cnt = 0;
+  while (received_cnt < sender_num * range_num) {
+    OBJECT_MSG_LIST(Foo, link) tmp_list;
+    mpsc_list.MoveTo(&tmp_list);
+    OBJECT_MSG_LIST_FOR_EACH_PTR(&tmp_list, foo) {
+      ++visit.at(foo->x());
+      const int sender_id = foo->x() / range_num;
+      ASSERT_GT(foo->x(), last_x.at(sender_id));
+      last_x.at(sender_id) = foo->x();
+      ++received_cnt;
+      tmp_list.Erase(foo);
+    }
+  }
+  for (std::thread& sender : senders) { sender.join(); }
+  ASSERT_TRUE(mpsc_list.empty());
+  for (int count : visit) { ASSERT_EQ(count, 1); }
+}
+
+}  // namespace
+
+}  // namespace test
+
+}  // namespace oneflow
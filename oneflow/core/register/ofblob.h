@@ -28,7 +28,10 @@ class OfBlob final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(OfBlob);
   OfBlob(DeviceCtx* device_ctx, Blob* blob)
-      : device_ctx_(device_ctx), blob_(blob), tensor_back_inserter_(new TensorBackInserter(blob)) {
+      : device_ctx_(device_ctx),
+        blob_(blob),
+        tensor_back_inserter_(new TensorBackInserter(blob)),
+        is_host_body_lendable_(false) {
     mem_case_.mutable_host_mem();
   }
   ~OfBlob() = default;
@@ -62,6 +65,16 @@ class OfBlob final {
   template<typename T>
   void StaticTensorAutoMemCopyFrom(const T* ptr, int64_t len) const;
 
+  // Zero-copy access to the body of a static blob in host memory, only valid inside PushBlob or
+  // PullBlob. The foreign input kernel also lets its blob be lent a caller buffer as the body,
+  // which is read in place of a copy and must stay valid until the job instance is finished.
+  bool IsHostBodyAccessible() const;
+  bool is_host_body_lendable() const { return is_host_body_lendable_; }
+  void set_is_host_body_lendable(bool val) { is_host_body_lendable_ = val; }
+  int64_t ByteSizeOfHostBody() const;
+  const char* HostBodyDptr() const;
+  void LendHostBody(char* dptr, int64_t byte_size) const;
+
  private:
   void ClearShape(FullyMutTensorView* tensor) const;
 
@@ -70,6 +83,7 @@ class OfBlob final {
   MemoryCase mem_case_;
   std::unique_ptr<TensorBackInserter> tensor_back_inserter_;
   std::unique_ptr<TensorView> cur_tensor_;
+  bool is_host_body_lendable_;
 };
 
 inline void OfBlob::CopyShapeFrom(const int64_t* ptr, int64_t num_axis) const {
@@ -132,6 +146,29 @@ inline void OfBlob::CurMutTensorCopyShapeFrom(const int64_t* ptr, int64_t num_ax
   tensor_back_inserter_->cur_mut_tensor()->set_shape(ShapeView(ptr, num_axis));
 }
 
+inline bool OfBlob::IsHostBodyAccessible() const {
+  return blob_->mem_case().has_host_mem() && !is_dynamic() && !is_tensor_list();
+}
+
+inline int64_t OfBlob::ByteSizeOfHostBody() const {
+  CHECK(IsHostBodyAccessible());
+  return blob_->ByteSizeOfBlobBody();
+}
+
+inline const char* OfBlob::HostBodyDptr() const {
+  CHECK(IsHostBodyAccessible());
+  return static_cast<const char*>(blob_->dptr());
+}
+
+inline void OfBlob::LendHostBody(char* dptr, int64_t byte_size) const {
+  CHECK(is_host_body_lendable_);
+  CHECK(IsHostBodyAccessible());
+  CHECK_NOTNULL(dptr);
+  CHECK_GE(byte_size, blob_->ByteSizeOfBlobBody());
+  blob_->blob_access_checker()->CheckBodyMutable();
+  blob_->reset_dptr(dptr);
+}
+
 template<typename T>
 void OfBlob::CurTensorAutoMemCopyTo(T* ptr, int64_t len) const {
   CHECK_EQ(cur_tensor_->shape().elem_cnt(), len);
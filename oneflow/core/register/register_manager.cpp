@@ -22,6 +22,10 @@ limitations under the License.
 #include "oneflow/core/job/machine_context.h"
 #include "oneflow/core/memory/memory_case.pb.h"
 #include "oneflow/core/memory/memory_allocator.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/thread/numa_util.h"
 
 namespace oneflow {
 
@@ -33,14 +37,55 @@ void CheckBlobInRegstNotDisabled(const RegstDescProto& regst_desc) {
         == false);
 }
 
+bool IsUnpinnedHostMem(const MemoryCase& mem_case) {
+  return mem_case.has_host_mem() && !mem_case.host_mem().has_cuda_pinned_mem();
+}
+
+int32_t NumaNodeOwningMostBytes(const HashMap<int32_t, int64_t>& numa_node2bytes) {
+  int32_t ret = -1;
+  int64_t max_bytes = -1;
+  for (const auto& pair : numa_node2bytes) {
+    if (pair.second > max_bytes || (pair.second == max_bytes && pair.first < ret)) {
+      ret = pair.first;
+      max_bytes = pair.second;
+    }
+  }
+  return ret;
+}
+
+int32_t NumaNode4Id(const HashMap<int64_t, int32_t>& id2numa_node, int64_t id) {
+  const auto it = id2numa_node.find(id);
+  return it == id2numa_node.end() ? -1 : it->second;
+}
+
 }  // namespace
 
 RegstMgr::RegstMgr(const Plan& plan) {
   int64_t this_machine_id = Global<MachineCtx>::Get()->this_machine_id();
+  for (const TaskProto& task : plan.task()) {
+    if (task.machine_id() != this_machine_id) { continue; }
+    for (const auto& pair : task.produced_regst_desc()) {
+      const RegstDescProto& regst_desc = pair.second;
+      const int64_t regst_desc_id = regst_desc.regst_desc_id();
+      CHECK(regst_desc_id2rt_regst_desc_
+                .emplace(regst_desc_id, std::make_unique<const RtRegstDesc>(regst_desc))
+                .second);
+      CHECK(regst_desc_id2parallel_ctx_.emplace(regst_desc_id, task.parallel_ctx()).second);
+    }
+  }
+  HashMap<int64_t, int32_t> mem_block_id2numa_node;
+  HashMap<int64_t, int32_t> chunk_id2numa_node;
+  const ThreadAffinityConf& affinity_conf =
+      Global<ResourceDesc, ForSession>::Get()->thread_affinity_conf();
+  if (affinity_conf.enable_numa_local_regst_mem()) {
+    InferNumaNode4HostMem(plan, &mem_block_id2numa_node, &chunk_id2numa_node);
+  }
   HashMap<int64_t, char*> chunk_id2ptr;
   for (const ChunkProto& chunk : plan.block_chunk_list().chunk()) {
     if (chunk.machine_id() != this_machine_id) { continue; }
     if (chunk.mem_size() == 0) { continue; }
+    // the allocator zeroes the memory, which places its pages on the node of the calling thread
+    NumaNodeAffinityGuard guard(NumaNode4Id(chunk_id2numa_node, chunk.chunk_id()));
     char* chunk_ptr = Global<MemoryAllocator>::Get()->Allocate(chunk.mem_case(), chunk.mem_size());
     CHECK(chunk_id2ptr.emplace(chunk.chunk_id(), chunk_ptr).second);
   }
@@ -53,22 +98,86 @@ RegstMgr::RegstMgr(const Plan& plan) {
       CHECK(chunk_id2ptr.find(mem_block.chunk_id()) != chunk_id2ptr.end());
       mem_block_ptr = chunk_id2ptr.at(mem_block.chunk_id()) + mem_block.chunk_offset();
     } else {
+      NumaNodeAffinityGuard guard(NumaNode4Id(mem_block_id2numa_node, mem_block.mem_block_id()));
       mem_block_ptr =
           Global<MemoryAllocator>::Get()->Allocate(mem_block.mem_case(), mem_block.mem_size());
     }
     CHECK(mem_block_id2ptr_.emplace(mem_block.mem_block_id(), mem_block_ptr).second);
   }
+}
+
+void RegstMgr::InferNumaNode4HostMem(const Plan& plan,
+                                     HashMap<int64_t, int32_t>* mem_block_id2numa_node,
+                                     HashMap<int64_t, int32_t>* chunk_id2numa_node) const {
+  const int64_t this_machine_id = Global<MachineCtx>::Get()->this_machine_id();
+  HashMap<int64_t, int32_t> regst_desc_id2numa_node;
+  HashMap<int64_t, HashMap<int32_t, int64_t>> mem_block_id2numa_node2bytes;
+  for (const TaskProto& task : plan.task()) {
+    if (task.machine_id() != this_machine_id) { continue; }
+    const int32_t numa_node = NumaNode4ActorThrdId(task.thrd_id());
+    if (numa_node < 0) { continue; }
+    for (const auto& pair : task.produced_regst_desc()) {
+      const RegstDescProto& regst_desc = pair.second;
+      if (regst_desc.mem_block_id() == -1 || !IsUnpinnedHostMem(regst_desc.mem_case())) {
+        continue;
+      }
+      const RtRegstDesc& rt_regst_desc = RegstDesc4RegstDescId(regst_desc.regst_desc_id());
+      mem_block_id2numa_node2bytes[regst_desc.mem_block_id()][numa_node] +=
+          rt_regst_desc.TotalMainByteSize4AllRegst();
+    }
+  }
+  for (const auto& pair : mem_block_id2numa_node2bytes) {
+    (*mem_block_id2numa_node)[pair.first] = NumaNodeOwningMostBytes(pair.second);
+  }
+  HashMap<int64_t, HashMap<int32_t, int64_t>> chunk_id2numa_node2bytes;
+  for (const MemBlockProto& mem_block : plan.block_chunk_list().mem_block()) {
+    if (mem_block.machine_id() != this_machine_id || !mem_block.has_chunk_id()) { continue; }
+    const int32_t numa_node = NumaNode4Id(*mem_block_id2numa_node, mem_block.mem_block_id());
+    if (numa_node < 0) { continue; }
+    chunk_id2numa_node2bytes[mem_block.chunk_id()][numa_node] += mem_block.mem_size();
+  }
+  for (const auto& pair : chunk_id2numa_node2bytes) {
+    (*chunk_id2numa_node)[pair.first] = NumaNodeOwningMostBytes(pair.second);
+  }
+  for (const MemBlockProto& mem_block : plan.block_chunk_list().mem_block()) {
+    if (mem_block.machine_id() != this_machine_id || !mem_block.has_chunk_id()) { continue; }
+    const int32_t chunk_numa_node = NumaNode4Id(*chunk_id2numa_node, mem_block.chunk_id());
+    // the pages of a chunk are all placed on its node
+    if (chunk_numa_node >= 0) {
+      (*mem_block_id2numa_node)[mem_block.mem_block_id()] = chunk_numa_node;
+    }
+  }
+
+  // the bytes each act of a consumer reads from the memory of another node
+  std::vector<int64_t> numa_node2placed_bytes(NumaNodeNum());
+  int64_t cross_node_consumer_cnt = 0;
+  int64_t cross_node_bytes_per_act = 0;
   for (const TaskProto& task : plan.task()) {
     if (task.machine_id() != this_machine_id) { continue; }
     for (const auto& pair : task.produced_regst_desc()) {
       const RegstDescProto& regst_desc = pair.second;
-      const int64_t regst_desc_id = regst_desc.regst_desc_id();
-      CHECK(regst_desc_id2rt_regst_desc_
-                .emplace(regst_desc_id, std::make_unique<const RtRegstDesc>(regst_desc))
-                .second);
-      CHECK(regst_desc_id2parallel_ctx_.emplace(regst_desc_id, task.parallel_ctx()).second);
+      const int32_t mem_numa_node = NumaNode4Id(*mem_block_id2numa_node, regst_desc.mem_block_id());
+      if (mem_numa_node < 0) { continue; }
+      const RtRegstDesc& rt_regst_desc = RegstDesc4RegstDescId(regst_desc.regst_desc_id());
+      numa_node2placed_bytes.at(mem_numa_node) += rt_regst_desc.TotalMainByteSize4AllRegst();
+      for (int64_t consumer_task_id : regst_desc.consumer_task_id()) {
+        if (Global<IDMgr>::Get()->MachineId4ActorId(consumer_task_id) != this_machine_id) {
+          continue;
+        }
+        const int32_t consumer_numa_node =
+            NumaNode4ActorThrdId(Global<IDMgr>::Get()->ThrdId4ActorId(consumer_task_id));
+        if (consumer_numa_node < 0 || consumer_numa_node == mem_numa_node) { continue; }
+        cross_node_consumer_cnt += 1;
+        cross_node_bytes_per_act += rt_regst_desc.MainByteSize4OneRegst();
+      }
     }
   }
+  FOR_RANGE(int32_t, numa_node, 0, numa_node2placed_bytes.size()) {
+    LOG(INFO) << "numa node " << numa_node << " holds " << numa_node2placed_bytes.at(numa_node)
+              << " bytes of host regsts";
+  }
+  LOG(INFO) << cross_node_consumer_cnt << " consumers of host regsts are pinned to another numa "
+            << "node, and read " << cross_node_bytes_per_act << " bytes across nodes per act";
 }
 
 void RegstMgr::NewRegsts(const RegstDescProto& regst_desc_proto,
@@ -44,6 +44,10 @@ class RegstMgr final {
   friend class Global<RegstMgr>;
 
   explicit RegstMgr(const Plan& plan);
+  // Places each host mem block on the numa node of the producers owning most of its bytes, and
+  // each chunk on the node owning most bytes of its mem blocks
+  void InferNumaNode4HostMem(const Plan& plan, HashMap<int64_t, int32_t>* mem_block_id2numa_node,
+                             HashMap<int64_t, int32_t>* chunk_id2numa_node) const;
   void NewBlobsInOneRegst(const std::vector<LbiBlobDescPair>& lbis, Regst*, const RtRegstDesc*,
                           char* main_mem_ptr, char* separated_header_mem_ptr);
   HashMap<int64_t, std::unique_ptr<const RtRegstDesc>> regst_desc_id2rt_regst_desc_;
@@ -0,0 +1,178 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <cstring>
+#include "oneflow/core/serving/dynamic_batcher.h"
+
+namespace oneflow {
+
+namespace {
+
+Shape ShapeWithRows(const Shape& shape, int64_t rows) {
+  DimVector dim_vec = shape.dim_vec();
+  dim_vec.at(0) = rows;
+  return Shape(dim_vec);
+}
+
+Maybe<void> CheckInputsBatchable(const ServingTensorMap& lhs, const ServingTensorMap& rhs) {
+  CHECK_EQ_OR_RETURN(lhs.size(), rhs.size()) << "requests of a batch have different inputs";
+  for (const auto& pair : lhs) {
+    const auto it = rhs.find(pair.first);
+    CHECK_OR_RETURN(it != rhs.end()) << "input " << pair.first << " is absent";
+    CHECK_EQ_OR_RETURN(it->second.data_type(), pair.second.data_type())
+        << "input " << pair.first << " has a different data type from the rest of its batch";
+    CHECK_EQ_OR_RETURN(it->second.shape().NumAxes(), pair.second.shape().NumAxes());
+    FOR_RANGE(int64_t, axis, 1, pair.second.shape().NumAxes()) {
+      CHECK_EQ_OR_RETURN(it->second.shape().At(axis), pair.second.shape().At(axis))
+          << "input " << pair.first << " has a different sample shape from the rest of its batch";
+    }
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+DynamicBatcher::DynamicBatcher(const DynamicBatcherConf& conf, const RunBatchFn& RunBatch)
+    : conf_(conf), RunBatch_(RunBatch), stats_(conf.max_latency_sample_cnt), shutdown_(false) {
+  CHECK_GT(conf_.max_batch_size, 0);
+  CHECK_GE(conf_.max_queue_delay_us, 0);
+  batch_thread_ = std::thread([this]() { BatchLoop(); });
+}
+
+DynamicBatcher::~DynamicBatcher() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  cond_.notify_all();
+  batch_thread_.join();
+}
+
+Maybe<void> DynamicBatcher::Infer(const ServingTensorMap& inputs, ServingTensorMap* outputs) {
+  CHECK_OR_RETURN(!inputs.empty()) << "request has no input";
+  int64_t batch_size = -1;
+  for (const auto& pair : inputs) {
+    const Shape& shape = pair.second.shape();
+    CHECK_GT_OR_RETURN(shape.NumAxes(), 0) << "input " << pair.first << " has no batch axis";
+    if (batch_size == -1) { batch_size = shape.At(0); }
+    CHECK_EQ_OR_RETURN(shape.At(0), batch_size) << "inputs of a request have different rows";
+  }
+  CHECK_GT_OR_RETURN(batch_size, 0);
+  CHECK_LE_OR_RETURN(batch_size, conf_.max_batch_size);
+  Request request;
+  request.inputs = &inputs;
+  request.outputs = outputs;
+  request.batch_size = batch_size;
+  request.enqueue_time = std::chrono::steady_clock::now();
+  std::future<Maybe<void>> done = request.done.get_future();
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    CHECK_OR_RETURN(!shutdown_) << "dynamic batcher is shut down";
+    queue_.push_back(&request);
+  }
+  cond_.notify_one();
+  return done.get();
+}
+
+void DynamicBatcher::TakeRequestsIntoBatch(std::vector<Request*>* batch, int64_t* batch_size) {
+  while (!queue_.empty() && *batch_size + queue_.front()->batch_size <= conf_.max_batch_size) {
+    *batch_size += queue_.front()->batch_size;
+    batch->push_back(queue_.front());
+    queue_.pop_front();
+  }
+}
+
+void DynamicBatcher::BatchLoop() {
+  while (true) {
+    std::vector<Request*> batch;
+    int64_t batch_size = 0;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this]() { return shutdown_ || !queue_.empty(); });
+      if (queue_.empty()) { return; }
+      const auto deadline = queue_.front()->enqueue_time
+                            + std::chrono::microseconds(conf_.max_queue_delay_us);
+      while (true) {
+        TakeRequestsIntoBatch(&batch, &batch_size);
+        // the batch is full or the next request does not fit in it
+        if (batch_size == conf_.max_batch_size || !queue_.empty() || shutdown_) { break; }
+        if (cond_.wait_until(lock, deadline) == std::cv_status::timeout) {
+          TakeRequestsIntoBatch(&batch, &batch_size);
+          break;
+        }
+      }
+    }
+    ProcessBatch(batch);
+  }
+}
+
+void DynamicBatcher::ProcessBatch(const std::vector<Request*>& batch) {
+  // a request that can not be batched with the first one fails alone
+  std::vector<Request*> requests;
+  int64_t batch_size = 0;
+  for (Request* request : batch) {
+    Maybe<void> status = CheckInputsBatchable(*batch.front()->inputs, *request->inputs);
+    if (status.IsOk()) {
+      requests.push_back(request);
+      batch_size += request->batch_size;
+    } else {
+      request->done.set_value(status);
+    }
+  }
+  const int64_t padded_batch_size = conf_.pad_to_max_batch_size ? conf_.max_batch_size : batch_size;
+  ServingTensorMap batch_inputs;
+  for (const auto& pair : *requests.front()->inputs) {
+    // a new ServingTensor is zero-filled, which the padding rows fed to the model rely on
+    ServingTensor batch_input(pair.second.data_type(),
+                              ShapeWithRows(pair.second.shape(), padded_batch_size));
+    char* dst = batch_input.mut_data();
+    for (const Request* request : requests) {
+      const ServingTensor& input = request->inputs->at(pair.first);
+      std::memcpy(dst, input.data(), input.ByteSize());
+      dst += input.ByteSize();
+    }
+    batch_inputs.emplace(pair.first, std::move(batch_input));
+  }
+  const auto RunAndSplit = [&]() -> Maybe<void> {
+    ServingTensorMap batch_outputs;
+    JUST(RunBatch_(batch_inputs, &batch_outputs));
+    for (const auto& pair : batch_outputs) {
+      const Shape& shape = pair.second.shape();
+      CHECK_GT_OR_RETURN(shape.NumAxes(), 0) << "output " << pair.first << " has no batch axis";
+      CHECK_EQ_OR_RETURN(shape.At(0), padded_batch_size)
+          << "output " << pair.first << " has different rows from the inputs";
+      const size_t row_byte_size = pair.second.ByteSize() / padded_batch_size;
+      const char* src = pair.second.data();
+      for (Request* request : requests) {
+        ServingTensor output(pair.second.data_type(), ShapeWithRows(shape, request->batch_size));
+        std::memcpy(output.mut_data(), src, output.ByteSize());
+        src += row_byte_size * request->batch_size;
+        (*request->outputs)[pair.first] = std::move(output);
+      }
+    }
+    return Maybe<void>::Ok();
+  };
+  const Maybe<void> status = RunAndSplit();
+  stats_.RecordBatch(batch_size, padded_batch_size);
+  const auto now = std::chrono::steady_clock::now();
+  for (Request* request : requests) {
+    stats_.RecordRequest(
+        std::chrono::duration<double, std::micro>(now - request->enqueue_time).count());
+    // the request may be released by its caller once done is set
+    request->done.set_value(status);
+  }
+}
+
+}  // namespace oneflow
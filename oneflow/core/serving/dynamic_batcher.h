@@ -0,0 +1,84 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_SERVING_DYNAMIC_BATCHER_H_
+#define ONEFLOW_CORE_SERVING_DYNAMIC_BATCHER_H_
+
+#include <chrono>
+#include <deque>
+#include <future>
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/serving/serving_tensor.h"
+#include "oneflow/core/serving/serving_stats.h"
+
+namespace oneflow {
+
+struct DynamicBatcherConf {
+  // rows of a merged batch, which is the batch size the model is compiled with
+  int64_t max_batch_size = 1;
+  // how long the oldest queued request may wait for others to join its batch
+  int64_t max_queue_delay_us = 1000;
+  // a batch is zero padded to max_batch_size when the model only takes a static batch
+  bool pad_to_max_batch_size = true;
+  int64_t max_latency_sample_cnt = 100000;
+};
+
+// Merges concurrent requests into batches along axis 0 of every input. A batch is run when it is
+// full or when the oldest request in it has waited for max_queue_delay_us, and the rows of every
+// output are split back to the requests. Batches are run one at a time by a single thread.
+class DynamicBatcher final {
+ public:
+  using RunBatchFn =
+      std::function<Maybe<void>(const ServingTensorMap& inputs, ServingTensorMap* outputs)>;
+
+  OF_DISALLOW_COPY_AND_MOVE(DynamicBatcher);
+  DynamicBatcher(const DynamicBatcherConf& conf, const RunBatchFn& RunBatch);
+  ~DynamicBatcher();
+
+  // Blocks until the batch of the request is run. All inputs of a request have the same number
+  // of rows, which is at most max_batch_size.
+  Maybe<void> Infer(const ServingTensorMap& inputs, ServingTensorMap* outputs);
+
+  const DynamicBatcherConf& conf() const { return conf_; }
+  const ServingStats& stats() const { return stats_; }
+  ServingStats* mut_stats() { return &stats_; }
+
+ private:
+  struct Request {
+    const ServingTensorMap* inputs;
+    ServingTensorMap* outputs;
+    int64_t batch_size;
+    std::chrono::steady_clock::time_point enqueue_time;
+    std::promise<Maybe<void>> done;
+  };
+
+  void BatchLoop();
+  void TakeRequestsIntoBatch(std::vector<Request*>* batch, int64_t* batch_size);
+  void ProcessBatch(const std::vector<Request*>& batch);
+
+  const DynamicBatcherConf conf_;
+  const RunBatchFn RunBatch_;
+  ServingStats stats_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<Request*> queue_;
+  bool shutdown_;
+  std::thread batch_thread_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_SERVING_DYNAMIC_BATCHER_H_
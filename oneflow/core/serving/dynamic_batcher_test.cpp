@@ -0,0 +1,189 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/serving/dynamic_batcher.h"
+
+namespace oneflow {
+
+namespace {
+
+ServingTensor MakeRows(int64_t rows, float first_value) {
+  ServingTensor tensor(DataType::kFloat, Shape({rows, 3}));
+  FOR_RANGE(int64_t, i, 0, rows * 3) { tensor.mut_data<float>()[i] = first_value + i; }
+  return tensor;
+}
+
+// doubles x into y and records the rows of every batch it runs
+DynamicBatcher::RunBatchFn MakeDoubleFn(std::vector<int64_t>* batch_rows, std::mutex* mutex) {
+  return [batch_rows, mutex](const ServingTensorMap& inputs,
+                             ServingTensorMap* outputs) -> Maybe<void> {
+    const ServingTensor& x = inputs.at("x");
+    {
+      std::unique_lock<std::mutex> lock(*mutex);
+      batch_rows->push_back(x.shape().At(0));
+    }
+    ServingTensor y(DataType::kFloat, x.shape());
+    FOR_RANGE(int64_t, i, 0, x.shape().elem_cnt()) {
+      y.mut_data<float>()[i] = 2 * x.data<float>()[i];
+    }
+    outputs->emplace("y", std::move(y));
+    return Maybe<void>::Ok();
+  };
+}
+
+void CheckDoubled(const ServingTensor& x, const ServingTensor& y) {
+  ASSERT_EQ(x.shape(), y.shape());
+  FOR_RANGE(int64_t, i, 0, x.shape().elem_cnt()) {
+    ASSERT_EQ(y.data<float>()[i], 2 * x.data<float>()[i]);
+  }
+}
+
+}  // namespace
+
+TEST(DynamicBatcher, merge_concurrent_requests) {
+  std::vector<int64_t> batch_rows;
+  std::mutex mutex;
+  DynamicBatcherConf conf;
+  conf.max_batch_size = 8;
+  // long enough for all clients to join the first batch, which runs as soon as it is full
+  conf.max_queue_delay_us = 10 * 1000 * 1000;
+  DynamicBatcher batcher(conf, MakeDoubleFn(&batch_rows, &mutex));
+  std::vector<std::thread> clients;
+  FOR_RANGE(int64_t, i, 0, 4) {
+    clients.emplace_back([&batcher, i]() {
+      ServingTensorMap inputs;
+      inputs.emplace("x", MakeRows(2, 100 * i));
+      ServingTensorMap outputs;
+      ASSERT_TRUE(batcher.Infer(inputs, &outputs).IsOk());
+      CheckDoubled(inputs.at("x"), outputs.at("y"));
+    });
+  }
+  for (auto& client : clients) { client.join(); }
+  ASSERT_EQ(batch_rows, std::vector<int64_t>({8}));
+  const ServingStatsSummary summary = batcher.stats().Summary();
+  ASSERT_EQ(summary.request_cnt, 4);
+  ASSERT_EQ(summary.batch_cnt, 1);
+  ASSERT_EQ(summary.mean_batch_size, 8);
+  ASSERT_EQ(summary.padding_ratio, 0);
+}
+
+TEST(DynamicBatcher, deadline_runs_padded_batch) {
+  std::vector<int64_t> batch_rows;
+  std::mutex mutex;
+  DynamicBatcherConf conf;
+  conf.max_batch_size = 8;
+  conf.max_queue_delay_us = 1000;
+  DynamicBatcher batcher(conf, MakeDoubleFn(&batch_rows, &mutex));
+  ServingTensorMap inputs;
+  inputs.emplace("x", MakeRows(3, 1));
+  ServingTensorMap outputs;
+  ASSERT_TRUE(batcher.Infer(inputs, &outputs).IsOk());
+  CheckDoubled(inputs.at("x"), outputs.at("y"));
+  ASSERT_EQ(batch_rows, std::vector<int64_t>({8}));
+  ASSERT_EQ(batcher.stats().Summary().padding_ratio, 5.0 / 8);
+}
+
+TEST(DynamicBatcher, padding_rows_are_zero) {
+  DynamicBatcherConf conf;
+  conf.max_batch_size = 4;
+  conf.max_queue_delay_us = 0;
+  int64_t num_nonzero_padding = -1;
+  DynamicBatcher batcher(conf, [&](const ServingTensorMap& inputs,
+                                   ServingTensorMap* outputs) -> Maybe<void> {
+    const ServingTensor& x = inputs.at("x");
+    num_nonzero_padding = 0;
+    FOR_RANGE(int64_t, i, 3, x.shape().elem_cnt()) {
+      if (x.data<float>()[i] != 0) { num_nonzero_padding += 1; }
+    }
+    outputs->emplace("y", ServingTensor(DataType::kFloat, x.shape()));
+    return Maybe<void>::Ok();
+  });
+  ServingTensorMap inputs;
+  inputs.emplace("x", MakeRows(1, 1));
+  ServingTensorMap outputs;
+  ASSERT_TRUE(batcher.Infer(inputs, &outputs).IsOk());
+  ASSERT_EQ(num_nonzero_padding, 0);
+}
+
+TEST(DynamicBatcher, no_padding) {
+  std::vector<int64_t> batch_rows;
+  std::mutex mutex;
+  DynamicBatcherConf conf;
+  conf.max_batch_size = 8;
+  conf.max_queue_delay_us = 0;
+  conf.pad_to_max_batch_size = false;
+  DynamicBatcher batcher(conf, MakeDoubleFn(&batch_rows, &mutex));
+  ServingTensorMap inputs;
+  inputs.emplace("x", MakeRows(3, 1));
+  ServingTensorMap outputs;
+  ASSERT_TRUE(batcher.Infer(inputs, &outputs).IsOk());
+  CheckDoubled(inputs.at("x"), outputs.at("y"));
+  ASSERT_EQ(batch_rows, std::vector<int64_t>({3}));
+}
+
+TEST(DynamicBatcher, invalid_requests) {
+  std::vector<int64_t> batch_rows;
+  std::mutex mutex;
+  DynamicBatcherConf conf;
+  conf.max_batch_size = 4;
+  conf.max_queue_delay_us = 0;
+  DynamicBatcher batcher(conf, MakeDoubleFn(&batch_rows, &mutex));
+  ServingTensorMap outputs;
+  ServingTensorMap too_many_rows;
+  too_many_rows.emplace("x", MakeRows(5, 0));
+  ASSERT_FALSE(batcher.Infer(too_many_rows, &outputs).IsOk());
+  ServingTensorMap different_rows;
+  different_rows.emplace("x", MakeRows(2, 0));
+  different_rows.emplace("z", MakeRows(3, 0));
+  ASSERT_FALSE(batcher.Infer(different_rows, &outputs).IsOk());
+  ASSERT_TRUE(batch_rows.empty());
+}
+
+TEST(DynamicBatcher, run_error) {
+  DynamicBatcherConf conf;
+  conf.max_batch_size = 4;
+  conf.max_queue_delay_us = 0;
+  DynamicBatcher batcher(conf, [](const ServingTensorMap&, ServingTensorMap*) -> Maybe<void> {
+    return Error::CheckFailedError() << "model failed";
+  });
+  ServingTensorMap inputs;
+  inputs.emplace("x", MakeRows(1, 0));
+  ServingTensorMap outputs;
+  ASSERT_FALSE(batcher.Infer(inputs, &outputs).IsOk());
+}
+
+TEST(ServingStats, summary) {
+  ServingStats stats(1000);
+  FOR_RANGE(int64_t, i, 1, 101) { stats.RecordRequest(i); }
+  stats.RecordBatch(6, 8);
+  ServingStatsSummary summary = stats.Summary();
+  ASSERT_EQ(summary.request_cnt, 100);
+  ASSERT_EQ(summary.p50_latency_us, 50);
+  ASSERT_EQ(summary.p99_latency_us, 99);
+  ASSERT_EQ(summary.max_latency_us, 100);
+  ASSERT_EQ(summary.mean_latency_us, 50.5);
+  ASSERT_EQ(summary.padding_ratio, 0.25);
+  // only the latest samples are kept for the percentiles
+  ServingStats latest_stats(10);
+  FOR_RANGE(int64_t, i, 1, 101) { latest_stats.RecordRequest(i); }
+  summary = latest_stats.Summary();
+  ASSERT_EQ(summary.request_cnt, 100);
+  ASSERT_EQ(summary.p50_latency_us, 95);
+  ASSERT_EQ(summary.max_latency_us, 100);
+  latest_stats.Reset();
+  ASSERT_EQ(latest_stats.Summary().request_cnt, 0);
+}
+
+}  // namespace oneflow
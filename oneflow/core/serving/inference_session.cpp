@@ -0,0 +1,421 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <cctype>
+#include <cstring>
+#include "oneflow/core/serving/inference_session.h"
+#include "oneflow/api/python/env/env.h"
+#include "oneflow/api/python/framework/framework.h"
+#include "oneflow/api/python/job_build/job_build_and_infer.h"
+#include "oneflow/api/python/session/session.h"
+#include "oneflow/core/common/blocking_counter.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/common/switch_func.h"
+#include "oneflow/core/framework/interpreter.h"
+#include "oneflow/core/framework/instructions_builder.h"
+#include "oneflow/core/job/env_desc.h"
+#include "oneflow/core/job/foreign_job_instance.h"
+#include "oneflow/core/job/inter_user_job_info.pb.h"
+#include "oneflow/core/job/job_conf.cfg.h"
+#include "oneflow/core/job/scope.h"
+#include "oneflow/core/job/session.h"
+#include "oneflow/core/operator/operator.h"
+#include "oneflow/core/persistence/file_system.h"
+#include "oneflow/core/register/ofblob.h"
+
+namespace oneflow {
+
+namespace {
+
+class ServingJobInstance final : public ForeignJobInstance {
+ public:
+  ServingJobInstance(const std::string& job_name, const std::string& sole_input_op_name,
+                     const std::string& sole_output_op_name,
+                     const std::function<void(OfBlob*)>& Push,
+                     const std::function<void(OfBlob*)>& Pull, const std::function<void()>& Finish)
+      : job_name_(job_name),
+        sole_input_op_name_(sole_input_op_name),
+        sole_output_op_name_(sole_output_op_name),
+        Push_(Push),
+        Pull_(Pull),
+        Finish_(Finish) {}
+  ~ServingJobInstance() override = default;
+
+  std::string job_name() const override { return job_name_; }
+  std::string sole_input_op_name_in_user_job() const override { return sole_input_op_name_; }
+  std::string sole_output_op_name_in_user_job() const override { return sole_output_op_name_; }
+  void PushBlob(uint64_t ofblob_ptr) const override {
+    Push_(reinterpret_cast<OfBlob*>(ofblob_ptr));
+  }
+  void PullBlob(uint64_t ofblob_ptr) const override {
+    Pull_(reinterpret_cast<OfBlob*>(ofblob_ptr));
+  }
+  void Finish() const override { Finish_(); }
+
+ private:
+  const std::string job_name_;
+  const std::string sole_input_op_name_;
+  const std::string sole_output_op_name_;
+  const std::function<void(OfBlob*)> Push_;
+  const std::function<void(OfBlob*)> Pull_;
+  const std::function<void()> Finish_;
+};
+
+template<typename T>
+void CopyToOfBlob(const ServingTensor* tensor, OfBlob* of_blob) {
+  const Shape& shape = tensor->shape();
+  if (of_blob->is_host_body_lendable() && of_blob->IsHostBodyAccessible()
+      && tensor->ByteSize() > 0) {
+    // the tensor outlives the push job, which reads it in place of the regst memory
+    of_blob->LendHostBody(const_cast<char*>(tensor->data()), tensor->ByteSize());
+  } else if (of_blob->is_dynamic()) {
+    of_blob->ClearTensorLists();
+    of_blob->AddTensorListSlice();
+    of_blob->AddTensor();
+    CHECK(of_blob->CurMutTensorAvailable());
+    of_blob->CurMutTensorCopyShapeFrom(shape.dim_vec().data(), shape.NumAxes());
+    of_blob->CurMutTensorAutoMemCopyFrom<T>(tensor->data<T>(), shape.elem_cnt());
+  } else {
+    of_blob->StaticTensorAutoMemCopyFrom<T>(tensor->data<T>(), shape.elem_cnt());
+  }
+}
+
+template<typename T>
+void CopyFromOfBlob(OfBlob* of_blob, ServingTensor* tensor) {
+  std::vector<int64_t> dims(of_blob->NumAxes());
+  if (of_blob->IsHostBodyAccessible()) {
+    of_blob->CopyStaticShapeTo(dims.data(), dims.size());
+    *tensor = ServingTensor(GetDataType<T>::value, Shape(DimVector(dims.begin(), dims.end())));
+    CHECK_EQ(tensor->ByteSize(), of_blob->ByteSizeOfHostBody());
+    std::memcpy(tensor->mut_data(), of_blob->HostBodyDptr(), tensor->ByteSize());
+    return;
+  }
+  of_blob->ResetTensorIterator();
+  CHECK(!of_blob->CurTensorIteratorEqEnd());
+  of_blob->CurTensorCopyShapeTo(dims.data(), dims.size());
+  *tensor = ServingTensor(GetDataType<T>::value, Shape(DimVector(dims.begin(), dims.end())));
+  of_blob->CurTensorAutoMemCopyTo<T>(tensor->mut_data<T>(), tensor->shape().elem_cnt());
+}
+
+#define MAKE_OF_BLOB_COPY_SWITCH_ENTRY(func_name, T) func_name<T>
+DEFINE_STATIC_SWITCH_FUNC(void, CopyToOfBlob, MAKE_OF_BLOB_COPY_SWITCH_ENTRY,
+                          MAKE_DATA_TYPE_CTRV_SEQ(POD_DATA_TYPE_SEQ));
+DEFINE_STATIC_SWITCH_FUNC(void, CopyFromOfBlob, MAKE_OF_BLOB_COPY_SWITCH_ENTRY,
+                          MAKE_DATA_TYPE_CTRV_SEQ(POD_DATA_TYPE_SEQ));
+#undef MAKE_OF_BLOB_COPY_SWITCH_ENTRY
+
+std::shared_ptr<ForeignJobInstance> MakePushJobInstance(const std::string& job_name,
+                                                        const std::string& op_name,
+                                                        const ServingTensor* tensor,
+                                                        const std::function<void()>& Finish) {
+  return std::make_shared<ServingJobInstance>(
+      job_name, op_name, "",
+      [tensor](OfBlob* of_blob) {
+        SwitchCopyToOfBlob(SwitchCase(tensor->data_type()), tensor, of_blob);
+      },
+      nullptr, Finish);
+}
+
+std::shared_ptr<ForeignJobInstance> MakePullJobInstance(
+    const std::string& job_name, const std::string& op_name,
+    const std::function<void(ServingTensor&&)>& Handler, const std::function<void()>& Finish) {
+  return std::make_shared<ServingJobInstance>(
+      job_name, "", op_name, nullptr,
+      [Handler](OfBlob* of_blob) {
+        ServingTensor tensor;
+        SwitchCopyFromOfBlob(SwitchCase(static_cast<DataType>(of_blob->data_type())), of_blob,
+                             &tensor);
+        Handler(std::move(tensor));
+      },
+      Finish);
+}
+
+std::shared_ptr<ForeignJobInstance> MakeUserJobInstance(const std::string& job_name,
+                                                        const std::function<void()>& Finish) {
+  return std::make_shared<ServingJobInstance>(job_name, "", "", nullptr, nullptr, Finish);
+}
+
+bool NeedCheckDeviceTag(const OperatorConf& op_conf) {
+  return !op_conf.has_return_conf() && op_conf.has_device_tag();
+}
+
+Maybe<ServingTensorInfo> GetServingTensorInfo(const JobBuildAndInferCtx& ctx,
+                                              const std::string& lbn) {
+  ServingTensorInfo info;
+  info.data_type = JUST(ctx.GetDataType(lbn));
+  info.static_shape = *JUST(ctx.GetStaticShape(lbn));
+  info.is_dynamic = JUST(ctx.IsDynamic(lbn));
+  return info;
+}
+
+}  // namespace
+
+Maybe<std::string> FindSavedModelVersionDir(const std::string& saved_model_dir,
+                                            int64_t model_version) {
+  CHECK_OR_RETURN(LocalFS()->IsDirectory(saved_model_dir))
+      << saved_model_dir << " is not a valid directory";
+  if (model_version < 0) {
+    for (const std::string& name : LocalFS()->ListDir(saved_model_dir)) {
+      if (name.empty() || !std::all_of(name.begin(), name.end(), ::isdigit)) { continue; }
+      if (!LocalFS()->IsDirectory(JoinPath(saved_model_dir, name))) { continue; }
+      model_version = std::max<int64_t>(model_version, std::stoll(name));
+    }
+    CHECK_GE_OR_RETURN(model_version, 0) << "no version of saved model in " << saved_model_dir;
+  }
+  const std::string version_dir = JoinPath(saved_model_dir, std::to_string(model_version));
+  CHECK_OR_RETURN(LocalFS()->IsDirectory(version_dir))
+      << "version " << model_version << " of saved model in " << saved_model_dir
+      << " does not exist";
+  return version_dir;
+}
+
+Maybe<void> ReadSavedModel(const std::string& version_dir, SavedModel* saved_model) {
+  const std::string pb_path = JoinPath(version_dir, "saved_model.pb");
+  const std::string prototxt_path = JoinPath(version_dir, "saved_model.prototxt");
+  if (LocalFS()->FileExists(pb_path)) {
+    CHECK_OR_RETURN(TryParseProtoFromPbFile(pb_path, saved_model)) << "failed to parse " << pb_path;
+  } else {
+    CHECK_OR_RETURN(LocalFS()->FileExists(prototxt_path))
+        << "saved model meta file does not exist in " << version_dir;
+    CHECK_OR_RETURN(TryParseProtoFromTextFile(prototxt_path, saved_model))
+        << "failed to parse " << prototxt_path;
+  }
+  return Maybe<void>::Ok();
+}
+
+InferenceSession::InferenceSession(const InferenceSessionOption& option)
+    : option_(option), status_(Status::kNew), session_id_(-1) {}
+
+InferenceSession::~InferenceSession() { CHECK_JUST(Close()); }
+
+Maybe<void> InferenceSession::Init() {
+  CHECK_OR_RETURN(status_ == Status::kNew);
+  CHECK_OR_RETURN(JUST(IsEnvInited())) << "env not inited";
+  CHECK_OR_RETURN(!JUST(IsSessionInited())) << "a global session exists already";
+  CHECK_GT_OR_RETURN(option_.device_num, 0);
+  session_id_ = NewSessionId();
+  config_proto_.set_session_id(session_id_);
+  Resource* resource = config_proto_.mutable_resource();
+  resource->set_machine_num(Global<EnvDesc>::Get()->TotalMachineNum());
+  if (option_.device_tag == "gpu") {
+    resource->set_gpu_device_num(option_.device_num);
+  } else if (option_.device_tag == "cpu") {
+    resource->set_cpu_device_num(option_.device_num);
+    resource->set_gpu_device_num(0);
+  } else {
+    UNIMPLEMENTED_THEN_RETURN() << "not supported device tag " << option_.device_tag;
+  }
+  IOConf* io_conf = config_proto_.mutable_io_conf();
+  io_conf->mutable_data_fs_conf()->mutable_localfs_conf();
+  io_conf->mutable_snapshot_fs_conf()->mutable_localfs_conf();
+  io_conf->set_enable_legacy_model_io(true);
+  JUST(InitLazyGlobalSession(PbMessage2TxtString(config_proto_)));
+  status_ = Status::kOpen;
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> InferenceSession::LoadSavedModel(const std::string& saved_model_dir,
+                                             int64_t model_version, const std::string& graph_name,
+                                             const std::string& signature_name,
+                                             int64_t batch_size) {
+  CHECK_OR_RETURN(status_ == Status::kOpen);
+  CHECK_OR_RETURN(job_name_.empty()) << "only one graph is served by a session";
+  const std::string version_dir = *JUST(FindSavedModelVersionDir(saved_model_dir, model_version));
+  SavedModel saved_model;
+  JUST(ReadSavedModel(version_dir, &saved_model));
+  checkpoint_path_ = JoinPath(version_dir, saved_model.checkpoint_dir());
+  job_name_ = graph_name.empty() ? saved_model.default_graph_name() : graph_name;
+  const auto graph_it = saved_model.graphs().find(job_name_);
+  CHECK_OR_RETURN(graph_it != saved_model.graphs().end()) << "graph " << job_name_ << " not found";
+  const GraphDef& graph_def = graph_it->second;
+  const std::string& sig_name =
+      signature_name.empty() ? graph_def.default_signature_name() : signature_name;
+  const auto signature_it = graph_def.signatures().find(sig_name);
+  CHECK_OR_RETURN(signature_it != graph_def.signatures().end())
+      << "signature " << sig_name << " not found";
+
+  JobConfigProto job_conf;
+  job_conf.set_job_name(job_name_);
+  job_conf.mutable_predict_conf();
+  *job_conf.mutable_signature() = signature_it->second;
+  if (batch_size > 0) {
+    for (auto& pair : *job_conf.mutable_signature()->mutable_inputs()) {
+      InterfaceBlobConf* blob_conf = pair.second.mutable_blob_conf();
+      if (!blob_conf->has_batch_axis() || !blob_conf->batch_axis().has_value()) { continue; }
+      blob_conf->mutable_shape()->set_dim(blob_conf->batch_axis().value(), batch_size);
+    }
+  }
+
+  JUST(JobBuildAndInferCtx_Open(job_name_));
+  JUST(JUST(GetCurInferCtx())->SetJobConf(job_conf));
+  std::vector<std::string> machine_device_ids;
+  FOR_RANGE(int64_t, machine_id, 0, config_proto_.resource().machine_num()) {
+    machine_device_ids.push_back(std::to_string(machine_id) + ":0-"
+                                 + std::to_string(option_.device_num - 1));
+  }
+  std::shared_ptr<Scope> scope;
+  const auto job_conf_cfg = std::make_shared<cfg::JobConfigProto>(job_conf);
+  JUST(LogicalInterpreter().Run([&](InstructionsBuilder* builder) -> Maybe<void> {
+    scope = JUST(builder->BuildInitialScope(session_id_, job_conf_cfg, option_.device_tag,
+                                            machine_device_ids, option_.is_mirrored_view));
+    return Maybe<void>::Ok();
+  }));
+  const int64_t scope_symbol_id = JUST(scope->symbol_id());
+  JobBuildAndInferCtx* ctx = JUST(GetCurInferCtx());
+  for (OperatorConf op_conf : graph_def.op_list()) {
+    op_conf.set_scope_symbol_id(scope_symbol_id);
+    if (!op_conf.has_device_tag()) {
+      op_conf.set_device_tag(option_.device_tag);
+    } else if (NeedCheckDeviceTag(op_conf) && op_conf.device_tag() != option_.device_tag) {
+      LOG(WARNING) << "the device_tag of op " << op_conf.name() << " is " << op_conf.device_tag()
+                   << " rather than " << option_.device_tag
+                   << ", which may make the graph incompatible";
+    }
+    if (option_.is_mirrored_view) {
+      JUST(ctx->AddAndInferMirroredOp(op_conf));
+    } else {
+      JUST(ctx->AddAndInferConsistentOp(op_conf));
+    }
+  }
+  JUST(ctx->Complete());
+  JUST(ctx->Rebuild());
+  for (const auto& pair : signature_it->second.inputs()) {
+    input_name2op_name_[pair.first] = pair.second.lbi().op_name();
+    input_name2info_[pair.first] =
+        *JUST(GetServingTensorInfo(*ctx, GenLogicalBlobName(pair.second.lbi())));
+  }
+  for (const auto& pair : signature_it->second.outputs()) {
+    output_name2op_name_[pair.first] = pair.second.lbi().op_name();
+    output_name2info_[pair.first] =
+        *JUST(GetServingTensorInfo(*ctx, GenLogicalBlobName(pair.second.lbi())));
+  }
+  JUST(JobBuildAndInferCtx_Close());
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> InferenceSession::Launch() {
+  CHECK_OR_RETURN(status_ == Status::kOpen);
+  CHECK_OR_RETURN(!job_name_.empty()) << "no saved model loaded";
+  JUST(StartLazyGlobalSession());
+  status_ = Status::kRunning;
+  const InterUserJobInfo& inter_user_job_info = *Global<InterUserJobInfo>::Get();
+  for (const auto& pair : input_name2op_name_) {
+    const auto it = inter_user_job_info.input_or_var_op_name2push_job_name().find(pair.second);
+    CHECK_OR_RETURN(it != inter_user_job_info.input_or_var_op_name2push_job_name().end())
+        << "no push job of input " << pair.first;
+    input_name2push_job_name_[pair.first] = it->second;
+  }
+  for (const auto& pair : output_name2op_name_) {
+    const auto it = inter_user_job_info.output_or_var_op_name2pull_job_name().find(pair.second);
+    CHECK_OR_RETURN(it != inter_user_job_info.output_or_var_op_name2pull_job_name().end())
+        << "no pull job of output " << pair.first;
+    output_name2pull_job_name_[pair.first] = it->second;
+  }
+  JUST(RunCheckpointLoadJob());
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> InferenceSession::RunCheckpointLoadJob() {
+  ServingTensor path(DataType::kInt8, Shape({static_cast<int64_t>(checkpoint_path_.size())}));
+  std::memcpy(path.mut_data(), checkpoint_path_.data(), checkpoint_path_.size());
+  BlockingCounter counter(1);
+  JUST(LaunchJob(MakePushJobInstance(Global<InterUserJobInfo>::Get()->global_model_load_job_name(),
+                                     "", &path, [&counter]() { counter.Decrease(); })));
+  counter.WaitUntilCntEqualZero();
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> InferenceSession::CheckJobsLaunchable(
+    const std::vector<std::shared_ptr<ForeignJobInstance>>& job_instances) const {
+  CHECK_OR_RETURN(Global<MachineCtx>::Get()->IsThisMachineMaster());
+  CHECK_NOTNULL_OR_RETURN(Global<Oneflow>::Get());
+  const auto* job_name2job_id = Global<JobName2JobId>::Get();
+  CHECK_NOTNULL_OR_RETURN(job_name2job_id);
+  for (const auto& job_instance : job_instances) {
+    CHECK_OR_RETURN(job_name2job_id->find(job_instance->job_name()) != job_name2job_id->end())
+        << "job " << job_instance->job_name() << " is not compiled";
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> InferenceSession::Run(const ServingTensorMap& inputs, ServingTensorMap* outputs) {
+  CHECK_OR_RETURN(status_ == Status::kRunning);
+  for (const auto& pair : input_name2info_) {
+    const auto it = inputs.find(pair.first);
+    CHECK_OR_RETURN(it != inputs.end()) << "input " << pair.first << " is absent";
+    const ServingTensor& input = it->second;
+    const ServingTensorInfo& info = pair.second;
+    CHECK_EQ_OR_RETURN(input.data_type(), info.data_type)
+        << "input " << pair.first << " has a wrong data type";
+    if (info.is_dynamic) {
+      CHECK_EQ_OR_RETURN(input.shape().NumAxes(), info.static_shape.NumAxes())
+          << "input " << pair.first << " should be within " << info.static_shape.ToString();
+      FOR_RANGE(int64_t, axis, 0, input.shape().NumAxes()) {
+        CHECK_GE_OR_RETURN(input.shape().At(axis), 0)
+            << "input " << pair.first << " has a negative dim in " << input.shape().ToString();
+        CHECK_LE_OR_RETURN(input.shape().At(axis), info.static_shape.At(axis))
+            << "input " << pair.first << " should be within " << info.static_shape.ToString();
+      }
+    } else {
+      CHECK_EQ_OR_RETURN(input.shape(), info.static_shape)
+          << "input " << pair.first << " has shape " << input.shape().ToString() << " rather than "
+          << info.static_shape.ToString();
+    }
+  }
+  std::unique_lock<std::mutex> lock(run_mutex_);
+  outputs->clear();
+  std::mutex outputs_mutex;
+  BlockingCounter counter(input_name2push_job_name_.size() + 1 + output_name2pull_job_name_.size());
+  const auto Finish = [&counter]() { counter.Decrease(); };
+  // pushes, then the user job, then pulls
+  std::vector<std::shared_ptr<ForeignJobInstance>> job_instances;
+  for (const auto& pair : input_name2push_job_name_) {
+    job_instances.push_back(MakePushJobInstance(pair.second, input_name2op_name_.at(pair.first),
+                                                &inputs.at(pair.first), Finish));
+  }
+  job_instances.push_back(MakeUserJobInstance(job_name_, Finish));
+  for (const auto& pair : output_name2pull_job_name_) {
+    const std::string& output_name = pair.first;
+    const auto Handler = [&, output_name](ServingTensor&& tensor) {
+      std::unique_lock<std::mutex> outputs_lock(outputs_mutex);
+      (*outputs)[output_name] = std::move(tensor);
+    };
+    job_instances.push_back(
+        MakePullJobInstance(pair.second, output_name2op_name_.at(output_name), Handler, Finish));
+  }
+  JUST(CheckJobsLaunchable(job_instances));
+  FOR_RANGE(size_t, i, 0, job_instances.size()) {
+    const Maybe<void> launched = LaunchJob(job_instances.at(i));
+    if (!launched.IsOk()) {
+      // the launched jobs still refer to the counter and the outputs on this stack
+      FOR_RANGE(size_t, j, i, job_instances.size()) { counter.Decrease(); }
+      counter.WaitUntilCntEqualZero();
+      return launched;
+    }
+  }
+  counter.WaitUntilCntEqualZero();
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> InferenceSession::Close() {
+  if (status_ == Status::kRunning) { JUST(StopLazyGlobalSession()); }
+  if (status_ == Status::kRunning || status_ == Status::kOpen) {
+    JUST(DestroyLazyGlobalSession());
+  }
+  status_ = Status::kClosed;
+  return Maybe<void>::Ok();
+}
+
+}  // namespace oneflow
@@ -0,0 +1,95 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_SERVING_INFERENCE_SESSION_H_
+#define ONEFLOW_CORE_SERVING_INFERENCE_SESSION_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/job/job_set.pb.h"
+#include "oneflow/core/serving/saved_model.pb.h"
+#include "oneflow/core/serving/serving_tensor.h"
+
+namespace oneflow {
+
+class ForeignJobInstance;
+
+struct InferenceSessionOption {
+  std::string device_tag = "cpu";
+  int64_t device_num = 1;
+  bool is_mirrored_view = false;
+};
+
+// Finds the directory of a version of a SavedModel, a negative model_version picks the latest
+Maybe<std::string> FindSavedModelVersionDir(const std::string& saved_model_dir,
+                                            int64_t model_version);
+// Reads saved_model.pb, or saved_model.prototxt if there is no pb, of a version directory
+Maybe<void> ReadSavedModel(const std::string& version_dir, SavedModel* saved_model);
+
+// The native counterpart of oneflow.serving.InferenceSession. It compiles one graph of a
+// SavedModel into the lazy global session and runs it with jobs launched from C++, the blobs of
+// the push and pull jobs are filled from and copied to ServingTensors. The env must be inited.
+class InferenceSession final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(InferenceSession);
+  explicit InferenceSession(const InferenceSessionOption& option);
+  ~InferenceSession();
+
+  Maybe<void> Init();
+  // An empty graph or signature name picks the default one of the SavedModel, a positive
+  // batch_size replaces the batch axis of every input of the signature
+  Maybe<void> LoadSavedModel(const std::string& saved_model_dir, int64_t model_version,
+                             const std::string& graph_name, const std::string& signature_name,
+                             int64_t batch_size);
+  // Starts the runtime and loads the checkpoint of the SavedModel
+  Maybe<void> Launch();
+  // Inputs and outputs are keyed by their names in the signature, runs are serialized
+  Maybe<void> Run(const ServingTensorMap& inputs, ServingTensorMap* outputs);
+  Maybe<void> Close();
+
+  const std::string& job_name() const { return job_name_; }
+  const HashMap<std::string, ServingTensorInfo>& input_name2info() const {
+    return input_name2info_;
+  }
+  const HashMap<std::string, ServingTensorInfo>& output_name2info() const {
+    return output_name2info_;
+  }
+
+ private:
+  enum class Status { kNew, kOpen, kRunning, kClosed };
+
+  Maybe<void> RunCheckpointLoadJob();
+  // Run launches its jobs only if none of them can fail to launch
+  Maybe<void> CheckJobsLaunchable(
+      const std::vector<std::shared_ptr<ForeignJobInstance>>& job_instances) const;
+
+  const InferenceSessionOption option_;
+  Status status_;
+  int64_t session_id_;
+  ConfigProto config_proto_;
+  std::string job_name_;
+  std::string checkpoint_path_;
+  HashMap<std::string, ServingTensorInfo> input_name2info_;
+  HashMap<std::string, ServingTensorInfo> output_name2info_;
+  HashMap<std::string, std::string> input_name2op_name_;
+  HashMap<std::string, std::string> output_name2op_name_;
+  HashMap<std::string, std::string> input_name2push_job_name_;
+  HashMap<std::string, std::string> output_name2pull_job_name_;
+  std::mutex run_mutex_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_SERVING_INFERENCE_SESSION_H_
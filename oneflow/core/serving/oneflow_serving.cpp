@@ -0,0 +1,188 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstring>
+#include "oneflow/api/python/env/env.h"
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/common/protobuf.h"
+#include "oneflow/core/job/env.pb.h"
+#include "oneflow/core/serving/dynamic_batcher.h"
+#include "oneflow/core/serving/inference_session.h"
+#include "oneflow/core/serving/serving_http_server.h"
+
+DEFINE_string(env_proto, "", "EnvProto file path, a single machine env on localhost if empty");
+DEFINE_string(saved_model_dir, "", "directory of the versions of a SavedModel");
+DEFINE_int64(model_version, -1, "version of the SavedModel to serve, the latest if negative");
+DEFINE_string(graph_name, "", "graph to serve, the default graph of the SavedModel if empty");
+DEFINE_string(signature_name, "", "signature of the graph, the default one if empty");
+DEFINE_string(device_tag, "cpu", "cpu or gpu");
+DEFINE_int32(device_num, 1, "devices per machine");
+DEFINE_int64(max_batch_size, 8, "rows of a merged batch, the model is compiled with this batch");
+DEFINE_int64(max_queue_delay_us, 1000, "how long a request waits for others to join its batch");
+DEFINE_string(host, "127.0.0.1", "address the http front end listens on");
+DEFINE_int32(port, 8000, "port of the http front end");
+DEFINE_int32(http_worker_num, 64, "connections the http front end serves at the same time");
+DEFINE_int32(benchmark_client_num, 0,
+             "run the load generator with this many closed loop clients instead of serving http");
+DEFINE_int64(benchmark_rows_per_request, 1, "rows of every request of the load generator");
+DEFINE_int64(benchmark_warmup_seconds, 2, "seconds of load before the stats are reset");
+DEFINE_int64(benchmark_seconds, 10, "seconds of load that are measured");
+
+namespace oneflow {
+
+namespace {
+
+Maybe<int32_t> FindFreePort() {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  CHECK_GE_OR_RETURN(fd, 0);
+  sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  socklen_t addr_len = sizeof(addr);
+  const bool found = bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0
+                     && getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &addr_len) == 0;
+  close(fd);
+  CHECK_OR_RETURN(found) << "no free port for the ctrl server";
+  return static_cast<int32_t>(ntohs(addr.sin_port));
+}
+
+Maybe<std::string> EnvProtoString() {
+  EnvProto env_proto;
+  if (FLAGS_env_proto.empty()) {
+    Machine* machine = env_proto.add_machine();
+    machine->set_id(0);
+    machine->set_addr("127.0.0.1");
+    env_proto.set_ctrl_port(JUST(FindFreePort()));
+  } else {
+    CHECK_OR_RETURN(TryParseProtoFromTextFile(FLAGS_env_proto, &env_proto))
+        << "failed to parse " << FLAGS_env_proto;
+  }
+  return PbMessage2TxtString(env_proto);
+}
+
+ServingTensorMap MakeBenchmarkInputs(const HashMap<std::string, ServingTensorInfo>& name2info) {
+  ServingTensorMap inputs;
+  for (const auto& pair : name2info) {
+    DimVector dim_vec = pair.second.static_shape.dim_vec();
+    dim_vec.at(0) = FLAGS_benchmark_rows_per_request;
+    inputs.emplace(pair.first, ServingTensor(pair.second.data_type, Shape(dim_vec)));
+  }
+  return inputs;
+}
+
+// Closed loop clients, each sends its next request once the last one is answered
+Maybe<void> RunBenchmark(const InferenceSession& session, DynamicBatcher* batcher) {
+  CHECK_GT_OR_RETURN(FLAGS_benchmark_rows_per_request, 0);
+  CHECK_LE_OR_RETURN(FLAGS_benchmark_rows_per_request, FLAGS_max_batch_size);
+  const ServingTensorMap inputs = MakeBenchmarkInputs(session.input_name2info());
+  std::atomic<bool> stopped(false);
+  std::atomic<int64_t> failed_cnt(0);
+  std::vector<std::thread> clients;
+  FOR_RANGE(int32_t, i, 0, FLAGS_benchmark_client_num) {
+    clients.emplace_back([&]() {
+      ServingTensorMap outputs;
+      while (!stopped) {
+        if (!batcher->Infer(inputs, &outputs).IsOk()) { failed_cnt += 1; }
+      }
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::seconds(FLAGS_benchmark_warmup_seconds));
+  batcher->mut_stats()->Reset();
+  std::this_thread::sleep_for(std::chrono::seconds(FLAGS_benchmark_seconds));
+  const ServingStatsSummary summary = batcher->stats().Summary();
+  stopped = true;
+  for (auto& client : clients) { client.join(); }
+  std::cout << "clients: " << FLAGS_benchmark_client_num
+            << ", rows per request: " << FLAGS_benchmark_rows_per_request
+            << ", max batch size: " << FLAGS_max_batch_size
+            << ", max queue delay: " << FLAGS_max_queue_delay_us << "us" << std::endl
+            << summary.ToString() << ", rows/s: "
+            << summary.requests_per_second * FLAGS_benchmark_rows_per_request
+            << ", failed requests: " << failed_cnt << std::endl;
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> WaitForTermination(const sigset_t& signals) {
+  int signal = 0;
+  CHECK_EQ_OR_RETURN(sigwait(&signals, &signal), 0);
+  LOG(INFO) << "received signal " << signal << ", stopping";
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> Serve(const sigset_t& signals) {
+  CHECK_OR_RETURN(!FLAGS_saved_model_dir.empty()) << "--saved_model_dir is required";
+  InferenceSessionOption option;
+  option.device_tag = FLAGS_device_tag;
+  option.device_num = FLAGS_device_num;
+  InferenceSession session(option);
+  JUST(session.Init());
+  JUST(session.LoadSavedModel(FLAGS_saved_model_dir, FLAGS_model_version, FLAGS_graph_name,
+                              FLAGS_signature_name, FLAGS_max_batch_size));
+  JUST(session.Launch());
+  DynamicBatcherConf batcher_conf;
+  batcher_conf.max_batch_size = FLAGS_max_batch_size;
+  batcher_conf.max_queue_delay_us = FLAGS_max_queue_delay_us;
+  // a dynamic input takes a batch of any rows within the compiled one
+  batcher_conf.pad_to_max_batch_size = !std::any_of(
+      session.input_name2info().begin(), session.input_name2info().end(),
+      [](const std::pair<const std::string, ServingTensorInfo>& pair) {
+        return pair.second.is_dynamic;
+      });
+  DynamicBatcher batcher(batcher_conf,
+                         [&session](const ServingTensorMap& inputs, ServingTensorMap* outputs) {
+                           return session.Run(inputs, outputs);
+                         });
+  if (FLAGS_benchmark_client_num > 0) {
+    JUST(RunBenchmark(session, &batcher));
+  } else {
+    ServingHttpServerConf server_conf;
+    server_conf.host = FLAGS_host;
+    server_conf.port = FLAGS_port;
+    server_conf.worker_num = FLAGS_http_worker_num;
+    ServingHttpServer server(server_conf, session.input_name2info(), session.output_name2info(),
+                             &batcher);
+    JUST(server.Start());
+    JUST(WaitForTermination(signals));
+    server.Stop();
+    LOG(INFO) << batcher.stats().Summary().ToString();
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+}  // namespace oneflow
+
+int main(int argc, char* argv[]) {
+  using namespace oneflow;
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  // blocked before any thread starts, so that only sigwait receives them
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+  CHECK_JUST(InitEnv(*CHECK_JUST(EnvProtoString())));
+  CHECK_JUST(Serve(signals));
+  CHECK_JUST(DestroyEnv());
+  return 0;
+}
@@ -0,0 +1,325 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <json.hpp>
+#include "oneflow/core/serving/serving_http_server.h"
+#include "oneflow/core/common/switch_func.h"
+
+namespace oneflow {
+
+namespace {
+
+const size_t kMaxHeaderSize = 64 << 10;
+
+const char* ReasonPhrase(int32_t status) {
+  switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    default: return "Internal Server Error";
+  }
+}
+
+bool SendAll(int fd, const std::string& data) {
+  size_t offset = 0;
+  while (offset < data.size()) {
+    const ssize_t n = send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) { continue; }
+    if (n <= 0) { return false; }
+    offset += n;
+  }
+  return true;
+}
+
+// Returns the bytes read, 0 if the connection is closed or broken
+size_t Recv(int fd, std::string* data) {
+  char buf[8192];
+  while (true) {
+    const ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n < 0 && errno == EINTR) { continue; }
+    if (n <= 0) { return 0; }
+    data->append(buf, n);
+    return n;
+  }
+}
+
+bool ReadRequest(int fd, int64_t max_body_size, std::string* method, std::string* path,
+                 std::string* body) {
+  std::string data;
+  size_t header_end = std::string::npos;
+  while ((header_end = data.find("\r\n\r\n")) == std::string::npos) {
+    if (data.size() > kMaxHeaderSize || Recv(fd, &data) == 0) { return false; }
+  }
+  std::istringstream header(data.substr(0, header_end));
+  std::string request_line;
+  std::getline(header, request_line);
+  std::istringstream(request_line) >> *method >> *path;
+  *path = path->substr(0, path->find('?'));
+  int64_t content_length = 0;
+  std::string line;
+  while (std::getline(header, line)) {
+    const size_t colon = line.find(':');
+    if (colon == std::string::npos) { continue; }
+    std::string name = line.substr(0, colon);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name == "content-length") {
+      content_length = std::strtoll(line.c_str() + colon + 1, nullptr, 10);
+    }
+  }
+  if (content_length < 0 || content_length > max_body_size) { return false; }
+  *body = data.substr(header_end + 4);
+  while (static_cast<int64_t>(body->size()) < content_length) {
+    if (Recv(fd, body) == 0) { return false; }
+  }
+  body->resize(content_length);
+  return true;
+}
+
+std::vector<int64_t> ShapeToVector(const Shape& shape) {
+  return std::vector<int64_t>(shape.dim_vec().begin(), shape.dim_vec().end());
+}
+
+template<typename T>
+void JsonToTensor(const nlohmann::json& data, ServingTensor* tensor) {
+  T* dptr = tensor->mut_data<T>();
+  FOR_RANGE(size_t, i, 0, data.size()) { dptr[i] = data[i].get<T>(); }
+}
+
+template<typename T>
+void TensorToJson(const ServingTensor& tensor, nlohmann::json* data) {
+  const T* dptr = tensor.data<T>();
+  *data = nlohmann::json::array();
+  FOR_RANGE(int64_t, i, 0, tensor.shape().elem_cnt()) { data->push_back(dptr[i]); }
+}
+
+#define MAKE_JSON_CONVERT_SWITCH_ENTRY(func_name, T) func_name<T>
+DEFINE_STATIC_SWITCH_FUNC(void, JsonToTensor, MAKE_JSON_CONVERT_SWITCH_ENTRY,
+                          MAKE_DATA_TYPE_CTRV_SEQ(POD_DATA_TYPE_SEQ));
+DEFINE_STATIC_SWITCH_FUNC(void, TensorToJson, MAKE_JSON_CONVERT_SWITCH_ENTRY,
+                          MAKE_DATA_TYPE_CTRV_SEQ(POD_DATA_TYPE_SEQ));
+#undef MAKE_JSON_CONVERT_SWITCH_ENTRY
+
+nlohmann::json InfosToJson(const HashMap<std::string, ServingTensorInfo>& name2info) {
+  nlohmann::json infos = nlohmann::json::object();
+  for (const auto& pair : name2info) {
+    infos[pair.first] = {{"data_type", DataType_Name(pair.second.data_type)},
+                         {"shape", ShapeToVector(pair.second.static_shape)},
+                         {"is_dynamic", pair.second.is_dynamic}};
+  }
+  return infos;
+}
+
+nlohmann::json StatsToJson(const ServingStatsSummary& summary) {
+  return {{"request_cnt", summary.request_cnt},
+          {"batch_cnt", summary.batch_cnt},
+          {"mean_batch_size", summary.mean_batch_size},
+          {"padding_ratio", summary.padding_ratio},
+          {"mean_latency_us", summary.mean_latency_us},
+          {"p50_latency_us", summary.p50_latency_us},
+          {"p99_latency_us", summary.p99_latency_us},
+          {"max_latency_us", summary.max_latency_us},
+          {"elapsed_seconds", summary.elapsed_seconds},
+          {"requests_per_second", summary.requests_per_second}};
+}
+
+std::string ErrorToJson(const std::string& message) {
+  return nlohmann::json({{"error", message}}).dump();
+}
+
+}  // namespace
+
+ServingHttpServer::ServingHttpServer(
+    const ServingHttpServerConf& conf,
+    const HashMap<std::string, ServingTensorInfo>& input_name2info,
+    const HashMap<std::string, ServingTensorInfo>& output_name2info, DynamicBatcher* batcher)
+    : conf_(conf),
+      input_name2info_(input_name2info),
+      output_name2info_(output_name2info),
+      batcher_(batcher),
+      listen_fd_(-1),
+      port_(-1),
+      stopped_(true) {
+  CHECK_GT(conf_.worker_num, 0);
+}
+
+ServingHttpServer::~ServingHttpServer() { Stop(); }
+
+Maybe<void> ServingHttpServer::Start() {
+  CHECK_OR_RETURN(stopped_) << "http server is started already";
+  listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+  CHECK_GE_OR_RETURN(listen_fd_, 0) << "failed to create socket: " << std::strerror(errno);
+  const int reuse_addr = 1;
+  setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse_addr, sizeof(reuse_addr));
+  sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(conf_.port);
+  CHECK_EQ_OR_RETURN(inet_pton(AF_INET, conf_.host.c_str(), &addr.sin_addr), 1)
+      << "invalid host " << conf_.host;
+  CHECK_EQ_OR_RETURN(bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0)
+      << "failed to bind " << conf_.host << ":" << conf_.port << ": " << std::strerror(errno);
+  CHECK_EQ_OR_RETURN(listen(listen_fd_, SOMAXCONN), 0) << std::strerror(errno);
+  socklen_t addr_len = sizeof(addr);
+  CHECK_EQ_OR_RETURN(getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &addr_len), 0);
+  port_ = ntohs(addr.sin_port);
+  stopped_ = false;
+  FOR_RANGE(int32_t, i, 0, conf_.worker_num) {
+    workers_.emplace_back([this]() {
+      int fd = -1;
+      while (connection_channel_.Receive(&fd) == kChannelStatusSuccess) { ServeConnection(fd); }
+    });
+  }
+  accept_thread_ = std::thread([this]() { AcceptLoop(); });
+  LOG(INFO) << "serving http on " << conf_.host << ":" << port_;
+  return Maybe<void>::Ok();
+}
+
+void ServingHttpServer::Stop() {
+  if (stopped_.exchange(true)) { return; }
+  // wakes up the accept loop
+  shutdown(listen_fd_, SHUT_RDWR);
+  accept_thread_.join();
+  close(listen_fd_);
+  connection_channel_.Close();
+  for (auto& worker : workers_) { worker.join(); }
+  workers_.clear();
+}
+
+void ServingHttpServer::AcceptLoop() {
+  while (!stopped_) {
+    const int fd = accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) { continue; }
+      if (!stopped_) { LOG(ERROR) << "accept failed: " << std::strerror(errno); }
+      break;
+    }
+    if (connection_channel_.Send(fd) != kChannelStatusSuccess) { close(fd); }
+  }
+}
+
+void ServingHttpServer::ServeConnection(int fd) {
+  timeval timeout;
+  timeout.tv_sec = 30;
+  timeout.tv_usec = 0;
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  std::string method;
+  std::string path;
+  std::string body;
+  std::string response_body;
+  int32_t status = 400;
+  if (ReadRequest(fd, conf_.max_body_size, &method, &path, &body)) {
+    status = HandleRequest(method, path, body, &response_body);
+  } else {
+    response_body = ErrorToJson("malformed request");
+  }
+  std::ostringstream response;
+  response << "HTTP/1.1 " << status << " " << ReasonPhrase(status) << "\r\n"
+           << "Content-Type: application/json\r\n"
+           << "Content-Length: " << response_body.size() << "\r\n"
+           << "Connection: close\r\n\r\n"
+           << response_body;
+  SendAll(fd, response.str());
+  close(fd);
+}
+
+int32_t ServingHttpServer::HandleRequest(const std::string& method, const std::string& path,
+                                         const std::string& body, std::string* response_body) {
+  if (method == "GET" && path == "/v1/model") {
+    const nlohmann::json model = {{"inputs", InfosToJson(input_name2info_)},
+                                  {"outputs", InfosToJson(output_name2info_)}};
+    *response_body = model.dump();
+    return 200;
+  }
+  if (method == "GET" && path == "/v1/stats") {
+    *response_body = StatsToJson(batcher_->stats().Summary()).dump();
+    return 200;
+  }
+  if (method != "POST" || path != "/v1/infer") {
+    *response_body = ErrorToJson(method + " " + path + " not found");
+    return 404;
+  }
+  ServingTensorMap inputs;
+  try {
+    const Maybe<void> parsed = ParseInputs(body, &inputs);
+    if (!parsed.IsOk()) {
+      *response_body = ErrorToJson(parsed.GetSerializedError());
+      return 400;
+    }
+  } catch (const nlohmann::json::exception& e) {
+    *response_body = ErrorToJson(e.what());
+    return 400;
+  }
+  ServingTensorMap outputs;
+  const Maybe<void> inferred = batcher_->Infer(inputs, &outputs);
+  if (!inferred.IsOk()) {
+    *response_body = ErrorToJson(inferred.GetSerializedError());
+    return 500;
+  }
+  nlohmann::json json_outputs = nlohmann::json::object();
+  for (const auto& pair : outputs) {
+    nlohmann::json data;
+    SwitchTensorToJson(SwitchCase(pair.second.data_type()), pair.second, &data);
+    json_outputs[pair.first] = {{"shape", ShapeToVector(pair.second.shape())}, {"data", data}};
+  }
+  *response_body = nlohmann::json({{"outputs", json_outputs}}).dump();
+  return 200;
+}
+
+Maybe<void> ServingHttpServer::ParseInputs(const std::string& request_body,
+                                           ServingTensorMap* inputs) const {
+  const nlohmann::json request = nlohmann::json::parse(request_body);
+  const nlohmann::json& json_inputs = request.at("inputs");
+  for (const auto& pair : input_name2info_) {
+    const auto it = json_inputs.find(pair.first);
+    CHECK_OR_RETURN(it != json_inputs.end()) << "input " << pair.first << " is absent";
+    const ServingTensorInfo& info = pair.second;
+    const std::vector<int64_t> dims = it->at("shape").get<std::vector<int64_t>>();
+    const Shape shape(DimVector(dims.begin(), dims.end()));
+    // the batch axis is checked by the batcher, the rest must fit the compiled shape
+    CHECK_EQ_OR_RETURN(shape.NumAxes(), info.static_shape.NumAxes())
+        << "input " << pair.first << " should be of shape " << info.static_shape.ToString();
+    FOR_RANGE(int64_t, axis, 0, shape.NumAxes()) {
+      CHECK_GE_OR_RETURN(shape.At(axis), 0)
+          << "input " << pair.first << " has a negative dim in " << shape.ToString();
+    }
+    FOR_RANGE(int64_t, axis, 1, shape.NumAxes()) {
+      if (info.is_dynamic) {
+        CHECK_LE_OR_RETURN(shape.At(axis), info.static_shape.At(axis))
+            << "input " << pair.first << " should be within " << info.static_shape.ToString();
+      } else {
+        CHECK_EQ_OR_RETURN(shape.At(axis), info.static_shape.At(axis))
+            << "input " << pair.first << " should be of shape " << info.static_shape.ToString();
+      }
+    }
+    const nlohmann::json& data = it->at("data");
+    CHECK_OR_RETURN(data.is_array()) << "data of input " << pair.first << " is not an array";
+    CHECK_EQ_OR_RETURN(static_cast<int64_t>(data.size()), shape.elem_cnt())
+        << "input " << pair.first << " has " << data.size() << " elements rather than "
+        << shape.elem_cnt();
+    ServingTensor tensor(info.data_type, shape);
+    SwitchJsonToTensor(SwitchCase(info.data_type), data, &tensor);
+    inputs->emplace(pair.first, std::move(tensor));
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace oneflow
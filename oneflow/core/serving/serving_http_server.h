@@ -0,0 +1,77 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_SERVING_SERVING_HTTP_SERVER_H_
+#define ONEFLOW_CORE_SERVING_SERVING_HTTP_SERVER_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/common/channel.h"
+#include "oneflow/core/serving/dynamic_batcher.h"
+#include "oneflow/core/serving/serving_tensor.h"
+
+namespace oneflow {
+
+struct ServingHttpServerConf {
+  std::string host = "127.0.0.1";
+  // 0 picks a free port
+  int32_t port = 8000;
+  // connections served at the same time, which bounds how many requests a batch can merge
+  int32_t worker_num = 64;
+  int64_t max_body_size = 64 << 20;
+};
+
+// A minimal HTTP/1.1 front end of a DynamicBatcher for local clients, every connection carries
+// one request. Tensors are json objects of a shape and the flat data in row major order:
+//   POST /v1/infer {"inputs": {"x": {"shape": [2, 3], "data": [...]}}}
+//     -> {"outputs": {"y": {"shape": [2, 10], "data": [...]}}}
+//   GET /v1/model -> data types and static shapes of the inputs and outputs
+//   GET /v1/stats -> latency percentiles and throughput of the batcher
+class ServingHttpServer final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ServingHttpServer);
+  ServingHttpServer(const ServingHttpServerConf& conf,
+                    const HashMap<std::string, ServingTensorInfo>& input_name2info,
+                    const HashMap<std::string, ServingTensorInfo>& output_name2info,
+                    DynamicBatcher* batcher);
+  ~ServingHttpServer();
+
+  Maybe<void> Start();
+  void Stop();
+  int32_t port() const { return port_; }
+
+ private:
+  void AcceptLoop();
+  void ServeConnection(int fd);
+  // returns the status code and fills the json body of the response
+  int32_t HandleRequest(const std::string& method, const std::string& path,
+                        const std::string& body, std::string* response_body);
+  Maybe<void> ParseInputs(const std::string& request_body, ServingTensorMap* inputs) const;
+
+  const ServingHttpServerConf conf_;
+  const HashMap<std::string, ServingTensorInfo> input_name2info_;
+  const HashMap<std::string, ServingTensorInfo> output_name2info_;
+  DynamicBatcher* batcher_;
+  int listen_fd_;
+  int32_t port_;
+  std::atomic<bool> stopped_;
+  Channel<int> connection_channel_;
+  std::thread accept_thread_;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_SERVING_SERVING_HTTP_SERVER_H_
@@ -0,0 +1,111 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include "oneflow/core/serving/serving_stats.h"
+
+namespace oneflow {
+
+namespace {
+
+// nearest rank percentile of sorted samples
+double Percentile(const std::vector<double>& sorted_samples, double percent) {
+  if (sorted_samples.empty()) { return 0; }
+  const int64_t rank =
+      static_cast<int64_t>(std::ceil(percent / 100.0 * sorted_samples.size())) - 1;
+  return sorted_samples.at(std::min<int64_t>(std::max<int64_t>(rank, 0),
+                                             sorted_samples.size() - 1));
+}
+
+}  // namespace
+
+std::string ServingStatsSummary::ToString() const {
+  std::ostringstream ss;
+  ss << std::fixed << std::setprecision(2) << "requests: " << request_cnt
+     << ", batches: " << batch_cnt << ", mean batch size: " << mean_batch_size
+     << ", padding ratio: " << padding_ratio << ", latency mean/p50/p99/max (us): "
+     << mean_latency_us << "/" << p50_latency_us << "/" << p99_latency_us << "/"
+     << max_latency_us << ", throughput: " << requests_per_second << " requests/s over "
+     << elapsed_seconds << "s";
+  return ss.str();
+}
+
+ServingStats::ServingStats(int64_t max_latency_sample_cnt)
+    : max_latency_sample_cnt_(max_latency_sample_cnt) {
+  CHECK_GT(max_latency_sample_cnt_, 0);
+  Reset();
+}
+
+void ServingStats::RecordRequest(double latency_us) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (static_cast<int64_t>(latency_samples_.size()) < max_latency_sample_cnt_) {
+    latency_samples_.push_back(latency_us);
+  } else {
+    latency_samples_.at(next_sample_index_) = latency_us;
+    next_sample_index_ = (next_sample_index_ + 1) % max_latency_sample_cnt_;
+  }
+  request_cnt_ += 1;
+  latency_sum_us_ += latency_us;
+}
+
+void ServingStats::RecordBatch(int64_t batch_size, int64_t padded_batch_size) {
+  CHECK_LE(batch_size, padded_batch_size);
+  std::unique_lock<std::mutex> lock(mutex_);
+  batch_cnt_ += 1;
+  row_cnt_ += batch_size;
+  padded_row_cnt_ += padded_batch_size - batch_size;
+}
+
+void ServingStats::Reset() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  start_time_ = std::chrono::steady_clock::now();
+  latency_samples_.clear();
+  next_sample_index_ = 0;
+  request_cnt_ = 0;
+  latency_sum_us_ = 0;
+  batch_cnt_ = 0;
+  row_cnt_ = 0;
+  padded_row_cnt_ = 0;
+}
+
+ServingStatsSummary ServingStats::Summary() const {
+  std::vector<double> sorted_samples;
+  ServingStatsSummary summary;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    sorted_samples = latency_samples_;
+    summary.request_cnt = request_cnt_;
+    summary.batch_cnt = batch_cnt_;
+    if (batch_cnt_ > 0) { summary.mean_batch_size = static_cast<double>(row_cnt_) / batch_cnt_; }
+    if (row_cnt_ + padded_row_cnt_ > 0) {
+      summary.padding_ratio = static_cast<double>(padded_row_cnt_) / (row_cnt_ + padded_row_cnt_);
+    }
+    if (request_cnt_ > 0) { summary.mean_latency_us = latency_sum_us_ / request_cnt_; }
+    summary.elapsed_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+  }
+  std::sort(sorted_samples.begin(), sorted_samples.end());
+  summary.p50_latency_us = Percentile(sorted_samples, 50);
+  summary.p99_latency_us = Percentile(sorted_samples, 99);
+  summary.max_latency_us = sorted_samples.empty() ? 0 : sorted_samples.back();
+  if (summary.elapsed_seconds > 0) {
+    summary.requests_per_second = summary.request_cnt / summary.elapsed_seconds;
+  }
+  return summary;
+}
+
+}  // namespace oneflow
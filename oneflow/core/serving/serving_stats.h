@@ -0,0 +1,68 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_SERVING_SERVING_STATS_H_
+#define ONEFLOW_CORE_SERVING_SERVING_STATS_H_
+
+#include <chrono>
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+struct ServingStatsSummary {
+  int64_t request_cnt = 0;
+  int64_t batch_cnt = 0;
+  double mean_batch_size = 0;
+  // padded rows over all rows run, padding is needed when the model is compiled with a fixed batch
+  double padding_ratio = 0;
+  double mean_latency_us = 0;
+  double p50_latency_us = 0;
+  double p99_latency_us = 0;
+  double max_latency_us = 0;
+  double elapsed_seconds = 0;
+  double requests_per_second = 0;
+
+  std::string ToString() const;
+};
+
+// Thread safe counters of a serving endpoint. Only the latest max_latency_sample_cnt request
+// latencies are kept for the percentiles, the counts cover everything since the last Reset.
+class ServingStats final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ServingStats);
+  explicit ServingStats(int64_t max_latency_sample_cnt);
+  ~ServingStats() = default;
+
+  void RecordRequest(double latency_us);
+  void RecordBatch(int64_t batch_size, int64_t padded_batch_size);
+  void Reset();
+  ServingStatsSummary Summary() const;
+
+ private:
+  const int64_t max_latency_sample_cnt_;
+  mutable std::mutex mutex_;
+  std::chrono::steady_clock::time_point start_time_;
+  std::vector<double> latency_samples_;
+  int64_t next_sample_index_;
+  int64_t request_cnt_;
+  double latency_sum_us_;
+  int64_t batch_cnt_;
+  int64_t row_cnt_;
+  int64_t padded_row_cnt_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_SERVING_SERVING_STATS_H_
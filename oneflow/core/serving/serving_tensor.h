@@ -0,0 +1,69 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_SERVING_SERVING_TENSOR_H_
+#define ONEFLOW_CORE_SERVING_SERVING_TENSOR_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/shape.h"
+#include "oneflow/core/common/data_type.h"
+
+namespace oneflow {
+
+// A dense tensor in host memory that is passed in and out of the serving runtime
+class ServingTensor final {
+ public:
+  ServingTensor() : data_type_(DataType::kInvalidDataType) {}
+  ServingTensor(DataType data_type, const Shape& shape)
+      : data_type_(data_type),
+        shape_(shape),
+        buffer_(shape.elem_cnt() * GetSizeOfDataType(data_type), 0) {}
+  ~ServingTensor() = default;
+
+  DataType data_type() const { return data_type_; }
+  const Shape& shape() const { return shape_; }
+  size_t ByteSize() const { return buffer_.size(); }
+  const char* data() const { return buffer_.data(); }
+  char* mut_data() { return buffer_.data(); }
+
+  template<typename T>
+  const T* data() const {
+    CHECK_EQ(data_type_, GetDataType<T>::value);
+    return reinterpret_cast<const T*>(buffer_.data());
+  }
+  template<typename T>
+  T* mut_data() {
+    CHECK_EQ(data_type_, GetDataType<T>::value);
+    return reinterpret_cast<T*>(buffer_.data());
+  }
+
+ private:
+  DataType data_type_;
+  Shape shape_;
+  std::vector<char> buffer_;
+};
+
+using ServingTensorMap = HashMap<std::string, ServingTensor>;
+
+struct ServingTensorInfo {
+  DataType data_type;
+  // the shape the job is compiled with, a dynamic blob takes any shape within it
+  Shape static_shape;
+  bool is_dynamic;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_SERVING_SERVING_TENSOR_H_
@@ -26,7 +26,8 @@ class CpuThread final : public Thread {
   CpuThread() = delete;
   ~CpuThread() = default;
 
-  CpuThread(int64_t thrd_id);
+  // The thread is pinned to the cpus of numa_node if it is not negative
+  CpuThread(int64_t thrd_id, int32_t numa_node);
 
  private:
 };
@@ -0,0 +1,168 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/thread/numa_util.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/common/str_util.h"
+#include <fstream>
+#include <numeric>
+#ifdef OF_PLATFORM_POSIX
+#include <sched.h>
+#endif
+
+namespace oneflow {
+
+namespace {
+
+bool TryReadFirstLine(const std::string& path, std::string* line) {
+  std::ifstream is(path);
+  return is.is_open() && std::getline(is, *line).good();
+}
+
+struct NumaTopology {
+  std::vector<std::vector<int32_t>> numa_node2cpu_ids;
+  HashMap<int32_t, int32_t> cpu_id2numa_node;
+};
+
+NumaTopology MakeNumaTopology() {
+  NumaTopology topology;
+#ifdef OF_PLATFORM_POSIX
+  cpu_set_t allowed_cpu_set;
+  CHECK_EQ(sched_getaffinity(0, sizeof(cpu_set_t), &allowed_cpu_set), 0);
+  const auto IsAllowed = [&](int32_t cpu_id) {
+    return cpu_id < CPU_SETSIZE && CPU_ISSET(cpu_id, &allowed_cpu_set);
+  };
+  const std::string sysfs_node_dir = "/sys/devices/system/node";
+  std::string online_nodes;
+  if (TryReadFirstLine(JoinPath(sysfs_node_dir, "online"), &online_nodes)) {
+    for (int32_t node_id : ParseCpuList(online_nodes)) {
+      std::string cpu_list;
+      const std::string node_name = "node" + std::to_string(node_id);
+      if (!TryReadFirstLine(JoinPath(sysfs_node_dir, node_name, "cpulist"), &cpu_list)) {
+        continue;
+      }
+      std::vector<int32_t> cpu_ids;
+      for (int32_t cpu_id : ParseCpuList(cpu_list)) {
+        if (IsAllowed(cpu_id)) { cpu_ids.push_back(cpu_id); }
+      }
+      if (!cpu_ids.empty()) { topology.numa_node2cpu_ids.push_back(cpu_ids); }
+    }
+  }
+  if (topology.numa_node2cpu_ids.empty()) {
+    std::vector<int32_t> cpu_ids;
+    FOR_RANGE(int32_t, cpu_id, 0, CPU_SETSIZE) {
+      if (IsAllowed(cpu_id)) { cpu_ids.push_back(cpu_id); }
+    }
+    topology.numa_node2cpu_ids.push_back(cpu_ids);
+  }
+#else
+  std::vector<int32_t> cpu_ids(std::thread::hardware_concurrency());
+  std::iota(cpu_ids.begin(), cpu_ids.end(), 0);
+  topology.numa_node2cpu_ids.push_back(cpu_ids);
+#endif
+  FOR_RANGE(int32_t, numa_node, 0, topology.numa_node2cpu_ids.size()) {
+    for (int32_t cpu_id : topology.numa_node2cpu_ids.at(numa_node)) {
+      topology.cpu_id2numa_node.emplace(cpu_id, numa_node);
+    }
+  }
+  return topology;
+}
+
+const NumaTopology& GetNumaTopology() {
+  static const NumaTopology topology = MakeNumaTopology();
+  return topology;
+}
+
+}  // namespace
+
+int32_t NumaNodeNum() { return GetNumaTopology().numa_node2cpu_ids.size(); }
+
+const std::vector<int32_t>& CpuIds4NumaNode(int32_t numa_node) {
+  return GetNumaTopology().numa_node2cpu_ids.at(numa_node);
+}
+
+int32_t NumaNode4ThisThread() {
+#ifdef OF_PLATFORM_POSIX
+  const auto& cpu_id2numa_node = GetNumaTopology().cpu_id2numa_node;
+  const auto it = cpu_id2numa_node.find(sched_getcpu());
+  if (it != cpu_id2numa_node.end()) { return it->second; }
+#endif
+  return -1;
+}
+
+int32_t NumaNode4Index(int64_t index, int64_t num) {
+  CHECK_GE(index, 0);
+  CHECK_LT(index, num);
+  const int64_t numa_node_num = NumaNodeNum();
+  if (num < numa_node_num) { return index; }
+  const BalancedSplitter bs(num, numa_node_num);
+  FOR_RANGE(int64_t, numa_node, 0, numa_node_num) {
+    if (bs.At(numa_node).end() > index) { return numa_node; }
+  }
+  UNIMPLEMENTED();
+  return -1;
+}
+
+void SetThisThreadNumaNodeAffinity(int32_t numa_node) {
+#ifdef OF_PLATFORM_POSIX
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int32_t cpu_id : CpuIds4NumaNode(numa_node)) { CPU_SET(cpu_id, &cpu_set); }
+  CHECK_EQ(sched_setaffinity(0, sizeof(cpu_set_t), &cpu_set), 0);
+#else
+  UNIMPLEMENTED();
+#endif
+}
+
+struct NumaNodeAffinityGuard::SavedAffinity {
+#ifdef OF_PLATFORM_POSIX
+  cpu_set_t cpu_set;
+#endif
+};
+
+NumaNodeAffinityGuard::NumaNodeAffinityGuard(int32_t numa_node) {
+  if (numa_node < 0) { return; }
+#ifdef OF_PLATFORM_POSIX
+  saved_affinity_.reset(new SavedAffinity());
+  CHECK_EQ(sched_getaffinity(0, sizeof(cpu_set_t), &saved_affinity_->cpu_set), 0);
+#endif
+  SetThisThreadNumaNodeAffinity(numa_node);
+}
+
+NumaNodeAffinityGuard::~NumaNodeAffinityGuard() {
+#ifdef OF_PLATFORM_POSIX
+  if (saved_affinity_) {
+    CHECK_EQ(sched_setaffinity(0, sizeof(cpu_set_t), &saved_affinity_->cpu_set), 0);
+  }
+#endif
+}
+
+std::vector<int32_t> ParseCpuList(const std::string& cpu_list) {
+  std::vector<int32_t> cpu_ids;
+  std::istringstream ss(cpu_list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty()) { continue; }
+    const size_t dash_pos = range.find('-');
+    const int32_t first = std::stoi(range.substr(0, dash_pos));
+    const int32_t last =
+        dash_pos == std::string::npos ? first : std::stoi(range.substr(dash_pos + 1));
+    CHECK_LE(first, last) << cpu_list;
+    FOR_RANGE(int32_t, cpu_id, first, last + 1) { cpu_ids.push_back(cpu_id); }
+  }
+  return cpu_ids;
+}
+
+}  // namespace oneflow
@@ -0,0 +1,51 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_THREAD_NUMA_UTIL_H_
+#define ONEFLOW_CORE_THREAD_NUMA_UTIL_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// The numa nodes of this machine which have cpus this process may run on, numbered in the order
+// of /sys/devices/system/node. A machine without numa support is a single node with all the cpus.
+int32_t NumaNodeNum();
+const std::vector<int32_t>& CpuIds4NumaNode(int32_t numa_node);
+// Returns -1 if the cpu the calling thread runs on is unknown
+int32_t NumaNode4ThisThread();
+// Spreads num consecutive indices over the numa nodes in balanced contiguous ranges
+int32_t NumaNode4Index(int64_t index, int64_t num);
+void SetThisThreadNumaNodeAffinity(int32_t numa_node);
+
+// Restricts the calling thread to the cpus of a numa node while it is alive, so that the pages the
+// thread touches first meanwhile are placed on that node. It does nothing for a negative node.
+class NumaNodeAffinityGuard final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(NumaNodeAffinityGuard);
+  explicit NumaNodeAffinityGuard(int32_t numa_node);
+  ~NumaNodeAffinityGuard();
+
+ private:
+  struct SavedAffinity;
+  std::unique_ptr<SavedAffinity> saved_affinity_;
+};
+
+// Parses a cpu list of sysfs like "0-3,8,10-11"
+std::vector<int32_t> ParseCpuList(const std::string& cpu_list);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_THREAD_NUMA_UTIL_H_
@@ -0,0 +1,49 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/thread/numa_util.h"
+
+namespace oneflow {
+
+TEST(NumaUtil, parse_cpu_list) {
+  ASSERT_EQ(ParseCpuList("0"), std::vector<int32_t>({0}));
+  ASSERT_EQ(ParseCpuList("0-3,8,10-11"), std::vector<int32_t>({0, 1, 2, 3, 8, 10, 11}));
+  ASSERT_TRUE(ParseCpuList("").empty());
+}
+
+TEST(NumaUtil, numa_node_of_index) {
+  const int64_t numa_node_num = NumaNodeNum();
+  ASSERT_GT(numa_node_num, 0);
+  const int64_t num = numa_node_num * 3 + 1;
+  int32_t last_numa_node = 0;
+  FOR_RANGE(int64_t, i, 0, num) {
+    const int32_t numa_node = NumaNode4Index(i, num);
+    ASSERT_GE(numa_node, last_numa_node);
+    ASSERT_LT(numa_node, numa_node_num);
+    last_numa_node = numa_node;
+  }
+  ASSERT_EQ(last_numa_node, numa_node_num - 1);
+}
+
+TEST(NumaUtil, affinity_guard) {
+  const int32_t numa_node = NumaNodeNum() - 1;
+  {
+    NumaNodeAffinityGuard guard(numa_node);
+    ASSERT_EQ(NumaNode4ThisThread(), numa_node);
+  }
+  NumaNodeAffinityGuard guard(-1);
+}
+
+}  // namespace oneflow
@@ -14,6 +14,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/thread/thread.h"
+#include <iomanip>
+#include <numeric>
+#include "oneflow/core/job/resource_desc.h"
 #include "oneflow/core/job/runtime_context.h"
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/actor/actor.h"
@@ -21,6 +24,32 @@ limitations under the License.
 
 namespace oneflow {
 
+namespace {
+
+const int64_t kMinSpinNs = 1000;
+
+int64_t SteadyClockNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+Thread::Thread()
+    : enable_local_message_queue_(
+        Global<ResourceDesc, ForSession>::Get()->thread_enable_local_message_queue()),
+      enable_busy_poll_(Global<ResourceDesc, ForSession>::Get()->thread_enable_busy_poll()),
+      max_spin_ns_(Global<ResourceDesc, ForSession>::Get()->thread_busy_poll_max_spin_us() * 1000),
+      spin_ns_(max_spin_ns_),
+      spun_to_msg_cnt_(0),
+      blocked_cnt_(0),
+      enable_wake_latency_histogram_(
+          Global<ResourceDesc, ForSession>::Get()->thread_enable_wake_latency_histogram()),
+      first_send_ns_since_idle_(0) {
+  wake_latency_histogram_.fill(0);
+}
+
 Thread::~Thread() {
   actor_thread_.join();
   CHECK(id2task_.empty());
@@ -33,24 +62,73 @@ void Thread::AddTask(const TaskProto& task) {
 }
 
 void Thread::EnqueueActorMsg(const ActorMsg& msg) {
-  if (Global<ResourceDesc, ForSession>::Get()->thread_enable_local_message_queue()
-      && std::this_thread::get_id() == actor_thread_.get_id()) {
+  if (enable_local_message_queue_ && std::this_thread::get_id() == actor_thread_.get_id()) {
     local_msg_queue_.push(msg);
   } else {
+    if (enable_wake_latency_histogram_
+        && first_send_ns_since_idle_.load(std::memory_order_relaxed) == 0) {
+      int64_t idle = 0;
+      first_send_ns_since_idle_.compare_exchange_strong(idle, SteadyClockNs());
+    }
     msg_channel_.Send(msg);
   }
 }
 
+void Thread::ReceiveMsgs() {
+  if (enable_wake_latency_histogram_) { first_send_ns_since_idle_.store(0); }
+  if (enable_busy_poll_) {
+    bool spun_to_msg = false;
+    CHECK_EQ(msg_channel_.SpinThenReceiveMany(&local_msg_queue_, spin_ns_, &spun_to_msg),
+             kChannelStatusSuccess);
+    if (spun_to_msg) {
+      spun_to_msg_cnt_ += 1;
+      spin_ns_ = std::min(max_spin_ns_, spin_ns_ * 2);
+    } else {
+      blocked_cnt_ += 1;
+      spin_ns_ = std::max(spin_ns_ / 2, std::min(kMinSpinNs, max_spin_ns_));
+    }
+  } else {
+    CHECK_EQ(msg_channel_.ReceiveMany(&local_msg_queue_), kChannelStatusSuccess);
+  }
+  if (enable_wake_latency_histogram_) {
+    const int64_t first_send_ns = first_send_ns_since_idle_.exchange(0);
+    if (first_send_ns > 0) {
+      const int64_t latency_ns = std::max<int64_t>(SteadyClockNs() - first_send_ns, 1);
+      const int32_t bucket = 63 - __builtin_clzll(latency_ns);
+      wake_latency_histogram_.at(std::min<int32_t>(bucket, wake_latency_histogram_.size() - 1)) +=
+          1;
+    }
+  }
+}
+
+void Thread::LogWakeLatency() const {
+  const int64_t sample_cnt =
+      std::accumulate(wake_latency_histogram_.begin(), wake_latency_histogram_.end(), int64_t(0));
+  std::ostringstream ss;
+  ss << "thread " << thrd_id_ << " wake latency of " << sample_cnt << " samples:";
+  int64_t cnt = 0;
+  FOR_RANGE(int32_t, bucket, 0, wake_latency_histogram_.size()) {
+    if (wake_latency_histogram_.at(bucket) == 0) { continue; }
+    cnt += wake_latency_histogram_.at(bucket);
+    ss << " " << std::fixed << std::setprecision(2) << cnt * 100.0 / sample_cnt << "% below "
+       << (int64_t(1) << (bucket + 1)) << "ns,";
+  }
+  if (enable_busy_poll_) {
+    ss << " busy poll received " << spun_to_msg_cnt_ << " times while spinning and "
+       << blocked_cnt_ << " times after blocking";
+  }
+  LOG(INFO) << ss.str();
+}
+
 void Thread::PollMsgChannel(const ThreadCtx& thread_ctx) {
   while (true) {
-    if (local_msg_queue_.empty()) {
-      CHECK_EQ(msg_channel_.ReceiveMany(&local_msg_queue_), kChannelStatusSuccess);
-    }
+    if (local_msg_queue_.empty()) { ReceiveMsgs(); }
     ActorMsg msg = std::move(local_msg_queue_.front());
     local_msg_queue_.pop();
     if (msg.msg_type() == ActorMsgType::kCmdMsg) {
       if (msg.actor_cmd() == ActorCmd::kStopThread) {
         CHECK(id2actor_ptr_.empty());
+        if (enable_wake_latency_histogram_) { LogWakeLatency(); }
         break;
       } else if (msg.actor_cmd() == ActorCmd::kConstructActor) {
         ConstructActor(msg.dst_actor_id(), thread_ctx);
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef ONEFLOW_CORE_THREAD_THREAD_H_
 #define ONEFLOW_CORE_THREAD_THREAD_H_
 
+#include <array>
 #include "oneflow/core/actor/actor_message_bus.h"
 #include "oneflow/core/common/channel.h"
 #include "oneflow/core/common/util.h"
@@ -38,13 +39,15 @@ class Thread {
   void JoinAllActor() { actor_thread_.join(); }
 
  protected:
-  Thread() = default;
+  Thread();
   std::thread& mut_actor_thread() { return actor_thread_; }
   void PollMsgChannel(const ThreadCtx& thread_ctx);
   void set_thrd_id(int64_t val) { thrd_id_ = val; }
 
  private:
   void ConstructActor(int64_t actor_id, const ThreadCtx& thread_ctx);
+  void ReceiveMsgs();
+  void LogWakeLatency() const;
 
   HashMap<int64_t, TaskProto> id2task_;
   std::mutex id2task_mtx_;
@@ -55,6 +58,21 @@ class Thread {
   std::queue<ActorMsg> local_msg_queue_;
 
   int64_t thrd_id_;
+
+  const bool enable_local_message_queue_;
+  // In busy poll mode the thread spins for a message before it blocks. The spin window adapts
+  // between 1us and max_spin_ns_: it is doubled when a message came while spinning and halved
+  // when the thread had to block.
+  const bool enable_busy_poll_;
+  const int64_t max_spin_ns_;
+  int64_t spin_ns_;
+  int64_t spun_to_msg_cnt_;
+  int64_t blocked_cnt_;
+  // The wake latency is the time from the first message sent to the thread while it waited to
+  // the thread receiving it. Bucket i of the histogram counts the latencies in [2^i, 2^(i+1)) ns.
+  const bool enable_wake_latency_histogram_;
+  std::atomic<int64_t> first_send_ns_since_idle_;
+  std::array<int64_t, 40> wake_latency_histogram_;
 };
 
 }  // namespace oneflow
@@ -18,6 +18,8 @@ limitations under the License.
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/thread/cpu_thread.h"
 #include "oneflow/core/thread/gpu_thread.h"
+#include "oneflow/core/thread/numa_util.h"
+#include "oneflow/core/job/id_manager.h"
 #include "oneflow/core/common/balanced_splitter.h"
 #include "oneflow/core/common/blocking_counter.h"
 #include "oneflow/core/job/machine_context.h"
@@ -47,9 +49,10 @@ ThreadMgr::ThreadMgr(const Plan& plan) {
   }
 #endif
   FOR_RANGE(int64_t, i, 0, (Global<ResourceDesc, ForSession>::Get()->CpuDeviceNum())) {
-    threads_.push_back(new CpuThread(thrd_id++));
+    threads_.push_back(new CpuThread(thrd_id, NumaNode4ActorThrdId(thrd_id)));
+    thrd_id += 1;
   }
-  threads_.push_back(new CpuThread(thrd_id++));  // comm_net
+  threads_.push_back(new CpuThread(thrd_id++, -1));  // comm_net
   CreatePersistenceThrd(plan, thrd_id);
 }
 
@@ -63,7 +66,17 @@ void ThreadMgr::CreatePersistenceThrd(const Plan& plan, int64_t thrd_id) {
     }
   }
 
-  for (int64_t i = thrd_id; i <= max_thrd_id; i++) { threads_.push_back(new CpuThread(i)); }
+  for (int64_t i = thrd_id; i <= max_thrd_id; i++) { threads_.push_back(new CpuThread(i, -1)); }
+}
+
+int32_t NumaNode4ActorThrdId(int64_t thrd_id) {
+  const ResourceDesc* resource_desc = Global<ResourceDesc, ForSession>::Get();
+  if (!resource_desc->thread_affinity_conf().enable_actor_thread_affinity()) { return -1; }
+  const int64_t cpu_device_num = resource_desc->CpuDeviceNum();
+  const int64_t cpu_device_thrd_id_begin = Global<IDMgr>::Get()->GetCpuDeviceThrdId(0);
+  const int64_t dev_phy_id = thrd_id - cpu_device_thrd_id_begin;
+  if (dev_phy_id < 0 || dev_phy_id >= cpu_device_num) { return -1; }
+  return NumaNode4Index(dev_phy_id, cpu_device_num);
 }
 
 void SingleThreadLoop(size_t num, std::function<void(size_t i)> Callback) {
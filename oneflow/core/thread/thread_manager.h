@@ -42,6 +42,9 @@ class ThreadMgr final {
   std::vector<Thread*> threads_;
 };
 
+// Returns the numa node the actor thread is pinned to, or -1 if it is not pinned to a node
+int32_t NumaNode4ActorThrdId(int64_t thrd_id);
+
 void SingleThreadLoop(size_t num, std::function<void(size_t i)> Callback);
 void MultiThreadLoop(size_t num, std::function<void(size_t i)> Callback);
 
@@ -17,11 +17,22 @@ limitations under the License.
 
 namespace oneflow {
 
-ThreadPool::ThreadPool(int32_t thread_num)
+namespace {
+
+thread_local bool is_current_thread_worker = false;
+
+}  // namespace
+
+ThreadPool::ThreadPool(int32_t thread_num) : ThreadPool(thread_num, [](int32_t) {}) {}
+
+ThreadPool::ThreadPool(int32_t thread_num,
+                       const std::function<void(int32_t thread_idx)>& InitThread)
     : work_chans_(thread_num), threads_(thread_num), work_cnt_(0) {
   FOR_RANGE(int32_t, i, 0, thread_num) {
     Channel<std::function<void()>>* chan = &(work_chans_.at(i));
-    threads_[i] = std::thread([chan]() {
+    threads_[i] = std::thread([chan, i, InitThread]() {
+      is_current_thread_worker = true;
+      InitThread(i);
       std::function<void()> work;
       while (chan->Receive(&work) == kChannelStatusSuccess) { work(); }
     });
@@ -41,4 +52,6 @@ void ThreadPool::AddWork(const std::function<void()>& work) {
   work_chans_.at(cur_chan_idx).Send(work);
 }
 
+bool ThreadPool::IsCurrentThreadWorker() { return is_current_thread_worker; }
+
 }  // namespace oneflow
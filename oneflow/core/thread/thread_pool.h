@@ -26,11 +26,17 @@ class ThreadPool final {
   OF_DISALLOW_COPY_AND_MOVE(ThreadPool);
   ThreadPool() = delete;
   ThreadPool(int32_t thread_num);
+  // InitThread is called by each worker with its index before it takes any work
+  ThreadPool(int32_t thread_num, const std::function<void(int32_t thread_idx)>& InitThread);
   ~ThreadPool();
 
   int32_t thread_num() const { return threads_.size(); }
   void AddWork(const std::function<void()>& work);
 
+  // Whether the calling thread is a worker of any thread pool. A worker must not wait for work it
+  // adds to a pool, the work may be queued behind the waiting worker itself.
+  static bool IsCurrentThreadWorker();
+
  private:
   std::vector<Channel<std::function<void()>>> work_chans_;
   std::vector<std::thread> threads_;
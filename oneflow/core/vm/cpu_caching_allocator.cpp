@@ -0,0 +1,220 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/vm/cpu_caching_allocator.h"
+#include "oneflow/core/vm/cpu_allocator.h"
+
+namespace oneflow {
+namespace vm {
+
+namespace {
+
+std::atomic<int64_t> caching_allocator_uid(0);
+
+}  // namespace
+
+constexpr size_t CpuCachingAllocator::kMinBinSize;
+constexpr size_t CpuCachingAllocator::kLinearBinStep;
+constexpr int32_t CpuCachingAllocator::kPowerOfTwoBinNum;
+constexpr size_t CpuCachingAllocator::kMaxBinSize;
+constexpr int32_t CpuCachingAllocator::kBinNumSize;
+constexpr size_t CpuCachingAllocator::kThreadCacheBytes;
+
+CpuCachingAllocator::CpuCachingAllocator(std::unique_ptr<Allocator>&& backend_allocator)
+    : Allocator(),
+      uid_(caching_allocator_uid.fetch_add(1)),
+      backend_allocator_(std::move(backend_allocator)),
+      bin2shared_free_ptrs_(kBinNumSize),
+      allocated_bytes_(0),
+      peak_allocated_bytes_(0),
+      cached_bytes_(0),
+      backend_allocate_cnt_(0),
+      backend_deallocate_cnt_(0) {}
+
+CpuCachingAllocator::~CpuCachingAllocator() {
+  for (const auto& thread_cache : thread_caches_) {
+    ReleaseFreePtrs(&thread_cache->bin2free_ptrs);
+  }
+  ReleaseFreePtrs(&bin2shared_free_ptrs_);
+}
+
+int32_t CpuCachingAllocator::BinNum4Size(size_t size) {
+  if (size <= kMinBinSize) { return 0; }
+  if (size <= kLinearBinStep) {
+    const uint64_t value = (size - 1) / kMinBinSize;
+    return static_cast<int32_t>(64 - __builtin_clzll(value));
+  }
+  if (size > kMaxBinSize) { return kBinNumSize; }
+  const size_t step_num = RoundUp(size, kLinearBinStep) / kLinearBinStep;
+  return kPowerOfTwoBinNum + static_cast<int32_t>(step_num) - 2;
+}
+
+CpuCachingAllocator::ThreadCache* CpuCachingAllocator::ThisThreadCache() {
+  // A thread may use several allocators, and an allocator id is never reused. The caches are
+  // shared with the allocator, which takes over their free lists once their thread exited.
+  struct ThreadCacheHolder {
+    HashMap<int64_t, std::shared_ptr<ThreadCache>> uid2thread_cache;
+    ~ThreadCacheHolder() {
+      for (const auto& pair : uid2thread_cache) {
+        pair.second->thread_exited.store(true, std::memory_order_release);
+      }
+    }
+  };
+  thread_local ThreadCacheHolder holder;
+  std::shared_ptr<ThreadCache>& thread_cache = holder.uid2thread_cache[uid_];
+  if (!thread_cache) {
+    thread_cache.reset(new ThreadCache());
+    thread_cache->bin2free_ptrs.resize(kBinNumSize);
+    std::unique_lock<std::mutex> lock(mutex_);
+    thread_caches_.push_back(thread_cache);
+  }
+  return thread_cache.get();
+}
+
+void CpuCachingAllocator::ReclaimExitedThreadCaches() {
+  auto it = thread_caches_.begin();
+  while (it != thread_caches_.end()) {
+    ThreadCache* thread_cache = it->get();
+    if (!thread_cache->thread_exited.load(std::memory_order_acquire)) {
+      ++it;
+      continue;
+    }
+    FOR_RANGE(int32_t, bin_num, 0, kBinNumSize) {
+      std::vector<char*>* free_ptrs = &thread_cache->bin2free_ptrs.at(bin_num);
+      std::vector<char*>* shared_free_ptrs = &bin2shared_free_ptrs_.at(bin_num);
+      shared_free_ptrs->insert(shared_free_ptrs->end(), free_ptrs->begin(), free_ptrs->end());
+    }
+    it = thread_caches_.erase(it);
+  }
+}
+
+char* CpuCachingAllocator::AllocateFromBackend(size_t size) {
+  char* mem_ptr = nullptr;
+  backend_allocator_->Allocate(&mem_ptr, size);
+  if (mem_ptr == nullptr) {
+    LOG(WARNING) << "CpuCachingAllocator failed to allocate " << size
+                 << " bytes, releasing the cached memory and trying again";
+    ReleaseCachedMemory();
+    backend_allocator_->Allocate(&mem_ptr, size);
+  }
+  CHECK(mem_ptr != nullptr) << "Error! : Out of memory when allocate size : " << size;
+  backend_allocate_cnt_ += 1;
+  return mem_ptr;
+}
+
+void CpuCachingAllocator::DeallocateToBackend(char* mem_ptr, size_t size) {
+  backend_allocator_->Deallocate(mem_ptr, size);
+  backend_deallocate_cnt_ += 1;
+}
+
+void CpuCachingAllocator::ReleaseFreePtrs(std::vector<std::vector<char*>>* bin2free_ptrs) {
+  FOR_RANGE(int32_t, bin_num, 0, bin2free_ptrs->size()) {
+    std::vector<char*>* free_ptrs = &bin2free_ptrs->at(bin_num);
+    const size_t bin_size = BinSize4BinNum(bin_num);
+    for (char* mem_ptr : *free_ptrs) { DeallocateToBackend(mem_ptr, bin_size); }
+    cached_bytes_ -= bin_size * free_ptrs->size();
+    free_ptrs->clear();
+  }
+}
+
+void CpuCachingAllocator::IncreaseAllocatedBytes(size_t size) {
+  const int64_t allocated_bytes = (allocated_bytes_ += size);
+  int64_t peak_allocated_bytes = peak_allocated_bytes_.load();
+  while (allocated_bytes > peak_allocated_bytes
+         && !peak_allocated_bytes_.compare_exchange_weak(peak_allocated_bytes, allocated_bytes)) {}
+}
+
+void CpuCachingAllocator::Allocate(char** mem_ptr, std::size_t size) {
+  if (size == 0) {
+    *mem_ptr = nullptr;
+    return;
+  }
+  const int32_t bin_num = BinNum4Size(size);
+  if (bin_num == kBinNumSize) {
+    *mem_ptr = AllocateFromBackend(size);
+    IncreaseAllocatedBytes(size);
+    return;
+  }
+  const size_t bin_size = BinSize4BinNum(bin_num);
+  char* ptr = nullptr;
+  ThreadCache* thread_cache = ThisThreadCache();
+  std::vector<char*>* free_ptrs = &thread_cache->bin2free_ptrs.at(bin_num);
+  if (!free_ptrs->empty()) {
+    ptr = free_ptrs->back();
+    free_ptrs->pop_back();
+    thread_cache->cached_bytes -= bin_size;
+  } else {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ReclaimExitedThreadCaches();
+    std::vector<char*>* shared_free_ptrs = &bin2shared_free_ptrs_.at(bin_num);
+    if (!shared_free_ptrs->empty()) {
+      ptr = shared_free_ptrs->back();
+      shared_free_ptrs->pop_back();
+    }
+  }
+  if (ptr == nullptr) {
+    ptr = AllocateFromBackend(bin_size);
+  } else {
+    cached_bytes_ -= bin_size;
+  }
+  IncreaseAllocatedBytes(bin_size);
+  *mem_ptr = ptr;
+}
+
+void CpuCachingAllocator::Deallocate(char* mem_ptr, std::size_t size) {
+  if (mem_ptr == nullptr) { return; }
+  const int32_t bin_num = BinNum4Size(size);
+  if (bin_num == kBinNumSize) {
+    allocated_bytes_ -= size;
+    DeallocateToBackend(mem_ptr, size);
+    return;
+  }
+  const size_t bin_size = BinSize4BinNum(bin_num);
+  allocated_bytes_ -= bin_size;
+  cached_bytes_ += bin_size;
+  ThreadCache* thread_cache = ThisThreadCache();
+  if (thread_cache->cached_bytes + bin_size <= kThreadCacheBytes) {
+    thread_cache->bin2free_ptrs.at(bin_num).push_back(mem_ptr);
+    thread_cache->cached_bytes += bin_size;
+  } else {
+    std::unique_lock<std::mutex> lock(mutex_);
+    bin2shared_free_ptrs_.at(bin_num).push_back(mem_ptr);
+  }
+}
+
+CpuCachingAllocatorStats CpuCachingAllocator::GetStats() const {
+  CpuCachingAllocatorStats stats;
+  stats.allocated_bytes = allocated_bytes_.load();
+  stats.peak_allocated_bytes = peak_allocated_bytes_.load();
+  stats.cached_bytes = cached_bytes_.load();
+  stats.backend_allocate_cnt = backend_allocate_cnt_.load();
+  stats.backend_deallocate_cnt = backend_deallocate_cnt_.load();
+  return stats;
+}
+
+void CpuCachingAllocator::ReleaseCachedMemory() {
+  ThreadCache* thread_cache = ThisThreadCache();
+  ReleaseFreePtrs(&thread_cache->bin2free_ptrs);
+  thread_cache->cached_bytes = 0;
+  std::unique_lock<std::mutex> lock(mutex_);
+  ReclaimExitedThreadCaches();
+  ReleaseFreePtrs(&bin2shared_free_ptrs_);
+}
+
+COMMAND(Global<CpuCachingAllocator>::SetAllocated(
+    new CpuCachingAllocator(std::unique_ptr<Allocator>(new CpuAllocator()))));
+
+}  // namespace vm
+}  // namespace oneflow
@@ -0,0 +1,106 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_VM_CPU_CACHING_ALLOCATOR_H_
+#define ONEFLOW_CORE_VM_CPU_CACHING_ALLOCATOR_H_
+
+#include <atomic>
+#include <mutex>
+#include "oneflow/core/vm/allocator.h"
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+namespace vm {
+
+struct CpuCachingAllocatorStats {
+  // bytes held by the users of the allocator, rounded up to the bin sizes
+  int64_t allocated_bytes;
+  int64_t peak_allocated_bytes;
+  // bytes freed by the users and kept for reuse
+  int64_t cached_bytes;
+  int64_t backend_allocate_cnt;
+  int64_t backend_deallocate_cnt;
+};
+
+// Caches the host memory of eager blobs so that an eager loop which allocates the same sizes in
+// every iteration stops calling the backend allocator once it reaches its steady state.
+//
+// Like CudaAllocator, freed memory is kept in bins whose sizes are 512 bytes times powers of two up
+// to 1MB, but a piece is never split or merged, so that it can be kept in a free list of the thread
+// which freed it and reused by that thread without taking any lock. Above 1MB the bins grow by 1MB
+// steps, so a piece wastes less than 1MB, and pieces larger than 64MB are not cached at all.
+// Pieces which do not fit into the bounded free lists of a thread, and the free lists of the
+// threads which exited, are moved to bins shared by all threads.
+class CpuCachingAllocator final : public Allocator {
+ public:
+  explicit CpuCachingAllocator(std::unique_ptr<Allocator>&& backend_allocator);
+  ~CpuCachingAllocator() override;
+
+  void Allocate(char** mem_ptr, std::size_t size) override;
+  void Deallocate(char* mem_ptr, std::size_t size) override;
+
+  CpuCachingAllocatorStats GetStats() const;
+  // Returns the pieces of the shared bins and of the calling thread to the backend allocator
+  void ReleaseCachedMemory();
+
+  static constexpr size_t kMinBinSize = 512;
+  // the bins up to kLinearBinStep are powers of two, the larger ones are multiples of it
+  static constexpr size_t kLinearBinStep = 1 << 20;
+  static constexpr int32_t kPowerOfTwoBinNum = 12;
+  static constexpr size_t kMaxBinSize = 64 << 20;
+  static constexpr int32_t kBinNumSize = kPowerOfTwoBinNum + kMaxBinSize / kLinearBinStep - 1;
+  // the free lists of a thread keep at most this many bytes
+  static constexpr size_t kThreadCacheBytes = 32 << 20;
+
+  static size_t BinSize4BinNum(int32_t bin_num) {
+    if (bin_num < kPowerOfTwoBinNum) { return kMinBinSize << bin_num; }
+    return (bin_num - kPowerOfTwoBinNum + 2) * kLinearBinStep;
+  }
+  // Returns the smallest bin whose size is not less than size, or kBinNumSize if size is larger
+  // than all bins, in which case the memory is not cached
+  static int32_t BinNum4Size(size_t size);
+
+ private:
+  struct ThreadCache {
+    std::vector<std::vector<char*>> bin2free_ptrs;
+    size_t cached_bytes = 0;
+    std::atomic<bool> thread_exited{false};
+  };
+
+  ThreadCache* ThisThreadCache();
+  char* AllocateFromBackend(size_t size);
+  void DeallocateToBackend(char* mem_ptr, size_t size);
+  void ReleaseFreePtrs(std::vector<std::vector<char*>>* bin2free_ptrs);
+  void IncreaseAllocatedBytes(size_t size);
+  // Must be called with mutex_ held
+  void ReclaimExitedThreadCaches();
+
+  const int64_t uid_;
+  std::unique_ptr<Allocator> backend_allocator_;
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<ThreadCache>> thread_caches_;
+  std::vector<std::vector<char*>> bin2shared_free_ptrs_;
+
+  std::atomic<int64_t> allocated_bytes_;
+  std::atomic<int64_t> peak_allocated_bytes_;
+  std::atomic<int64_t> cached_bytes_;
+  std::atomic<int64_t> backend_allocate_cnt_;
+  std::atomic<int64_t> backend_deallocate_cnt_;
+};
+
+}  // namespace vm
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_VM_CPU_CACHING_ALLOCATOR_H_
@@ -0,0 +1,123 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <thread>
+#include "oneflow/core/vm/cpu_caching_allocator.h"
+#include "oneflow/core/vm/cpu_allocator.h"
+
+namespace oneflow {
+namespace vm {
+
+namespace {
+
+std::unique_ptr<CpuCachingAllocator> NewCpuCachingAllocator() {
+  return std::unique_ptr<CpuCachingAllocator>(
+      new CpuCachingAllocator(std::unique_ptr<Allocator>(new CpuAllocator())));
+}
+
+}  // namespace
+
+TEST(CpuCachingAllocator, bin_num) {
+  ASSERT_EQ(CpuCachingAllocator::BinNum4Size(1), 0);
+  ASSERT_EQ(CpuCachingAllocator::BinNum4Size(512), 0);
+  ASSERT_EQ(CpuCachingAllocator::BinNum4Size(513), 1);
+  ASSERT_EQ(CpuCachingAllocator::BinNum4Size(1024), 1);
+  ASSERT_EQ(CpuCachingAllocator::BinNum4Size(1025), 2);
+  FOR_RANGE(int32_t, bin_num, 0, CpuCachingAllocator::kBinNumSize) {
+    const size_t bin_size = CpuCachingAllocator::BinSize4BinNum(bin_num);
+    ASSERT_EQ(CpuCachingAllocator::BinNum4Size(bin_size), bin_num);
+    ASSERT_EQ(CpuCachingAllocator::BinNum4Size(bin_size + 1), bin_num + 1);
+  }
+  // above kLinearBinStep a piece wastes less than kLinearBinStep instead of up to half of its bin
+  const size_t kStep = CpuCachingAllocator::kLinearBinStep;
+  ASSERT_EQ(CpuCachingAllocator::BinSize4BinNum(CpuCachingAllocator::BinNum4Size(kStep)), kStep);
+  for (size_t size = kStep + 1; size <= CpuCachingAllocator::kMaxBinSize; size += kStep / 3) {
+    const int32_t bin_num = CpuCachingAllocator::BinNum4Size(size);
+    const size_t bin_size = CpuCachingAllocator::BinSize4BinNum(bin_num);
+    ASSERT_GE(bin_size, size);
+    ASSERT_LT(bin_size - size, kStep);
+  }
+  ASSERT_EQ(CpuCachingAllocator::BinSize4BinNum(CpuCachingAllocator::kBinNumSize - 1),
+            CpuCachingAllocator::kMaxBinSize);
+  ASSERT_EQ(CpuCachingAllocator::BinNum4Size(513 << 20), CpuCachingAllocator::kBinNumSize);
+}
+
+TEST(CpuCachingAllocator, steady_state) {
+  auto allocator = NewCpuCachingAllocator();
+  const std::vector<size_t> sizes = {4, 1000, 4096, 100000, 3 << 20};
+  FOR_RANGE(int32_t, iter, 0, 10) {
+    std::vector<char*> ptrs(sizes.size(), nullptr);
+    FOR_RANGE(size_t, i, 0, sizes.size()) {
+      allocator->Allocate(&ptrs.at(i), sizes.at(i));
+      ASSERT_TRUE(ptrs.at(i) != nullptr);
+      std::memset(ptrs.at(i), iter, sizes.at(i));
+    }
+    FOR_RANGE(size_t, i, 0, sizes.size()) { allocator->Deallocate(ptrs.at(i), sizes.at(i)); }
+    ASSERT_EQ(allocator->GetStats().backend_allocate_cnt, sizes.size());
+  }
+  CpuCachingAllocatorStats stats = allocator->GetStats();
+  ASSERT_EQ(stats.allocated_bytes, 0);
+  ASSERT_EQ(stats.peak_allocated_bytes, stats.cached_bytes);
+  allocator->ReleaseCachedMemory();
+  stats = allocator->GetStats();
+  ASSERT_EQ(stats.cached_bytes, 0);
+  ASSERT_EQ(stats.backend_deallocate_cnt, sizes.size());
+  char* ptr = nullptr;
+  allocator->Allocate(&ptr, 0);
+  ASSERT_TRUE(ptr == nullptr);
+  allocator->Deallocate(ptr, 0);
+}
+
+TEST(CpuCachingAllocator, large_pieces_not_cached) {
+  auto allocator = NewCpuCachingAllocator();
+  const size_t kSize = CpuCachingAllocator::kMaxBinSize + 1;
+  FOR_RANGE(int32_t, iter, 0, 2) {
+    char* ptr = nullptr;
+    allocator->Allocate(&ptr, kSize);
+    ASSERT_TRUE(ptr != nullptr);
+    ASSERT_EQ(allocator->GetStats().allocated_bytes, static_cast<int64_t>(kSize));
+    allocator->Deallocate(ptr, kSize);
+  }
+  const CpuCachingAllocatorStats stats = allocator->GetStats();
+  ASSERT_EQ(stats.allocated_bytes, 0);
+  ASSERT_EQ(stats.cached_bytes, 0);
+  ASSERT_EQ(stats.backend_allocate_cnt, 2);
+  ASSERT_EQ(stats.backend_deallocate_cnt, 2);
+}
+
+TEST(CpuCachingAllocator, free_on_other_threads) {
+  auto allocator = NewCpuCachingAllocator();
+  const int32_t kThreadNum = 8;
+  const int32_t kIters = 100;
+  const size_t kSize = 4 << 20;
+  std::vector<std::thread> threads;
+  std::vector<char*> ptrs(kThreadNum);
+  FOR_RANGE(int32_t, iter, 0, kIters) {
+    FOR_RANGE(int32_t, i, 0, kThreadNum) { allocator->Allocate(&ptrs.at(i), kSize); }
+    // the threads cache up to kThreadCacheBytes and give the rest back to the shared bins
+    FOR_RANGE(int32_t, i, 0, kThreadNum) {
+      threads.emplace_back([&, i]() { allocator->Deallocate(ptrs.at(i), kSize); });
+    }
+    for (auto& thread : threads) { thread.join(); }
+    threads.clear();
+  }
+  const CpuCachingAllocatorStats stats = allocator->GetStats();
+  ASSERT_EQ(stats.allocated_bytes, 0);
+  ASSERT_EQ(stats.peak_allocated_bytes, kThreadNum * kSize);
+  ASSERT_LT(stats.backend_allocate_cnt, kIters * kThreadNum);
+}
+
+}  // namespace vm
+}  // namespace oneflow
@@ -29,8 +29,11 @@ ObjectMsgConditionListStatus ThreadCtx::ReceiveAndRun() {
   OBJECT_MSG_LIST(Instruction, pending_instruction_link) tmp_list;
   ObjectMsgConditionListStatus status = mut_pending_instruction_list()->MoveTo(&tmp_list);
   OBJECT_MSG_LIST_FOR_EACH_PTR(&tmp_list, instruction) {
-    stream_type.Run(instruction);
+    // the scheduler thread releases the instruction once it is done, so it must not be the last
+    // reference dropped here
+    CHECK_GT(instruction->ref_cnt(), 1);
     tmp_list.Erase(instruction);
+    stream_type.Run(instruction);
   }
   return status;
 }
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include <iostream>
+#include <chrono>
 #include "oneflow/core/vm/virtual_machine.msg.h"
 #include "oneflow/core/vm/control_stream_type.h"
 #include "oneflow/core/vm/vm_desc.msg.h"
@@ -40,6 +41,62 @@ TEST(VirtualMachine, __Init__) {
   ASSERT_EQ(vm->stream_type_id2stream_rt_desc().size(), 2 * 2);
 }
 
+using InstructionMsgList = OBJECT_MSG_LIST(InstructionMsg, instr_msg_link);
+
+void ScheduleAndRunOnce(VirtualMachine* vm) {
+  vm->Schedule();
+  OBJECT_MSG_LIST_FOR_EACH_PTR(vm->mut_thread_ctx_list(), t) { t->TryReceiveAndRun(); }
+}
+
+// Each sender thread sends chain_len rounds of one Nop instruction for every object it owns, so
+// every object gets a chain of instructions depending on each other
+void BenchmarkNopInstructionChains(int64_t object_num, int64_t chain_len, int64_t sender_num) {
+  TestResourceDescScope scope(1, 1);
+  auto vm_desc = ObjectMsgPtr<VmDesc>::New(TestUtil::NewVmResourceDesc().Get());
+  TestUtil::AddStreamDescByInstrNames(vm_desc.Mutable(), {"Nop", "NewObject"});
+  auto vm = ObjectMsgPtr<VirtualMachine>::New(vm_desc.Get());
+  std::vector<int64_t> object_ids;
+  {
+    InstructionMsgList list;
+    FOR_RANGE(int64_t, i, 0, object_num) {
+      object_ids.push_back(TestUtil::NewObject(&list, "cpu", "0:0"));
+    }
+    vm->Receive(&list);
+    while (!vm->Empty()) { ScheduleAndRunOnce(vm.Mutable()); }
+  }
+  std::atomic<int64_t> finished_sender_num(0);
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> senders;
+  FOR_RANGE(int64_t, sender_id, 0, sender_num) {
+    senders.push_back(std::thread([&, sender_id]() {
+      FOR_RANGE(int64_t, i, 0, chain_len) {
+        InstructionMsgList list;
+        for (int64_t j = sender_id; j < object_num; j += sender_num) {
+          auto nop_instr_msg = NewInstruction("Nop");
+          nop_instr_msg->add_mut_operand(object_ids.at(j));
+          list.EmplaceBack(std::move(nop_instr_msg));
+        }
+        vm->Receive(&list);
+      }
+      finished_sender_num += 1;
+    }));
+  }
+  while (finished_sender_num < sender_num || !vm->Empty()) { ScheduleAndRunOnce(vm.Mutable()); }
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  for (auto& sender : senders) { sender.join(); }
+  LOG(INFO) << object_num << " chains of " << chain_len << " Nop instructions from " << sender_num
+            << " senders: " << object_num * chain_len / seconds << " instructions/s";
+}
+
+// Scheduling throughput of instruction chains, run with --gtest_also_run_disabled_tests
+TEST(VirtualMachine, DISABLED_nop_instruction_chains_benchmark) {
+  BenchmarkNopInstructionChains(1, 100000, 1);
+  BenchmarkNopInstructionChains(64, 2000, 1);
+  BenchmarkNopInstructionChains(64, 2000, 4);
+  BenchmarkNopInstructionChains(1024, 100, 8);
+}
+
 TEST(VirtualMachine, ToDot) {
   std::string dot_str = ObjectMsgListReflection<VirtualMachine>().ToDot("VirtualMachine");
   // std::cout << std::endl;
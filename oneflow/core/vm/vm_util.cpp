@@ -49,10 +49,7 @@ Maybe<void> Run(const InstructionListProto& instruction_list_proto) {
   auto* oneflow_vm = JUST(GlobalMaybe<OneflowVM>());
   auto* vm = oneflow_vm->mut_vm();
   vm->Receive(&instr_msg_list);
-  while (!vm->Empty()) {
-    vm->Schedule();
-    oneflow_vm->TryReceiveAndRun();
-  }
+  while (!vm->Empty()) { vm->Schedule(); }
   return Maybe<void>::Ok();
 }
 
@@ -0,0 +1,39 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import time
+
+
+
+def time_job(job, args, iter_num, warmup_iter_num):
+    """Returns the mean latency in milliseconds of calling `job(*args)` synchronously."""
+    for _ in range(warmup_iter_num):
+        job(*args).get()
+    start = time.perf_counter()
+    for _ in range(iter_num):
+        job(*args).get()
+    return (time.perf_counter() - start) * 1000.0 / iter_num
+
+
+def print_table(header, rows):
+    widths = [
+        max(len(str(header[i])), max(len(str(row[i])) for row in rows))
+        for i in range(len(header))
+    ]
+    fmt = " | ".join("{:>%d}" % w for w in widths)
+    print(fmt.format(*header))
+    print("-+-".join("-" * w for w in widths))
+    for row in rows:
+        print(fmt.format(*row))
@@ -0,0 +1,139 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+from __future__ import absolute_import, division, print_function
+
+import argparse
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+
+from benchmark_util import print_table, time_job
+
+parser = argparse.ArgumentParser(description="flags for cpu int8 inference benchmark")
+parser.add_argument("--iter_num", type=int, default=50, required=False)
+parser.add_argument("--warmup_iter_num", type=int, default=5, required=False)
+parser.add_argument("--cpu_device_num", type=int, default=1, required=False)
+parser.add_argument("--per_channel", action="store_true", required=False)
+args = parser.parse_args()
+
+# (name, input shape, builder), a dense layer of bert-base and resnet-50 convolutions
+MODELS = [
+    ("dense 128x768->3072", (128, 768), lambda x: _dense(x, 3072)),
+    ("dense 384x1024->1024", (384, 1024), lambda x: _dense(x, 1024)),
+    ("conv3x3 64ch 56x56", (1, 64, 56, 56), lambda x: _conv(x, 64, 3)),
+    ("conv1x1 256->64 56x56", (1, 256, 56, 56), lambda x: _conv(x, 64, 1)),
+    ("conv3x3 256ch 14x14 b8", (8, 256, 14, 14), lambda x: _conv(x, 256, 3)),
+]
+
+# run as float, with fake quantization and with int8 kernels
+MODES = ["float", "fake_quant", "int8"]
+
+
+def _dense(x, units):
+    w = flow.get_variable(
+        "w",
+        shape=(units, x.shape[1]),
+        dtype=flow.float,
+        initializer=flow.random_uniform_initializer(minval=-0.1, maxval=0.1),
+        trainable=False,
+    )
+    return flow.matmul(x, w, transpose_b=True)
+
+
+def _conv(x, filters, kernel_size):
+    return flow.layers.conv2d(x, filters, kernel_size, 1, "SAME", name="conv")
+
+
+def _make_job(mode, input_shape, build_fn):
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    if mode != "float":
+        func_config.enable_qat(True)
+        func_config.qat.symmetric(True)
+        func_config.qat.per_channel_weight_quantization(args.per_channel)
+        func_config.qat.moving_min_max_stop_update_after_iters(1000)
+        func_config.qat.lower_to_int8_kernels(mode == "int8")
+
+    def Job(x: oft.Numpy.Placeholder(input_shape)):
+        with flow.scope.placement("cpu", "0:0"):
+            return build_fn(x)
+
+    Job.__name__ = mode + "_job"
+    return flow.global_function(type="predict", function_config=func_config)(Job)
+
+
+def _calibrate(x):
+    # stands in for QAT: activation ranges are taken from the input of the benchmark
+    max_abs = float(np.abs(x).max())
+    variables = {}
+    for name in flow.get_all_variables().keys():
+        if name.endswith("-fake-quant-moving-max"):
+            variables[name] = np.array([max_abs], dtype=np.float32)
+        elif name.endswith("-fake-quant-moving-min"):
+            variables[name] = np.array([-max_abs], dtype=np.float32)
+    flow.load_variables(variables)
+
+
+def benchmark(input_shape, build_fn):
+    flow.clear_default_session()
+    flow.config.cpu_device_num(args.cpu_device_num)
+    jobs = {mode: _make_job(mode, input_shape, build_fn) for mode in MODES}
+    x = np.random.uniform(-1, 1, input_shape).astype(np.float32)
+    for mode in MODES:
+        jobs[mode](x).get()
+    _calibrate(x)
+    outs = {mode: jobs[mode](x).get().numpy() for mode in MODES}
+    latency = {
+        mode: time_job(jobs[mode], (x,), args.iter_num, args.warmup_iter_num)
+        for mode in MODES
+    }
+    ref = outs["float"]
+    rel_err = np.abs(outs["int8"] - ref).max() / max(np.abs(ref).max(), 1e-12)
+    # difference to what QAT trained against, should be float rounding only
+    fq_err = np.abs(outs["int8"] - outs["fake_quant"]).max()
+    return latency, rel_err, fq_err
+
+
+def main():
+    rows = []
+    for name, input_shape, build_fn in MODELS:
+        latency, rel_err, fq_err = benchmark(input_shape, build_fn)
+        rows.append(
+            (
+                name,
+                "{:.3f}".format(latency["float"]),
+                "{:.3f}".format(latency["fake_quant"]),
+                "{:.3f}".format(latency["int8"]),
+                "{:.2f}".format(latency["float"] / latency["int8"]),
+                "{:.2e}".format(rel_err),
+                "{:.2e}".format(fq_err),
+            )
+        )
+    header = (
+        "model",
+        "float ms",
+        "fake quant ms",
+        "int8 ms",
+        "int8 speedup",
+        "max rel err vs float",
+        "max abs err vs fake quant",
+    )
+    print_table(header, rows)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,89 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+from __future__ import absolute_import, division, print_function
+
+import argparse
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+
+from benchmark_util import print_table, time_job
+
+parser = argparse.ArgumentParser(description="flags for cpu matmul benchmark")
+parser.add_argument("--iter_num", type=int, default=50, required=False)
+parser.add_argument("--warmup_iter_num", type=int, default=5, required=False)
+parser.add_argument("--cpu_device_num", type=int, default=1, required=False)
+args = parser.parse_args()
+
+# (tokens, in_features, out_features) of the dense layers of a bert-base/large encoder
+TRANSFORMER_SHAPES = [
+    (1, 768, 768),
+    (1, 768, 3072),
+    (1, 3072, 768),
+    (32, 768, 768),
+    (128, 768, 3072),
+    (128, 3072, 768),
+    (384, 1024, 1024),
+    (384, 1024, 4096),
+    (384, 4096, 1024),
+]
+
+
+def benchmark(m, k, n, prepack):
+    flow.clear_default_session()
+    flow.config.cpu_device_num(args.cpu_device_num)
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.enable_cpu_gemm_weight_prepack(prepack)
+
+    @flow.global_function(type="predict", function_config=func_config)
+    def DenseJob(x: oft.Numpy.Placeholder((m, k), dtype=flow.float)):
+        with flow.scope.placement("cpu", "0:0"):
+            w = flow.get_variable(
+                "w",
+                shape=(n, k),
+                dtype=flow.float,
+                initializer=flow.random_uniform_initializer(),
+                trainable=False,
+            )
+            return flow.matmul(x, w, transpose_b=True)
+
+    x = np.random.uniform(-1, 1, (m, k)).astype(np.float32)
+    return time_job(DenseJob, (x,), args.iter_num, args.warmup_iter_num)
+
+
+def main():
+    rows = []
+    for m, k, n in TRANSFORMER_SHAPES:
+        blas_ms = benchmark(m, k, n, False)
+        packed_ms = benchmark(m, k, n, True)
+        gflops = 2.0 * m * n * k / packed_ms / 1e6
+        rows.append(
+            (
+                "{}x{}x{}".format(m, k, n),
+                "{:.3f}".format(blas_ms),
+                "{:.3f}".format(packed_ms),
+                "{:.2f}".format(blas_ms / packed_ms),
+                "{:.1f}".format(gflops),
+            )
+        )
+    header = ("m x k x n", "blas ms", "packed ms", "speedup", "packed GFLOPS")
+    print_table(header, rows)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,31 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+from __future__ import absolute_import
+
+import traceback
+from oneflow.python.oneflow_export import oneflow_export
+import oneflow_api
+
+
+@oneflow_export("xrt.compilation_cache_metrics")
+def compilation_cache_metrics():
+    r"""Returns the hit, miss, eviction and compile time counters of the XRT
+    compilation caches of this process as a string.
+    """
+    try:
+        return oneflow_api.GetXrtCompilationCacheMetrics()
+    except oneflow_api.exception.CompileOptionWrongException:
+        traceback.print_exc()
@@ -287,6 +287,57 @@ def thread_enable_local_message_queue(val):
     sess.config_proto.resource.thread_enable_local_message_queue = val
 
 
+@oneflow_export("config.thread_enable_busy_poll")
+def api_thread_enable_busy_poll(val: bool = True) -> None:
+    r"""Whether or not let actor threads spin for messages before blocking, which costs cpu time but lowers wake latency
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([thread_enable_busy_poll, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def thread_enable_busy_poll(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.thread_enable_busy_poll = val
+
+
+@oneflow_export("config.thread_busy_poll_max_spin_us")
+def api_thread_busy_poll_max_spin_us(val: int) -> None:
+    r"""Set up the longest time an actor thread spins for messages in busy poll mode
+
+    Args:
+        val (int): time in microseconds
+    """
+    return enable_if.unique([thread_busy_poll_max_spin_us, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def thread_busy_poll_max_spin_us(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.thread_busy_poll_max_spin_us = val
+
+
+@oneflow_export("config.thread_enable_wake_latency_histogram")
+def api_thread_enable_wake_latency_histogram(val: bool = True) -> None:
+    r"""Whether or not log a histogram of the wake latency of each actor thread when it stops
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([thread_enable_wake_latency_histogram, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def thread_enable_wake_latency_histogram(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.thread_enable_wake_latency_histogram = val
+
+
 @oneflow_export("config.enable_debug_mode")
 def api_enable_debug_mode(val: bool) -> None:
     r"""Whether use debug mode or not.
@@ -390,9 +441,43 @@ def api_collect_act_event(val: bool = True) -> None:
 
 @enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
 def collect_act_event(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.profiler_conf.collect_act_event = val
+
+
+@oneflow_export("config.act_event_sample_interval")
+def api_act_event_sample_interval(val: int) -> None:
+    r"""Record one act in every `val` acts of each actor when collecting act events.
+
+    Args:
+        val (int): sample interval, 1 records every act
+    """
+    return enable_if.unique([act_event_sample_interval, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def act_event_sample_interval(val):
     sess = session_ctx.GetDefaultSession()
     assert type(val) is int
-    sess.config_proto.profile_conf.collect_act_event = val
+    sess.config_proto.profiler_conf.act_event_sample_interval = val
+
+
+@oneflow_export("config.act_event_buffer_size")
+def api_act_event_buffer_size(val: int) -> None:
+    r"""Number of latest sampled acts kept for each actor thread when collecting act events.
+
+    Args:
+        val (int): buffer size
+    """
+    return enable_if.unique([act_event_buffer_size, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def act_event_buffer_size(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.profiler_conf.act_event_buffer_size = val
 
 
 @oneflow_export("config.collective_boxing.enable_fusion")
@@ -636,6 +721,57 @@ def nccl_enable_mixed_fusion(val):
     sess.config_proto.resource.collective_boxing_conf.nccl_enable_mixed_fusion = val
 
 
+@oneflow_export("config.thread_affinity.enable_actor_thread_affinity")
+def api_enable_actor_thread_affinity(val: bool = True) -> None:
+    r"""Whether or not pin the actor threads of cpu devices to numa nodes and those of gpus to their near cpus
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_actor_thread_affinity, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_actor_thread_affinity(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.thread_affinity_conf.enable_actor_thread_affinity = val
+
+
+@oneflow_export("config.thread_affinity.enable_thread_pool_affinity")
+def api_enable_thread_pool_affinity(val: bool = True) -> None:
+    r"""Whether or not pin the workers of the compute thread pool to numa nodes
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_thread_pool_affinity, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_thread_pool_affinity(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.thread_affinity_conf.enable_thread_pool_affinity = val
+
+
+@oneflow_export("config.thread_affinity.enable_numa_local_regst_mem")
+def api_enable_numa_local_regst_mem(val: bool = True) -> None:
+    r"""Whether or not place the host memory of regsts on the numa node of their pinned producer
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_numa_local_regst_mem, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_numa_local_regst_mem(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.thread_affinity_conf.enable_numa_local_regst_mem = val
+
+
 @enable_if.condition(hob.in_normal_mode & hob.session_initialized)
 def do_nothing(*args, **kwargs):
     print("Nothing happened because the session is running")
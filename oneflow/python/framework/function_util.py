@@ -474,6 +474,105 @@ def set_enable_fuse_cast_scale(func_desc, value=True):
     func_desc.job_config_proto.set_enable_fuse_cast_scale(value)
 
 
+@oneflow_function_config("enable_fuse_elementwise")
+def set_enable_fuse_elementwise(func_desc, value=True):
+    r"""Whether enable fuse_elementwise.
+            If enabled, try to fuse chains of elementwise ops such as activations, scalar_add,
+            scalar_mul and bias_add into one fused_elementwise op to reduce memory traffic.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_enable_fuse_elementwise(value)
+
+
+@oneflow_function_config("enable_auto_checkpointing")
+def set_enable_auto_checkpointing(func_desc, value=True):
+    r"""Whether enable auto_checkpointing.
+            If enabled, a train function chooses the forward ops whose outputs are dropped after
+            the forward pass and recomputed in the backward pass, preferring the ops which save
+            the most memory per flop of recomputation. The memory saved and the compute added
+            are logged. Ops in a checkpointing scope are always recomputed, while random ops,
+            normalization ops and ops updating a state in place are never recomputed.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_enable_auto_checkpointing(value)
+
+
+@oneflow_function_config("auto_checkpointing_memory_budget_mbyte")
+def set_auto_checkpointing_memory_budget_mbyte(func_desc, value):
+    r"""Set the memory budget per device of the activations kept for the backward pass
+            when auto_checkpointing is enabled, e.g. 1024mb. Recomputation stops once the
+            activations fit. 0 recomputes every op that reduces the memory.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_auto_checkpointing_memory_budget_mbyte(value)
+
+
+@oneflow_function_config("enable_auto_parallel")
+def set_enable_auto_parallel(func_desc, value=True):
+    r"""Whether enable auto_parallel.
+            If enabled, the sbp signatures of the ops are searched over the whole job with a cost
+            model of compute, memory traffic and boxing bytes, instead of being inferred greedily
+            op by op. The searched plan is only used if its estimated step time is lower, and a
+            report comparing both plans is written to the log dir.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_enable_auto_parallel(value)
+
+
+@oneflow_function_config("enable_cpu_gemm_weight_prepack")
+def set_enable_cpu_gemm_weight_prepack(func_desc, value=True):
+    r"""Whether enable cpu_gemm_weight_prepack.
+            If enabled, cpu matmul and batch_matmul of a predict function pack their variable
+            operand once and reuse it until the variable is overwritten, e.g. by initializing or
+            loading a checkpoint or by the model update of a train function of the same session.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_enable_cpu_gemm_weight_prepack(value)
+
+
+@oneflow_function_config("enable_cpu_max_pool_argmax")
+def set_enable_cpu_max_pool_argmax(func_desc, value=True):
+    r"""Whether enable cpu_max_pool_argmax.
+            If enabled, cpu max pooling of a train function records the position of every max
+            and its backward scatters the gradient there instead of searching the windows again.
+            Only the first max of a window gets the gradient then, while without it every max
+            tied with it gets the gradient too.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_enable_cpu_max_pool_argmax(value)
+
+
+@oneflow_function_config("enable_fold_normalization_into_conv")
+def set_enable_fold_normalization_into_conv(func_desc, value=True):
+    r"""Whether enable fold_normalization_into_conv.
+            If enabled, an inference mode batch normalization of a cpu predict function that
+            follows a convolution is removed, and the convolution uses the folded weight and bias.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_enable_fold_normalization_into_conv(value)
+
+
 @oneflow_function_config("cudnn_conv_use_deterministic_algo_only")
 def set_cudnn_conv_use_deterministic_algo_only(func_desc, value):
     r"""Set value to cudnn conv_use_deterministic_only algorithm
@@ -731,6 +830,18 @@ def set_qat_moving_min_max_momentum(func_desc, value: float):
     )
 
 
+@oneflow_function_config("qat.lower_to_int8_kernels")
+def set_qat_lower_to_int8_kernels(func_desc, value=True):
+    r"""If true, predict jobs replace fake quantized cpu matmul and conv2d with int8 kernels.
+    Only weights quantized with the symmetric scheme are lowered.
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.mutable_qat_config().set_lower_to_int8_kernels(value)
+
+
 @oneflow_function_config("enable_auto_mixed_precision")
 def set_enable_auto_mixed_precision(func_desc, value=True):
     r"""If true, then job will use mixed precision mode, it means use both float16 and float32 during model training.
@@ -901,6 +1012,17 @@ def set_use_tensorrt(func_desc, value=True):
     func_desc.job_config_proto.mutable_xrt_config().set_use_tensorrt(value)
 
 
+@oneflow_function_config("use_native_fusion")
+def set_use_native_fusion(func_desc, value=True):
+    r"""Whether fuse elementwise, broadcast and reduce ops on cpu with the native xrt engine or not
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.mutable_xrt_config().set_use_native_fusion(value)
+
+
 @oneflow_function_config("tensorrt.use_fp16")
 def set_tensorrt_use_fp16(func_desc, value=True):
     r"""Whether use tensorrt fp16  or not
@@ -1162,7 +1162,10 @@ def batch_normalization(
         moving_variance_initializer,
     )
 
-    if flow.current_scope().device_parallel_desc_symbol.device_tag == "cpu":
+    if (
+        flow.current_scope().device_parallel_desc_symbol.device_tag == "cpu"
+        and inputs.dtype == flow.float16
+    ):
         if training:
             reduce_axis = []
             for dim in range(len(inputs.shape)):
@@ -1272,9 +1275,9 @@ def batch_normalization_add_relu(
     if not flow.current_global_function_desc().IsTrainable() or not trainable:
         training = False
 
-    if (
-        not training
-        or flow.current_scope().device_parallel_desc_symbol.device_tag == "cpu"
+    if not training or (
+        flow.current_scope().device_parallel_desc_symbol.device_tag == "cpu"
+        and inputs.dtype == flow.float16
     ):
         out = flow.layers.batch_normalization(
             inputs,
@@ -1411,6 +1414,7 @@ def upsample(
     size: Sequence[int] = (2, 2),
     data_format: str = "NCHW",
     interpolation: str = "nearest",
+    align_corners: bool = False,
     name: str = "Upsample2D",
 ):
     r"""The Upsample Layer, this layer can upsample the feature map to a specified scale. 
@@ -1421,6 +1425,7 @@ def upsample(
         data_format (str, optional): A string specifies the format of the input `Blob`, one of "NCHW" or "NHWC" (default: "NCHW"). "NCHW" cooresponds to channels_first, i.e. the input `Blob` with shape (batch_size, channels, height, width).
                         "NHWC" cooresponds to channels_last, i.e. the input `Blob` with shape (batch_size, height, width, channels).. Defaults to "NCHW".
         interpolation (str, optional): Image interpolation algorithm to enlarge the image size. Defaults to "nearest". "nearest" and "bilinear" are available now.
+        align_corners (bool, optional): Whether the corner pixels of the input and the output are aligned. Only supported on cpu. Defaults to False.
         name ([type], optional): This layer's name. Defaults to None.
 
     Raises:
@@ -1471,9 +1476,14 @@ def upsample(
     if data_format.upper() != "NCHW" and data_format.upper() != "NHWC":
         raise ValueError('data_format must be "NHWC" or "NCHW".')
 
+    # cpu kernels support NHWC directly
     need_transpose = 0
-    if data_format.upper() == "NHWC":
+    if (
+        data_format.upper() == "NHWC"
+        and flow.current_scope().device_parallel_desc_symbol.device_tag != "cpu"
+    ):
         need_transpose = 1
+    channel_pos = "channels_last" if data_format.upper() == "NHWC" else "channels_first"
 
     if need_transpose:
         x = flow.transpose(x, perm=[0, 3, 1, 2])
@@ -1485,7 +1495,8 @@ def upsample(
         .Output("y")
         .Attr("height_scale", float(height_scale))
         .Attr("width_scale", float(width_scale))
-        .Attr("data_format", "channels_first")
+        .Attr("align_corners", align_corners)
+        .Attr("data_format", "channels_first" if need_transpose else channel_pos)
         .Attr("interpolation", interpolation)
         .Build()
     )
@@ -1083,6 +1083,176 @@ def image_decode(
     return op.InferAndTryRun().SoleOutputBlob()
 
 
+@oneflow_export(
+    "image.decode_random_crop_resize_normalize",
+    "image_decode_random_crop_resize_normalize",
+)
+def api_image_decode_random_crop_resize_normalize(
+    images_bytes_buffer: oneflow_api.BlobDesc,
+    target_width: int,
+    target_height: int,
+    mirror_blob: Optional[oneflow_api.BlobDesc] = None,
+    color_space: str = "BGR",
+    num_attempts: int = 10,
+    seed: Optional[int] = None,
+    random_area: Sequence[float] = [0.08, 1.0],
+    random_aspect_ratio: Sequence[float] = [0.75, 1.333333],
+    interpolation_type: str = "bilinear",
+    output_layout: str = "NCHW",
+    mean: Sequence[float] = [0.0],
+    std: Sequence[float] = [1.0],
+    output_dtype: dtype_util.dtype = dtype_util.float,
+    name: str = "ImageDecodeRandomCropResizeNormalize",
+) -> oneflow_api.BlobDesc:
+    """This operator decodes the images, crops them randomly, resizes the crops to a fixed size, flips them horizontally if required, and normalizes them into one Blob. 
+
+    It does the same as `image.decode`, `image.random_crop`, `image.Resize` with a fixed target size and `image.CropMirrorNormalize` in a row, but it does not keep any intermediate image. JPEG images are decoded only inside their crop windows. If a crop window is at least twice as large as the target size, the image is also decoded at a scale of 1/2, 1/4 or 1/8. 
+
+    Args:
+        images_bytes_buffer (oneflow_api.BlobDesc): The encoded images. Its type should be `kTensorBuffer`. 
+        target_width (int): The width of the output images. 
+        target_height (int): The height of the output images. 
+        mirror_blob (Optional[oneflow_api.BlobDesc], optional): Which images to flip horizontally, no image is flipped if it is `None`. Defaults to None.
+        color_space (str, optional): The color space, one of "BGR", "RGB" and "GRAY". Defaults to "BGR".
+        num_attempts (int, optional): The maximum number of random cropping attempts. Defaults to 10.
+        seed (Optional[int], optional): The random seed. Defaults to None.
+        random_area (Sequence[float], optional): The random cropping area. Defaults to [0.08, 1.0].
+        random_aspect_ratio (Sequence[float], optional): The random scaled ratio. Defaults to [0.75, 1.333333].
+        interpolation_type (str, optional): The interpolation of the resize. Defaults to "bilinear".
+        output_layout (str, optional): The output format, "NCHW" or "NHWC". Defaults to "NCHW".
+        mean (Sequence[float], optional): The mean value for normalization. Defaults to [0.0].
+        std (Sequence[float], optional): The standard deviation values for normalization. Defaults to [1.0].
+        output_dtype (dtype_util.dtype, optional): The datatype of output Blob, `flow.float` or `flow.float16`. Defaults to dtype_util.float.
+        name (str, optional): The name for the operation. Defaults to "ImageDecodeRandomCropResizeNormalize".
+
+    Returns:
+        oneflow_api.BlobDesc: The normalized images. 
+
+    For example: 
+
+    .. code-block:: python 
+
+        import oneflow as flow
+        import oneflow.typing as tp
+
+
+        @flow.global_function(type="predict")
+        def imagenet_input_job() -> tp.Numpy:
+            batch_size = 16
+            ofrecord = flow.data.ofrecord_reader(
+                "./imgdataset",
+                batch_size=batch_size,
+                data_part_num=1,
+                part_name_suffix_length=5,
+                random_shuffle=True,
+                shuffle_after_epoch=True,
+            )
+            encoded = flow.data.OFRecordBytesDecoder(ofrecord, "encoded")
+            rng = flow.random.CoinFlip(batch_size=batch_size)
+            normal = flow.image.decode_random_crop_resize_normalize(
+                encoded,
+                target_width=224,
+                target_height=224,
+                mirror_blob=rng,
+                color_space="RGB",
+                mean=[123.68, 116.779, 103.939],
+                std=[58.393, 57.12, 57.375],
+            )
+            return normal
+
+
+        if __name__ == "__main__":
+            images = imagenet_input_job()
+            # images.shape (16, 3, 224, 224)
+
+    """
+    assert isinstance(name, str)
+    if seed is not None:
+        assert name is not None
+    module = flow.find_or_create_module(
+        name,
+        lambda: ImageDecodeRandomCropResizeNormalizeModule(
+            target_width=target_width,
+            target_height=target_height,
+            has_mirror=mirror_blob is not None,
+            color_space=color_space,
+            num_attempts=num_attempts,
+            random_seed=seed,
+            random_area=random_area,
+            random_aspect_ratio=random_aspect_ratio,
+            interpolation_type=interpolation_type,
+            output_layout=output_layout,
+            mean=mean,
+            std=std,
+            output_dtype=output_dtype,
+            name=name,
+        ),
+    )
+    return module(images_bytes_buffer, mirror_blob)
+
+
+class ImageDecodeRandomCropResizeNormalizeModule(module_util.Module):
+    def __init__(
+        self,
+        target_width: int,
+        target_height: int,
+        has_mirror: bool,
+        color_space: str,
+        num_attempts: int,
+        random_seed: Optional[int],
+        random_area: Sequence[float],
+        random_aspect_ratio: Sequence[float],
+        interpolation_type: str,
+        output_layout: str,
+        mean: Sequence[float],
+        std: Sequence[float],
+        output_dtype: dtype_util.dtype,
+        name: str,
+    ):
+        module_util.Module.__init__(self, name)
+        seed, has_seed = flow.random.gen_seed(random_seed)
+        self.has_mirror = has_mirror
+        builder = flow.user_op_module_builder(
+            "image_decode_random_crop_resize_normalize"
+        ).InputSize("in", 1)
+        if has_mirror:
+            builder = builder.InputSize("mirror", 1)
+        self.op_module_builder = (
+            builder.Output("out")
+            .Attr("color_space", color_space)
+            .Attr("num_attempts", num_attempts)
+            .Attr("random_area", random_area)
+            .Attr("random_aspect_ratio", random_aspect_ratio)
+            .Attr("has_seed", has_seed)
+            .Attr("seed", seed)
+            .Attr("target_width", target_width)
+            .Attr("target_height", target_height)
+            .Attr("interpolation_type", interpolation_type)
+            .Attr("output_layout", output_layout)
+            .Attr("mean", mean)
+            .Attr("std", std)
+            .Attr("output_dtype", output_dtype)
+            .CheckAndComplete()
+        )
+        self.op_module_builder.user_op_module.InitOpKernel()
+
+    def forward(
+        self,
+        input: oneflow_api.BlobDesc,
+        mirror: Optional[oneflow_api.BlobDesc] = None,
+    ):
+        assert (mirror is not None) == self.has_mirror
+        if self.call_seq_no == 0:
+            name = self.module_name
+        else:
+            name = id_util.UniqueStr("ImageDecodeRandomCropResizeNormalize_")
+
+        op = self.op_module_builder.OpName(name).Input("in", [input])
+        if mirror is not None:
+            op = op.Input("mirror", [mirror])
+        return op.Build().InferAndTryRun().SoleOutputBlob()
+
+
 @oneflow_export("image.batch_align", "image_batch_align")
 def image_batch_align(
     images: oneflow_api.BlobDesc,
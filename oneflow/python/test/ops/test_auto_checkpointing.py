@@ -0,0 +1,70 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+
+
+def _train(x, enable_auto_checkpointing):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.enable_auto_checkpointing(enable_auto_checkpointing)
+    # recompute every op that reduces the memory
+    func_config.auto_checkpointing_memory_budget_mbyte(0)
+
+    @flow.global_function(type="train", function_config=func_config)
+    def TrainJob(x: oft.Numpy.Placeholder(x.shape)):
+        with flow.scope.placement("gpu", "0:0"):
+            w = flow.get_variable(
+                "w",
+                shape=(x.shape[1], 16),
+                initializer=flow.constant_initializer(0.01),
+            )
+            y = flow.math.relu(flow.matmul(x, w))
+            # the observer updates its moving max in place, and the backward pass of
+            # the multiplication reads its scale
+            scale, _ = flow.quantization.moving_average_min_maxObserver(y, momentum=0.5)
+            loss = flow.math.reduce_mean(
+                flow.math.square(flow.math.multiply(y, scale))
+            )
+            lr_scheduler = flow.optimizer.PiecewiseConstantScheduler([], [1e-2])
+            flow.optimizer.SGD(lr_scheduler, momentum=0).minimize(loss)
+            return scale, loss
+
+    check_point = flow.train.CheckPoint()
+    check_point.init()
+    scales = []
+    for _ in range(5):
+        scale, _ = TrainJob(x).get()
+        scales.append(scale.numpy())
+    return scales
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestAutoCheckpointing(flow.unittest.TestCase):
+    def test_state_updated_once(test_case):
+        x = np.random.uniform(0, 1, (8, 64)).astype(np.float32)
+        scales = _train(x, False)
+        checkpointing_scales = _train(x, True)
+        # recomputing the observer would move its moving max twice per iteration
+        test_case.assertTrue(np.allclose(scales, checkpointing_scales, rtol=1e-5))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,72 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+
+
+def _train(x, enable_auto_parallel, optimizer_name):
+    flow.clear_default_session()
+    flow.config.gpu_device_num(2)
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.consistent_view())
+    func_config.enable_auto_parallel(enable_auto_parallel)
+
+    @flow.global_function(type="train", function_config=func_config)
+    def TrainJob(x: oft.Numpy.Placeholder(x.shape)):
+        with flow.scope.placement("gpu", "0:0-1"):
+            # a large weight makes splitting the model look cheap to the search
+            w = flow.get_variable(
+                "w",
+                shape=(x.shape[1], 2048),
+                initializer=flow.constant_initializer(0.01),
+            )
+            loss = flow.math.reduce_mean(flow.math.square(flow.matmul(x, w)))
+            lr_scheduler = flow.optimizer.PiecewiseConstantScheduler([], [1e-2])
+            if optimizer_name == "sgd":
+                flow.optimizer.SGD(lr_scheduler, momentum=0).minimize(loss)
+            elif optimizer_name == "momentum":
+                flow.optimizer.SGD(lr_scheduler, momentum=0.9).minimize(loss)
+            else:
+                flow.optimizer.Adam(lr_scheduler).minimize(loss)
+            return loss
+
+    check_point = flow.train.CheckPoint()
+    check_point.init()
+    return [TrainJob(x).get().numpy() for _ in range(5)]
+
+
+def compare_with_greedy(test_case, optimizer_name):
+    x = np.random.uniform(-1, 1, (8, 1024)).astype(np.float32)
+    greedy_losses = _train(x, False, optimizer_name)
+    searched_losses = _train(x, True, optimizer_name)
+    # the variable must be updated in place, so the losses keep decreasing the same way
+    test_case.assertTrue(greedy_losses[-1] < greedy_losses[0])
+    test_case.assertTrue(np.allclose(greedy_losses, searched_losses, rtol=1e-4, atol=1e-5))
+
+
+@flow.unittest.skip_unless_1n2d()
+class TestAutoParallel(flow.unittest.TestCase):
+    def test_auto_parallel_with_update_ops(test_case):
+        for optimizer_name in ["sgd", "momentum", "adam"]:
+            compare_with_greedy(test_case, optimizer_name)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -340,11 +340,14 @@ def CompareBnWithTensorFlow(
         test_case.assertTrue(np.allclose(of_y, tf_y, rtol=y_rtol, atol=y_atol), msg)
 
 
-def _test_batchnorm_add_relu(test_case, input_shape, axis, data_type):
+def _test_batchnorm_add_relu(
+    test_case, input_shape, axis, data_type, device_type="gpu"
+):
     flow.clear_default_session()
     func_config = flow.FunctionConfig()
     func_config.default_logical_view(flow.scope.consistent_view())
     func_config.default_data_type(flow.float32)
+    func_config.default_placement_scope(flow.scope.placement(device_type, "0:0"))
 
     @flow.global_function(type="train", function_config=func_config)
     def test_job(
@@ -424,11 +427,12 @@ def _test_batchnorm_add_relu(test_case, input_shape, axis, data_type):
     test_case.assertTrue(np.allclose(addend1_diff, addend2_diff, rtol=tol, atol=tol))
 
 
-def _test_batchnorm_relu(test_case, input_shape, axis, data_type):
+def _test_batchnorm_relu(test_case, input_shape, axis, data_type, device_type="gpu"):
     flow.clear_default_session()
     func_config = flow.FunctionConfig()
     func_config.default_logical_view(flow.scope.consistent_view())
     func_config.default_data_type(flow.float32)
+    func_config.default_placement_scope(flow.scope.placement(device_type, "0:0"))
 
     @flow.global_function(type="train", function_config=func_config)
     def test_job(x: oft.Numpy.Placeholder(input_shape, dtype=flow.float32),):
@@ -487,6 +491,53 @@ def _test_batchnorm_relu(test_case, input_shape, axis, data_type):
     test_case.assertTrue(np.allclose(x1_diff, x2_diff, rtol=tol, atol=tol))
 
 
+def _test_fold_normalization_into_conv(test_case, data_format, use_bias):
+    flow.clear_default_session()
+    input_shape = (2, 3, 10, 10) if data_format == "NCHW" else (2, 10, 10, 3)
+    axis = 1 if data_format == "NCHW" else 3
+
+    def MakeJob(name, fold):
+        func_config = flow.FunctionConfig()
+        func_config.default_data_type(flow.float32)
+        func_config.enable_fold_normalization_into_conv(fold)
+
+        def Job(x: oft.Numpy.Placeholder(input_shape)):
+            with flow.scope.placement("cpu", "0:0"):
+                y = flow.layers.conv2d(
+                    x,
+                    8,
+                    3,
+                    padding="SAME",
+                    data_format=data_format,
+                    use_bias=use_bias,
+                    bias_initializer=flow.random_uniform_initializer(),
+                    name="conv",
+                )
+                y = flow.layers.batch_normalization(
+                    y,
+                    axis=axis,
+                    moving_mean_initializer=flow.random_uniform_initializer(),
+                    moving_variance_initializer=flow.random_uniform_initializer(
+                        minval=0.5, maxval=2
+                    ),
+                    beta_initializer=flow.random_uniform_initializer(),
+                    gamma_initializer=flow.random_uniform_initializer(),
+                    training=False,
+                    name="bn",
+                )
+                return flow.math.relu(y)
+
+        Job.__name__ = name
+        return flow.global_function(type="predict", function_config=func_config)(Job)
+
+    folded_job = MakeJob("FoldedJob", True)
+    unfolded_job = MakeJob("UnfoldedJob", False)
+    x = np.random.uniform(-1, 1, input_shape).astype(np.float32)
+    folded = folded_job(x).get().numpy()
+    unfolded = unfolded_job(x).get().numpy()
+    test_case.assertTrue(np.allclose(folded, unfolded, rtol=1e-4, atol=1e-4))
+
+
 @flow.unittest.skip_unless_1n1d()
 class TestBatchNormalization(flow.unittest.TestCase):
     @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
@@ -641,6 +692,23 @@ class TestBatchNormalization(flow.unittest.TestCase):
         for arg in GenArgDict(arg_dict):
             _test_batchnorm_relu(test_case, **arg)
 
+    def test_batchnorm_add_relu_cpu(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["input_shape"] = [(12, 16, 24, 32), (5, 7, 9, 11)]
+        arg_dict["axis"] = [1, 3]
+        arg_dict["data_type"] = [flow.float32]
+        arg_dict["device_type"] = ["cpu"]
+        for arg in GenArgDict(arg_dict):
+            _test_batchnorm_add_relu(test_case, **arg)
+            _test_batchnorm_relu(test_case, **arg)
+
+    def test_fold_normalization_into_conv(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["data_format"] = ["NCHW", "NHWC"]
+        arg_dict["use_bias"] = [True, False]
+        for arg in GenArgDict(arg_dict):
+            _test_fold_normalization_into_conv(test_case, **arg)
+
 
 if __name__ == "__main__":
     unittest.main()
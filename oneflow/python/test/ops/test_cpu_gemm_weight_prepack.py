@@ -0,0 +1,133 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+from collections import OrderedDict
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+from test_util import GenArgList, type_name_to_flow_type, type_name_to_np_type
+
+
+def _np_matmul(a, b, transpose_a, transpose_b):
+    if transpose_a:
+        a = np.swapaxes(a, -1, -2)
+    if transpose_b:
+        b = np.swapaxes(b, -1, -2)
+    return np.matmul(a, b)
+
+
+def compare_with_numpy(
+    test_case, a_shape, b_shape, transpose_a, transpose_b, data_type,
+):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.enable_cpu_gemm_weight_prepack(True)
+    flow_type = type_name_to_flow_type[data_type]
+    np_type = type_name_to_np_type[data_type]
+
+    @flow.global_function(type="predict", function_config=func_config)
+    def MatmulJob(a: oft.Numpy.Placeholder(a_shape, dtype=flow_type)):
+        with flow.scope.placement("cpu", "0:0"):
+            b = flow.get_variable(
+                "b",
+                shape=b_shape,
+                dtype=flow_type,
+                initializer=flow.random_uniform_initializer(minval=-1, maxval=1),
+                trainable=False,
+            )
+            return flow.matmul(a, b, transpose_a, transpose_b)
+
+    b = flow.get_all_variables()["b"].numpy()
+    for _ in range(2):
+        a = np.random.uniform(-1, 1, a_shape).astype(np_type)
+        of_out = MatmulJob(a).get().numpy()
+        np_out = _np_matmul(a, b, transpose_a, transpose_b)
+        test_case.assertTrue(np.allclose(of_out, np_out, rtol=1e-4, atol=1e-4))
+
+    # packed weight must be refreshed after the variable is overwritten
+    new_b = np.random.uniform(-1, 1, b_shape).astype(np_type)
+    flow.load_variables({"b": new_b})
+    a = np.random.uniform(-1, 1, a_shape).astype(np_type)
+    of_out = MatmulJob(a).get().numpy()
+    np_out = _np_matmul(a, new_b, transpose_a, transpose_b)
+    test_case.assertTrue(np.allclose(of_out, np_out, rtol=1e-4, atol=1e-4))
+
+
+def compare_with_numpy_after_training(test_case, a_shape, b_shape):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.enable_cpu_gemm_weight_prepack(True)
+
+    def _b():
+        return flow.get_variable(
+            "b",
+            shape=b_shape,
+            initializer=flow.random_uniform_initializer(minval=-1, maxval=1),
+        )
+
+    @flow.global_function(type="predict", function_config=func_config)
+    def MatmulJob(a: oft.Numpy.Placeholder(a_shape)):
+        with flow.scope.placement("cpu", "0:0"):
+            return flow.matmul(a, _b())
+
+    @flow.global_function(type="train", function_config=func_config)
+    def TrainJob(a: oft.Numpy.Placeholder(a_shape)):
+        with flow.scope.placement("cpu", "0:0"):
+            loss = flow.math.reduce_mean(flow.matmul(a, _b()))
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [0.1]), momentum=0
+            ).minimize(loss)
+            return loss
+
+    a = np.random.uniform(-1, 1, a_shape).astype(np.float32)
+    for _ in range(3):
+        of_out = MatmulJob(a).get().numpy()
+        b = flow.get_all_variables()["b"].numpy()
+        test_case.assertTrue(np.allclose(of_out, np.matmul(a, b), rtol=1e-4, atol=1e-4))
+        # the update kernel of the train job overwrites b, the packed b must follow
+        TrainJob(a).get()
+
+
+def _shapes(m, n, k, batch, transpose_a, transpose_b):
+    a_shape = (k, m) if transpose_a else (m, k)
+    b_shape = (n, k) if transpose_b else (k, n)
+    return batch + a_shape, batch + b_shape
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestCpuGemmWeightPrepack(flow.unittest.TestCase):
+    def test_matmul(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["mnk"] = [(1, 768, 768), (7, 33, 300), (100, 17, 5), (13, 1, 600)]
+        arg_dict["batch"] = [(), (3,)]
+        arg_dict["transpose_a"] = [True, False]
+        arg_dict["transpose_b"] = [True, False]
+        arg_dict["data_type"] = ["float32", "double"]
+        for mnk, batch, transpose_a, transpose_b, data_type in GenArgList(arg_dict):
+            a_shape, b_shape = _shapes(*mnk, batch, transpose_a, transpose_b)
+            compare_with_numpy(
+                test_case, a_shape, b_shape, transpose_a, transpose_b, data_type
+            )
+
+    def test_matmul_with_train_job(test_case):
+        compare_with_numpy_after_training(test_case, (7, 300), (300, 33))
+
+
+if __name__ == "__main__":
+    unittest.main()
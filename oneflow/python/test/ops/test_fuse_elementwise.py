@@ -0,0 +1,84 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+from collections import OrderedDict
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+import oneflow.python.framework.c_api_util as c_api_util
+from test_util import GenArgList, type_name_to_flow_type, type_name_to_np_type
+
+
+def _run_chain(device_type, x, bias, data_type, enable_fuse_elementwise):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.enable_fuse_elementwise(enable_fuse_elementwise)
+    flow_type = type_name_to_flow_type[data_type]
+
+    @flow.global_function(type="predict", function_config=func_config)
+    def ElementwiseChainJob(
+        x: oft.Numpy.Placeholder(x.shape, dtype=flow_type),
+        bias: oft.Numpy.Placeholder(bias.shape, dtype=flow_type),
+    ):
+        with flow.scope.placement(device_type, "0:0"):
+            y = flow.nn.bias_add(x, bias, data_format="NCHW")
+            y = flow.math.relu(y * 0.5 + 1.0)
+            y = flow.math.tanh(y)
+            y = flow.nn.leaky_relu(y - 0.5, alpha=0.1)
+            y = flow.math.gelu(flow.math.sigmoid(y) * 3.0)
+            return flow.math.square(y)
+
+    out = ElementwiseChainJob(x, bias).get().numpy()
+    return out, _op_type_names_of_compiled_job("ElementwiseChainJob")
+
+
+def _op_type_names_of_compiled_job(job_name):
+    for job in c_api_util.GetJobSet().job:
+        if job.job_conf.job_name == job_name:
+            return [
+                op.user_conf.op_type_name
+                for op in job.net.op
+                if op.HasField("user_conf")
+            ]
+    raise ValueError("job {} not found".format(job_name))
+
+
+def compare_with_unfused(test_case, device_type, shape, data_type):
+    np_type = type_name_to_np_type[data_type]
+    x = np.random.uniform(-2, 2, shape).astype(np_type)
+    bias = np.random.uniform(-1, 1, (shape[1],)).astype(np_type)
+    fused_out, fused_op_types = _run_chain(device_type, x, bias, data_type, True)
+    unfused_out, unfused_op_types = _run_chain(device_type, x, bias, data_type, False)
+    test_case.assertIn("fused_elementwise", fused_op_types)
+    test_case.assertNotIn("fused_elementwise", unfused_op_types)
+    test_case.assertTrue(np.allclose(fused_out, unfused_out, rtol=1e-4, atol=1e-4))
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestFuseElementwise(flow.unittest.TestCase):
+    def test_fuse_elementwise(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["gpu", "cpu"]
+        arg_dict["shape"] = [(2, 3, 4, 5), (7, 600, 3)]
+        arg_dict["data_type"] = ["float32", "double"]
+        for arg in GenArgList(arg_dict):
+            compare_with_unfused(test_case, *arg)
+
+
+if __name__ == "__main__":
+    unittest.main()
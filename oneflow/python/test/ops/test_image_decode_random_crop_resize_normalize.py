@@ -0,0 +1,124 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+import cv2
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+
+
+def _of_image_decode_random_crop_resize_normalize(
+    image_file, target_size, mirror, mean, std, output_layout
+):
+    with open(image_file, "rb") as f:
+        image_bytes = f.read()
+    height, width = cv2.imread(image_file).shape[:2]
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.mirrored_view())
+
+    @flow.global_function(function_config=func_config)
+    def image_decode_random_crop_resize_normalize_job(
+        images_def: oft.ListListNumpy.Placeholder(
+            shape=(1, len(image_bytes)), dtype=flow.int8
+        ),
+        mirror_def: oft.ListNumpy.Placeholder(shape=(1,), dtype=flow.int8),
+    ):
+        images_buffer = flow.tensor_list_to_tensor_buffer(images_def)
+        # the crop window is the whole image with this area and aspect ratio
+        return flow.image.decode_random_crop_resize_normalize(
+            images_buffer,
+            target_width=target_size[0],
+            target_height=target_size[1],
+            mirror_blob=mirror_def,
+            color_space="RGB",
+            random_area=[1.0, 1.0],
+            random_aspect_ratio=[width / height, width / height],
+            output_layout=output_layout,
+            mean=mean,
+            std=std,
+        )
+
+    images_np_arr = [np.frombuffer(image_bytes, dtype=np.byte).reshape(1, -1)]
+    mirror_np_arr = [np.array([1 if mirror else 0], dtype=np.int8)]
+    return (
+        image_decode_random_crop_resize_normalize_job([images_np_arr], mirror_np_arr)
+        .get()
+        .numpy_list()[0]
+    )
+
+
+def _cv_image_decode_resize_normalize(
+    image_file, target_size, mirror, mean, std, output_layout
+):
+    image = cv2.imread(image_file)
+    image = cv2.resize(image, target_size, interpolation=cv2.INTER_LINEAR)
+    image = cv2.cvtColor(image, cv2.COLOR_BGR2RGB).astype(np.float32)
+    if mirror:
+        image = image[:, ::-1, :]
+    image = (image - np.array(mean, dtype=np.float32)) / np.array(std, dtype=np.float32)
+    if output_layout == "NCHW":
+        image = np.transpose(image, (2, 0, 1))
+    return np.expand_dims(image, axis=0)
+
+
+def _compare_with_cv(test_case, image_file, target_size, mirror, output_layout):
+    mean = [123.68, 116.779, 103.939]
+    std = [58.393, 57.12, 57.375]
+    of_image = _of_image_decode_random_crop_resize_normalize(
+        image_file, target_size, mirror, mean, std, output_layout
+    )
+    cv_image = _cv_image_decode_resize_normalize(
+        image_file, target_size, mirror, mean, std, output_layout
+    )
+    test_case.assertEqual(of_image.shape, cv_image.shape)
+    # libjpeg and the decoder of opencv upsample chroma slightly differently
+    test_case.assertTrue(np.mean(np.abs(of_image - cv_image)) < 0.05)
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestImageDecodeRandomCropResizeNormalize(flow.unittest.TestCase):
+    def test_nchw(test_case):
+        _compare_with_cv(
+            test_case,
+            "/dataset/mscoco_2017/val2017/000000000139.jpg",
+            (320, 240),
+            False,
+            "NCHW",
+        )
+
+    def test_nchw_mirror(test_case):
+        _compare_with_cv(
+            test_case,
+            "/dataset/mscoco_2017/val2017/000000000632.jpg",
+            (321, 243),
+            True,
+            "NCHW",
+        )
+
+    def test_nhwc_mirror(test_case):
+        _compare_with_cv(
+            test_case,
+            "/dataset/mscoco_2017/val2017/000000000139.jpg",
+            (300, 300),
+            True,
+            "NHWC",
+        )
+
+
+if __name__ == "__main__":
+    unittest.main()
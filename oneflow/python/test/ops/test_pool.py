@@ -134,8 +134,53 @@ def _GetSequence(value, n, name):
         )
 
 
+def _max_pool_tie_grad(data_format, enable_cpu_max_pool_argmax):
+    flow.clear_default_session()
+    x_shape = (1, 2, 4, 4) if data_format == "NCHW" else (1, 4, 4, 2)
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.enable_cpu_max_pool_argmax(enable_cpu_max_pool_argmax)
+    grads = []
+
+    @flow.global_function(type="train", function_config=func_config)
+    def MaxPoolJob(x: oft.Numpy.Placeholder(x_shape)):
+        with flow.scope.placement("cpu", "0:0"):
+            v = flow.get_variable(
+                "v",
+                shape=x_shape,
+                initializer=flow.constant_initializer(0),
+                trainable=True,
+            )
+            flow.watch_diff(v, lambda b: grads.append(b.numpy()))
+            y = flow.nn.max_pool2d(
+                x + v, ksize=2, strides=2, padding="VALID", data_format=data_format
+            )
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [1e-4]), momentum=0
+            ).minimize(y)
+            return y
+
+    MaxPoolJob(np.ones(x_shape, dtype=np.float32)).get()
+    return grads[0]
+
+
 @flow.unittest.skip_unless_1n1d()
 class TestPool(flow.unittest.TestCase):
+    def test_cpu_max_pool_ties(test_case):
+        for data_format in ["NCHW", "NHWC"]:
+            # every element of a window is a max, each of them gets the gradient by default
+            dx = _max_pool_tie_grad(data_format, False)
+            test_case.assertTrue(np.allclose(dx, np.ones_like(dx)))
+            # with argmax only the first max of each window gets it
+            dx = _max_pool_tie_grad(data_format, True)
+            first_max = np.zeros((4, 4), dtype=np.float32)
+            first_max[::2, ::2] = 1
+            if data_format == "NCHW":
+                expected = np.broadcast_to(first_max, dx.shape)
+            else:
+                expected = np.broadcast_to(first_max[:, :, np.newaxis], dx.shape)
+            test_case.assertTrue(np.allclose(dx, expected))
+
     def test_pool(_):
         arg_dict = OrderedDict()
         arg_dict["device_type"] = ["gpu", "cpu"]
@@ -157,8 +202,8 @@ class TestPool(flow.unittest.TestCase):
             x = np.random.randn(*x_shape).astype(type_name_to_np_type[data_type])
             dim = len(x.shape) - 2
 
-            # TODO: these cases will fail in old implementation
-            if dim == 3 and data_format == "NDHWC":
+            # TODO: these cases will fail in the gpu implementation
+            if dim == 3 and data_format == "NDHWC" and device_type == "gpu":
                 continue
             # TF results
             with tf.GradientTape(persistent=True) as tape:
@@ -0,0 +1,115 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+from collections import OrderedDict
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+from test_util import GenArgList
+
+MOVING_MAX = 4.0
+
+
+def _make_predict_func(name, input_shape, build_fn, per_channel, lower_to_int8):
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.enable_qat(True)
+    func_config.qat.symmetric(True)
+    func_config.qat.per_channel_weight_quantization(per_channel)
+    func_config.qat.moving_min_max_stop_update_after_iters(1000)
+    func_config.qat.lower_to_int8_kernels(lower_to_int8)
+
+    def Job(x: oft.Numpy.Placeholder(input_shape)):
+        with flow.scope.placement("cpu", "0:0"):
+            return build_fn(x)
+
+    Job.__name__ = name
+    return flow.global_function(type="predict", function_config=func_config)(Job)
+
+
+def _set_moving_min_max():
+    # the activation scales of a predict job come from moving min/max variables
+    variables = {}
+    for name in flow.get_all_variables().keys():
+        if name.endswith("-fake-quant-moving-max"):
+            variables[name] = np.array([MOVING_MAX], dtype=np.float32)
+        elif name.endswith("-fake-quant-moving-min"):
+            variables[name] = np.array([-MOVING_MAX], dtype=np.float32)
+    flow.load_variables(variables)
+
+
+def compare_with_fake_quantization(test_case, input_shape, build_fn, per_channel):
+    flow.clear_default_session()
+    int8_job = _make_predict_func(
+        "Int8Job", input_shape, build_fn, per_channel, lower_to_int8=True
+    )
+    fake_quant_job = _make_predict_func(
+        "FakeQuantJob", input_shape, build_fn, per_channel, lower_to_int8=False
+    )
+    x = np.random.uniform(-MOVING_MAX, MOVING_MAX, input_shape).astype(np.float32)
+    int8_job(x).get()
+    fake_quant_job(x).get()
+    _set_moving_min_max()
+    for _ in range(2):
+        x = np.random.uniform(-MOVING_MAX, MOVING_MAX, input_shape).astype(np.float32)
+        int8_out = int8_job(x).get().numpy()
+        fake_quant_out = fake_quant_job(x).get().numpy()
+        test_case.assertTrue(
+            np.allclose(int8_out, fake_quant_out, rtol=1e-4, atol=1e-3)
+        )
+
+
+def _build_matmul(x):
+    w = flow.get_variable(
+        "w",
+        shape=(33, x.shape[1]),
+        dtype=flow.float,
+        initializer=flow.random_uniform_initializer(minval=-1, maxval=1),
+        trainable=False,
+    )
+    return flow.matmul(x, w, transpose_b=True)
+
+
+def _build_conv(x):
+    return flow.layers.conv2d(x, 8, 3, 1, "SAME", use_bias=True, name="conv")
+
+
+def _build_strided_conv(x):
+    return flow.layers.conv2d(x, 5, 3, 2, "VALID", use_bias=False, name="conv")
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestQuantizedInference(flow.unittest.TestCase):
+    def test_quantized_matmul(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["input_shape"] = [(1, 64), (17, 301)]
+        arg_dict["build_fn"] = [_build_matmul]
+        arg_dict["per_channel"] = [True, False]
+        for arg in GenArgList(arg_dict):
+            compare_with_fake_quantization(test_case, *arg)
+
+    def test_quantized_conv2d(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["input_shape"] = [(2, 3, 9, 7)]
+        arg_dict["build_fn"] = [_build_conv, _build_strided_conv]
+        arg_dict["per_channel"] = [True, False]
+        for arg in GenArgList(arg_dict):
+            compare_with_fake_quantization(test_case, *arg)
+
+
+if __name__ == "__main__":
+    unittest.main()
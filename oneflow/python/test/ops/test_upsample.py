@@ -82,11 +82,64 @@ def compare_with_tensorflow(
     )
 
 
+def compare_align_corners_with_tensorflow(input_shape, size, interpolation):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+
+    @flow.global_function(type="train", function_config=func_config)
+    def UpsampleJob():
+        with flow.scope.placement("cpu", "0:0"):
+            x = flow.get_variable(
+                "input",
+                shape=input_shape,
+                dtype=flow.float,
+                initializer=flow.random_uniform_initializer(minval=2, maxval=5),
+                trainable=True,
+            )
+            loss = flow.layers.upsample_2d(
+                x,
+                size=size,
+                data_format="NHWC",
+                interpolation=interpolation,
+                align_corners=True,
+            )
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [1e-4]), momentum=0
+            ).minimize(loss)
+
+            flow.watch(x, test_global_storage.Setter("x"))
+            flow.watch_diff(x, test_global_storage.Setter("x_diff"))
+            flow.watch_diff(loss, test_global_storage.Setter("loss_diff"))
+            return loss
+
+    check_point = flow.train.CheckPoint()
+    check_point.init()
+    of_out = UpsampleJob().get()
+
+    height_scale, width_scale = (size, size) if isinstance(size, int) else size
+    out_size = (input_shape[1] * height_scale, input_shape[2] * width_scale)
+    resize = (
+        tf.compat.v1.image.resize_nearest_neighbor
+        if interpolation == "nearest"
+        else tf.compat.v1.image.resize_bilinear
+    )
+    with tf.GradientTape(persistent=True) as tape:
+        x = tf.Variable(test_global_storage.Get("x").astype(np.float32))
+        tf_out = resize(x, out_size, align_corners=True)
+    loss_diff = test_global_storage.Get("loss_diff").astype(np.float32)
+    tf_x_diff = tape.gradient(tf_out, x, loss_diff)
+    assert np.allclose(of_out.numpy(), tf_out.numpy(), rtol=1e-5, atol=1e-5)
+    assert np.allclose(
+        test_global_storage.Get("x_diff"), tf_x_diff.numpy(), rtol=1e-5, atol=1e-5
+    )
+
+
 @flow.unittest.skip_unless_1n1d()
 class TestUpsample(flow.unittest.TestCase):
     def test_upsample(test_case):
         arg_dict = OrderedDict()
-        arg_dict["device_type"] = ["gpu"]
+        arg_dict["device_type"] = ["gpu", "cpu"]
         arg_dict["input_shape"] = [(2, 11, 12, 13)]
         arg_dict["dtype"] = ["float32", "double"]
         arg_dict["size"] = [(2, 2), 3, (1, 2)]
@@ -95,6 +148,14 @@ class TestUpsample(flow.unittest.TestCase):
         for arg in GenArgList(arg_dict):
             compare_with_tensorflow(*arg)
 
+    def test_upsample_align_corners_cpu(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["input_shape"] = [(2, 5, 7, 3), (1, 1, 4, 16)]
+        arg_dict["size"] = [(2, 2), 3, (1, 2)]
+        arg_dict["interpolation"] = ["nearest", "bilinear"]
+        for arg in GenArgList(arg_dict):
+            compare_align_corners_with_tensorflow(*arg)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -0,0 +1,114 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/image/jpeg_decoder.h"
+#include <csetjmp>
+#include <jpeglib.h>
+
+namespace oneflow {
+
+namespace {
+
+struct JpegErrorManager {
+  jpeg_error_mgr pub;
+  jmp_buf setjmp_buffer;
+};
+
+void JpegErrorExit(j_common_ptr cinfo) {
+  JpegErrorManager* error_manager = reinterpret_cast<JpegErrorManager*>(cinfo->err);
+  longjmp(error_manager->setjmp_buffer, 1);
+}
+
+// Warnings of corrupted data are not printed, cv::imdecode does not print them either
+void JpegOutputMessage(j_common_ptr cinfo) {}
+
+int ScaleDenom4Window(int window_width, int window_height, int min_width, int min_height) {
+  for (int denom = 8; denom > 1; denom /= 2) {
+    if (window_width >= min_width * denom && window_height >= min_height * denom) { return denom; }
+  }
+  return 1;
+}
+
+int DivUp(int n, int denom) { return (n + denom - 1) / denom; }
+
+cv::Rect CropWindow4ImageSize(RandomCropGenerator* crop_generator, int width, int height,
+                              CropWindow* crop_window) {
+  if (crop_generator == nullptr) { return cv::Rect(0, 0, width, height); }
+  crop_generator->GenerateCropWindow({height, width}, crop_window);
+  return cv::Rect(crop_window->anchor.At(1), crop_window->anchor.At(0), crop_window->shape.At(1),
+                  crop_window->shape.At(0));
+}
+
+}  // namespace
+
+bool JpegDecodeRandomCrop(const unsigned char* data, size_t length,
+                          RandomCropGenerator* crop_generator, int min_width, int min_height,
+                          bool bgr, cv::Mat* image, CropWindow* crop_window) {
+  // JPEG images start with the SOI marker
+  if (length < 2 || data[0] != 0xFF || data[1] != 0xD8) { return false; }
+  jpeg_decompress_struct cinfo;
+  JpegErrorManager error_manager;
+  cinfo.err = jpeg_std_error(&error_manager.pub);
+  error_manager.pub.error_exit = JpegErrorExit;
+  error_manager.pub.output_message = JpegOutputMessage;
+  jpeg_create_decompress(&cinfo);
+  // only trivially destructible locals live from here on, longjmp would skip their destructors
+  if (setjmp(error_manager.setjmp_buffer)) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  jpeg_mem_src(&cinfo, const_cast<unsigned char*>(data), length);
+  if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK
+      || cinfo.jpeg_color_space == JCS_CMYK || cinfo.jpeg_color_space == JCS_YCCK) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  const cv::Rect window =
+      CropWindow4ImageSize(crop_generator, cinfo.image_width, cinfo.image_height, crop_window);
+  const int denom = ScaleDenom4Window(window.width, window.height, min_width, min_height);
+  cinfo.scale_num = 1;
+  cinfo.scale_denom = denom;
+  cinfo.out_color_space = bgr ? JCS_EXT_BGR : JCS_RGB;
+  jpeg_start_decompress(&cinfo);
+  // the window in the scaled image, which is DivUp(width, denom) x DivUp(height, denom)
+  const int scaled_x = window.x / denom;
+  const int scaled_y = window.y / denom;
+  const int scaled_width =
+      std::min<int>(DivUp(window.x + window.width, denom), cinfo.output_width) - scaled_x;
+  const int scaled_height =
+      std::min<int>(DivUp(window.y + window.height, denom), cinfo.output_height) - scaled_y;
+  // libjpeg widens the cropped columns to the iMCU boundaries
+  JDIMENSION crop_x = scaled_x;
+  JDIMENSION crop_width = scaled_width;
+  jpeg_crop_scanline(&cinfo, &crop_x, &crop_width);
+  if (jpeg_skip_scanlines(&cinfo, scaled_y) != static_cast<JDIMENSION>(scaled_y)) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  image->create(scaled_height, cinfo.output_width, CV_8UC3);
+  while (cinfo.output_scanline < static_cast<JDIMENSION>(scaled_y + scaled_height)) {
+    JSAMPROW row = image->ptr(cinfo.output_scanline - scaled_y);
+    if (jpeg_read_scanlines(&cinfo, &row, 1) != 1) {
+      jpeg_destroy_decompress(&cinfo);
+      return false;
+    }
+  }
+  // the rows below the window are never decoded, so the decompression is aborted
+  jpeg_destroy_decompress(&cinfo);
+  *image = (*image)(cv::Rect(scaled_x - crop_x, 0, scaled_width, scaled_height));
+  return true;
+}
+
+}  // namespace oneflow
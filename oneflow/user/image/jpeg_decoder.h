@@ -0,0 +1,40 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_IMAGE_JPEG_DECODER_H_
+#define ONEFLOW_USER_IMAGE_JPEG_DECODER_H_
+
+#include "oneflow/user/image/random_crop_generator.h"
+#include <opencv2/opencv.hpp>
+
+namespace oneflow {
+
+// Decodes only the random crop window of a JPEG image into an RGB image, or a BGR image if bgr is
+// true. The crop window is the whole image if crop_generator is nullptr. Rows above the window
+// are skipped and columns outside of it are cropped by libjpeg. If the window is at least 2, 4 or
+// 8 times as large as min_width x min_height, it is decoded with the DCT scaled down by the same
+// factor, so the result is never smaller than min_width x min_height unless the window is.
+// Returns false for data that is not a JPEG image libjpeg can convert to RGB, the caller then
+// decodes it in another way. The generated crop window is stored to crop_window as soon as the
+// header is read, also if the decode fails later, so the caller crops its fallback decode with it
+// instead of drawing another window from crop_generator. crop_window is left as it is, which is
+// zero-sized by default, if the header can not be read, and may be nullptr if crop_generator is.
+bool JpegDecodeRandomCrop(const unsigned char* data, size_t length,
+                          RandomCropGenerator* crop_generator, int min_width, int min_height,
+                          bool bgr, cv::Mat* image, CropWindow* crop_window);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_IMAGE_JPEG_DECODER_H_
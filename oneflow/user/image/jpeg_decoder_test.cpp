@@ -0,0 +1,179 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <chrono>
+#include "oneflow/user/image/jpeg_decoder.h"
+
+namespace oneflow {
+
+namespace {
+
+cv::Mat GenGradientImage(int width, int height) {
+  cv::Mat image(height, width, CV_8UC3);
+  FOR_RANGE(int, row, 0, height) {
+    FOR_RANGE(int, col, 0, width) {
+      image.at<cv::Vec3b>(row, col) =
+          cv::Vec3b(row * 255 / height, col * 255 / width, (row + col) * 255 / (height + width));
+    }
+  }
+  return image;
+}
+
+std::vector<unsigned char> EncodeImage(const cv::Mat& image, const std::string& ext) {
+  std::vector<unsigned char> data;
+  CHECK(cv::imencode(ext, image, data));
+  return data;
+}
+
+cv::Mat ReferenceDecode(const std::vector<unsigned char>& data) {
+  cv::Mat image = cv::imdecode(data, cv::IMREAD_COLOR);
+  cv::cvtColor(image, image, cv::COLOR_BGR2RGB);
+  return image;
+}
+
+double MeanAbsDiff(const cv::Mat& lhs, const cv::Mat& rhs) {
+  CHECK_EQ(lhs.size(), rhs.size());
+  cv::Mat diff;
+  cv::absdiff(lhs, rhs, diff);
+  const cv::Scalar mean = cv::mean(diff);
+  return (mean[0] + mean[1] + mean[2]) / 3;
+}
+
+RandomCropGenerator CreateImageNetCropGenerator(int64_t seed) {
+  return RandomCropGenerator({3.f / 4.f, 4.f / 3.f}, {0.08f, 1.f}, seed, 10);
+}
+
+}  // namespace
+
+TEST(JpegDecoder, decode_whole_image) {
+  const std::vector<unsigned char> data = EncodeImage(GenGradientImage(333, 217), ".jpg");
+  cv::Mat image;
+  ASSERT_TRUE(
+      JpegDecodeRandomCrop(data.data(), data.size(), nullptr, 333, 217, false, &image, nullptr));
+  ASSERT_LT(MeanAbsDiff(image, ReferenceDecode(data)), 1.0);
+}
+
+TEST(JpegDecoder, decode_random_crop) {
+  const std::vector<unsigned char> data = EncodeImage(GenGradientImage(640, 480), ".jpg");
+  const cv::Mat reference = ReferenceDecode(data);
+  RandomCropGenerator crop_generator = CreateImageNetCropGenerator(7);
+  RandomCropGenerator reference_crop_generator = CreateImageNetCropGenerator(7);
+  FOR_RANGE(int, i, 0, 16) {
+    cv::Mat image;
+    // no scaling as the crop window is never larger than the minimum size
+    CropWindow decoded_window;
+    ASSERT_TRUE(JpegDecodeRandomCrop(data.data(), data.size(), &crop_generator, 640, 480, false,
+                                     &image, &decoded_window));
+    CropWindow window;
+    reference_crop_generator.GenerateCropWindow({480, 640}, &window);
+    ASSERT_EQ(decoded_window.anchor, window.anchor);
+    ASSERT_EQ(decoded_window.shape, window.shape);
+    const cv::Rect roi(window.anchor.At(1), window.anchor.At(0), window.shape.At(1),
+                       window.shape.At(0));
+    ASSERT_LT(MeanAbsDiff(image, reference(roi)), 1.0);
+  }
+}
+
+TEST(JpegDecoder, decode_scaled) {
+  const std::vector<unsigned char> data = EncodeImage(GenGradientImage(640, 480), ".jpg");
+  const cv::Mat reference = ReferenceDecode(data);
+  // 480 is at least 4 but not 8 times as large as 64
+  cv::Mat image;
+  ASSERT_TRUE(
+      JpegDecodeRandomCrop(data.data(), data.size(), nullptr, 64, 64, false, &image, nullptr));
+  ASSERT_EQ(image.cols, 160);
+  ASSERT_EQ(image.rows, 120);
+  cv::Mat resized;
+  cv::resize(reference, resized, image.size(), 0, 0, cv::INTER_AREA);
+  ASSERT_LT(MeanAbsDiff(image, resized), 2.0);
+}
+
+TEST(JpegDecoder, not_jpeg) {
+  const std::vector<unsigned char> data = EncodeImage(GenGradientImage(64, 64), ".png");
+  cv::Mat image;
+  ASSERT_FALSE(
+      JpegDecodeRandomCrop(data.data(), data.size(), nullptr, 64, 64, false, &image, nullptr));
+  // a JPEG image cut off before its first scan
+  const std::vector<unsigned char> jpeg_data = EncodeImage(GenGradientImage(64, 64), ".jpg");
+  ASSERT_FALSE(JpegDecodeRandomCrop(jpeg_data.data(), 16, nullptr, 64, 64, false, &image, nullptr));
+}
+
+TEST(JpegDecoder, keep_crop_window_of_failed_decode) {
+  const std::vector<unsigned char> data = EncodeImage(GenGradientImage(640, 480), ".jpg");
+  RandomCropGenerator crop_generator = CreateImageNetCropGenerator(7);
+  RandomCropGenerator reference_crop_generator = CreateImageNetCropGenerator(7);
+  // the header is read but the scan refers to undefined Huffman tables, so the window is generated
+  // before libjpeg fails in jpeg_start_decompress
+  std::vector<unsigned char> corrupted = data;
+  FOR_RANGE(size_t, i, 2, corrupted.size() - 1) {
+    if (corrupted[i] != 0xFF || corrupted[i + 1] != 0xDA) { continue; }
+    const int num_components = corrupted[i + 4];
+    FOR_RANGE(int, c, 0, num_components) { corrupted[i + 6 + 2 * c] = 0x33; }
+    break;
+  }
+  cv::Mat image;
+  CropWindow decoded_window;
+  ASSERT_FALSE(JpegDecodeRandomCrop(corrupted.data(), corrupted.size(), &crop_generator, 640, 480,
+                                    false, &image, &decoded_window));
+  CropWindow window;
+  reference_crop_generator.GenerateCropWindow({480, 640}, &window);
+  ASSERT_EQ(decoded_window.anchor, window.anchor);
+  ASSERT_EQ(decoded_window.shape, window.shape);
+  // the next window is drawn from the same state as the one of a generator used once
+  ASSERT_TRUE(JpegDecodeRandomCrop(data.data(), data.size(), &crop_generator, 640, 480, false,
+                                   &image, &decoded_window));
+  reference_crop_generator.GenerateCropWindow({480, 640}, &window);
+  ASSERT_EQ(decoded_window.shape, window.shape);
+}
+
+// Images/sec of random-crop-resize to 224x224 by a full decode and by JpegDecodeRandomCrop, run
+// with --gtest_also_run_disabled_tests
+TEST(JpegDecoder, DISABLED_random_crop_resize_benchmark) {
+  const int kTargetSize = 224;
+  const int kIters = 200;
+  const std::vector<std::pair<int, int>> image_sizes = {{500, 375}, {1280, 960}, {4000, 3000}};
+  for (const auto& size : image_sizes) {
+    const std::vector<unsigned char> data =
+        EncodeImage(GenGradientImage(size.first, size.second), ".jpg");
+    cv::Mat dst(kTargetSize, kTargetSize, CV_8UC3);
+    RandomCropGenerator full_crop_generator = CreateImageNetCropGenerator(1);
+    auto start = std::chrono::steady_clock::now();
+    FOR_RANGE(int, i, 0, kIters) {
+      const cv::Mat image = ReferenceDecode(data);
+      CropWindow window;
+      full_crop_generator.GenerateCropWindow({image.rows, image.cols}, &window);
+      const cv::Rect roi(window.anchor.At(1), window.anchor.At(0), window.shape.At(1),
+                         window.shape.At(0));
+      cv::resize(image(roi), dst, dst.size(), 0, 0, cv::INTER_LINEAR);
+    }
+    const double full_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    RandomCropGenerator crop_generator = CreateImageNetCropGenerator(1);
+    start = std::chrono::steady_clock::now();
+    FOR_RANGE(int, i, 0, kIters) {
+      cv::Mat window;
+      CropWindow crop_window;
+      CHECK(JpegDecodeRandomCrop(data.data(), data.size(), &crop_generator, kTargetSize,
+                                 kTargetSize, false, &window, &crop_window));
+      cv::resize(window, dst, dst.size(), 0, 0, cv::INTER_LINEAR);
+    }
+    const double roi_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG(INFO) << size.first << "x" << size.second << ": full decode " << kIters / full_seconds
+              << " images/sec, roi decode " << kIters / roi_seconds << " images/sec";
+  }
+}
+
+}  // namespace oneflow
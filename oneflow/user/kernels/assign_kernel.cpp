@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/kernel/kernel_util.h"
+#include "oneflow/user/kernels/variable_version.h"
 
 namespace oneflow {
 
@@ -37,6 +38,7 @@ class AssignKernel final : public user_op::OpKernel {
     CHECK_EQ(tensor_bytes_size, val_tensor_bytes_size);
     AutoMemcpy(ctx->device_ctx(), ref_tensor->mut_dptr(), value_tensor->dptr(), tensor_bytes_size,
                ref_tensor->mem_case(), value_tensor->mem_case());
+    IncreaseVariableVersion();
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
 };
@@ -0,0 +1,187 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <cmath>
+#include "oneflow/user/kernels/cpu_int8_gemm.h"
+#include "oneflow/core/common/cpu_isa.h"
+#include "oneflow/core/framework/multi_thread.h"
+
+namespace oneflow {
+
+namespace {
+
+constexpr int kNr = 16;
+constexpr int kMaxMr = 8;
+constexpr int32_t kSymmetricShift = 128;
+constexpr int64_t kParallelOpThreshold = 1 << 21;
+static_assert(kNr == CpuInt8Gemm::kNr, "");
+
+template<int mr>
+void Int8MicroKernelGeneric(int k4, const uint8_t* a, const int8_t* b, int32_t* acc) {
+  std::fill(acc, acc + mr * kNr, 0);
+  FOR_RANGE(int, kk, 0, k4 / 4) {
+    FOR_RANGE(int, i, 0, mr) {
+      const uint8_t* a_quad = a + i * 4;
+      int32_t* acc_row = acc + i * kNr;
+      FOR_RANGE(int, j, 0, kNr) {
+        const int8_t* b_quad = b + j * 4;
+        acc_row[j] += static_cast<int32_t>(a_quad[0]) * b_quad[0]
+                      + static_cast<int32_t>(a_quad[1]) * b_quad[1]
+                      + static_cast<int32_t>(a_quad[2]) * b_quad[2]
+                      + static_cast<int32_t>(a_quad[3]) * b_quad[3];
+      }
+    }
+    a += mr * 4;
+    b += kNr * 4;
+  }
+}
+
+#ifdef OF_CPU_ISA_VNNI_DISPATCH
+
+OF_CPU_TARGET_AVX512_VNNI void Int8MicroKernel8x16Vnni(int k4, const uint8_t* a, const int8_t* b,
+                                                       int32_t* acc) {
+  __m512i c[8];
+  for (int i = 0; i < 8; ++i) { c[i] = _mm512_setzero_si512(); }
+  for (int kk = 0; kk < k4 / 4; ++kk) {
+    const __m512i b_val = _mm512_loadu_si512(b);
+    for (int i = 0; i < 8; ++i) {
+      int32_t a_quad;
+      std::memcpy(&a_quad, a + i * 4, sizeof(int32_t));
+      c[i] = _mm512_dpbusd_epi32(c[i], _mm512_set1_epi32(a_quad), b_val);
+    }
+    a += 8 * 4;
+    b += kNr * 4;
+  }
+  for (int i = 0; i < 8; ++i) { _mm512_storeu_si512(acc + i * kNr, c[i]); }
+}
+
+#endif  // OF_CPU_ISA_VNNI_DISPATCH
+
+}  // namespace
+
+const int CpuInt8Gemm::kNr;
+const int CpuInt8Gemm::kMc;
+
+CpuInt8Gemm::CpuInt8Gemm() : k_(0), k4_(0), n_(0), num_panels_(0) {
+  mr_ = 4;
+  micro_kernel_ = &Int8MicroKernelGeneric<4>;
+#ifdef OF_CPU_ISA_VNNI_DISPATCH
+  if (CpuSupportsAvx512Vnni()) {
+    mr_ = 8;
+    micro_kernel_ = &Int8MicroKernel8x16Vnni;
+  }
+#endif
+  CHECK_LE(mr_, kMaxMr);
+  CHECK_EQ(kMc % mr_, 0);
+}
+
+void CpuInt8Gemm::PackB(enum CBLAS_TRANSPOSE trans_b, int k, int n, const int8_t* b) {
+  k_ = k;
+  k4_ = RoundUp(k, 4);
+  n_ = n;
+  num_panels_ = RoundUp(n, kNr) / kNr;
+  packed_b_.assign(static_cast<size_t>(num_panels_) * kNr * k4_, 0);
+  b_col_sum_.assign(num_panels_ * kNr, 0);
+  FOR_RANGE(int, p, 0, k) {
+    FOR_RANGE(int, j, 0, n) {
+      const int8_t val = trans_b == CblasNoTrans ? b[static_cast<size_t>(p) * n + j]
+                                                 : b[static_cast<size_t>(j) * k + p];
+      const int panel = j / kNr;
+      const int col = j % kNr;
+      packed_b_[(static_cast<size_t>(panel) * k4_ + (p / 4) * 4) * kNr + col * 4 + p % 4] = val;
+      b_col_sum_[j] += val;
+    }
+  }
+}
+
+void CpuInt8Gemm::PackA(int m, const uint8_t* a) {
+  const int num_row_panels = RoundUp(m, mr_) / mr_;
+  packed_a_.assign(static_cast<size_t>(num_row_panels) * mr_ * k4_, 0);
+  FOR_RANGE(int, i, 0, m) {
+    uint8_t* dst = packed_a_.data() + static_cast<size_t>(i / mr_) * mr_ * k4_ + (i % mr_) * 4;
+    const uint8_t* src = a + static_cast<size_t>(i) * k_;
+    FOR_RANGE(int, p, 0, k_) { dst[(p / 4) * mr_ * 4 + p % 4] = src[p]; }
+  }
+}
+
+void CpuInt8Gemm::Gemm(int m, const uint8_t* a, int32_t* c) {
+  CHECK_GT(k_, 0);
+  PackA(m, a);
+  const int num_m_blocks = RoundUp(m, kMc) / kMc;
+  // one task computes a kMc x kNr strip of c
+  auto ComputeStrip = [&](size_t task_id) {
+    const int m_block = task_id / num_panels_;
+    const int panel = task_id % num_panels_;
+    const int8_t* b_panel = packed_b_.data() + static_cast<size_t>(panel) * k4_ * kNr;
+    const int j_begin = panel * kNr;
+    const int nr = std::min(n_ - j_begin, static_cast<int>(kNr));
+    const int i_end = std::min(m, (m_block + 1) * static_cast<int>(kMc));
+    int32_t acc[kMaxMr * kNr];
+    for (int i_begin = m_block * kMc; i_begin < i_end; i_begin += mr_) {
+      micro_kernel_(k4_, packed_a_.data() + static_cast<size_t>(i_begin) * k4_, b_panel, acc);
+      FOR_RANGE(int, i, 0, std::min(i_end - i_begin, mr_)) {
+        int32_t* c_row = c + static_cast<size_t>(i_begin + i) * n_ + j_begin;
+        FOR_RANGE(int, j, 0, nr) { c_row[j] = acc[i * kNr + j]; }
+      }
+    }
+  };
+  const size_t num_tasks = static_cast<size_t>(num_m_blocks) * num_panels_;
+  if (2LL * m * n_ * k_ >= kParallelOpThreshold && num_tasks > 1) {
+    user_op::MultiThreadLoopInOpKernel(num_tasks, ComputeStrip);
+  } else {
+    FOR_RANGE(size_t, task_id, 0, num_tasks) { ComputeStrip(task_id); }
+  }
+}
+
+void QuantizeSymmetric(const float* in, float scale, int32_t quantization_bit, int64_t n,
+                       int8_t* out) {
+  const float upper_bound = static_cast<float>(std::pow(2.0, quantization_bit - 1)) - 1;
+  const float lower_bound = -upper_bound;
+  FOR_RANGE(int64_t, i, 0, n) {
+    float val = std::round(in[i] / scale);
+    val = val > upper_bound ? upper_bound : val;
+    val = val < lower_bound ? lower_bound : val;
+    out[i] = static_cast<int8_t>(val);
+  }
+}
+
+void QuantizeToUint8(const float* in, float scale, float zero_point,
+                     const std::string& quantization_scheme, int32_t quantization_bit, int64_t n,
+                     uint8_t* out) {
+  float upper_bound = 0;
+  float lower_bound = 0;
+  float shift = 0;
+  if (quantization_scheme == "symmetric") {
+    upper_bound = static_cast<float>(std::pow(2.0, quantization_bit - 1)) - 1;
+    lower_bound = -upper_bound;
+    shift = kSymmetricShift;
+    zero_point = 0;
+  } else {
+    upper_bound = static_cast<float>(std::pow(2.0, quantization_bit)) - 1;
+    lower_bound = 0;
+  }
+  FOR_RANGE(int64_t, i, 0, n) {
+    float val = std::round(in[i] / scale + zero_point);
+    val = val > upper_bound ? upper_bound : val;
+    val = val < lower_bound ? lower_bound : val;
+    out[i] = static_cast<uint8_t>(val + shift);
+  }
+}
+
+float Uint8ZeroPoint(float zero_point, const std::string& quantization_scheme) {
+  return quantization_scheme == "symmetric" ? static_cast<float>(kSymmetricShift) : zero_point;
+}
+
+}  // namespace oneflow
@@ -0,0 +1,74 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_CPU_INT8_GEMM_H_
+#define ONEFLOW_USER_KERNELS_CPU_INT8_GEMM_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/cblas.h"
+
+namespace oneflow {
+
+// Exact int32 = uint8 x int8 row-major gemm with a right hand side packed once.
+//
+// The operand types match the u8s8 dot product instruction of AVX512-VNNI, which is used when
+// the cpu has it. k is padded to a multiple of 4 and b is stored as panels of kNr columns with 4
+// consecutive k per column. The column sums of b are kept so that callers can fold the zero point
+// of a: sum((a - zp) * b) == c - zp * b_col_sum.
+class CpuInt8Gemm final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuInt8Gemm);
+  CpuInt8Gemm();
+  ~CpuInt8Gemm() = default;
+
+  static const int kNr = 16;
+  static const int kMc = 64;
+
+  void PackB(enum CBLAS_TRANSPOSE trans_b, int k, int n, const int8_t* b);
+  // c = a * op(b), a is m x k and c is m x n
+  void Gemm(int m, const uint8_t* a, int32_t* c);
+
+  int k() const { return k_; }
+  int n() const { return n_; }
+  const int32_t* b_col_sum() const { return b_col_sum_.data(); }
+
+ private:
+  void PackA(int m, const uint8_t* a);
+
+  int k_;
+  int k4_;
+  int n_;
+  int num_panels_;
+  int mr_;
+  void (*micro_kernel_)(int k4, const uint8_t* a, const int8_t* b, int32_t* acc);
+  std::vector<int8_t> packed_b_;
+  std::vector<int32_t> b_col_sum_;
+  std::vector<uint8_t> packed_a_;
+};
+
+// Quantize in the same way as fake_quantization. Weights use the symmetric scheme and are stored as
+// int8. Activations are stored as uint8 with an integer zero point, the symmetric values are
+// shifted by 128 and the affine ones are stored as is.
+void QuantizeSymmetric(const float* in, float scale, int32_t quantization_bit, int64_t n,
+                       int8_t* out);
+void QuantizeToUint8(const float* in, float scale, float zero_point,
+                     const std::string& quantization_scheme, int32_t quantization_bit, int64_t n,
+                     uint8_t* out);
+// the zero point to fold for the values written by QuantizeToUint8
+float Uint8ZeroPoint(float zero_point, const std::string& quantization_scheme);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_CPU_INT8_GEMM_H_
@@ -0,0 +1,223 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/cpu_packed_gemm.h"
+#include "oneflow/core/common/cpu_isa.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/framework/multi_thread.h"
+
+namespace oneflow {
+
+namespace {
+
+constexpr int kNr = 16;
+constexpr int kMaxMr = 12;
+static_assert(kNr == CpuPackedGemm<float>::kNr, "");
+constexpr int64_t kParallelFlopThreshold = 1 << 21;
+
+template<typename T, int mr>
+void MicroKernelGeneric(int kc, const T* a, const T* b, T* acc) {
+  std::fill(acc, acc + mr * kNr, GetZeroVal<T>());
+  FOR_RANGE(int, p, 0, kc) {
+    FOR_RANGE(int, i, 0, mr) {
+      const T a_val = a[i];
+      T* acc_row = acc + i * kNr;
+      FOR_RANGE(int, j, 0, kNr) { acc_row[j] += a_val * b[j]; }
+    }
+    a += mr;
+    b += kNr;
+  }
+}
+
+#ifdef OF_CPU_ISA_DISPATCH
+
+OF_CPU_TARGET_AVX2 void SgemmMicroKernel6x16Avx2(int kc, const float* a, const float* b,
+                                                 float* acc) {
+  __m256 c_lo[6];
+  __m256 c_hi[6];
+  for (int i = 0; i < 6; ++i) {
+    c_lo[i] = _mm256_setzero_ps();
+    c_hi[i] = _mm256_setzero_ps();
+  }
+  for (int p = 0; p < kc; ++p) {
+    const __m256 b_lo = _mm256_loadu_ps(b);
+    const __m256 b_hi = _mm256_loadu_ps(b + 8);
+    for (int i = 0; i < 6; ++i) {
+      const __m256 a_val = _mm256_broadcast_ss(a + i);
+      c_lo[i] = _mm256_fmadd_ps(a_val, b_lo, c_lo[i]);
+      c_hi[i] = _mm256_fmadd_ps(a_val, b_hi, c_hi[i]);
+    }
+    a += 6;
+    b += kNr;
+  }
+  for (int i = 0; i < 6; ++i) {
+    _mm256_storeu_ps(acc + i * kNr, c_lo[i]);
+    _mm256_storeu_ps(acc + i * kNr + 8, c_hi[i]);
+  }
+}
+
+OF_CPU_TARGET_AVX512 void SgemmMicroKernel12x16Avx512(int kc, const float* a, const float* b,
+                                                      float* acc) {
+  __m512 c[12];
+  for (int i = 0; i < 12; ++i) { c[i] = _mm512_setzero_ps(); }
+  for (int p = 0; p < kc; ++p) {
+    const __m512 b_val = _mm512_loadu_ps(b);
+    for (int i = 0; i < 12; ++i) { c[i] = _mm512_fmadd_ps(_mm512_set1_ps(a[i]), b_val, c[i]); }
+    a += 12;
+    b += kNr;
+  }
+  for (int i = 0; i < 12; ++i) { _mm512_storeu_ps(acc + i * kNr, c[i]); }
+}
+
+#endif  // OF_CPU_ISA_DISPATCH
+
+template<typename T>
+void SelectMicroKernel(int* mr, void (**micro_kernel)(int, const T*, const T*, T*)) {
+  *mr = 4;
+  *micro_kernel = &MicroKernelGeneric<T, 4>;
+}
+
+template<>
+void SelectMicroKernel<float>(int* mr, void (**micro_kernel)(int, const float*, const float*,
+                                                             float*)) {
+#ifdef OF_CPU_ISA_DISPATCH
+  if (CpuSupportsAvx512()) {
+    *mr = 12;
+    *micro_kernel = &SgemmMicroKernel12x16Avx512;
+    return;
+  }
+  if (CpuSupportsAvx2()) {
+    *mr = 6;
+    *micro_kernel = &SgemmMicroKernel6x16Avx2;
+    return;
+  }
+#endif
+  *mr = 8;
+  *micro_kernel = &MicroKernelGeneric<float, 8>;
+}
+
+template<typename T>
+void StoreTile(const T* acc, int mr, int nr, T alpha, T beta, T* c, int ldc) {
+  FOR_RANGE(int, i, 0, mr) {
+    const T* acc_row = acc + i * kNr;
+    T* c_row = c + i * ldc;
+    if (beta == GetZeroVal<T>()) {
+      FOR_RANGE(int, j, 0, nr) { c_row[j] = alpha * acc_row[j]; }
+    } else {
+      FOR_RANGE(int, j, 0, nr) { c_row[j] = alpha * acc_row[j] + beta * c_row[j]; }
+    }
+  }
+}
+
+}  // namespace
+
+template<typename T>
+const int CpuPackedGemm<T>::kNr;
+template<typename T>
+const int CpuPackedGemm<T>::kKc;
+template<typename T>
+const int CpuPackedGemm<T>::kMc;
+
+template<typename T>
+CpuPackedGemm<T>::CpuPackedGemm() : k_(0), n_(0), num_panels_(0) {
+  SelectMicroKernel<T>(&mr_, &micro_kernel_);
+  CHECK_LE(mr_, kMaxMr);
+  CHECK_EQ(kMc % mr_, 0);
+}
+
+template<typename T>
+void CpuPackedGemm<T>::PackB(enum CBLAS_TRANSPOSE trans_b, int k, int n, const T* b) {
+  k_ = k;
+  n_ = n;
+  num_panels_ = RoundUp(n, kNr) / kNr;
+  const int n_pad = num_panels_ * kNr;
+  packed_b_.assign(static_cast<size_t>(k) * n_pad, GetZeroVal<T>());
+  for (int pc = 0; pc < k; pc += kKc) {
+    const int kc = std::min(k - pc, static_cast<int>(kKc));
+    T* block = packed_b_.data() + static_cast<size_t>(pc) * n_pad;
+    FOR_RANGE(int, panel, 0, num_panels_) {
+      T* dst = block + static_cast<size_t>(panel) * kc * kNr;
+      const int j_begin = panel * kNr;
+      const int nr = std::min(n - j_begin, static_cast<int>(kNr));
+      FOR_RANGE(int, p, 0, kc) {
+        FOR_RANGE(int, j, 0, nr) {
+          dst[p * kNr + j] = trans_b == CblasNoTrans
+                                 ? b[static_cast<size_t>(pc + p) * n + j_begin + j]
+                                 : b[static_cast<size_t>(j_begin + j) * k + pc + p];
+        }
+      }
+    }
+  }
+}
+
+template<typename T>
+void CpuPackedGemm<T>::PackA(enum CBLAS_TRANSPOSE trans_a, int m, int pc, int kc, const T* a) {
+  const int num_row_panels = RoundUp(m, mr_) / mr_;
+  packed_a_.resize(static_cast<size_t>(num_row_panels) * mr_ * kc);
+  FOR_RANGE(int, panel, 0, num_row_panels) {
+    T* dst = packed_a_.data() + static_cast<size_t>(panel) * mr_ * kc;
+    const int i_begin = panel * mr_;
+    const int mr = std::min(m - i_begin, mr_);
+    FOR_RANGE(int, p, 0, kc) {
+      FOR_RANGE(int, i, 0, mr) {
+        dst[p * mr_ + i] = trans_a == CblasNoTrans
+                               ? a[static_cast<size_t>(i_begin + i) * k_ + pc + p]
+                               : a[static_cast<size_t>(pc + p) * m + i_begin + i];
+      }
+      FOR_RANGE(int, i, mr, mr_) { dst[p * mr_ + i] = GetZeroVal<T>(); }
+    }
+  }
+}
+
+template<typename T>
+void CpuPackedGemm<T>::Gemm(enum CBLAS_TRANSPOSE trans_a, int m, T alpha, const T* a, T beta,
+                            T* c) {
+  CHECK_GT(k_, 0);
+  const int n_pad = num_panels_ * kNr;
+  const int num_m_blocks = RoundUp(m, kMc) / kMc;
+  for (int pc = 0; pc < k_; pc += kKc) {
+    const int kc = std::min(k_ - pc, static_cast<int>(kKc));
+    const T cur_beta = pc == 0 ? beta : GetOneVal<T>();
+    PackA(trans_a, m, pc, kc, a);
+    const T* b_block = packed_b_.data() + static_cast<size_t>(pc) * n_pad;
+    // one task computes a kMc x kNr strip of c
+    auto ComputeStrip = [&](size_t task_id) {
+      const int m_block = task_id / num_panels_;
+      const int panel = task_id % num_panels_;
+      const T* b_panel = b_block + static_cast<size_t>(panel) * kc * kNr;
+      const int j_begin = panel * kNr;
+      const int nr = std::min(n_ - j_begin, static_cast<int>(kNr));
+      const int i_end = std::min(m, (m_block + 1) * static_cast<int>(kMc));
+      T acc[kMaxMr * kNr];
+      for (int i_begin = m_block * kMc; i_begin < i_end; i_begin += mr_) {
+        const T* a_panel = packed_a_.data() + static_cast<size_t>(i_begin) * kc;
+        micro_kernel_(kc, a_panel, b_panel, acc);
+        StoreTile<T>(acc, std::min(i_end - i_begin, mr_), nr, alpha, cur_beta,
+                     c + static_cast<size_t>(i_begin) * n_ + j_begin, n_);
+      }
+    };
+    const size_t num_tasks = static_cast<size_t>(num_m_blocks) * num_panels_;
+    if (2LL * m * n_ * kc >= kParallelFlopThreshold && num_tasks > 1) {
+      user_op::MultiThreadLoopInOpKernel(num_tasks, ComputeStrip);
+    } else {
+      FOR_RANGE(size_t, task_id, 0, num_tasks) { ComputeStrip(task_id); }
+    }
+  }
+}
+
+template class CpuPackedGemm<float>;
+template class CpuPackedGemm<double>;
+
+}  // namespace oneflow
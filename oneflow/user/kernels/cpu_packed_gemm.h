@@ -0,0 +1,62 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_CPU_PACKED_GEMM_H_
+#define ONEFLOW_USER_KERNELS_CPU_PACKED_GEMM_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/cblas.h"
+
+namespace oneflow {
+
+// Row-major gemm whose right hand side is packed once and reused by every call.
+//
+// op(b) (k x n) is stored as column panels of kNr values, blocked by kKc rows, so that the
+// micro-kernel streams it contiguously. op(a) is packed per call. The micro-kernel is chosen at
+// runtime: AVX-512 or AVX2/FMA for float when the cpu has them, a portable one otherwise.
+template<typename T>
+class CpuPackedGemm final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuPackedGemm);
+  CpuPackedGemm();
+  ~CpuPackedGemm() = default;
+
+  static const int kNr = 16;
+  static const int kKc = 256;
+  static const int kMc = 96;
+
+  void PackB(enum CBLAS_TRANSPOSE trans_b, int k, int n, const T* b);
+  // c = alpha * op(a) * op(b) + beta * c, with ldc == n
+  void Gemm(enum CBLAS_TRANSPOSE trans_a, int m, T alpha, const T* a, T beta, T* c);
+
+  int k() const { return k_; }
+  int n() const { return n_; }
+  int mr() const { return mr_; }
+
+ private:
+  void PackA(enum CBLAS_TRANSPOSE trans_a, int m, int pc, int kc, const T* a);
+
+  int k_;
+  int n_;
+  int num_panels_;
+  int mr_;
+  void (*micro_kernel_)(int kc, const T* a, const T* b, T* acc);
+  std::vector<T> packed_b_;
+  std::vector<T> packed_a_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_CPU_PACKED_GEMM_H_
@@ -0,0 +1,80 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/fused_elementwise_util.h"
+
+namespace oneflow {
+
+namespace {
+
+// All the steps run on a tile before moving to the next one, so the intermediates stay in L1
+constexpr int64_t kFusedElementwiseCpuTileSize = 512;
+
+}  // namespace
+
+template<typename T>
+class FusedElementwiseCpuKernel final : public user_op::OpKernel {
+ public:
+  FusedElementwiseCpuKernel() = default;
+  ~FusedElementwiseCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    FusedElementwiseExpr expr;
+    MakeFusedElementwiseExpr(ctx, &expr);
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    std::vector<const T*> operands(ctx->user_op_conf().input_size("in"));
+    FOR_RANGE(int32_t, i, 1, operands.size()) {
+      operands.at(i) = ctx->Tensor4ArgNameAndIndex("in", i)->dptr<T>();
+    }
+    const int64_t elem_cnt = in->shape().elem_cnt();
+    const T* in_ptr = in->dptr<T>();
+    T* out_ptr = out->mut_dptr<T>();
+    T tile[kFusedElementwiseCpuTileSize];
+    for (int64_t begin = 0; begin < elem_cnt; begin += kFusedElementwiseCpuTileSize) {
+      const int64_t n = std::min(kFusedElementwiseCpuTileSize, elem_cnt - begin);
+      FOR_RANGE(int64_t, j, 0, n) { tile[j] = in_ptr[begin + j]; }
+      FOR_RANGE(int32_t, s, 0, expr.num_steps) {
+        const FusedElementwiseStep& step = expr.steps[s];
+        if (step.type == FusedElementwiseStepType::kBiasAdd) {
+          const T* operand = operands.at(step.operand);
+          FOR_RANGE(int64_t, j, 0, n) {
+            tile[j] = ApplyFusedElementwiseStep<T>(
+                step, tile[j], operand[FusedElementwiseOperandOffset(step, begin + j)]);
+          }
+        } else {
+          FOR_RANGE(int64_t, j, 0, n) {
+            tile[j] = ApplyFusedElementwiseStep<T>(step, tile[j], static_cast<T>(0));
+          }
+        }
+      }
+      FOR_RANGE(int64_t, j, 0, n) { out_ptr[begin + j] = tile[j]; }
+    }
+  };
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FUSED_ELEMENTWISE_CPU_KERNEL(dtype)      \
+  REGISTER_USER_KERNEL("fused_elementwise")               \
+      .SetCreateFn<FusedElementwiseCpuKernel<dtype>>()    \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu") \
+                       & (user_op::HobDataType("out", 0) == GetDataType<dtype>::value));
+
+REGISTER_FUSED_ELEMENTWISE_CPU_KERNEL(float)
+REGISTER_FUSED_ELEMENTWISE_CPU_KERNEL(double)
+
+}  // namespace oneflow
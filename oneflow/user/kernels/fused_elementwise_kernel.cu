@@ -0,0 +1,103 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/fused_elementwise_util.h"
+
+namespace oneflow {
+
+namespace {
+
+template<typename T>
+struct FusedElementwiseOperands {
+  const T* ptrs[kFusedElementwiseMaxNumOperands + 1];
+};
+
+// half is computed in float
+template<typename T>
+struct FusedElementwiseComputeType {
+  using type = T;
+  static __device__ __forceinline__ T From(const T x) { return x; }
+  static __device__ __forceinline__ T To(const T x) { return x; }
+};
+
+template<>
+struct FusedElementwiseComputeType<half> {
+  using type = float;
+  static __device__ __forceinline__ float From(const half x) { return __half2float(x); }
+  static __device__ __forceinline__ half To(const float x) { return __float2half(x); }
+};
+
+template<typename T>
+__global__ void FusedElementwiseGpu(const int n, const FusedElementwiseExpr expr,
+                                    const FusedElementwiseOperands<T> operands, const T* in,
+                                    T* out) {
+  using Trait = FusedElementwiseComputeType<T>;
+  using ComputeType = typename Trait::type;
+  CUDA_1D_KERNEL_LOOP(i, n) {
+    ComputeType value = Trait::From(in[i]);
+    for (int32_t s = 0; s < expr.num_steps; ++s) {
+      const FusedElementwiseStep& step = expr.steps[s];
+      ComputeType operand = 0;
+      if (step.type == FusedElementwiseStepType::kBiasAdd) {
+        operand = Trait::From(operands.ptrs[step.operand][FusedElementwiseOperandOffset(step, i)]);
+      }
+      value = ApplyFusedElementwiseStep<ComputeType>(step, value, operand);
+    }
+    out[i] = Trait::To(value);
+  }
+}
+
+}  // namespace
+
+template<typename T>
+class FusedElementwiseGpuKernel final : public user_op::OpKernel {
+ public:
+  FusedElementwiseGpuKernel() = default;
+  ~FusedElementwiseGpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    FusedElementwiseExpr expr;
+    MakeFusedElementwiseExpr(ctx, &expr);
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const int32_t num_inputs = ctx->user_op_conf().input_size("in");
+    CHECK_LE(num_inputs, kFusedElementwiseMaxNumOperands + 1);
+    FusedElementwiseOperands<T> operands;
+    operands.ptrs[0] = nullptr;
+    FOR_RANGE(int32_t, i, 1, num_inputs) {
+      operands.ptrs[i] = ctx->Tensor4ArgNameAndIndex("in", i)->dptr<T>();
+    }
+    const int64_t n = in->shape().elem_cnt();
+    CHECK_LE(n, GetMaxVal<int32_t>() / 2);
+    FusedElementwiseGpu<T>
+        <<<BlocksNum4ThreadsNum(n), kCudaThreadsNumPerBlock, 0, ctx->device_ctx()->cuda_stream()>>>(
+            n, expr, operands, in->dptr<T>(), out->mut_dptr<T>());
+  };
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FUSED_ELEMENTWISE_GPU_KERNEL(dtype)      \
+  REGISTER_USER_KERNEL("fused_elementwise")               \
+      .SetCreateFn<FusedElementwiseGpuKernel<dtype>>()    \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "gpu") \
+                       & (user_op::HobDataType("out", 0) == GetDataType<dtype>::value));
+
+REGISTER_FUSED_ELEMENTWISE_GPU_KERNEL(float)
+REGISTER_FUSED_ELEMENTWISE_GPU_KERNEL(double)
+REGISTER_FUSED_ELEMENTWISE_GPU_KERNEL(half)
+
+}  // namespace oneflow
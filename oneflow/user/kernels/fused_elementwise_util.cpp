@@ -0,0 +1,69 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/fused_elementwise_util.h"
+
+namespace oneflow {
+
+namespace {
+
+const HashMap<std::string, FusedElementwiseStepType>& StepType4OpTypeName() {
+#define MAKE_FUSED_ELEMENTWISE_MATH_STEP_ENTRY(op_type_name, func_prefix) \
+  {op_type_name, FusedElementwiseStepType::kMath##func_prefix},
+
+  static const HashMap<std::string, FusedElementwiseStepType> step_type4op_type_name = {
+      {"relu", FusedElementwiseStepType::kRelu},
+      {"leaky_relu", FusedElementwiseStepType::kLeakyRelu},
+      {"gelu", FusedElementwiseStepType::kGelu},
+      {"sigmoid", FusedElementwiseStepType::kMathSigmoid},
+      {"scalar_add", FusedElementwiseStepType::kScalarAdd},
+      {"scalar_mul", FusedElementwiseStepType::kScalarMul},
+      {"bias_add", FusedElementwiseStepType::kBiasAdd},
+      OF_PP_FOR_EACH_TUPLE(MAKE_FUSED_ELEMENTWISE_MATH_STEP_ENTRY,
+                           MATH_UNARY_ELEMENTWISE_FUNC_SEQ)};
+  return step_type4op_type_name;
+
+#undef MAKE_FUSED_ELEMENTWISE_MATH_STEP_ENTRY
+}
+
+}  // namespace
+
+void MakeFusedElementwiseExpr(user_op::KernelComputeContext* ctx, FusedElementwiseExpr* expr) {
+  const auto& op_type_names = ctx->Attr<std::vector<std::string>>("op_type_names");
+  const auto& scalars = ctx->Attr<std::vector<float>>("scalars");
+  const auto& axes = ctx->Attr<std::vector<int32_t>>("axes");
+  const ShapeView& in_shape = ctx->Tensor4ArgNameAndIndex("in", 0)->shape();
+  CHECK_LE(op_type_names.size(), kFusedElementwiseMaxNumSteps);
+  expr->num_steps = op_type_names.size();
+  int32_t operand = 1;
+  FOR_RANGE(int32_t, i, 0, expr->num_steps) {
+    FusedElementwiseStep* step = &expr->steps[i];
+    step->type = StepType4OpTypeName().at(op_type_names.at(i));
+    step->scalar = scalars.at(i);
+    step->operand = -1;
+    step->operand_size = 1;
+    step->inner_size = 1;
+    if (step->type == FusedElementwiseStepType::kBiasAdd) {
+      const int32_t axis = axes.at(i);
+      step->operand = operand;
+      step->operand_size = in_shape.At(axis);
+      step->inner_size = in_shape.Count(axis + 1);
+      operand += 1;
+    }
+  }
+  CHECK_EQ(operand, ctx->user_op_conf().input_size("in"));
+}
+
+}  // namespace oneflow
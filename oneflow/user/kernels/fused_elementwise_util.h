@@ -0,0 +1,93 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_FUSED_ELEMENTWISE_UTIL_H_
+#define ONEFLOW_USER_KERNELS_FUSED_ELEMENTWISE_UTIL_H_
+
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/kernels/math_unary_elementwise_func.h"
+
+namespace oneflow {
+
+constexpr int32_t kFusedElementwiseMaxNumSteps = 16;
+// Operands of the bias_add steps, they follow the fused input as in_1, in_2 ...
+constexpr int32_t kFusedElementwiseMaxNumOperands = 4;
+
+#define MAKE_FUSED_ELEMENTWISE_MATH_STEP_TYPE(op_type_name, func_prefix) kMath##func_prefix,
+
+enum class FusedElementwiseStepType : int32_t {
+  kRelu = 0,
+  kLeakyRelu,
+  kGelu,
+  kScalarAdd,
+  kScalarMul,
+  kBiasAdd,
+  OF_PP_FOR_EACH_TUPLE(MAKE_FUSED_ELEMENTWISE_MATH_STEP_TYPE, MATH_UNARY_ELEMENTWISE_FUNC_SEQ)
+};
+
+#undef MAKE_FUSED_ELEMENTWISE_MATH_STEP_TYPE
+
+struct FusedElementwiseStep {
+  FusedElementwiseStepType type;
+  // operand of the scalar ops, or alpha of leaky_relu
+  float scalar;
+  // the following are only used by bias_add, whose operand is in_{operand} and broadcast along
+  // all the axes except one of size operand_size, which has inner_size elements after it
+  int32_t operand;
+  int64_t operand_size;
+  int64_t inner_size;
+};
+
+// Trivially copyable so that it could be passed to a cuda kernel by value
+struct FusedElementwiseExpr {
+  int32_t num_steps;
+  FusedElementwiseStep steps[kFusedElementwiseMaxNumSteps];
+};
+
+// Builds the expression from the attrs of a fused_elementwise op and the shape of in_0
+void MakeFusedElementwiseExpr(user_op::KernelComputeContext* ctx, FusedElementwiseExpr* expr);
+
+OF_DEVICE_FUNC int64_t FusedElementwiseOperandOffset(const FusedElementwiseStep& step,
+                                                     int64_t i) {
+  return (i / step.inner_size) % step.operand_size;
+}
+
+// `operand` is only read by bias_add
+template<typename T>
+OF_DEVICE_FUNC T ApplyFusedElementwiseStep(const FusedElementwiseStep& step, const T x,
+                                           const T operand) {
+#define MAKE_FUSED_ELEMENTWISE_MATH_STEP_CASE(op_type_name, func_prefix) \
+  case FusedElementwiseStepType::kMath##func_prefix: return func_prefix##Functor<T>::Forward(x);
+
+  switch (step.type) {
+    case FusedElementwiseStepType::kRelu: return x > static_cast<T>(0) ? x : static_cast<T>(0);
+    case FusedElementwiseStepType::kLeakyRelu:
+      return x > static_cast<T>(0) ? x : x * static_cast<T>(step.scalar);
+    case FusedElementwiseStepType::kGelu:
+      return static_cast<T>(0.5) * x
+             * (static_cast<T>(1) + ErfFunctor<T>::Forward(x * static_cast<T>(M_SQRT1_2)));
+    case FusedElementwiseStepType::kScalarAdd: return x + static_cast<T>(step.scalar);
+    case FusedElementwiseStepType::kScalarMul: return x * static_cast<T>(step.scalar);
+    case FusedElementwiseStepType::kBiasAdd: return x + operand;
+      OF_PP_FOR_EACH_TUPLE(MAKE_FUSED_ELEMENTWISE_MATH_STEP_CASE, MATH_UNARY_ELEMENTWISE_FUNC_SEQ)
+    default: return x;
+  }
+
+#undef MAKE_FUSED_ELEMENTWISE_MATH_STEP_CASE
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_FUSED_ELEMENTWISE_UTIL_H_
@@ -0,0 +1,277 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/common/cpu_isa.h"
+#include "oneflow/core/common/tensor_buffer.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/image/image_util.h"
+#include "oneflow/user/image/jpeg_decoder.h"
+#include "oneflow/user/kernels/random_crop_kernel_state.h"
+
+namespace oneflow {
+
+namespace {
+
+enum TensorLayout {
+  kNCHW = 0,
+  kNHWC = 1,
+};
+
+// The vectorized normalization reads up to 4 bytes past the last pixel of the resized image
+constexpr size_t kResizedImagePadding = 16;
+
+class DecodeRandomCropResizeNormalizeState final : public user_op::OpKernelState {
+ public:
+  explicit DecodeRandomCropResizeNormalizeState(user_op::KernelInitContext* ctx)
+      : random_crop_state_(CreateRandomCropKernelState(ctx)) {
+    const std::vector<float>& mean_vec = ctx->Attr<std::vector<float>>("mean");
+    const std::vector<float>& std_vec = ctx->Attr<std::vector<float>>("std");
+    const int64_t C = ImageUtil::IsColor(ctx->Attr<std::string>("color_space")) ? 3 : 1;
+    // (x - mean) / std is computed as x * scale + bias
+    FOR_RANGE(int64_t, c, 0, C) {
+      const float mean = mean_vec.size() == 1 ? mean_vec.at(0) : mean_vec.at(c);
+      const float inv_std = 1.0f / (std_vec.size() == 1 ? std_vec.at(0) : std_vec.at(c));
+      scale_vec_.push_back(inv_std);
+      bias_vec_.push_back(-mean * inv_std);
+    }
+  }
+  ~DecodeRandomCropResizeNormalizeState() = default;
+
+  RandomCropGenerator* GetGenerator(int32_t idx) { return random_crop_state_->GetGenerator(idx); }
+  const std::vector<float>& scale_vec() const { return scale_vec_; }
+  const std::vector<float>& bias_vec() const { return bias_vec_; }
+
+ private:
+  std::shared_ptr<RandomCropKernelState> random_crop_state_;
+  std::vector<float> scale_vec_;
+  std::vector<float> bias_vec_;
+};
+
+// The resized image of each worker thread is kept to be reused by its next image
+cv::Mat ThisThreadResizedImage(int height, int width, int channels) {
+  thread_local std::vector<unsigned char> buffer;
+  const size_t size = static_cast<size_t>(height) * width * channels + kResizedImagePadding;
+  if (buffer.size() < size) { buffer.resize(size); }
+  return cv::Mat(height, width, CV_8UC(channels), buffer.data());
+}
+
+cv::Mat DecodeRandomCropResize(const TensorBuffer& encoded, const std::string& color_space,
+                               RandomCropGenerator* crop_generator, int target_width,
+                               int target_height, const std::string& interp_type) {
+  const unsigned char* data = encoded.data<unsigned char>();
+  const size_t length = encoded.nbytes();
+  const bool is_color = ImageUtil::IsColor(color_space);
+  cv::Mat resized = ThisThreadResizedImage(target_height, target_width, is_color ? 3 : 1);
+  cv::Mat window;
+  CropWindow crop;
+  if (is_color
+      && JpegDecodeRandomCrop(data, length, crop_generator, target_width, target_height,
+                              color_space == "BGR", &window, &crop)) {
+    cv::resize(window, resized, resized.size(), 0, 0,
+               GetCvInterpolationFlag(interp_type, window.cols, window.rows, target_width,
+                                      target_height));
+    return resized;
+  }
+  cv::Mat image = cv::imdecode(cv::Mat(1, length, CV_8UC1, const_cast<unsigned char*>(data)),
+                               is_color ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE);
+  CHECK(image.data != nullptr);
+  // a window generated before the JPEG decode failed is reused, so that a seeded generator draws
+  // the same windows whether or not an image falls back to cv::imdecode
+  if (crop.shape.elem_cnt() == 0) {
+    crop_generator->GenerateCropWindow({image.rows, image.cols}, &crop);
+  }
+  window = image(cv::Rect(crop.anchor.At(1), crop.anchor.At(0), crop.shape.At(1),
+                          crop.shape.At(0)));
+  cv::resize(window, resized, resized.size(), 0, 0,
+             GetCvInterpolationFlag(interp_type, window.cols, window.rows, target_width,
+                                    target_height));
+  if (is_color && color_space != "BGR") {
+    ImageUtil::ConvertColor("BGR", resized, color_space, resized);
+  }
+  return resized;
+}
+
+template<TensorLayout layout>
+inline int64_t GetOffset(int64_t h, int64_t w, int64_t c, int64_t H, int64_t W, int64_t C);
+
+template<>
+inline int64_t GetOffset<TensorLayout::kNCHW>(int64_t h, int64_t w, int64_t c, int64_t H, int64_t W,
+                                              int64_t C) {
+  return c * H * W + h * W + w;
+}
+
+template<>
+inline int64_t GetOffset<TensorLayout::kNHWC>(int64_t h, int64_t w, int64_t c, int64_t H, int64_t W,
+                                              int64_t C) {
+  return h * W * C + w * C + c;
+}
+
+template<typename T, TensorLayout layout, bool mirror>
+void NormalizeImageGeneric(const cv::Mat& image, const float* scale, const float* bias, T* out) {
+  const int64_t H = image.rows;
+  const int64_t W = image.cols;
+  const int64_t C = image.channels();
+  FOR_RANGE(int64_t, h, 0, H) {
+    const uint8_t* row = image.ptr<uint8_t>(h);
+    FOR_RANGE(int64_t, w, 0, W) {
+      const uint8_t* pixel = row + (mirror ? W - 1 - w : w) * C;
+      FOR_RANGE(int64_t, c, 0, C) {
+        out[GetOffset<layout>(h, w, c, H, W, C)] =
+            static_cast<T>(static_cast<float>(pixel[c]) * scale[c] + bias[c]);
+      }
+    }
+  }
+}
+
+#ifdef OF_CPU_ISA_DISPATCH
+
+// Converts 8 pixels of a row at a time from HWC uint8 to CHW float. Each 16 byte load holds 4
+// pixels, whose bytes of one channel are gathered by a shuffle and widened to float.
+OF_CPU_TARGET_AVX2 void NormalizeImageToNCHWAvx2(const cv::Mat& image, bool mirror,
+                                                 const float* scale, const float* bias,
+                                                 float* out) {
+  const int64_t H = image.rows;
+  const int64_t W = image.cols;
+  __m128i masks[3];
+  __m256 scales[3];
+  __m256 biases[3];
+  FOR_RANGE(int, c, 0, 3) {
+    int8_t mask[16];
+    std::fill(mask, mask + 16, -1);
+    FOR_RANGE(int, j, 0, 4) { mask[j] = c + 3 * (mirror ? 3 - j : j); }
+    masks[c] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask));
+    scales[c] = _mm256_set1_ps(scale[c]);
+    biases[c] = _mm256_set1_ps(bias[c]);
+  }
+  FOR_RANGE(int64_t, h, 0, H) {
+    const uint8_t* row = image.ptr<uint8_t>(h);
+    int64_t w = 0;
+    for (; w + 8 <= W; w += 8) {
+      const __m128i first = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(row + (mirror ? W - 4 - w : w) * 3));
+      const __m128i second = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(row + (mirror ? W - 8 - w : w + 4) * 3));
+      FOR_RANGE(int, c, 0, 3) {
+        const __m128i bytes = _mm_unpacklo_epi32(_mm_shuffle_epi8(first, masks[c]),
+                                                 _mm_shuffle_epi8(second, masks[c]));
+        const __m256 values = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+        _mm256_storeu_ps(out + (c * H + h) * W + w,
+                         _mm256_fmadd_ps(values, scales[c], biases[c]));
+      }
+    }
+    for (; w < W; ++w) {
+      const uint8_t* pixel = row + (mirror ? W - 1 - w : w) * 3;
+      FOR_RANGE(int, c, 0, 3) {
+        out[(c * H + h) * W + w] = static_cast<float>(pixel[c]) * scale[c] + bias[c];
+      }
+    }
+  }
+}
+
+#endif  // OF_CPU_ISA_DISPATCH
+
+template<typename T, TensorLayout layout>
+struct NormalizeImageUtil {
+  static void Normalize(const cv::Mat& image, bool mirror, const float* scale, const float* bias,
+                        T* out) {
+    if (mirror) {
+      NormalizeImageGeneric<T, layout, true>(image, scale, bias, out);
+    } else {
+      NormalizeImageGeneric<T, layout, false>(image, scale, bias, out);
+    }
+  }
+};
+
+template<>
+struct NormalizeImageUtil<float, TensorLayout::kNCHW> {
+  static void Normalize(const cv::Mat& image, bool mirror, const float* scale, const float* bias,
+                        float* out) {
+#ifdef OF_CPU_ISA_DISPATCH
+    if (image.channels() == 3 && CpuSupportsAvx2()) {
+      NormalizeImageToNCHWAvx2(image, mirror, scale, bias, out);
+      return;
+    }
+#endif
+    if (mirror) {
+      NormalizeImageGeneric<float, TensorLayout::kNCHW, true>(image, scale, bias, out);
+    } else {
+      NormalizeImageGeneric<float, TensorLayout::kNCHW, false>(image, scale, bias, out);
+    }
+  }
+};
+
+}  // namespace
+
+template<typename T>
+class ImageDecodeRandomCropResizeNormalizeKernel final : public user_op::OpKernel {
+ public:
+  ImageDecodeRandomCropResizeNormalizeKernel() = default;
+  ~ImageDecodeRandomCropResizeNormalizeKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<DecodeRandomCropResizeNormalizeState>(ctx);
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    auto* kernel_state = dynamic_cast<DecodeRandomCropResizeNormalizeState*>(state);
+    CHECK_NOTNULL(kernel_state);
+    const user_op::Tensor* in_blob = ctx->Tensor4ArgNameAndIndex("in", 0);
+    const user_op::Tensor* mirror_blob = ctx->Tensor4ArgNameAndIndex("mirror", 0);
+    user_op::Tensor* out_blob = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const int64_t record_num = in_blob->shape().At(0);
+    CHECK_EQ(out_blob->shape().At(0), record_num);
+    if (mirror_blob) { CHECK_EQ(mirror_blob->shape().elem_cnt(), record_num); }
+    const std::string& color_space = ctx->Attr<std::string>("color_space");
+    const std::string& interp_type = ctx->Attr<std::string>("interpolation_type");
+    const std::string& output_layout = ctx->Attr<std::string>("output_layout");
+    const int target_width = ctx->Attr<int64_t>("target_width");
+    const int target_height = ctx->Attr<int64_t>("target_height");
+    const float* scale = kernel_state->scale_vec().data();
+    const float* bias = kernel_state->bias_vec().data();
+    const int64_t out_image_elem_cnt = out_blob->shape().Count(1);
+    const TensorBuffer* in_buffers = in_blob->dptr<TensorBuffer>();
+    T* out_dptr = out_blob->mut_dptr<T>();
+    MultiThreadLoop(record_num, [&](size_t i) {
+      const cv::Mat image =
+          DecodeRandomCropResize(in_buffers[i], color_space, kernel_state->GetGenerator(i),
+                                 target_width, target_height, interp_type);
+      const bool mirror = mirror_blob != nullptr && mirror_blob->dptr<int8_t>()[i] != 0;
+      T* out = out_dptr + out_image_elem_cnt * i;
+      if (output_layout == "NCHW") {
+        NormalizeImageUtil<T, TensorLayout::kNCHW>::Normalize(image, mirror, scale, bias, out);
+      } else if (output_layout == "NHWC") {
+        NormalizeImageUtil<T, TensorLayout::kNHWC>::Normalize(image, mirror, scale, bias, out);
+      } else {
+        UNIMPLEMENTED();
+      }
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_IMAGE_DECODE_RANDOM_CROP_RESIZE_NORMALIZE_KERNEL(dtype)           \
+  REGISTER_USER_KERNEL("image_decode_random_crop_resize_normalize")                \
+      .SetCreateFn<ImageDecodeRandomCropResizeNormalizeKernel<dtype>>()            \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                          \
+                       & (user_op::HobDataType("in", 0) == DataType::kTensorBuffer) \
+                       & (user_op::HobDataType("out", 0) == GetDataType<dtype>::value));
+
+REGISTER_IMAGE_DECODE_RANDOM_CROP_RESIZE_NORMALIZE_KERNEL(float)
+REGISTER_IMAGE_DECODE_RANDOM_CROP_RESIZE_NORMALIZE_KERNEL(float16)
+
+}  // namespace oneflow
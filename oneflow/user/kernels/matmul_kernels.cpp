@@ -17,6 +17,8 @@ limitations under the License.
 #include "oneflow/core/kernel/new_kernel_util.h"
 #include "oneflow/core/framework/config_def.h"
 #include "oneflow/core/job/job_desc.h"
+#include "oneflow/user/kernels/cpu_packed_gemm.h"
+#include "oneflow/user/kernels/variable_version.h"
 
 namespace oneflow {
 
@@ -74,7 +76,8 @@ class MatmulFloatingKernel final : public user_op::OpKernel {
   REGISTER_USER_KERNEL("matmul")                                                                \
       .SetCreateFn<MatmulFloatingKernel<device, dtype>>()                                       \
       .SetIsMatchedHob((user_op::HobDeviceTag() == device)                                      \
-                       & (user_op::HobDataType("a", 0) == GetDataType<dtype>::value))           \
+                       & (user_op::HobDataType("a", 0) == GetDataType<dtype>::value)            \
+                       & (user_op::HobAttr<bool>("_prepack_b") == false))                       \
       .SetInplaceProposalFn([](const user_op::InferContext& ctx,                                \
                                user_op::AddInplaceArgPair AddInplaceArgPairFn) -> Maybe<void> { \
         if (ctx.user_op_conf().has_input("_add_to_output", 0)) {                                \
@@ -177,7 +180,8 @@ class BatchMatmulFloatingKernel final : public user_op::OpKernel {
   REGISTER_USER_KERNEL("batch_matmul")                                                          \
       .SetCreateFn<BatchMatmulFloatingKernel<device, dtype>>()                                  \
       .SetIsMatchedHob((user_op::HobDeviceTag() == device)                                      \
-                       & (user_op::HobDataType("a", 0) == GetDataType<dtype>::value))           \
+                       & (user_op::HobDataType("a", 0) == GetDataType<dtype>::value)            \
+                       & (user_op::HobAttr<bool>("_prepack_b") == false))                       \
       .SetInferTmpSizeFn([](user_op::InferContext* ctx) {                                       \
         user_op::TensorDesc* a = ctx->TensorDesc4ArgNameAndIndex("a", 0);                       \
         size_t num_axes = a->shape().NumAxes();                                                 \
@@ -199,6 +203,105 @@ REGISTER_BATCH_MATMUL_KERNEL(DeviceType::kGPU, float);
 REGISTER_BATCH_MATMUL_KERNEL(DeviceType::kGPU, double);
 #endif
 
+template<typename T>
+class CpuPackedWeightGemmState final : public user_op::OpKernelState {
+ public:
+  CpuPackedWeightGemmState() : b_dptr_(nullptr), variable_version_(-1) {}
+  ~CpuPackedWeightGemmState() override = default;
+
+  // b is re-packed only when it is another buffer or when a variable has been overwritten since
+  // the last packing, e.g. by loading a checkpoint or by a train job of the same session
+  void PackIfStale(enum CBLAS_TRANSPOSE trans_b, int64_t batch_size, int32_t k, int32_t n,
+                   const T* b) {
+    const int64_t variable_version = CurrentVariableVersion();
+    if (b == b_dptr_ && variable_version == variable_version_ && batch_size == gemms_.size()) {
+      return;
+    }
+    gemms_.resize(batch_size);
+    FOR_RANGE(int64_t, i, 0, batch_size) {
+      if (!gemms_.at(i)) { gemms_.at(i).reset(new CpuPackedGemm<T>()); }
+      gemms_.at(i)->PackB(trans_b, k, n, b + i * k * n);
+    }
+    b_dptr_ = b;
+    variable_version_ = variable_version;
+  }
+
+  CpuPackedGemm<T>* MutGemm4Batch(int64_t i) { return gemms_.at(i).get(); }
+
+ private:
+  const T* b_dptr_;
+  int64_t variable_version_;
+  std::vector<std::unique_ptr<CpuPackedGemm<T>>> gemms_;
+};
+
+// Selected for matmul and batch_matmul whose b is a variable of a predict job, see
+// CpuGemmWeightPrepackPass
+template<typename T>
+class CpuPackedWeightMatmulKernel final : public user_op::OpKernel {
+ public:
+  CpuPackedWeightMatmulKernel() = default;
+  ~CpuPackedWeightMatmulKernel() = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<CpuPackedWeightGemmState<T>>();
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    auto* gemm_state = dynamic_cast<CpuPackedWeightGemmState<T>*>(state);
+    CHECK_NOTNULL(gemm_state);
+    CBLAS_TRANSPOSE trans_a = ctx->Attr<bool>("transpose_a") ? CblasTrans : CblasNoTrans;
+    CBLAS_TRANSPOSE trans_b = ctx->Attr<bool>("transpose_b") ? CblasTrans : CblasNoTrans;
+    const user_op::Tensor* a = ctx->Tensor4ArgNameAndIndex("a", 0);
+    const user_op::Tensor* b = ctx->Tensor4ArgNameAndIndex("b", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    int32_t num_axes = a->shape().NumAxes();
+    CHECK_GE(num_axes, 2);
+
+    int32_t m = 0, n = 0, k = 0;
+    std::tie(m, n, k) = CalcMNK(a->shape(), out->shape(), trans_a);
+    T beta;
+    if (ctx->user_op_conf().has_input("_add_to_output", 0)) {
+      const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
+      CHECK_EQ(add_to_output->data_type(), out->data_type());
+      CHECK_EQ(add_to_output->shape(), out->shape());
+      Memcpy<DeviceType::kCPU>(
+          ctx->device_ctx(), out->mut_dptr<void>(), add_to_output->dptr<void>(),
+          add_to_output->shape().elem_cnt() * GetSizeOfDataType(add_to_output->data_type()));
+      beta = GetOneVal<T>();
+    } else {
+      beta = GetZeroVal<T>();
+    }
+    const int64_t batch_size = a->shape().Count(0, num_axes - 2);
+    gemm_state->PackIfStale(trans_b, batch_size, k, n, b->dptr<T>());
+    FOR_RANGE(int64_t, i, 0, batch_size) {
+      gemm_state->MutGemm4Batch(i)->Gemm(trans_a, m, GetOneVal<T>(), a->dptr<T>() + i * m * k,
+                                         beta, out->mut_dptr<T>() + i * m * n);
+    }
+  }
+};
+
+#define REGISTER_CPU_PACKED_WEIGHT_MATMUL_KERNEL(op_type_name, dtype)                          \
+  REGISTER_USER_KERNEL(op_type_name)                                                            \
+      .SetCreateFn<CpuPackedWeightMatmulKernel<dtype>>()                                        \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == DeviceType::kCPU)                            \
+                       & (user_op::HobDataType("a", 0) == GetDataType<dtype>::value)            \
+                       & (user_op::HobAttr<bool>("_prepack_b") == true))                        \
+      .SetInplaceProposalFn([](const user_op::InferContext& ctx,                                \
+                               user_op::AddInplaceArgPair AddInplaceArgPairFn) -> Maybe<void> { \
+        if (ctx.user_op_conf().has_input("_add_to_output", 0)) {                                \
+          OF_RETURN_IF_ERROR(AddInplaceArgPairFn("out", 0, "_add_to_output", 0, true));         \
+        }                                                                                       \
+        return Maybe<void>::Ok();                                                               \
+      });
+
+REGISTER_CPU_PACKED_WEIGHT_MATMUL_KERNEL("matmul", float);
+REGISTER_CPU_PACKED_WEIGHT_MATMUL_KERNEL("matmul", double);
+REGISTER_CPU_PACKED_WEIGHT_MATMUL_KERNEL("batch_matmul", float);
+REGISTER_CPU_PACKED_WEIGHT_MATMUL_KERNEL("batch_matmul", double);
+
 #ifdef WITH_CUDA
 class BatchMatmulGpuHalfKernel final : public user_op::OpKernel {
  public:
@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/user/kernels/model_update_kernel_util.h"
+#include "oneflow/user/kernels/variable_version.h"
 #include "oneflow/core/kernel/indexed_slices_reduce_sum_kernel_util.h"
 #include "oneflow/core/common/balanced_splitter.h"
 
@@ -141,6 +142,7 @@ class SGDUpdateKernel final : public user_op::OpKernel {
         ctx->device_ctx(), model->shape().elem_cnt(), static_cast<T>(scale), l1, l2, weight_decay,
         learning_rate->dptr<float>(), scale_by_ptr, skip_if_ptr, model_diff->dptr<G>(),
         model->mut_dptr<T>());
+    IncreaseVariableVersion();
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
 };
@@ -219,6 +221,7 @@ class IndexedSlicesSGDUpdateKernel final : public user_op::OpKernel {
                           buffer_manager.NumUniqueDiffIndicesPtr(), learning_rate->dptr<float>(),
                           buffer_manager.UniqueDiffIndicesPtr(),
                           buffer_manager.UniqueDiffValuesPtr(), model->mut_dptr<T>());
+    IncreaseVariableVersion();
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
 };
@@ -277,6 +280,7 @@ class MomentumUpdateKernel final : public user_op::OpKernel {
         ctx->device_ctx(), model->shape().elem_cnt(), static_cast<T>(scale_), l1_, l2_, beta_,
         weight_decay_, learning_rate->dptr<float>(), scale_by_ptr, skip_if_ptr,
         model_diff->dptr<G>(), model->mut_dptr<T>(), momentum->mut_dptr<T>());
+    IncreaseVariableVersion();
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
 
@@ -355,6 +359,7 @@ class IndexedSlicesMomentumUpdateKernel final : public user_op::OpKernel {
         kernel_state->upper(), buffer_manager.NumUniqueDiffIndicesPtr(),
         learning_rate->dptr<float>(), buffer_manager.UniqueDiffIndicesPtr(),
         buffer_manager.UniqueDiffValuesPtr(), model->mut_dptr<T>(), momentum->mut_dptr<T>());
+    IncreaseVariableVersion();
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
 };
@@ -413,6 +418,7 @@ class AdamUpdateKernel final : public user_op::OpKernel {
         ctx->device_ctx(), model->shape().elem_cnt(), static_cast<T>(scale), l1, l2, beta1, beta2,
         epsilon, weight_decay, learning_rate->dptr<float>(), scale_by_ptr, skip_if_ptr,
         model_diff->dptr<G>(), model->mut_dptr<T>(), m->mut_dptr<T>(), v->mut_dptr<T>());
+    IncreaseVariableVersion();
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
 };
@@ -487,6 +493,7 @@ class IndexedSlicesAdamUpdateKernel final : public user_op::OpKernel {
                           buffer_manager.UniqueDiffIndicesPtr(),
                           buffer_manager.UniqueDiffValuesPtr(), model->mut_dptr<T>(),
                           m->mut_dptr<T>(), v->mut_dptr<T>());
+    IncreaseVariableVersion();
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
 };
@@ -584,6 +591,7 @@ class LambUpdateKernel final : public user_op::OpKernel {
         weight_decay, learning_rate->dptr<float>(), scale_by_ptr, skip_if_ptr,
         model_diff->dptr<G>(), tbm.AdamDiffPtr(), model->mut_dptr<T>(), m->mut_dptr<T>(),
         v->mut_dptr<T>(), tbm.NormBufferPtr(), beta1_t->mut_dptr<T>(), beta2_t->mut_dptr<T>());
+    IncreaseVariableVersion();
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
 };
@@ -683,6 +691,7 @@ class RmsPropUpdateKernel final : public user_op::OpKernel {
         ctx->device_ctx(), model->shape().elem_cnt(), static_cast<T>(scale), l1, l2, centered,
         epsilon, weight_decay, decay_rate, learning_rate->dptr<float>(), scale_by_ptr, skip_if_ptr,
         model_diff->dptr<G>(), model->mut_dptr<T>(), mean_square->mut_dptr<T>(), mean_gradient_ptr);
+    IncreaseVariableVersion();
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
 };
@@ -777,6 +786,7 @@ class LarsUpdateKernel final : public user_op::OpKernel {
         epsilon, lars_coefficient, weight_decay, learning_rate->dptr<float>(),
         train_step->dptr<int64_t>(), scale_by_ptr, skip_if_ptr, model_diff->dptr<G>(),
         model->mut_dptr<T>(), momentum->mut_dptr<T>(), tlm.DataTmpPtr(), tlm.ModelDiffPtr());
+    IncreaseVariableVersion();
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
 };
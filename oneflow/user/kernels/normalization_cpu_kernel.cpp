@@ -0,0 +1,426 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/framework/multi_thread.h"
+#include "oneflow/core/common/balanced_splitter.h"
+
+namespace oneflow {
+
+namespace {
+
+// NOTE: the cpu kernels follow the cudnn semantics of the gpu kernels: the batch variance is
+// biased, the moving variance is updated with the unbiased one, and reserve_space of
+// normalization_add_relu holds one relu mask bit per element.
+
+// elements per task of the elementwise passes, a multiple of the 32 bits of a mask word
+constexpr int64_t kElemsPerTask = 1 << 14;
+constexpr int64_t kMaskBits = 32;
+// channels_last statistics are reduced in at most this many row chunks
+constexpr int64_t kMaxStatChunks = 64;
+
+// x viewed as (outer, channels, inner) around the normalized axis
+struct NormalizationShape {
+  NormalizationShape(const ShapeView& x_shape, int32_t axis)
+      : outer(x_shape.Count(0, axis)),
+        channels(x_shape.At(axis)),
+        inner(x_shape.Count(axis + 1)),
+        elem_cnt(x_shape.elem_cnt()) {}
+  int64_t outer;
+  int64_t channels;
+  int64_t inner;
+  int64_t elem_cnt;
+  int64_t reduce_size() const { return outer * inner; }
+};
+
+size_t StatBufferSize(int64_t channels) {
+  return GetCudaAlignedSize(kMaxStatChunks * channels * 2 * sizeof(double));
+}
+
+// sums[2 * c] and sums[2 * c + 1] get the two sums of Elem(index, c) over the elements of channel
+// c, in a single pass over x. partial_sums must hold kMaxStatChunks * channels * 2 doubles.
+template<typename ElemFn>
+void ReduceByChannel(const NormalizationShape& shape, const ElemFn& Elem, double* partial_sums,
+                     double* sums) {
+  if (shape.inner > 1) {
+    user_op::ParallelForEachTask(shape.channels, shape.reduce_size(), [&](int64_t c) {
+      double sum0 = 0;
+      double sum1 = 0;
+      FOR_RANGE(int64_t, o, 0, shape.outer) {
+        const int64_t offset = (o * shape.channels + c) * shape.inner;
+        FOR_RANGE(int64_t, i, offset, offset + shape.inner) { Elem(i, c, &sum0, &sum1); }
+      }
+      sums[2 * c] = sum0;
+      sums[2 * c + 1] = sum1;
+    });
+    return;
+  }
+  // channels is the last axis, every task sums all channels of a chunk of rows
+  CHECK_GT(shape.outer, 0);
+  const int64_t num_chunks = std::min(shape.outer, kMaxStatChunks);
+  const BalancedSplitter splitter(shape.outer, num_chunks);
+  user_op::ParallelForEachTask(num_chunks, shape.elem_cnt / num_chunks, [&](int64_t chunk) {
+    double* chunk_sums = partial_sums + chunk * shape.channels * 2;
+    std::fill(chunk_sums, chunk_sums + shape.channels * 2, 0.0);
+    const Range range = splitter.At(chunk);
+    FOR_RANGE(int64_t, o, range.begin(), range.end()) {
+      FOR_RANGE(int64_t, c, 0, shape.channels) {
+        Elem(o * shape.channels + c, c, &chunk_sums[2 * c], &chunk_sums[2 * c + 1]);
+      }
+    }
+  });
+  std::fill(sums, sums + shape.channels * 2, 0.0);
+  FOR_RANGE(int64_t, chunk, 0, num_chunks) {
+    FOR_RANGE(int64_t, i, 0, shape.channels * 2) {
+      sums[i] += partial_sums[chunk * shape.channels * 2 + i];
+    }
+  }
+}
+
+// Calls Fn(begin, end, c) for the runs of [begin, end) that belong to a single channel
+template<typename RunFn>
+void ForEachChannelRun(const NormalizationShape& shape, int64_t begin, int64_t end,
+                       const RunFn& Fn) {
+  while (begin < end) {
+    const int64_t row = begin / shape.inner;
+    const int64_t run_end = std::min(end, (row + 1) * shape.inner);
+    Fn(begin, run_end, row % shape.channels);
+    begin = run_end;
+  }
+}
+
+void ParallelForEachElemRange(int64_t elem_cnt, const std::function<void(int64_t, int64_t)>& Fn) {
+  const int64_t num_tasks = RoundUp(elem_cnt, kElemsPerTask) / kElemsPerTask;
+  user_op::ParallelForEachTask(num_tasks, kElemsPerTask, [&](int64_t task) {
+    const int64_t begin = task * kElemsPerTask;
+    Fn(begin, std::min(begin + kElemsPerTask, elem_cnt));
+  });
+}
+
+// y = x * scale[c] + shift[c] (+ add_to_output), then with relu: y = max(y + addend, 0) with the
+// positive bits written to mask
+template<typename T>
+void NormalizeForward(const NormalizationShape& shape, const T* x, const T* scale, const T* shift,
+                      const T* add_to_output, bool relu, const T* addend, int32_t* mask, T* y) {
+  ParallelForEachElemRange(shape.elem_cnt, [&](int64_t begin, int64_t end) {
+    ForEachChannelRun(shape, begin, end, [&](int64_t run_begin, int64_t run_end, int64_t c) {
+      const T scale_c = scale[c];
+      const T shift_c = shift[c];
+      FOR_RANGE(int64_t, i, run_begin, run_end) {
+        T val = x[i] * scale_c + shift_c;
+        if (add_to_output != nullptr) { val += add_to_output[i]; }
+        y[i] = val;
+      }
+    });
+    if (!relu) { return; }
+    // begin is a multiple of kMaskBits, so no mask word is shared with another task
+    std::fill(mask + begin / kMaskBits, mask + RoundUp(end, kMaskBits) / kMaskBits, 0);
+    FOR_RANGE(int64_t, i, begin, end) {
+      const T sum = addend == nullptr ? y[i] : y[i] + addend[i];
+      const bool is_positive = sum > 0;
+      y[i] = is_positive ? sum : GetZeroVal<T>();
+      if (is_positive) { mask[i / kMaskBits] |= static_cast<int32_t>(1U << (i % kMaskBits)); }
+    }
+  });
+}
+
+template<typename T>
+class NormalizationCpuKernel final : public user_op::OpKernel {
+ public:
+  NormalizationCpuKernel() = default;
+  ~NormalizationCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const bool is_add_relu = ctx->user_op_conf().op_type_name() == "normalization_add_relu";
+    const bool training = is_add_relu ? true : ctx->Attr<bool>("training");
+    const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    auto* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const auto* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    const auto* beta = ctx->Tensor4ArgNameAndIndex("beta", 0);
+    auto* moving_mean = ctx->Tensor4ArgNameAndIndex("moving_mean", 0);
+    auto* moving_variance = ctx->Tensor4ArgNameAndIndex("moving_variance", 0);
+    auto* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const auto axis = ctx->Attr<int32_t>("axis");
+    const auto epsilon = ctx->Attr<float>("epsilon");
+    CHECK_EQ(x->shape(), y->shape());
+    CHECK_GE(axis, 0);
+    CHECK_LT(axis, x->shape().NumAxes());
+    const NormalizationShape shape(x->shape(), axis);
+    const int64_t channels = shape.channels;
+    CHECK_EQ(gamma->shape().elem_cnt(), channels);
+    // an empty batch has no statistics, so the moving ones are left as they are
+    if (shape.elem_cnt == 0) { return; }
+
+    // scale and shift share the tmp buffer with the statistics
+    double* partial_sums = tmp_buffer->mut_dptr<double>();
+    auto* sums =
+        reinterpret_cast<double*>(tmp_buffer->mut_dptr<char>() + StatBufferSize(channels));
+    T* scale = reinterpret_cast<T*>(sums + 2 * channels);
+    T* shift = scale + channels;
+    const T* gamma_ptr = gamma->dptr<T>();
+    const T* beta_ptr = beta->dptr<T>();
+    if (training) {
+      T* mean = nullptr;
+      if (ctx->user_op_conf().has_output("mean", 0)) {
+        mean = ctx->Tensor4ArgNameAndIndex("mean", 0)->mut_dptr<T>();
+      }
+      T* inv_variance = nullptr;
+      if (ctx->user_op_conf().has_output("inv_variance", 0)) {
+        inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0)->mut_dptr<T>();
+      }
+      const T* x_ptr = x->dptr<T>();
+      ReduceByChannel(
+          shape,
+          [x_ptr](int64_t i, int64_t c, double* sum, double* square_sum) {
+            const double val = x_ptr[i];
+            *sum += val;
+            *square_sum += val * val;
+          },
+          partial_sums, sums);
+      const auto momentum = ctx->Attr<float>("momentum");
+      const int64_t n = shape.reduce_size();
+      T* moving_mean_ptr = moving_mean->mut_dptr<T>();
+      T* moving_variance_ptr = moving_variance->mut_dptr<T>();
+      FOR_RANGE(int64_t, c, 0, channels) {
+        const double batch_mean = sums[2 * c] / n;
+        const double batch_variance = std::max(sums[2 * c + 1] / n - batch_mean * batch_mean, 0.0);
+        const double inv_std = 1.0 / std::sqrt(batch_variance + epsilon);
+        const double unbiased_variance = n > 1 ? batch_variance * n / (n - 1) : batch_variance;
+        if (mean != nullptr) { mean[c] = batch_mean; }
+        if (inv_variance != nullptr) { inv_variance[c] = inv_std; }
+        moving_mean_ptr[c] = momentum * moving_mean_ptr[c] + (1 - momentum) * batch_mean;
+        moving_variance_ptr[c] =
+            momentum * moving_variance_ptr[c] + (1 - momentum) * unbiased_variance;
+        scale[c] = gamma_ptr[c] * inv_std;
+        shift[c] = beta_ptr[c] - batch_mean * scale[c];
+      }
+    } else {
+      const T* moving_mean_ptr = moving_mean->dptr<T>();
+      const T* moving_variance_ptr = moving_variance->dptr<T>();
+      FOR_RANGE(int64_t, c, 0, channels) {
+        scale[c] = gamma_ptr[c] / std::sqrt(moving_variance_ptr[c] + epsilon);
+        shift[c] = beta_ptr[c] - moving_mean_ptr[c] * scale[c];
+      }
+    }
+
+    const T* add_to_output = nullptr;
+    if (ctx->user_op_conf().has_input("_add_to_output", 0)) {
+      CHECK(!is_add_relu);
+      const user_op::Tensor* add_to_output_tensor =
+          ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
+      CHECK_EQ(add_to_output_tensor->shape(), y->shape());
+      add_to_output = add_to_output_tensor->dptr<T>();
+    }
+    const T* addend = nullptr;
+    int32_t* mask = nullptr;
+    if (is_add_relu) {
+      if (ctx->user_op_conf().has_input("addend", 0)) {
+        addend = ctx->Tensor4ArgNameAndIndex("addend", 0)->dptr<T>();
+      }
+      mask = ctx->Tensor4ArgNameAndIndex("reserve_space", 0)->mut_dptr<int32_t>();
+    }
+    NormalizeForward<T>(shape, x->dptr<T>(), scale, shift, add_to_output, is_add_relu, addend,
+                        mask, y->mut_dptr<T>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+size_t InferFwTmpSize(user_op::InferContext* ctx) {
+  const auto* x = ctx->TensorDesc4ArgNameAndIndex("x", 0);
+  const int64_t channels = x->shape().At(ctx->Attr<int32_t>("axis"));
+  // partial sums, sums, scale and shift
+  return StatBufferSize(channels) + channels * 2 * sizeof(double)
+         + channels * 2 * GetSizeOfDataType(x->data_type());
+}
+
+#define REGISTER_BN_CPU_KERNEL(op_type_name, dtype)                                             \
+  REGISTER_USER_KERNEL(op_type_name)                                                            \
+      .SetCreateFn<NormalizationCpuKernel<dtype>>()                                             \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                       \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value))           \
+      .SetInferTmpSizeFn(InferFwTmpSize)                                                        \
+      .SetInplaceProposalFn([](const user_op::InferContext& ctx,                                \
+                               user_op::AddInplaceArgPair AddInplaceArgPairFn) -> Maybe<void> { \
+        if (ctx.user_op_conf().has_input("_add_to_output", 0)) {                                \
+          OF_RETURN_IF_ERROR(AddInplaceArgPairFn("y", 0, "_add_to_output", 0, true));           \
+        }                                                                                       \
+        return Maybe<void>::Ok();                                                               \
+      });
+
+REGISTER_BN_CPU_KERNEL("normalization", float)
+REGISTER_BN_CPU_KERNEL("normalization", double)
+REGISTER_BN_CPU_KERNEL("normalization_add_relu", float)
+REGISTER_BN_CPU_KERNEL("normalization_add_relu", double)
+
+template<typename T>
+class NormalizationGradCpuKernel final : public user_op::OpKernel {
+ public:
+  NormalizationGradCpuKernel() = default;
+  ~NormalizationGradCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    auto* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    const auto* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const auto* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    auto* gamma_diff = ctx->Tensor4ArgNameAndIndex("gamma_diff", 0);
+    auto* beta_diff = ctx->Tensor4ArgNameAndIndex("beta_diff", 0);
+    const auto* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    const auto* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    auto* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const auto axis = ctx->Attr<int32_t>("axis");
+    CHECK_EQ(dy->shape(), x->shape());
+    CHECK_EQ(dx->shape(), x->shape());
+    CHECK_GE(axis, 0);
+    CHECK_LT(axis, x->shape().NumAxes());
+    const NormalizationShape shape(x->shape(), axis);
+    const int64_t channels = shape.channels;
+    if (shape.elem_cnt == 0) {
+      std::fill(gamma_diff->mut_dptr<T>(), gamma_diff->mut_dptr<T>() + channels, GetZeroVal<T>());
+      std::fill(beta_diff->mut_dptr<T>(), beta_diff->mut_dptr<T>() + channels, GetZeroVal<T>());
+      return;
+    }
+    double* partial_sums = tmp_buffer->mut_dptr<double>();
+    auto* sums =
+        reinterpret_cast<double*>(tmp_buffer->mut_dptr<char>() + StatBufferSize(channels));
+
+    const T* dy_ptr = dy->dptr<T>();
+    if (ctx->user_op_conf().op_type_name() == "normalization_add_relu_grad") {
+      // the gradient through relu goes to addend_diff when there is an addend
+      T* relu_dy = nullptr;
+      if (ctx->user_op_conf().has_output("addend_diff", 0)) {
+        relu_dy = ctx->Tensor4ArgNameAndIndex("addend_diff", 0)->mut_dptr<T>();
+      } else {
+        relu_dy = reinterpret_cast<T*>(tmp_buffer->mut_dptr<char>() + StatBufferSize(channels)
+                                       + GetCudaAlignedSize(channels * 2 * sizeof(double)));
+      }
+      const int32_t* mask = ctx->Tensor4ArgNameAndIndex("reserve_space", 0)->dptr<int32_t>();
+      ParallelForEachElemRange(shape.elem_cnt, [&](int64_t begin, int64_t end) {
+        FOR_RANGE(int64_t, i, begin, end) {
+          const int32_t bit = static_cast<int32_t>(1U << (i % kMaskBits));
+          relu_dy[i] = (mask[i / kMaskBits] & bit) ? dy_ptr[i] : GetZeroVal<T>();
+        }
+      });
+      dy_ptr = relu_dy;
+    }
+
+    const T* x_ptr = x->dptr<T>();
+    const T* mean_ptr = mean->dptr<T>();
+    ReduceByChannel(
+        shape,
+        [x_ptr, dy_ptr, mean_ptr](int64_t i, int64_t c, double* dy_sum, double* dy_x_sum) {
+          *dy_sum += dy_ptr[i];
+          *dy_x_sum += static_cast<double>(dy_ptr[i]) * (x_ptr[i] - mean_ptr[c]);
+        },
+        partial_sums, sums);
+    const T* inv_variance_ptr = inv_variance->dptr<T>();
+    const T* gamma_ptr = gamma->dptr<T>();
+    T* gamma_diff_ptr = gamma_diff->mut_dptr<T>();
+    T* beta_diff_ptr = beta_diff->mut_dptr<T>();
+    const double n = shape.reduce_size();
+    FOR_RANGE(int64_t, c, 0, channels) {
+      beta_diff_ptr[c] = sums[2 * c];
+      gamma_diff_ptr[c] = sums[2 * c + 1] * inv_variance_ptr[c];
+    }
+    // dx = gamma * inv_variance * (dy - mean(dy) - x_hat * mean(dy * x_hat))
+    T* dx_ptr = dx->mut_dptr<T>();
+    ParallelForEachElemRange(shape.elem_cnt, [&](int64_t begin, int64_t end) {
+      ForEachChannelRun(shape, begin, end, [&](int64_t run_begin, int64_t run_end, int64_t c) {
+        const T inv_std = inv_variance_ptr[c];
+        const T dy_mean = static_cast<T>(beta_diff_ptr[c] / n);
+        const T x_hat_scale = static_cast<T>(gamma_diff_ptr[c] / n) * inv_std;
+        const T dx_scale = gamma_ptr[c] * inv_std;
+        const T mean_c = mean_ptr[c];
+        FOR_RANGE(int64_t, i, run_begin, run_end) {
+          dx_ptr[i] = dx_scale * (dy_ptr[i] - dy_mean - (x_ptr[i] - mean_c) * x_hat_scale);
+        }
+      });
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+size_t InferGradTmpSize(user_op::InferContext* ctx) {
+  const auto* dy = ctx->TensorDesc4ArgNameAndIndex("dy", 0);
+  const int64_t channels = dy->shape().At(ctx->Attr<int32_t>("axis"));
+  size_t tmp_size = StatBufferSize(channels) + GetCudaAlignedSize(channels * 2 * sizeof(double));
+  if (ctx->user_op_conf().op_type_name() == "normalization_add_relu_grad"
+      && !ctx->user_op_conf().has_output("addend_diff", 0)) {
+    tmp_size += GetCudaAlignedSize(dy->shape().elem_cnt() * GetSizeOfDataType(dy->data_type()));
+  }
+  return tmp_size;
+}
+
+#define REGISTER_BN_GRAD_CPU_KERNEL(op_type_name, dtype)                               \
+  REGISTER_USER_KERNEL(op_type_name)                                                   \
+      .SetCreateFn<NormalizationGradCpuKernel<dtype>>()                                \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
+                       & (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn(InferGradTmpSize);
+
+REGISTER_BN_GRAD_CPU_KERNEL("normalization_grad", float)
+REGISTER_BN_GRAD_CPU_KERNEL("normalization_grad", double)
+REGISTER_BN_GRAD_CPU_KERNEL("normalization_add_relu_grad", float)
+REGISTER_BN_GRAD_CPU_KERNEL("normalization_add_relu_grad", double)
+
+template<typename T>
+class FoldNormalizationParamsCpuKernel final : public user_op::OpKernel {
+ public:
+  FoldNormalizationParamsCpuKernel() = default;
+  ~FoldNormalizationParamsCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const auto* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const T* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0)->dptr<T>();
+    const T* beta = ctx->Tensor4ArgNameAndIndex("beta", 0)->dptr<T>();
+    const T* moving_mean = ctx->Tensor4ArgNameAndIndex("moving_mean", 0)->dptr<T>();
+    const T* moving_variance = ctx->Tensor4ArgNameAndIndex("moving_variance", 0)->dptr<T>();
+    const T* bias = nullptr;
+    if (ctx->user_op_conf().has_input("bias", 0)) {
+      bias = ctx->Tensor4ArgNameAndIndex("bias", 0)->dptr<T>();
+    }
+    T* folded_weight = ctx->Tensor4ArgNameAndIndex("folded_weight", 0)->mut_dptr<T>();
+    T* folded_bias = ctx->Tensor4ArgNameAndIndex("folded_bias", 0)->mut_dptr<T>();
+    const auto epsilon = ctx->Attr<float>("epsilon");
+    const int64_t filters = weight->shape().At(0);
+    const int64_t filter_size = weight->shape().Count(1);
+    const T* weight_ptr = weight->dptr<T>();
+    FOR_RANGE(int64_t, f, 0, filters) {
+      const T scale = gamma[f] / std::sqrt(moving_variance[f] + epsilon);
+      const T bias_f = bias == nullptr ? GetZeroVal<T>() : bias[f];
+      folded_bias[f] = (bias_f - moving_mean[f]) * scale + beta[f];
+      FOR_RANGE(int64_t, i, f * filter_size, (f + 1) * filter_size) {
+        folded_weight[i] = weight_ptr[i] * scale;
+      }
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_FOLD_NORMALIZATION_PARAMS_CPU_KERNEL(dtype)  \
+  REGISTER_USER_KERNEL("fold_normalization_params")           \
+      .SetCreateFn<FoldNormalizationParamsCpuKernel<dtype>>() \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")     \
+                       & (user_op::HobDataType("weight", 0) == GetDataType<dtype>::value));
+
+REGISTER_FOLD_NORMALIZATION_PARAMS_CPU_KERNEL(float)
+REGISTER_FOLD_NORMALIZATION_PARAMS_CPU_KERNEL(double)
+
+}  // namespace
+
+}  // namespace oneflow
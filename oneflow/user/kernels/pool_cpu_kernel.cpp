@@ -17,6 +17,7 @@ limitations under the License.
 #include "oneflow/user/kernels/op_kernel_state_wrapper.h"
 #include "oneflow/user/utils/pool_util.h"
 #include "oneflow/core/common/eigen_util.h"
+#include "oneflow/core/framework/multi_thread.h"
 
 namespace oneflow {
 
@@ -33,312 +34,325 @@ struct PoolOpKernelState final : public user_op::OpKernelState {
   }
 };
 
+// Window of one output position clipped to the input, in (d, h, w)
+struct PoolWindow {
+  int64_t start[3];
+  int64_t end[3];
+  int64_t size() const {
+    return (end[0] - start[0]) * (end[1] - start[1]) * (end[2] - start[2]);
+  }
+};
+
+PoolWindow GetPoolWindow(const Params3D& params_3d, const Shape& in, int64_t pd, int64_t ph,
+                         int64_t pw) {
+  const int64_t out_pos[3] = {pd, ph, pw};
+  PoolWindow window;
+  FOR_RANGE(int32_t, i, 0, 3) {
+    const int64_t start =
+        out_pos[i] * params_3d.strides_3d().at(i) - params_3d.padding_before_3d().at(i);
+    window.end[i] = std::min(start + params_3d.pool_size_3d().at(i), in.At(2 + i));
+    window.start[i] = std::max(start, static_cast<int64_t>(0));
+  }
+  return window;
+}
+
+// Range [begin, end) of the outputs along one axis whose window covers input index in_idx
+void GetOutputRange(int64_t in_idx, int32_t pool_size, int32_t stride, int32_t padding,
+                    int64_t out_dim, int64_t* begin, int64_t* end) {
+  const int64_t padded_idx = in_idx + padding;
+  *begin = padded_idx < pool_size ? 0 : (padded_idx - pool_size) / stride + 1;
+  *end = std::min(padded_idx / stride + 1, out_dim);
+}
+
+int64_t WindowVolume(const Params3D& params_3d) {
+  const std::vector<int32_t>& pool_size = params_3d.pool_size_3d();
+  return pool_size.at(0) * pool_size.at(1) * pool_size.at(2);
+}
+
+// NOTE: channels_first pooling runs in parallel over the N * C planes. channels_last pooling runs
+// in parallel over (n, d, h) rows and reduces whole channel columns at once, which Eigen and the
+// compiler vectorize. Max pooling may also write "_argmax", the flat (d, h, w) index of the max
+// inside the plane, so that the backward scatters the gradient without scanning the windows again.
 template<typename T>
 struct PoolCpuKernelUtil {
  public:
-  typedef std::function<T()> ForwardInitialize;
-  typedef std::function<void(const T& lhs, T& rhs)> CFirstProcess;
-  typedef std::function<void(const int64_t in_col, const int64_t out_col,
-                             ConstEigenMatrixMap<T>& in_mat, EigenMatrixMap<T>& out_mat)>
-      CLastProcess;
-  typedef std::function<void(const int64_t size, T& out)> CFirstFinalize;
-  typedef std::function<void(const int64_t size, const int64_t col, EigenMatrixMap<T>& out_mat)>
-      CLastFinalize;
-  typedef std::function<void(const T& in, const T& out, const T& out_diff, const int64_t size,
-                             T& in_diff)>
-      CFirstProcessGrad;
-  typedef std::function<void(const int64_t out_col, const int64_t in_col, const int64_t size,
-                             ConstEigenArrayMap<T>& out_arr, ConstEigenArrayMap<T>& in_arr,
-                             ConstEigenArrayMap<T>& out_diff_arr, EigenArrayMap<T>& in_diff_arr)>
-      CLastProcessGrad;
-
-  static void CFirstForward(const Params3D& params_3d, const user_op::Tensor* in_blob,
-                            user_op::Tensor* out_blob, const ForwardInitialize& initialize,
-                            const CFirstProcess& process, const CFirstFinalize& finalize) {
-    const Shape& in = params_3d.GetXShape5D();
-    const Shape& out = params_3d.GetYShape5D();
-    const std::vector<int32_t>& pool_size = params_3d.pool_size_3d();
-    const std::vector<int32_t>& strides = params_3d.strides_3d();
-    const std::vector<int32_t>& padding_before = params_3d.padding_before_3d();
-
+  static void CFirstForward(const Params3D& params_3d, bool is_max, const user_op::Tensor* in_blob,
+                            user_op::Tensor* out_blob, user_op::Tensor* argmax_blob) {
+    const Shape in = params_3d.GetXShape5D();
+    const Shape out = params_3d.GetYShape5D();
+    const int64_t in_plane_size = in.Count(2);
+    const int64_t out_plane_size = out.Count(2);
     const T* input = in_blob->dptr<T>();
     T* output = out_blob->mut_dptr<T>();
-    FOR_RANGE(int64_t, n, 0, in.At(0)) {
-      FOR_RANGE(int64_t, c, 0, in.At(1)) {
-        FOR_RANGE(int64_t, pd, 0, out.At(2)) {
-          int64_t dstart = pd * strides.at(0) - padding_before.at(0);
-          int64_t dend = std::min(dstart + pool_size.at(0), in.At(2));
-          dstart = std::max(dstart, static_cast<int64_t>(0));
-          FOR_RANGE(int64_t, ph, 0, out.At(3)) {
-            int64_t hstart = ph * strides.at(1) - padding_before.at(1);
-            int64_t hend = std::min(hstart + pool_size.at(1), in.At(3));
-            hstart = std::max(hstart, static_cast<int64_t>(0));
-            FOR_RANGE(int64_t, pw, 0, out.At(4)) {
-              int64_t wstart = pw * strides.at(2) - padding_before.at(2);
-              int64_t wend = std::min(wstart + pool_size.at(2), in.At(4));
-              wstart = std::max(wstart, static_cast<int64_t>(0));
-
-              const int64_t pool_index = pd * out.Count(3) + ph * out.At(4) + pw;
-              T res = initialize();
-              FOR_RANGE(int64_t, d, dstart, dend) {
-                FOR_RANGE(int64_t, h, hstart, hend) {
-                  FOR_RANGE(int64_t, w, wstart, wend) {
-                    const int64_t input_index = d * in.Count(3) + h * in.At(4) + w;
-                    process(input[input_index], res);
+    int32_t* argmax = argmax_blob == nullptr ? nullptr : argmax_blob->mut_dptr<int32_t>();
+    // a dynamic x may have grown past the check of the op
+    if (argmax != nullptr) { CHECK_LE(in.Count(2), GetMaxVal<int32_t>()); }
+    user_op::ParallelForEachTask(
+        in.Count(0, 2), out_plane_size * WindowVolume(params_3d), [&](int64_t plane) {
+          const T* x = input + plane * in_plane_size;
+          T* y = output + plane * out_plane_size;
+          int32_t* y_argmax = argmax == nullptr ? nullptr : argmax + plane * out_plane_size;
+          int64_t pool_index = 0;
+          FOR_RANGE(int64_t, pd, 0, out.At(2)) {
+            FOR_RANGE(int64_t, ph, 0, out.At(3)) {
+              FOR_RANGE(int64_t, pw, 0, out.At(4)) {
+                const PoolWindow window = GetPoolWindow(params_3d, in, pd, ph, pw);
+                T res = is_max ? GetMinVal<T>() : GetZeroVal<T>();
+                int64_t res_index = -1;
+                FOR_RANGE(int64_t, d, window.start[0], window.end[0]) {
+                  FOR_RANGE(int64_t, h, window.start[1], window.end[1]) {
+                    FOR_RANGE(int64_t, w, window.start[2], window.end[2]) {
+                      const int64_t index = (d * in.At(3) + h) * in.At(4) + w;
+                      if (!is_max) {
+                        res += x[index];
+                      } else if (res_index == -1 || x[index] > res) {
+                        res = x[index];
+                        res_index = index;
+                      }
+                    }
                   }
                 }
+                y[pool_index] = is_max ? res : res / static_cast<T>(window.size());
+                if (y_argmax != nullptr) { y_argmax[pool_index] = res_index; }
+                ++pool_index;
               }
-              finalize((dend - dstart) * (hend - hstart) * (wend - wstart), res);
-              output[pool_index] = res;
             }
           }
-        }
-        input += in.Count(2);
-        output += out.Count(2);
-      }
-    }
+        });
   }
 
-  static void CFirstBackward(const Params3D& params_3d, const user_op::Tensor* out_diff_blob,
-                             const user_op::Tensor* out_blob, const user_op::Tensor* in_blob,
-                             user_op::Tensor* in_diff_blob, const CFirstProcessGrad& process) {
-    const Shape& in = params_3d.GetXShape5D();
-    const Shape& out = params_3d.GetYShape5D();
-    const std::vector<int32_t>& pool_size = params_3d.pool_size_3d();
-    const std::vector<int32_t>& strides = params_3d.strides_3d();
-    const std::vector<int32_t>& padding_before = params_3d.padding_before_3d();
-
+  static void CFirstBackward(const Params3D& params_3d, bool is_max,
+                             const user_op::Tensor* out_diff_blob, const user_op::Tensor* out_blob,
+                             const user_op::Tensor* in_blob, const user_op::Tensor* argmax_blob,
+                             user_op::Tensor* in_diff_blob) {
+    const Shape in = params_3d.GetXShape5D();
+    const Shape out = params_3d.GetYShape5D();
+    const int64_t in_plane_size = in.Count(2);
+    const int64_t out_plane_size = out.Count(2);
     const T* output_diff = out_diff_blob->dptr<T>();
     const T* output = out_blob->dptr<T>();
     const T* input = in_blob->dptr<T>();
-    std::memset(in_diff_blob->mut_dptr<T>(), T(0), in.elem_cnt() * sizeof(T));
+    const int32_t* argmax = argmax_blob == nullptr ? nullptr : argmax_blob->dptr<int32_t>();
     T* input_diff = in_diff_blob->mut_dptr<T>();
-    FOR_RANGE(int64_t, n, 0, in.At(0)) {
-      FOR_RANGE(int64_t, c, 0, in.At(1)) {
-        FOR_RANGE(int64_t, pd, 0, out.At(2)) {
-          int64_t dstart = pd * strides.at(0) - padding_before.at(0);
-          int64_t dend = std::min(dstart + pool_size.at(0), in.At(2));
-          dstart = std::max(dstart, static_cast<int64_t>(0));
-          FOR_RANGE(int64_t, ph, 0, out.At(3)) {
-            int64_t hstart = ph * strides.at(1) - padding_before.at(1);
-            int64_t hend = std::min(hstart + pool_size.at(1), in.At(3));
-            hstart = std::max(hstart, static_cast<int64_t>(0));
-            FOR_RANGE(int64_t, pw, 0, out.At(4)) {
-              int64_t wstart = pw * strides.at(2) - padding_before.at(2);
-              int64_t wend = std::min(wstart + pool_size.at(2), in.At(4));
-              wstart = std::max(wstart, static_cast<int64_t>(0));
-
-              const int64_t size = (dend - dstart) * (hend - hstart) * (wend - wstart);
-              const int64_t pool_index = pd * out.Count(3) + ph * out.At(4) + pw;
-              FOR_RANGE(int64_t, d, dstart, dend) {
-                FOR_RANGE(int64_t, h, hstart, hend) {
-                  FOR_RANGE(int64_t, w, wstart, wend) {
-                    const int64_t index = d * in.Count(3) + h * in.At(4) + w;
-                    process(input[index], output[pool_index], output_diff[pool_index], size,
-                            input_diff[index]);
+    const int64_t work_per_plane = argmax == nullptr ? out_plane_size * WindowVolume(params_3d)
+                                                     : in_plane_size + out_plane_size;
+    // gradients only scatter inside their own plane, so planes never race
+    user_op::ParallelForEachTask(in.Count(0, 2), work_per_plane, [&](int64_t plane) {
+      const T* x = input + plane * in_plane_size;
+      const T* y = output + plane * out_plane_size;
+      const T* dy = output_diff + plane * out_plane_size;
+      T* dx = input_diff + plane * in_plane_size;
+      std::fill(dx, dx + in_plane_size, GetZeroVal<T>());
+      if (argmax != nullptr) {
+        const int32_t* y_argmax = argmax + plane * out_plane_size;
+        FOR_RANGE(int64_t, i, 0, out_plane_size) {
+          if (y_argmax[i] >= 0) { dx[y_argmax[i]] += dy[i]; }
+        }
+        return;
+      }
+      int64_t pool_index = 0;
+      FOR_RANGE(int64_t, pd, 0, out.At(2)) {
+        FOR_RANGE(int64_t, ph, 0, out.At(3)) {
+          FOR_RANGE(int64_t, pw, 0, out.At(4)) {
+            const PoolWindow window = GetPoolWindow(params_3d, in, pd, ph, pw);
+            const T avg_diff = dy[pool_index] / static_cast<T>(window.size());
+            FOR_RANGE(int64_t, d, window.start[0], window.end[0]) {
+              FOR_RANGE(int64_t, h, window.start[1], window.end[1]) {
+                FOR_RANGE(int64_t, w, window.start[2], window.end[2]) {
+                  const int64_t index = (d * in.At(3) + h) * in.At(4) + w;
+                  if (!is_max) {
+                    dx[index] += avg_diff;
+                  } else if (x[index] == y[pool_index]) {
+                    dx[index] += dy[pool_index];
                   }
                 }
               }
             }
+            ++pool_index;
           }
         }
-        // offset
-        input += in.Count(2);
-        input_diff += in.Count(2);
-        output += out.Count(2);
-        output_diff += out.Count(2);
       }
-    }
+    });
   }
 
-  static void CLastForward(const Params3D& params_3d, const user_op::Tensor* in_blob,
-                           user_op::Tensor* out_blob, const ForwardInitialize& forward_initialize,
-                           const CLastProcess& process, const CLastFinalize& finalize) {
-    const Shape& in = params_3d.GetXShape5D();
-    const Shape& out = params_3d.GetYShape5D();
-    const std::vector<int32_t>& pool_size = params_3d.pool_size_3d();
-    const std::vector<int32_t>& strides = params_3d.strides_3d();
-    const std::vector<int32_t>& padding_before = params_3d.padding_before_3d();
-
-    ConstEigenMatrixMap<T> in_mat(in_blob->dptr<T>(), in.At(1), in.elem_cnt() / in.At(1));
-    EigenMatrixMap<T> out_mat(out_blob->mut_dptr<T>(), out.At(1), out.elem_cnt() / out.At(1));
-    FOR_RANGE(int64_t, n, 0, in.At(0)) {
-      FOR_RANGE(int64_t, pd, 0, out.At(2)) {
-        int64_t dstart = pd * strides.at(0) - padding_before.at(0);
-        int64_t dend = std::min(dstart + pool_size.at(0), in.At(2));
-        dstart = std::max(dstart, static_cast<int64_t>(0));
-        FOR_RANGE(int64_t, ph, 0, out.At(3)) {
-          int64_t hstart = ph * strides.at(1) - padding_before.at(1);
-          int64_t hend = std::min(hstart + pool_size.at(1), in.At(3));
-          hstart = std::max(hstart, static_cast<int64_t>(0));
-          FOR_RANGE(int64_t, pw, 0, out.At(4)) {
-            int64_t wstart = pw * strides.at(2) - padding_before.at(2);
-            int64_t wend = std::min(wstart + pool_size.at(2), in.At(4));
-            wstart = std::max(wstart, static_cast<int64_t>(0));
-            const int out_col = ((n * out.At(2) + pd) * out.At(3) + ph) * out.At(4) + pw;
-            out_mat.col(out_col).setConstant(forward_initialize());
-            FOR_RANGE(int64_t, d, dstart, dend) {
-              FOR_RANGE(int64_t, h, hstart, hend) {
-                FOR_RANGE(int64_t, w, wstart, wend) {
-                  const int in_col = ((n * in.At(2) + d) * in.At(3) + h) * in.At(4) + w;
-                  process(in_col, out_col, in_mat, out_mat);
+  static void CLastForward(const Params3D& params_3d, bool is_max, const user_op::Tensor* in_blob,
+                           user_op::Tensor* out_blob, user_op::Tensor* argmax_blob) {
+    const Shape in = params_3d.GetXShape5D();
+    const Shape out = params_3d.GetYShape5D();
+    const int64_t channels = in.At(1);
+    ConstEigenMatrixMap<T> in_mat(in_blob->dptr<T>(), channels, in.elem_cnt() / channels);
+    EigenMatrixMap<T> out_mat(out_blob->mut_dptr<T>(), channels, out.elem_cnt() / channels);
+    int32_t* argmax = argmax_blob == nullptr ? nullptr : argmax_blob->mut_dptr<int32_t>();
+    // a dynamic x may have grown past the check of the op
+    if (argmax != nullptr) { CHECK_LE(in.Count(2), GetMaxVal<int32_t>()); }
+    const int64_t num_rows = in.At(0) * out.At(2) * out.At(3);
+    const int64_t work_per_row = out.At(4) * channels * WindowVolume(params_3d);
+    user_op::ParallelForEachTask(num_rows, work_per_row, [&](int64_t row) {
+      const int64_t n = row / (out.At(2) * out.At(3));
+      const int64_t pd = row / out.At(3) % out.At(2);
+      const int64_t ph = row % out.At(3);
+      FOR_RANGE(int64_t, pw, 0, out.At(4)) {
+        const PoolWindow window = GetPoolWindow(params_3d, in, pd, ph, pw);
+        const int64_t out_col = row * out.At(4) + pw;
+        if (is_max && argmax != nullptr) {
+          T* y = out_mat.col(out_col).data();
+          int32_t* y_argmax = argmax + out_col * channels;
+          std::fill(y, y + channels, GetMinVal<T>());
+          std::fill(y_argmax, y_argmax + channels, -1);
+          FOR_RANGE(int64_t, d, window.start[0], window.end[0]) {
+            FOR_RANGE(int64_t, h, window.start[1], window.end[1]) {
+              FOR_RANGE(int64_t, w, window.start[2], window.end[2]) {
+                const int32_t index = (d * in.At(3) + h) * in.At(4) + w;
+                const T* x = in_mat.col(n * in.Count(2) + index).data();
+                FOR_RANGE(int64_t, c, 0, channels) {
+                  if (y_argmax[c] == -1 || x[c] > y[c]) {
+                    y[c] = x[c];
+                    y_argmax[c] = index;
+                  }
                 }
               }
             }
-            finalize((hend - hstart) * (wend - wstart) * (dend - dstart), out_col, out_mat);
           }
+          continue;
         }
+        out_mat.col(out_col).setConstant(is_max ? GetMinVal<T>() : GetZeroVal<T>());
+        FOR_RANGE(int64_t, d, window.start[0], window.end[0]) {
+          FOR_RANGE(int64_t, h, window.start[1], window.end[1]) {
+            FOR_RANGE(int64_t, w, window.start[2], window.end[2]) {
+              const int64_t in_col = ((n * in.At(2) + d) * in.At(3) + h) * in.At(4) + w;
+              if (is_max) {
+                out_mat.col(out_col) = out_mat.col(out_col).cwiseMax(in_mat.col(in_col));
+              } else {
+                out_mat.col(out_col) += in_mat.col(in_col);
+              }
+            }
+          }
+        }
+        if (!is_max) { out_mat.col(out_col) /= static_cast<T>(window.size()); }
       }
-    }
+    });
   }
 
-  static void CLastBackward(const Params3D& params_3d, const user_op::Tensor* out_diff_blob,
-                            const user_op::Tensor* out_blob, const user_op::Tensor* in_blob,
-                            user_op::Tensor* in_diff_blob, const CLastProcessGrad& process) {
-    const Shape& in = params_3d.GetXShape5D();
-    const Shape& out = params_3d.GetYShape5D();
+  static void CLastBackward(const Params3D& params_3d, bool is_max,
+                            const user_op::Tensor* out_diff_blob, const user_op::Tensor* out_blob,
+                            const user_op::Tensor* in_blob, const user_op::Tensor* argmax_blob,
+                            user_op::Tensor* in_diff_blob) {
+    const Shape in = params_3d.GetXShape5D();
+    const Shape out = params_3d.GetYShape5D();
     const std::vector<int32_t>& pool_size = params_3d.pool_size_3d();
     const std::vector<int32_t>& strides = params_3d.strides_3d();
     const std::vector<int32_t>& padding_before = params_3d.padding_before_3d();
-
-    // caffe2 implementation: need check
-    ConstEigenArrayMap<T> out_mat(out_blob->dptr<T>(), out.At(1), out.elem_cnt() / out.At(1));
-    ConstEigenArrayMap<T> in_mat(in_blob->dptr<T>(), in.At(1), in.elem_cnt() / in.At(1));
-    ConstEigenArrayMap<T> out_diff_mat(out_diff_blob->dptr<T>(), out.At(1),
-                                       out.elem_cnt() / out.At(1));
-    std::memset(in_diff_blob->mut_dptr<T>(), T(0), in.elem_cnt() * sizeof(T));
-    EigenArrayMap<T> in_diff_mat(in_diff_blob->mut_dptr<T>(), in.At(1), in.elem_cnt() / in.At(1));
-    FOR_RANGE(int64_t, n, 0, in.At(0)) {
-      FOR_RANGE(int64_t, pd, 0, out.At(2)) {
-        int64_t dstart = pd * strides.at(0) - padding_before.at(0);
-        int64_t dend = std::min(dstart + pool_size.at(0), in.At(2));
-        dstart = std::max(dstart, static_cast<int64_t>(0));
-        FOR_RANGE(int64_t, ph, 0, out.At(3)) {
-          int64_t hstart = ph * strides.at(1) - padding_before.at(1);
-          int64_t hend = std::min(hstart + pool_size.at(1), in.At(3));
-          hstart = std::max(hstart, static_cast<int64_t>(0));
-          FOR_RANGE(int64_t, pw, 0, out.At(4)) {
-            int64_t wstart = pw * strides.at(2) - padding_before.at(2);
-            int64_t wend = std::min(wstart + pool_size.at(2), in.At(4));
-            wstart = std::max(wstart, static_cast<int64_t>(0));
-            const int64_t pool_index = ((n * out.At(2) + pd) * out.At(3) + ph) * out.At(4) + pw;
-            const int64_t size = (dend - dstart) * (hend - hstart) * (wend - wstart);
-            FOR_RANGE(int64_t, d, dstart, dend) {
-              FOR_RANGE(int64_t, h, hstart, hend) {
-                FOR_RANGE(int64_t, w, wstart, wend) {
-                  const int64_t input_index = ((n * in.At(2) + d) * in.At(3) + h) * in.At(4) + w;
-                  process(pool_index, input_index, size, out_mat, in_mat, out_diff_mat,
-                          in_diff_mat);
+    const int64_t channels = in.At(1);
+    ConstEigenArrayMap<T> out_arr(out_blob->dptr<T>(), channels, out.elem_cnt() / channels);
+    ConstEigenArrayMap<T> in_arr(in_blob->dptr<T>(), channels, in.elem_cnt() / channels);
+    ConstEigenArrayMap<T> out_diff_arr(out_diff_blob->dptr<T>(), channels,
+                                       out.elem_cnt() / channels);
+    EigenArrayMap<T> in_diff_arr(in_diff_blob->mut_dptr<T>(), channels, in.elem_cnt() / channels);
+    const int32_t* argmax = argmax_blob == nullptr ? nullptr : argmax_blob->dptr<int32_t>();
+    // every input column gathers the gradients of the windows covering it, so each column of dx is
+    // written by exactly one task
+    const int64_t num_rows = in.At(0) * in.At(2) * in.At(3);
+    const int64_t work_per_row = in.At(4) * channels * WindowVolume(params_3d);
+    user_op::ParallelForEachTask(num_rows, work_per_row, [&](int64_t row) {
+      const int64_t n = row / (in.At(2) * in.At(3));
+      const int64_t d = row / in.At(3) % in.At(2);
+      const int64_t h = row % in.At(3);
+      int64_t od_begin = 0, od_end = 0, oh_begin = 0, oh_end = 0;
+      GetOutputRange(d, pool_size.at(0), strides.at(0), padding_before.at(0), out.At(2), &od_begin,
+                     &od_end);
+      GetOutputRange(h, pool_size.at(1), strides.at(1), padding_before.at(1), out.At(3), &oh_begin,
+                     &oh_end);
+      FOR_RANGE(int64_t, w, 0, in.At(4)) {
+        const int64_t in_col = row * in.At(4) + w;
+        const int32_t index = (d * in.At(3) + h) * in.At(4) + w;
+        in_diff_arr.col(in_col).setZero();
+        int64_t ow_begin = 0, ow_end = 0;
+        GetOutputRange(w, pool_size.at(2), strides.at(2), padding_before.at(2), out.At(4),
+                       &ow_begin, &ow_end);
+        FOR_RANGE(int64_t, od, od_begin, od_end) {
+          FOR_RANGE(int64_t, oh, oh_begin, oh_end) {
+            FOR_RANGE(int64_t, ow, ow_begin, ow_end) {
+              const int64_t out_col = ((n * out.At(2) + od) * out.At(3) + oh) * out.At(4) + ow;
+              if (!is_max) {
+                const int64_t size = GetPoolWindow(params_3d, in, od, oh, ow).size();
+                in_diff_arr.col(in_col) += out_diff_arr.col(out_col) / static_cast<T>(size);
+              } else if (argmax != nullptr) {
+                const int32_t* y_argmax = argmax + out_col * channels;
+                T* dx = in_diff_arr.col(in_col).data();
+                const T* dy = out_diff_arr.col(out_col).data();
+                FOR_RANGE(int64_t, c, 0, channels) {
+                  if (y_argmax[c] == index) { dx[c] += dy[c]; }
                 }
+              } else {
+                in_diff_arr.col(in_col) +=
+                    out_diff_arr.col(out_col)
+                    * (in_arr.col(in_col).cwiseEqual(out_arr.col(out_col)).template cast<T>());
               }
             }
           }
         }
       }
-    }
+    });
   }
 
-  static void AvgFWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) {
+  static void FWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state,
+                        bool is_max) {
     const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
     user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    user_op::Tensor* argmax = nullptr;
+    if (is_max && ctx->user_op_conf().has_output("_argmax", 0)) {
+      argmax = ctx->Tensor4ArgNameAndIndex("_argmax", 0);
+    }
     auto* pool_state = dynamic_cast<PoolOpKernelState*>(state);
     CHECK(pool_state != nullptr);
     pool_state->Update(x->shape());
     const std::string& data_format = ctx->Attr<std::string>("data_format");
     if (data_format == "channels_first") {
-      CFirstForward(pool_state->GetParams3D(), x, y, GetZeroVal<T>,
-                    [](const T& lhs, T& rhs) { rhs += lhs; },
-                    [](const int64_t size, T& out) { out /= size; });
+      CFirstForward(pool_state->GetParams3D(), is_max, x, y, argmax);
     } else if (data_format == "channels_last") {
-      CLastForward(pool_state->GetParams3D(), x, y, GetZeroVal<T>,
-                   [](const int64_t in_col, const int64_t out_col, ConstEigenMatrixMap<T>& in_mat,
-                      EigenMatrixMap<T>& out_mat) { out_mat.col(out_col) += in_mat.col(in_col); },
-                   [](const int64_t size, const int64_t col, EigenMatrixMap<T>& out_mat) {
-                     out_mat.col(col) /= size;
-                   });
+      CLastForward(pool_state->GetParams3D(), is_max, x, y, argmax);
     } else {
       UNIMPLEMENTED();
     }
   }
 
-  static void AvgBWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) {
+  static void BWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state,
+                        bool is_max) {
     const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
     const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
     const user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
     user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    const user_op::Tensor* argmax = nullptr;
+    if (is_max && ctx->user_op_conf().has_input("_argmax", 0)) {
+      argmax = ctx->Tensor4ArgNameAndIndex("_argmax", 0);
+    }
     auto* pool_state = dynamic_cast<PoolOpKernelState*>(state);
     CHECK(pool_state != nullptr);
     pool_state->Update(x->shape());
     const std::string& data_format = ctx->Attr<std::string>("data_format");
     if (data_format == "channels_first") {
-      CFirstBackward(pool_state->GetParams3D(), dy, y, x, dx,
-                     [](const T& in, const T& out, const T& out_diff, const int64_t size,
-                        T& in_diff) { in_diff += (out_diff / static_cast<T>(size)); });
+      CFirstBackward(pool_state->GetParams3D(), is_max, dy, y, x, argmax, dx);
     } else if (data_format == "channels_last") {
-      CLastBackward(pool_state->GetParams3D(), dy, y, x, dx,
-                    [](const int64_t out_col, const int64_t in_col, const int64_t size,
-                       ConstEigenArrayMap<T>& out_arr, ConstEigenArrayMap<T>& in_arr,
-                       ConstEigenArrayMap<T>& out_diff_arr, EigenArrayMap<T>& in_diff_arr) {
-                      in_diff_arr.col(in_col) += out_diff_arr.col(out_col) / static_cast<T>(size);
-                    });
+      CLastBackward(pool_state->GetParams3D(), is_max, dy, y, x, argmax, dx);
     } else {
       UNIMPLEMENTED();
     }
   }
 
+  static void AvgFWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) {
+    FWCompute(ctx, state, false);
+  }
+
+  static void AvgBWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) {
+    BWCompute(ctx, state, false);
+  }
+
   static void MaxFWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) {
-    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
-    user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
-    auto* pool_state = dynamic_cast<PoolOpKernelState*>(state);
-    CHECK(pool_state != nullptr);
-    pool_state->Update(x->shape());
-    const std::string& data_format = ctx->Attr<std::string>("data_format");
-    if (data_format == "channels_first") {
-      CFirstForward(pool_state->GetParams3D(), x, y, GetMinVal<T>,
-                    [](const T& lhs, T& rhs) {
-                      if (lhs > rhs) { rhs = lhs; }
-                    },
-                    [](const int64_t size, T& out) {});
-    } else if (data_format == "channels_last") {
-      CLastForward(pool_state->GetParams3D(), x, y, GetMinVal<T>,
-                   [](const int64_t in_col, const int64_t out_col, ConstEigenMatrixMap<T>& in_mat,
-                      EigenMatrixMap<T>& out_mat) {
-                     out_mat.col(out_col) = out_mat.col(out_col).cwiseMax(in_mat.col(in_col));
-                   },
-                   [](const int64_t size, const int64_t col, EigenMatrixMap<T>& out_mat) {});
-    } else {
-      UNIMPLEMENTED();
-    }
+    FWCompute(ctx, state, true);
   }
 
   static void MaxBWCompute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) {
-    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
-    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
-    const user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
-    user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
-    auto* pool_state = dynamic_cast<PoolOpKernelState*>(state);
-    CHECK(pool_state != nullptr);
-    pool_state->Update(x->shape());
-    const std::string& data_format = ctx->Attr<std::string>("data_format");
-    if (data_format == "channels_first") {
-      CFirstBackward(
-          pool_state->GetParams3D(), dy, y, x, dx,
-          [](const T& in, const T& out, const T& out_diff, const int64_t size, T& in_diff) {
-            if (in == out) { in_diff += out_diff; }
-          });
-    } else if (data_format == "channels_last") {
-      CLastBackward(
-          pool_state->GetParams3D(), dy, y, x, dx,
-          [](const int64_t out_col, const int64_t in_col, const int64_t size,
-             ConstEigenArrayMap<T>& out_arr, ConstEigenArrayMap<T>& in_arr,
-             ConstEigenArrayMap<T>& out_diff_arr, EigenArrayMap<T>& in_diff_arr) {
-            in_diff_arr.col(in_col) +=
-                out_diff_arr.col(out_col)
-                * (in_arr.col(in_col).cwiseEqual(out_arr.col(out_col)).template cast<T>());
-          });
-    } else {
-      UNIMPLEMENTED();
-    }
+    BWCompute(ctx, state, true);
   }
 };
 
@@ -0,0 +1,271 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/kernels/cpu_int8_gemm.h"
+#include "oneflow/user/kernels/variable_version.h"
+
+namespace oneflow {
+
+namespace {
+
+// Quantized and packed weights of a predict job. They are rebuilt when the weight is another
+// buffer, when a variable has been overwritten or when the weight scale changes.
+class QuantizedWeightState final : public user_op::OpKernelState {
+ public:
+  QuantizedWeightState() : weight_dptr_(nullptr), variable_version_(-1) {}
+  ~QuantizedWeightState() override = default;
+
+  // weight is op(b) of the gemm, weight_scale has 1 or n elements
+  void QuantizeAndPackIfStale(const user_op::Tensor* weight, const user_op::Tensor* weight_scale,
+                              int32_t quantization_bit, enum CBLAS_TRANSPOSE trans_b, int32_t k,
+                              int32_t n) {
+    const int64_t variable_version = CurrentVariableVersion();
+    const float* scale_ptr = weight_scale->dptr<float>();
+    const int64_t scale_size = weight_scale->shape().elem_cnt();
+    if (weight->dptr() == weight_dptr_ && variable_version == variable_version_
+        && scale_size == weight_scale_.size()
+        && std::equal(scale_ptr, scale_ptr + scale_size, weight_scale_.begin())) {
+      return;
+    }
+    const int64_t elem_cnt = weight->shape().elem_cnt();
+    std::vector<int8_t> quantized(elem_cnt);
+    if (scale_size == 1) {
+      QuantizeSymmetric(weight->dptr<float>(), scale_ptr[0], quantization_bit, elem_cnt,
+                        quantized.data());
+    } else {
+      // per-channel scales go along n, which is the outer axis of the transposed weight
+      CHECK_EQ(trans_b, CblasTrans);
+      CHECK_EQ(scale_size, n);
+      FOR_RANGE(int32_t, j, 0, n) {
+        QuantizeSymmetric(weight->dptr<float>() + j * k, scale_ptr[j], quantization_bit, k,
+                          quantized.data() + j * k);
+      }
+    }
+    gemm_.PackB(trans_b, k, n, quantized.data());
+    weight_dptr_ = weight->dptr();
+    variable_version_ = variable_version;
+    weight_scale_.assign(scale_ptr, scale_ptr + scale_size);
+  }
+
+  const CpuInt8Gemm& gemm() const { return gemm_; }
+  CpuInt8Gemm* mut_gemm() { return &gemm_; }
+  float WeightScale4Col(int32_t j) const {
+    return weight_scale_.size() == 1 ? weight_scale_.front() : weight_scale_.at(j);
+  }
+
+ private:
+  const void* weight_dptr_;
+  int64_t variable_version_;
+  std::vector<float> weight_scale_;
+  CpuInt8Gemm gemm_;
+};
+
+// out = in_scale * weight_scale * (c - zero_point * weight_col_sum) + bias
+void Dequantize(const QuantizedWeightState& state, const int32_t* c, int32_t m, float in_scale,
+                float zero_point, const float* bias, float* out) {
+  const CpuInt8Gemm& gemm = state.gemm();
+  const int32_t n = gemm.n();
+  std::vector<float> col_scale(n);
+  std::vector<float> col_offset(n);
+  FOR_RANGE(int32_t, j, 0, n) {
+    col_scale[j] = in_scale * state.WeightScale4Col(j);
+    col_offset[j] = -zero_point * gemm.b_col_sum()[j] * col_scale[j];
+    if (bias != nullptr) { col_offset[j] += bias[j]; }
+  }
+  FOR_RANGE(int32_t, i, 0, m) {
+    const int32_t* c_row = c + static_cast<int64_t>(i) * n;
+    float* out_row = out + static_cast<int64_t>(i) * n;
+    FOR_RANGE(int32_t, j, 0, n) { out_row[j] = c_row[j] * col_scale[j] + col_offset[j]; }
+  }
+}
+
+size_t InferQuantizedMatmulTmpSize(user_op::InferContext* ctx) {
+  const Shape* a_shape = ctx->Shape4ArgNameAndIndex("a", 0);
+  const Shape* out_shape = ctx->Shape4ArgNameAndIndex("out", 0);
+  return GetCudaAlignedSize(a_shape->elem_cnt() * sizeof(uint8_t))
+         + GetCudaAlignedSize(out_shape->elem_cnt() * sizeof(int32_t));
+}
+
+size_t InferQuantizedConv2DTmpSize(user_op::InferContext* ctx) {
+  const Shape* in_shape = ctx->Shape4ArgNameAndIndex("in", 0);
+  const Shape* weight_shape = ctx->Shape4ArgNameAndIndex("weight", 0);
+  const Shape* out_shape = ctx->Shape4ArgNameAndIndex("out", 0);
+  const int64_t out_spatial_size = out_shape->Count(2);
+  return GetCudaAlignedSize(in_shape->elem_cnt() * sizeof(uint8_t))
+         + GetCudaAlignedSize(out_spatial_size * weight_shape->Count(1) * sizeof(uint8_t))
+         + GetCudaAlignedSize(out_spatial_size * out_shape->At(1) * sizeof(int32_t))
+         + GetCudaAlignedSize(out_spatial_size * out_shape->At(1) * sizeof(float));
+}
+
+class CpuQuantizedMatmulKernel final : public user_op::OpKernel {
+ public:
+  CpuQuantizedMatmulKernel() = default;
+  ~CpuQuantizedMatmulKernel() = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<QuantizedWeightState>();
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    auto* weight_state = dynamic_cast<QuantizedWeightState*>(state);
+    CHECK_NOTNULL(weight_state);
+    const user_op::Tensor* a = ctx->Tensor4ArgNameAndIndex("a", 0);
+    const user_op::Tensor* a_scale = ctx->Tensor4ArgNameAndIndex("a_scale", 0);
+    const user_op::Tensor* a_zero_point = ctx->Tensor4ArgNameAndIndex("a_zero_point", 0);
+    const user_op::Tensor* b = ctx->Tensor4ArgNameAndIndex("b", 0);
+    const user_op::Tensor* b_scale = ctx->Tensor4ArgNameAndIndex("b_scale", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const int32_t quantization_bit = ctx->Attr<int32_t>("quantization_bit");
+    const std::string& quantization_scheme = ctx->Attr<std::string>("quantization_scheme");
+    const CBLAS_TRANSPOSE trans_b = ctx->Attr<bool>("transpose_b") ? CblasTrans : CblasNoTrans;
+
+    const int32_t m = a->shape().At(0);
+    const int32_t k = a->shape().At(1);
+    const int32_t n = out->shape().At(1);
+    weight_state->QuantizeAndPackIfStale(b, b_scale, quantization_bit, trans_b, k, n);
+
+    uint8_t* quantized_a = tmp_buffer->mut_dptr<uint8_t>();
+    int32_t* c = reinterpret_cast<int32_t*>(tmp_buffer->mut_dptr<char>()
+                                            + GetCudaAlignedSize(a->shape().elem_cnt()));
+    const float scale = a_scale->dptr<float>()[0];
+    const float zero_point = a_zero_point->dptr<float>()[0];
+    QuantizeToUint8(a->dptr<float>(), scale, zero_point, quantization_scheme, quantization_bit,
+                    a->shape().elem_cnt(), quantized_a);
+    weight_state->mut_gemm()->Gemm(m, quantized_a, c);
+    Dequantize(*weight_state, c, m, scale, Uint8ZeroPoint(zero_point, quantization_scheme),
+               nullptr, out->mut_dptr<float>());
+  }
+};
+
+REGISTER_USER_KERNEL("quantized_matmul")
+    .SetCreateFn<CpuQuantizedMatmulKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceTag() == DeviceType::kCPU)
+                     & (user_op::HobDataType("a", 0) == DataType::kFloat))
+    .SetInferTmpSizeFn(InferQuantizedMatmulTmpSize);
+
+// The convolution is computed per image as out^T = im2row(in) * weight^T, so that the weight is
+// the packed right hand side and its per-channel scales go along the columns.
+class CpuQuantizedConv2DKernel final : public user_op::OpKernel {
+ public:
+  CpuQuantizedConv2DKernel() = default;
+  ~CpuQuantizedConv2DKernel() = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<QuantizedWeightState>();
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    auto* weight_state = dynamic_cast<QuantizedWeightState*>(state);
+    CHECK_NOTNULL(weight_state);
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    const user_op::Tensor* in_scale = ctx->Tensor4ArgNameAndIndex("in_scale", 0);
+    const user_op::Tensor* in_zero_point = ctx->Tensor4ArgNameAndIndex("in_zero_point", 0);
+    const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const user_op::Tensor* weight_scale = ctx->Tensor4ArgNameAndIndex("weight_scale", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const int32_t quantization_bit = ctx->Attr<int32_t>("quantization_bit");
+    const std::string& quantization_scheme = ctx->Attr<std::string>("quantization_scheme");
+    const auto& padding_before = ctx->Attr<std::vector<int32_t>>("padding_before");
+    const auto& kernel_size = ctx->Attr<std::vector<int32_t>>("kernel_size");
+    const auto& strides = ctx->Attr<std::vector<int32_t>>("strides");
+    const auto& dilation_rate = ctx->Attr<std::vector<int32_t>>("dilation_rate");
+
+    const int64_t num_images = in->shape().At(0);
+    const int64_t channels = in->shape().At(1);
+    const int64_t in_h = in->shape().At(2);
+    const int64_t in_w = in->shape().At(3);
+    const int32_t filters = out->shape().At(1);
+    const int64_t out_h = out->shape().At(2);
+    const int64_t out_w = out->shape().At(3);
+    const int32_t k = weight->shape().Count(1);
+    const int32_t out_spatial_size = out_h * out_w;
+    weight_state->QuantizeAndPackIfStale(weight, weight_scale, quantization_bit, CblasTrans, k,
+                                         filters);
+
+    char* tmp_ptr = tmp_buffer->mut_dptr<char>();
+    uint8_t* quantized_in = reinterpret_cast<uint8_t*>(tmp_ptr);
+    tmp_ptr += GetCudaAlignedSize(in->shape().elem_cnt());
+    uint8_t* col = reinterpret_cast<uint8_t*>(tmp_ptr);
+    tmp_ptr += GetCudaAlignedSize(static_cast<int64_t>(out_spatial_size) * k);
+    int32_t* c = reinterpret_cast<int32_t*>(tmp_ptr);
+    tmp_ptr += GetCudaAlignedSize(static_cast<int64_t>(out_spatial_size) * filters
+                                  * sizeof(int32_t));
+    // out of one image in (h * w, filters) order
+    float* out_t = reinterpret_cast<float*>(tmp_ptr);
+
+    const float scale = in_scale->dptr<float>()[0];
+    const float zero_point = in_zero_point->dptr<float>()[0];
+    QuantizeToUint8(in->dptr<float>(), scale, zero_point, quantization_scheme, quantization_bit,
+                    in->shape().elem_cnt(), quantized_in);
+    // the padding is a quantized 0.0
+    const float zero = 0;
+    uint8_t quantized_zero = 0;
+    QuantizeToUint8(&zero, scale, zero_point, quantization_scheme, quantization_bit, 1,
+                    &quantized_zero);
+    const float folded_zero_point = Uint8ZeroPoint(zero_point, quantization_scheme);
+    const float* bias_ptr = bias != nullptr ? bias->dptr<float>() : nullptr;
+
+    FOR_RANGE(int64_t, image, 0, num_images) {
+      const uint8_t* image_ptr = quantized_in + image * channels * in_h * in_w;
+      FOR_RANGE(int64_t, oh, 0, out_h) {
+        FOR_RANGE(int64_t, ow, 0, out_w) {
+          uint8_t* col_row = col + (oh * out_w + ow) * k;
+          FOR_RANGE(int64_t, ch, 0, channels) {
+            FOR_RANGE(int32_t, kh, 0, kernel_size.at(0)) {
+              const int64_t ih =
+                  oh * strides.at(0) - padding_before.at(0) + kh * dilation_rate.at(0);
+              FOR_RANGE(int32_t, kw, 0, kernel_size.at(1)) {
+                const int64_t iw =
+                    ow * strides.at(1) - padding_before.at(1) + kw * dilation_rate.at(1);
+                *(col_row++) = (ih >= 0 && ih < in_h && iw >= 0 && iw < in_w)
+                                   ? image_ptr[(ch * in_h + ih) * in_w + iw]
+                                   : quantized_zero;
+              }
+            }
+          }
+        }
+      }
+      weight_state->mut_gemm()->Gemm(out_spatial_size, col, c);
+      Dequantize(*weight_state, c, out_spatial_size, scale, folded_zero_point, bias_ptr,
+                 out_t);
+      float* out_ptr = out->mut_dptr<float>() + image * filters * out_spatial_size;
+      FOR_RANGE(int32_t, oc, 0, filters) {
+        FOR_RANGE(int32_t, p, 0, out_spatial_size) {
+          out_ptr[oc * out_spatial_size + p] = out_t[p * filters + oc];
+        }
+      }
+    }
+  }
+};
+
+REGISTER_USER_KERNEL("quantized_conv2d")
+    .SetCreateFn<CpuQuantizedConv2DKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceTag() == DeviceType::kCPU)
+                     & (user_op::HobDataType("in", 0) == DataType::kFloat))
+    .SetInferTmpSizeFn(InferQuantizedConv2DTmpSize);
+
+}  // namespace
+
+}  // namespace oneflow
@@ -30,7 +30,7 @@ std::shared_ptr<RandomCropKernelState> CreateRandomCropKernelState(
   CHECK(random_area.size() == 2 && 0 < random_area.at(0) && random_area.at(0) <= random_area.at(1));
   const user_op::TensorDesc* out_tensor_desc = ctx->TensorDesc4ArgNameAndIndex("out", 0);
   return std::shared_ptr<RandomCropKernelState>(
-      new RandomCropKernelState(out_tensor_desc->shape().elem_cnt(), GetOpKernelRandomSeed(ctx),
+      new RandomCropKernelState(out_tensor_desc->shape().At(0), GetOpKernelRandomSeed(ctx),
                                 {random_aspect_ratio.at(0), random_aspect_ratio.at(1)},
                                 {random_area.at(0), random_area.at(1)}, num_attempts));
 }
@@ -19,6 +19,7 @@ limitations under the License.
 #include "oneflow/user/kernels/slice_util.h"
 #include "oneflow/core/kernel/kernel_util.h"
 #include "oneflow/user/kernels/op_kernel_state_wrapper.h"
+#include "oneflow/user/kernels/variable_version.h"
 
 namespace oneflow {
 
@@ -350,6 +351,7 @@ class LogicalSliceAssignKernel final : public user_op::OpKernel {
     const SliceContext& slice_ctx = dynamic_cast<OpKernelStateWrapper<SliceContext>*>(state)->Get();
     SwitchWriteSlice(SwitchCase(value_tensor->shape().NumAxes(), value_tensor->data_type()), ctx,
                      value_tensor, ref_tensor, slice_ctx, false);
+    IncreaseVariableVersion();
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
 };
@@ -0,0 +1,355 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/framework/multi_thread.h"
+
+namespace oneflow {
+
+namespace {
+
+// An output row or column reads input index lo, or interpolates lo and hi for bilinear:
+//   out = in[lo] + (in[hi] - in[lo]) * lerp
+struct InterpParam {
+  int64_t lo;
+  int64_t hi;
+  float lerp;
+};
+
+// The source coordinate follows the gpu kernels when align_corners is false, and maps the corner
+// pixels of input and output onto each other otherwise
+std::vector<InterpParam> GenInterpParams(int64_t in_size, int64_t out_size, float scale,
+                                         bool align_corners, bool is_bilinear) {
+  std::vector<InterpParam> params(out_size);
+  const float inv_scale = 1.f / scale;
+  const float corner_scale =
+      out_size > 1 ? static_cast<float>(in_size - 1) / static_cast<float>(out_size - 1) : 0.f;
+  FOR_RANGE(int64_t, i, 0, out_size) {
+    InterpParam* param = &params.at(i);
+    if (!is_bilinear) {
+      const int64_t src = align_corners
+                              ? static_cast<int64_t>(std::round(i * corner_scale))
+                              : static_cast<int64_t>(std::floor((i + 0.5f) * inv_scale));
+      param->lo = std::max(std::min(src, in_size - 1), static_cast<int64_t>(0));
+      param->hi = param->lo;
+      param->lerp = 0.f;
+    } else if (align_corners) {
+      const float src = i * corner_scale;
+      param->lo = std::min(static_cast<int64_t>(std::floor(src)), in_size - 1);
+      param->hi = std::min(param->lo + 1, in_size - 1);
+      param->lerp = src - param->lo;
+    } else {
+      const float src = (i + 0.5f) * inv_scale - 0.5f;
+      param->lo = src > 0.f ? static_cast<int64_t>(std::floor(src)) : 0;
+      param->hi = src < in_size - 1 ? static_cast<int64_t>(std::ceil(src)) : in_size - 1;
+      param->lerp = src - std::floor(src);
+    }
+  }
+  return params;
+}
+
+// Spatial layout of x (or dx) and y (or dy), both in NCHW or NHWC
+struct UpsampleShape {
+  int64_t num;
+  int64_t channels;
+  int64_t in_h;
+  int64_t in_w;
+  int64_t out_h;
+  int64_t out_w;
+  UpsampleShape(const ShapeView& in, const ShapeView& out, bool channels_first) {
+    const int32_t h_axis = channels_first ? 2 : 1;
+    num = in.At(0);
+    channels = in.At(channels_first ? 1 : 3);
+    in_h = in.At(h_axis);
+    in_w = in.At(h_axis + 1);
+    out_h = out.At(h_axis);
+    out_w = out.At(h_axis + 1);
+  }
+  bool operator==(const UpsampleShape& rhs) const {
+    return num == rhs.num && channels == rhs.channels && in_h == rhs.in_h && in_w == rhs.in_w
+           && out_h == rhs.out_h && out_w == rhs.out_w;
+  }
+};
+
+// Interpolation indices and weights only depend on the spatial sizes, so they are computed once
+// per shape instead of for every output element
+class UpsampleOpKernelState final : public user_op::OpKernelState {
+ public:
+  UpsampleOpKernelState(user_op::KernelInitContext* ctx, const UpsampleShape& shape)
+      : height_scale_(ctx->Attr<float>("height_scale")),
+        width_scale_(ctx->Attr<float>("width_scale")),
+        align_corners_(ctx->Attr<bool>("align_corners")),
+        is_bilinear_(ctx->Attr<std::string>("interpolation") == "bilinear"),
+        shape_(shape) {
+    Reset();
+  }
+  ~UpsampleOpKernelState() override = default;
+
+  const UpsampleShape& shape() const { return shape_; }
+  const std::vector<InterpParam>& h_params() const { return h_params_; }
+  const std::vector<InterpParam>& w_params() const { return w_params_; }
+  bool is_bilinear() const { return is_bilinear_; }
+
+  void Update(const UpsampleShape& shape) {
+    if (shape == shape_) { return; }
+    shape_ = shape;
+    Reset();
+  }
+
+ private:
+  void Reset() {
+    h_params_ =
+        GenInterpParams(shape_.in_h, shape_.out_h, height_scale_, align_corners_, is_bilinear_);
+    w_params_ =
+        GenInterpParams(shape_.in_w, shape_.out_w, width_scale_, align_corners_, is_bilinear_);
+  }
+
+  float height_scale_;
+  float width_scale_;
+  bool align_corners_;
+  bool is_bilinear_;
+  UpsampleShape shape_;
+  std::vector<InterpParam> h_params_;
+  std::vector<InterpParam> w_params_;
+};
+
+std::shared_ptr<user_op::OpKernelState> CreateUpsampleOpKernelState(
+    user_op::KernelInitContext* ctx, const std::string& in_name, const std::string& out_name) {
+  const bool channels_first = ctx->Attr<std::string>("data_format") == "channels_first";
+  const UpsampleShape shape(ShapeView(ctx->TensorDesc4ArgNameAndIndex(in_name, 0)->shape()),
+                            ShapeView(ctx->TensorDesc4ArgNameAndIndex(out_name, 0)->shape()),
+                            channels_first);
+  return std::make_shared<UpsampleOpKernelState>(ctx, shape);
+}
+
+// Channels of one image accumulated by a task of the NHWC backward
+constexpr int64_t kChannelsPerTask = 16;
+
+template<typename T>
+void UpsampleNCHWForward(const UpsampleOpKernelState& state, const T* x, T* y) {
+  const UpsampleShape& shape = state.shape();
+  const std::vector<InterpParam>& h_params = state.h_params();
+  const std::vector<InterpParam>& w_params = state.w_params();
+  const int64_t num_rows = shape.num * shape.channels * shape.out_h;
+  user_op::ParallelForEachTask(num_rows, shape.out_w, [&](int64_t row) {
+    const int64_t plane = row / shape.out_h;
+    const InterpParam& h_param = h_params.at(row % shape.out_h);
+    const T* top = x + (plane * shape.in_h + h_param.lo) * shape.in_w;
+    T* out = y + row * shape.out_w;
+    if (!state.is_bilinear()) {
+      FOR_RANGE(int64_t, ow, 0, shape.out_w) { out[ow] = top[w_params[ow].lo]; }
+      return;
+    }
+    const T* bottom = x + (plane * shape.in_h + h_param.hi) * shape.in_w;
+    const T h_lerp = h_param.lerp;
+    FOR_RANGE(int64_t, ow, 0, shape.out_w) {
+      const InterpParam& w_param = w_params[ow];
+      const T w_lerp = w_param.lerp;
+      const T t = top[w_param.lo] + (top[w_param.hi] - top[w_param.lo]) * w_lerp;
+      const T b = bottom[w_param.lo] + (bottom[w_param.hi] - bottom[w_param.lo]) * w_lerp;
+      out[ow] = t + (b - t) * h_lerp;
+    }
+  });
+}
+
+template<typename T>
+void UpsampleNCHWBackward(const UpsampleOpKernelState& state, const T* dy, T* dx) {
+  const UpsampleShape& shape = state.shape();
+  const std::vector<InterpParam>& h_params = state.h_params();
+  const std::vector<InterpParam>& w_params = state.w_params();
+  // a task accumulates into one whole dx plane, so no two tasks write the same element
+  const int64_t num_planes = shape.num * shape.channels;
+  user_op::ParallelForEachTask(num_planes, shape.out_h * shape.out_w, [&](int64_t plane) {
+    T* dx_plane = dx + plane * shape.in_h * shape.in_w;
+    std::fill(dx_plane, dx_plane + shape.in_h * shape.in_w, GetZeroVal<T>());
+    FOR_RANGE(int64_t, oh, 0, shape.out_h) {
+      const InterpParam& h_param = h_params[oh];
+      const T* in = dy + (plane * shape.out_h + oh) * shape.out_w;
+      T* top = dx_plane + h_param.lo * shape.in_w;
+      if (!state.is_bilinear()) {
+        FOR_RANGE(int64_t, ow, 0, shape.out_w) { top[w_params[ow].lo] += in[ow]; }
+        continue;
+      }
+      T* bottom = dx_plane + h_param.hi * shape.in_w;
+      const T h_lerp = h_param.lerp;
+      FOR_RANGE(int64_t, ow, 0, shape.out_w) {
+        const InterpParam& w_param = w_params[ow];
+        const T w_lerp = w_param.lerp;
+        const T dbottom = h_lerp * in[ow];
+        const T dtop = in[ow] - dbottom;
+        top[w_param.lo] += (1 - w_lerp) * dtop;
+        top[w_param.hi] += w_lerp * dtop;
+        bottom[w_param.lo] += (1 - w_lerp) * dbottom;
+        bottom[w_param.hi] += w_lerp * dbottom;
+      }
+    }
+  });
+}
+
+// NHWC interpolates whole channel vectors, so the innermost loops are contiguous
+template<typename T>
+void UpsampleNHWCForward(const UpsampleOpKernelState& state, const T* x, T* y) {
+  const UpsampleShape& shape = state.shape();
+  const std::vector<InterpParam>& h_params = state.h_params();
+  const std::vector<InterpParam>& w_params = state.w_params();
+  const int64_t channels = shape.channels;
+  user_op::ParallelForEachTask(shape.num * shape.out_h, shape.out_w * channels, [&](int64_t row) {
+    const int64_t n = row / shape.out_h;
+    const InterpParam& h_param = h_params.at(row % shape.out_h);
+    const T* top = x + (n * shape.in_h + h_param.lo) * shape.in_w * channels;
+    const T* bottom = x + (n * shape.in_h + h_param.hi) * shape.in_w * channels;
+    const T h_lerp = h_param.lerp;
+    FOR_RANGE(int64_t, ow, 0, shape.out_w) {
+      const InterpParam& w_param = w_params[ow];
+      T* out = y + (row * shape.out_w + ow) * channels;
+      const T* top_left = top + w_param.lo * channels;
+      if (!state.is_bilinear()) {
+        std::copy(top_left, top_left + channels, out);
+        continue;
+      }
+      const T* top_right = top + w_param.hi * channels;
+      const T* bottom_left = bottom + w_param.lo * channels;
+      const T* bottom_right = bottom + w_param.hi * channels;
+      const T w_lerp = w_param.lerp;
+      FOR_RANGE(int64_t, c, 0, channels) {
+        const T t = top_left[c] + (top_right[c] - top_left[c]) * w_lerp;
+        const T b = bottom_left[c] + (bottom_right[c] - bottom_left[c]) * w_lerp;
+        out[c] = t + (b - t) * h_lerp;
+      }
+    }
+  });
+}
+
+template<typename T>
+void UpsampleNHWCBackward(const UpsampleOpKernelState& state, const T* dy, T* dx) {
+  const UpsampleShape& shape = state.shape();
+  const std::vector<InterpParam>& h_params = state.h_params();
+  const std::vector<InterpParam>& w_params = state.w_params();
+  const int64_t channels = shape.channels;
+  // tasks own disjoint channel ranges of one image, so no two tasks write the same element
+  const int64_t tasks_per_image = (channels + kChannelsPerTask - 1) / kChannelsPerTask;
+  const int64_t task_work = shape.out_h * shape.out_w * std::min(channels, kChannelsPerTask);
+  user_op::ParallelForEachTask(shape.num * tasks_per_image, task_work, [&](int64_t task) {
+    const int64_t n = task / tasks_per_image;
+    const int64_t c_begin = task % tasks_per_image * kChannelsPerTask;
+    const int64_t c_end = std::min(c_begin + kChannelsPerTask, channels);
+    T* dx_image = dx + n * shape.in_h * shape.in_w * channels;
+    FOR_RANGE(int64_t, i, 0, shape.in_h * shape.in_w) {
+      std::fill(dx_image + i * channels + c_begin, dx_image + i * channels + c_end,
+                GetZeroVal<T>());
+    }
+    FOR_RANGE(int64_t, oh, 0, shape.out_h) {
+      const InterpParam& h_param = h_params[oh];
+      T* top = dx_image + h_param.lo * shape.in_w * channels;
+      T* bottom = dx_image + h_param.hi * shape.in_w * channels;
+      const T h_lerp = h_param.lerp;
+      FOR_RANGE(int64_t, ow, 0, shape.out_w) {
+        const InterpParam& w_param = w_params[ow];
+        const T* in = dy + ((n * shape.out_h + oh) * shape.out_w + ow) * channels;
+        T* top_left = top + w_param.lo * channels;
+        if (!state.is_bilinear()) {
+          FOR_RANGE(int64_t, c, c_begin, c_end) { top_left[c] += in[c]; }
+          continue;
+        }
+        T* top_right = top + w_param.hi * channels;
+        T* bottom_left = bottom + w_param.lo * channels;
+        T* bottom_right = bottom + w_param.hi * channels;
+        const T w_lerp = w_param.lerp;
+        FOR_RANGE(int64_t, c, c_begin, c_end) {
+          const T dbottom = h_lerp * in[c];
+          const T dtop = in[c] - dbottom;
+          top_left[c] += (1 - w_lerp) * dtop;
+          top_right[c] += w_lerp * dtop;
+          bottom_left[c] += (1 - w_lerp) * dbottom;
+          bottom_right[c] += w_lerp * dbottom;
+        }
+      }
+    }
+  });
+}
+
+}  // namespace
+
+template<typename T>
+class UpsampleCpuKernel final : public user_op::OpKernel {
+ public:
+  UpsampleCpuKernel() = default;
+  ~UpsampleCpuKernel() = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return CreateUpsampleOpKernelState(ctx, "x", "y");
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    auto* upsample_state = dynamic_cast<UpsampleOpKernelState*>(state);
+    CHECK_NOTNULL(upsample_state);
+    const bool channels_first = ctx->Attr<std::string>("data_format") == "channels_first";
+    upsample_state->Update(UpsampleShape(x->shape(), y->shape(), channels_first));
+    if (channels_first) {
+      UpsampleNCHWForward<T>(*upsample_state, x->dptr<T>(), y->mut_dptr<T>());
+    } else {
+      UpsampleNHWCForward<T>(*upsample_state, x->dptr<T>(), y->mut_dptr<T>());
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T>
+class UpsampleGradCpuKernel final : public user_op::OpKernel {
+ public:
+  UpsampleGradCpuKernel() = default;
+  ~UpsampleGradCpuKernel() = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return CreateUpsampleOpKernelState(ctx, "dx", "dy");
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    if (dx == nullptr) { return; }
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    auto* upsample_state = dynamic_cast<UpsampleOpKernelState*>(state);
+    CHECK_NOTNULL(upsample_state);
+    const bool channels_first = ctx->Attr<std::string>("data_format") == "channels_first";
+    upsample_state->Update(UpsampleShape(dx->shape(), dy->shape(), channels_first));
+    if (channels_first) {
+      UpsampleNCHWBackward<T>(*upsample_state, dy->dptr<T>(), dx->mut_dptr<T>());
+    } else {
+      UpsampleNHWCBackward<T>(*upsample_state, dy->dptr<T>(), dx->mut_dptr<T>());
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_UPSAMPLE_CPU_KERNEL(dtype)                                            \
+  REGISTER_USER_KERNEL("upsample")                                                     \
+      .SetCreateFn<UpsampleCpuKernel<dtype>>()                                         \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)); \
+  REGISTER_USER_KERNEL("upsample_grad")                                                \
+      .SetCreateFn<UpsampleGradCpuKernel<dtype>>()                                     \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
+                       & (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value));
+
+REGISTER_UPSAMPLE_CPU_KERNEL(float)
+REGISTER_UPSAMPLE_CPU_KERNEL(double)
+
+}  // namespace oneflow
@@ -0,0 +1,32 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_VARIABLE_VERSION_H_
+#define ONEFLOW_USER_KERNELS_VARIABLE_VERSION_H_
+
+#include <cstdint>
+
+namespace oneflow {
+
+// Process wide counter bumped by every kernel which overwrites a variable, i.e. the model update
+// kernels of a train job, the model init and load kernels, and assign and logical_slice_assign
+// used by checkpoint loading. Kernels caching data derived from a variable, e.g. in a predict job
+// of the same session, compare it with the version they cached to detect stale entries.
+int64_t CurrentVariableVersion();
+void IncreaseVariableVersion();
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_VARIABLE_VERSION_H_
@@ -0,0 +1,84 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+// Axis of each bias_add step of the expression, in the order of in_1, in_2 ...
+Maybe<void> GetOperandAxes(const std::vector<std::string>& op_type_names,
+                           const std::vector<int32_t>& axes, std::vector<int32_t>* operand_axes) {
+  CHECK_EQ_OR_RETURN(op_type_names.size(), axes.size());
+  FOR_RANGE(int64_t, i, 0, op_type_names.size()) {
+    if (op_type_names.at(i) == "bias_add") { operand_axes->push_back(axes.at(i)); }
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_USER_OP("fused_elementwise")
+    .InputWithMinimum("in", 1)
+    .Output("out")
+    .Attr<std::vector<std::string>>("op_type_names")
+    .Attr<std::vector<float>>("scalars")
+    .Attr<std::vector<int32_t>>("axes")
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const auto& op_type_names = ctx->Attr<std::vector<std::string>>("op_type_names");
+      CHECK_EQ_OR_RETURN(ctx->Attr<std::vector<float>>("scalars").size(), op_type_names.size());
+      std::vector<int32_t> operand_axes;
+      JUST(GetOperandAxes(op_type_names, ctx->Attr<std::vector<int32_t>>("axes"), &operand_axes));
+      CHECK_EQ_OR_RETURN(operand_axes.size() + 1, ctx->user_op_conf().input_size("in"));
+      const user_op::TensorDesc* in = ctx->TensorDesc4ArgNameAndIndex("in", 0);
+      FOR_RANGE(int32_t, i, 0, operand_axes.size()) {
+        const user_op::TensorDesc* operand = ctx->TensorDesc4ArgNameAndIndex("in", i + 1);
+        const int32_t axis = operand_axes.at(i);
+        CHECK_GE_OR_RETURN(axis, 0);
+        CHECK_LT_OR_RETURN(axis, in->shape().NumAxes());
+        CHECK_EQ_OR_RETURN(operand->shape().NumAxes(), 1);
+        CHECK_EQ_OR_RETURN(operand->shape().At(0), in->shape().At(axis));
+        CHECK_EQ_OR_RETURN(operand->data_type(), in->data_type());
+      }
+      *ctx->TensorDesc4ArgNameAndIndex("out", 0) = *in;
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      *ctx->BatchAxis4ArgNameAndIndex("out", 0) = *ctx->BatchAxis4ArgNameAndIndex("in", 0);
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      std::vector<int32_t> operand_axes;
+      JUST(GetOperandAxes(ctx->Attr<std::vector<std::string>>("op_type_names"),
+                          ctx->Attr<std::vector<int32_t>>("axes"), &operand_axes));
+      const user_op::TensorDesc& in = ctx->LogicalTensorDesc4InputArgNameAndIndex("in", 0);
+      FOR_RANGE(int64_t, axis, 0, in.shape().NumAxes()) {
+        auto builder = ctx->NewBuilder();
+        builder.Split(user_op::OpArg("in", 0), axis).Split(user_op::OpArg("out", 0), axis);
+        // an operand is split with the axis it is added along and broadcast otherwise
+        FOR_RANGE(int32_t, i, 0, operand_axes.size()) {
+          if (operand_axes.at(i) == axis) {
+            builder.Split(user_op::OpArg("in", i + 1), 0);
+          } else {
+            builder.Broadcast(user_op::OpArg("in", i + 1));
+          }
+        }
+        builder.Build();
+      }
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace oneflow
@@ -190,4 +190,93 @@ REGISTER_CPU_ONLY_USER_OP("image_random_crop")
     })
     .SetBatchAxisInferFn(user_op::BatchAxisInferFnUtil::NaiveInferBatchAxis);
 
+REGISTER_CPU_ONLY_USER_OP("image_decode_random_crop_resize_normalize")
+    .Input("in")
+    .OptionalInput("mirror")
+    .Output("out")
+    .Attr<std::string>("color_space", "BGR")
+    .Attr<int32_t>("num_attempts", 10)
+    .Attr<int64_t>("seed", -1)
+    .Attr<bool>("has_seed", false)
+    .Attr<std::vector<float>>("random_area", {0.08, 1.0})
+    .Attr<std::vector<float>>("random_aspect_ratio", {0.75, 1.333333})
+    .Attr<int64_t>("target_width", 0)
+    .Attr<int64_t>("target_height", 0)
+    .Attr<std::string>("interpolation_type", "bilinear")
+    .Attr<std::string>("output_layout", "NCHW")
+    .Attr<std::vector<float>>("mean", {0.0})
+    .Attr<std::vector<float>>("std", {1.0})
+    .Attr<DataType>("output_dtype", DataType::kFloat)
+    .SetCheckAttrFn([](const user_op::UserOpDefWrapper& def,
+                       const user_op::UserOpConfWrapper& conf) -> Maybe<void> {
+      bool check_failed = false;
+      std::ostringstream err;
+      err << "Illegal attr value for " << conf.op_type_name() << " op, op_name: " << conf.op_name();
+      const std::string& color_space = conf.attr<std::string>("color_space");
+      if (color_space != "BGR" && color_space != "RGB" && color_space != "GRAY") {
+        err << ", color_space: " << color_space
+            << " (color_space can only be one of BGR, RGB and GRAY)";
+        check_failed = true;
+      }
+      int64_t target_width = conf.attr<int64_t>("target_width");
+      int64_t target_height = conf.attr<int64_t>("target_height");
+      if (target_width <= 0 || target_height <= 0) {
+        err << ", target_width: " << target_width << ", target_height: " << target_height;
+        check_failed = true;
+      }
+      const std::string& interp_type = conf.attr<std::string>("interpolation_type");
+      if (!CheckInterpolationValid(interp_type, err)) { check_failed = true; }
+      const std::string& output_layout = conf.attr<std::string>("output_layout");
+      if (output_layout != "NCHW" && output_layout != "NHWC") {
+        err << ", output_layout: " << output_layout << " (only support NCHW and NHWC)";
+        check_failed = true;
+      }
+      const size_t C = ImageUtil::IsColor(color_space) ? 3 : 1;
+      const size_t mean_size = conf.attr<std::vector<float>>("mean").size();
+      const size_t std_size = conf.attr<std::vector<float>>("std").size();
+      if ((mean_size != 1 && mean_size != C) || (std_size != 1 && std_size != C)) {
+        err << ", mean and std should have 1 or " << C << " elements";
+        check_failed = true;
+      }
+      DataType output_dtype = conf.attr<DataType>("output_dtype");
+      if (output_dtype != DataType::kFloat && output_dtype != DataType::kFloat16) {
+        err << ", output_dtype: " << output_dtype << " (only support kFloat and kFloat16)";
+        check_failed = true;
+      }
+      if (check_failed) { return oneflow::Error::CheckFailedError() << err.str(); }
+      return Maybe<void>::Ok();
+    })
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* in_tensor = ctx->TensorDesc4ArgNameAndIndex("in", 0);
+      CHECK_EQ_OR_RETURN(in_tensor->data_type(), DataType::kTensorBuffer);
+      CHECK_EQ_OR_RETURN(in_tensor->shape().NumAxes(), 1);
+      const user_op::TensorDesc* mirror_tensor = ctx->TensorDesc4ArgNameAndIndex("mirror", 0);
+      if (mirror_tensor) {
+        CHECK_OR_RETURN(mirror_tensor->shape().NumAxes() == 1
+                        && in_tensor->shape().At(0) == mirror_tensor->shape().At(0));
+        CHECK_EQ_OR_RETURN(mirror_tensor->data_type(), DataType::kInt8);
+      }
+      user_op::TensorDesc* out_tensor = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      int64_t N = in_tensor->shape().At(0);
+      int64_t H = ctx->Attr<int64_t>("target_height");
+      int64_t W = ctx->Attr<int64_t>("target_width");
+      int64_t C = ImageUtil::IsColor(ctx->Attr<std::string>("color_space")) ? 3 : 1;
+      if (ctx->Attr<std::string>("output_layout") == "NCHW") {
+        *out_tensor->mut_shape() = Shape({N, C, H, W});
+      } else {
+        *out_tensor->mut_shape() = Shape({N, H, W, C});
+      }
+      *out_tensor->mut_data_type() = ctx->Attr<DataType>("output_dtype");
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder().Split(ctx->inputs(), 0).Split(ctx->outputs(), 0).Build();
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      CHECK_EQ_OR_RETURN(ctx->BatchAxis4ArgNameAndIndex("in", 0)->value(), 0);
+      ctx->BatchAxis4ArgNameAndIndex("out", 0)->set_value(0);
+      return Maybe<void>::Ok();
+    });
+
 }  // namespace oneflow
@@ -133,6 +133,7 @@ REGISTER_USER_OP("matmul")
     .Output("out")
     .Attr<bool>("transpose_a", false)
     .Attr<bool>("transpose_b", false)
+    .Attr<bool>("_prepack_b", false)
     .SetTensorDescInferFn(InferTensorDesc4Matmul)
     .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
       auto BatchAxis4BnInOp = [&ctx](const std::string& arg_name) -> OptInt64* {
@@ -220,6 +221,7 @@ REGISTER_USER_OP("batch_matmul")
     .Output("out")
     .Attr<bool>("transpose_a", false)
     .Attr<bool>("transpose_b", false)
+    .Attr<bool>("_prepack_b", false)
     .SetTensorDescInferFn(InferTensorDesc4Matmul)
     .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
       auto BatchAxis4BnInOp = [&ctx](const std::string& arg_name) -> OptInt64* {
@@ -617,6 +617,44 @@ REGISTER_USER_OP_GRAD("normalization_add_relu")
                                 });
     });
 
+// Computes the weight and bias of a convolution followed by an inference mode normalization, so that
+// the convolution alone gives the normalized output. The filters are on axis 0 of the weight.
+REGISTER_USER_OP("fold_normalization_params")
+    .Input("weight")
+    .OptionalInput("bias")
+    .Input("gamma")
+    .Input("beta")
+    .Input("moving_mean")
+    .Input("moving_variance")
+    .Output("folded_weight")
+    .Output("folded_bias")
+    .Attr<float>("epsilon")
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* weight = ctx->TensorDesc4ArgNameAndIndex("weight", 0);
+      const Shape param_shape({weight->shape().At(0)});
+      const auto CheckParamTensorDesc =
+          MakeCheckParamTensorDescFn(ctx, weight->data_type(), param_shape);
+      JUST(CheckParamTensorDesc("bias"));
+      JUST(CheckParamTensorDesc("gamma"));
+      JUST(CheckParamTensorDesc("beta"));
+      JUST(CheckParamTensorDesc("moving_mean"));
+      JUST(CheckParamTensorDesc("moving_variance"));
+      *ctx->TensorDesc4ArgNameAndIndex("folded_weight", 0) = *weight;
+      user_op::TensorDesc* folded_bias = ctx->TensorDesc4ArgNameAndIndex("folded_bias", 0);
+      *folded_bias = *weight;
+      *folded_bias->mut_shape() = param_shape;
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      ctx->BatchAxis4ArgNameAndIndex("folded_weight", 0)->clear_value();
+      ctx->BatchAxis4ArgNameAndIndex("folded_bias", 0)->clear_value();
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder().Broadcast(ctx->inputs()).Broadcast(ctx->outputs()).Build();
+      return Maybe<void>::Ok();
+    });
+
 }  // namespace
 
 }  // namespace oneflow
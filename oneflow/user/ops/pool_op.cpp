@@ -45,6 +45,14 @@ TensorDescInferFn MakeFwTensorDescInferFn(const int32_t dim) {
     user_op::TensorDesc* y_desc = ctx->TensorDesc4ArgNameAndIndex("y", 0);
     *y_desc = *ctx->TensorDesc4ArgNameAndIndex("x", 0);
     *y_desc->mut_shape() = params_3d.GetYShape();
+    if (ctx->user_op_conf().has_output("_argmax", 0)) {
+      // index of the max inside the spatial plane of each channel, written by max pooling
+      CHECK_LE_OR_RETURN(params_3d.GetXShape5D().Count(2), GetMaxVal<int32_t>())
+          << "the spatial plane of x is too large for the int32 argmax";
+      user_op::TensorDesc* argmax_desc = ctx->TensorDesc4ArgNameAndIndex("_argmax", 0);
+      *argmax_desc = *y_desc;
+      *argmax_desc->mut_data_type() = DataType::kInt32;
+    }
     return Maybe<void>::Ok();
   };
 }
@@ -56,6 +64,9 @@ Maybe<void> BwTensorDescInferFn(user_op::InferContext* ctx) {
 
 Maybe<void> FwBatchAxisInferFn(user_op::BatchAxisContext* ctx) {
   *ctx->BatchAxis4ArgNameAndIndex("y", 0) = *ctx->BatchAxis4ArgNameAndIndex("x", 0);
+  if (ctx->user_op_conf().has_output("_argmax", 0)) {
+    *ctx->BatchAxis4ArgNameAndIndex("_argmax", 0) = *ctx->BatchAxis4ArgNameAndIndex("x", 0);
+  }
   return Maybe<void>::Ok();
 }
 
@@ -67,7 +78,7 @@ Maybe<void> BwBatchAxisInferFn(user_op::BatchAxisContext* ctx) {
 Maybe<void> FwGetSbpFn(user_op::SbpContext* ctx) {
   const user_op::TensorDesc& tensor = ctx->LogicalTensorDesc4InputArgNameAndIndex("x", 0);
   FOR_RANGE(int64_t, i, 0, tensor.shape().NumAxes()) {
-    ctx->NewBuilder().Split(user_op::OpArg("x", 0), i).Split(user_op::OpArg("y", 0), i).Build();
+    ctx->NewBuilder().Split(ctx->inputs(), i).Split(ctx->outputs(), i).Build();
   }
   return Maybe<void>::Ok();
 }
@@ -75,12 +86,7 @@ Maybe<void> FwGetSbpFn(user_op::SbpContext* ctx) {
 Maybe<void> BwGetSbpFn(user_op::SbpContext* ctx) {
   const user_op::TensorDesc& tensor = ctx->LogicalTensorDesc4InputArgNameAndIndex("x", 0);
   FOR_RANGE(int64_t, i, 0, tensor.shape().NumAxes()) {
-    ctx->NewBuilder()
-        .Split(user_op::OpArg("x", 0), i)
-        .Split(user_op::OpArg("y", 0), i)
-        .Split(user_op::OpArg("dy", 0), i)
-        .Split(user_op::OpArg("dx", 0), i)
-        .Build();
+    ctx->NewBuilder().Split(ctx->inputs(), i).Split(ctx->outputs(), i).Build();
   }
   return Maybe<void>::Ok();
 }
@@ -210,6 +216,7 @@ REGISTER_USER_OP_GRAD("avg_pool_3d").SetGenBackwardOpConfFn(MakeGenBackwardOpCon
 REGISTER_USER_OP("max_pool_1d")
     .Input("x")
     .Output("y")
+    .OptionalOutput("_argmax")
     .Attr<std::string>("padding")
     .Attr<std::vector<int32_t>>("padding_before")
     .Attr<std::vector<int32_t>>("padding_after")
@@ -225,6 +232,7 @@ REGISTER_USER_OP("max_pool_1d_grad")
     .Input("x")
     .Input("y")
     .Input("dy")
+    .OptionalInput("_argmax")
     .Output("dx")
     .Attr<std::string>("padding")
     .Attr<std::vector<int32_t>>("padding_before")
@@ -242,6 +250,7 @@ REGISTER_USER_OP_GRAD("max_pool_1d").SetGenBackwardOpConfFn(MakeGenBackwardOpCon
 REGISTER_USER_OP("max_pool_2d")
     .Input("x")
     .Output("y")
+    .OptionalOutput("_argmax")
     .Attr<std::string>("padding")
     .Attr<std::vector<int32_t>>("padding_before")
     .Attr<std::vector<int32_t>>("padding_after")
@@ -257,6 +266,7 @@ REGISTER_USER_OP("max_pool_2d_grad")
     .Input("x")
     .Input("y")
     .Input("dy")
+    .OptionalInput("_argmax")
     .Output("dx")
     .Attr<std::string>("padding")
     .Attr<std::vector<int32_t>>("padding_before")
@@ -274,6 +284,7 @@ REGISTER_USER_OP_GRAD("max_pool_2d").SetGenBackwardOpConfFn(MakeGenBackwardOpCon
 REGISTER_USER_OP("max_pool_3d")
     .Input("x")
     .Output("y")
+    .OptionalOutput("_argmax")
     .Attr<std::string>("padding")
     .Attr<std::vector<int32_t>>("padding_before")
     .Attr<std::vector<int32_t>>("padding_after")
@@ -289,6 +300,7 @@ REGISTER_USER_OP("max_pool_3d_grad")
     .Input("x")
     .Input("y")
     .Input("dy")
+    .OptionalInput("_argmax")
     .Output("dx")
     .Attr<std::string>("padding")
     .Attr<std::vector<int32_t>>("padding_before")
@@ -0,0 +1,178 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/ops/nn_util.h"
+
+namespace oneflow {
+
+namespace {
+
+// NOTE: the quantized ops take the float tensors that fake_quantization would have consumed
+// together with its scale and zero_point, and do the quantization themselves. Weights are always
+// quantized with the symmetric scheme, the activation uses "quantization_scheme".
+
+Maybe<void> CheckQuantizationAttr(const user_op::UserOpDefWrapper& def,
+                                  const user_op::UserOpConfWrapper& conf) {
+  const int32_t quantization_bit = conf.attr<int32_t>("quantization_bit");
+  CHECK_GT_OR_RETURN(quantization_bit, 1);
+  CHECK_LE_OR_RETURN(quantization_bit, 8);
+  const std::string& quantization_scheme = conf.attr<std::string>("quantization_scheme");
+  CHECK_OR_RETURN(quantization_scheme == "symmetric" || quantization_scheme == "affine");
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> CheckScaleShape(const user_op::InferContext* ctx, const std::string& scale_arg_name,
+                            const std::string& zero_point_arg_name, int64_t per_channel_size) {
+  const Shape* scale_shape = ctx->Shape4ArgNameAndIndex(scale_arg_name, 0);
+  CHECK_OR_RETURN(scale_shape->elem_cnt() == 1 || scale_shape->elem_cnt() == per_channel_size);
+  if (!zero_point_arg_name.empty()) {
+    CHECK_EQ_OR_RETURN(ctx->Shape4ArgNameAndIndex(zero_point_arg_name, 0)->elem_cnt(),
+                       scale_shape->elem_cnt());
+  }
+  return Maybe<void>::Ok();
+}
+
+void SetScaleInputArgsNoGrad(user_op::GetInputArgModifier GetInputArgModifierFn,
+                             const std::vector<std::string>& arg_names) {
+  for (const auto& arg_name : arg_names) {
+    user_op::InputArgModifier* modifier = GetInputArgModifierFn(arg_name, 0);
+    CHECK(modifier != nullptr);
+    modifier->set_requires_grad(false);
+  }
+}
+
+}  // namespace
+
+REGISTER_USER_OP("quantized_matmul")
+    .Input("a")
+    .Input("a_scale")
+    .Input("a_zero_point")
+    .Input("b")
+    .Input("b_scale")
+    .Output("out")
+    .Attr<bool>("transpose_b", false)
+    .Attr<int32_t>("quantization_bit", 8)
+    .Attr<std::string>("quantization_scheme", "symmetric")
+    .SetCheckAttrFn(CheckQuantizationAttr)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* a = ctx->TensorDesc4ArgNameAndIndex("a", 0);
+      const user_op::TensorDesc* b = ctx->TensorDesc4ArgNameAndIndex("b", 0);
+      CHECK_EQ_OR_RETURN(a->shape().NumAxes(), 2);
+      CHECK_EQ_OR_RETURN(b->shape().NumAxes(), 2);
+      CHECK_EQ_OR_RETURN(a->data_type(), DataType::kFloat);
+      CHECK_EQ_OR_RETURN(b->data_type(), DataType::kFloat);
+      const bool transpose_b = ctx->Attr<bool>("transpose_b");
+      const int64_t k = a->shape().At(1);
+      CHECK_EQ_OR_RETURN(k, b->shape().At(transpose_b ? 1 : 0));
+      const int64_t n = b->shape().At(transpose_b ? 0 : 1);
+      // per-channel scales of b are only foldable along n
+      JUST(CheckScaleShape(ctx, "a_scale", "a_zero_point", 1));
+      JUST(CheckScaleShape(ctx, "b_scale", "", transpose_b ? n : 1));
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out = *a;
+      out->mut_shape()->Set(1, n);
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      *ctx->BatchAxis4ArgNameAndIndex("out", 0) = *ctx->BatchAxis4ArgNameAndIndex("a", 0);
+      return Maybe<void>::Ok();
+    })
+    .SetInputArgModifyFn([](user_op::GetInputArgModifier GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper&) {
+      SetScaleInputArgsNoGrad(GetInputArgModifierFn, {"a_scale", "a_zero_point", "b_scale"});
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder()
+          .Split(user_op::OpArg("a", 0), 0)
+          .Broadcast(user_op::OpArg("a_scale", 0))
+          .Broadcast(user_op::OpArg("a_zero_point", 0))
+          .Broadcast(user_op::OpArg("b", 0))
+          .Broadcast(user_op::OpArg("b_scale", 0))
+          .Split(user_op::OpArg("out", 0), 0)
+          .Build();
+      return Maybe<void>::Ok();
+    });
+
+REGISTER_USER_OP("quantized_conv2d")
+    .Input("in")
+    .Input("in_scale")
+    .Input("in_zero_point")
+    .Input("weight")
+    .Input("weight_scale")
+    .OptionalInput("bias")
+    .Output("out")
+    .Attr<int32_t>("filters")
+    .Attr<std::vector<int32_t>>("padding_before")
+    .Attr<std::vector<int32_t>>("kernel_size")
+    .Attr<std::vector<int32_t>>("strides")
+    .Attr<std::vector<int32_t>>("dilation_rate")
+    .Attr<int32_t>("quantization_bit", 8)
+    .Attr<std::string>("quantization_scheme", "symmetric")
+    .SetCheckAttrFn(CheckQuantizationAttr)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      // channels_first, groups == 1
+      const user_op::TensorDesc* in = ctx->TensorDesc4ArgNameAndIndex("in", 0);
+      CHECK_EQ_OR_RETURN(in->shape().NumAxes(), 4);
+      CHECK_EQ_OR_RETURN(in->data_type(), DataType::kFloat);
+      const int32_t filters = ctx->Attr<int32_t>("filters");
+      const auto& padding_before = ctx->Attr<std::vector<int32_t>>("padding_before");
+      const auto& kernel_size = ctx->Attr<std::vector<int32_t>>("kernel_size");
+      const auto& strides = ctx->Attr<std::vector<int32_t>>("strides");
+      const auto& dilation_rate = ctx->Attr<std::vector<int32_t>>("dilation_rate");
+      CHECK_EQ_OR_RETURN(padding_before.size(), 2);
+      CHECK_EQ_OR_RETURN(kernel_size.size(), 2);
+      CHECK_EQ_OR_RETURN(strides.size(), 2);
+      CHECK_EQ_OR_RETURN(dilation_rate.size(), 2);
+
+      const user_op::TensorDesc* weight = ctx->TensorDesc4ArgNameAndIndex("weight", 0);
+      CHECK_EQ_OR_RETURN(weight->shape(), Shape({filters, in->shape().At(1), kernel_size.at(0),
+                                                 kernel_size.at(1)}));
+      JUST(CheckScaleShape(ctx, "in_scale", "in_zero_point", 1));
+      JUST(CheckScaleShape(ctx, "weight_scale", "", filters));
+      const user_op::TensorDesc* bias = ctx->TensorDesc4ArgNameAndIndex("bias", 0);
+      if (bias != nullptr) { CHECK_EQ_OR_RETURN(bias->shape(), Shape({filters})); }
+
+      DimVector out_shape(4);
+      out_shape.at(0) = in->shape().At(0);
+      out_shape.at(1) = filters;
+      FOR_RANGE(int32_t, i, 0, 2) {
+        CalcConvOut(in->shape().At(2 + i), kernel_size.at(i), dilation_rate.at(i), strides.at(i),
+                    padding_before.at(i), &out_shape.at(2 + i));
+      }
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out = *in;
+      *out->mut_shape() = Shape(out_shape);
+      return Maybe<void>::Ok();
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      *ctx->BatchAxis4ArgNameAndIndex("out", 0) = *ctx->BatchAxis4ArgNameAndIndex("in", 0);
+      return Maybe<void>::Ok();
+    })
+    .SetInputArgModifyFn([](user_op::GetInputArgModifier GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper&) {
+      SetScaleInputArgsNoGrad(GetInputArgModifierFn, {"in_scale", "in_zero_point", "weight_scale"});
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      // everything but in and out is broadcast, including the optional bias
+      ctx->NewBuilder()
+          .Broadcast(ctx->inputs())
+          .Split(user_op::OpArg("in", 0), 0)
+          .Split(user_op::OpArg("out", 0), 0)
+          .Build();
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace oneflow
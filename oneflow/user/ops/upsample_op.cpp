@@ -17,11 +17,27 @@ limitations under the License.
 
 namespace oneflow {
 
+namespace {
+
+Maybe<void> GetUpsampleSbpSignatures(user_op::SbpContext* ctx) {
+  const int32_t channel_axis =
+      ctx->Attr<std::string>("data_format") == "channels_first" ? 1 : 3;
+  ctx->NewBuilder().Split(ctx->inputs(), 0).Split(ctx->outputs(), 0).Build();
+  ctx->NewBuilder()
+      .Split(ctx->inputs(), channel_axis)
+      .Split(ctx->outputs(), channel_axis)
+      .Build();
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
 REGISTER_USER_OP("upsample")
     .Input("x")
     .Output("y")
     .Attr<float>("height_scale")
     .Attr<float>("width_scale")
+    .Attr<bool>("align_corners", false)
     .Attr<std::string>("data_format")
     .Attr<std::string>("interpolation")
     .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
@@ -29,29 +45,29 @@ REGISTER_USER_OP("upsample")
       user_op::TensorDesc* y_desc = ctx->TensorDesc4ArgNameAndIndex("y", 0);
       const float height_scale = ctx->Attr<float>("height_scale");
       const float width_scale = ctx->Attr<float>("width_scale");
-      if (ctx->Attr<std::string>("data_format") != "channels_first"
-          || x_desc->shape().NumAxes() != 4) {
-        LOG(FATAL) << "upsample only supports NCHW";
-      }
-      *y_desc->mut_shape() = Shape({x_desc->shape().At(0), x_desc->shape().At(1),
-                                    static_cast<int32_t>(height_scale) * x_desc->shape().At(2),
-                                    static_cast<int32_t>(width_scale) * x_desc->shape().At(3)});
+      const std::string& data_format = ctx->Attr<std::string>("data_format");
+      CHECK_EQ_OR_RETURN(x_desc->shape().NumAxes(), 4);
+      CHECK_OR_RETURN(data_format == "channels_first" || data_format == "channels_last");
+      const int32_t h_axis = data_format == "channels_first" ? 2 : 1;
+      DimVector dim_vec = x_desc->shape().dim_vec();
+      dim_vec.at(h_axis) *= static_cast<int32_t>(height_scale);
+      dim_vec.at(h_axis + 1) *= static_cast<int32_t>(width_scale);
+      *y_desc = *x_desc;
+      *y_desc->mut_shape() = Shape(dim_vec);
       return Maybe<void>::Ok();
     })
     .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
       *ctx->BatchAxis4ArgNameAndIndex("y", 0) = *ctx->BatchAxis4ArgNameAndIndex("x", 0);
       return Maybe<void>::Ok();
     })
-    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
-      ctx->NewBuilder().Split(user_op::OpArg("x", 0), 0).Split(user_op::OpArg("y", 0), 0).Build();
-      return Maybe<void>::Ok();
-    });
+    .SetGetSbpFn(GetUpsampleSbpSignatures);
 
 REGISTER_USER_OP("upsample_grad")
     .Input("dy")
     .Output("dx")
     .Attr<float>("height_scale")
     .Attr<float>("width_scale")
+    .Attr<bool>("align_corners", false)
     .Attr<std::string>("data_format")
     .Attr<std::string>("interpolation")
     .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
@@ -59,18 +75,17 @@ REGISTER_USER_OP("upsample_grad")
       Shape* dx_shape = ctx->Shape4ArgNameAndIndex("dx", 0);
       const float height_scale = ctx->Attr<float>("height_scale");
       const float width_scale = ctx->Attr<float>("width_scale");
-      if (ctx->Attr<std::string>("data_format") != "channels_first" || dy_shape->NumAxes() != 4) {
-        LOG(FATAL) << "upsample_nearest only supports NCHW";
-      }
-      *dx_shape = Shape({dy_shape->At(0), dy_shape->At(1),
-                         dy_shape->At(2) / static_cast<int32_t>(height_scale),
-                         dy_shape->At(3) / static_cast<int32_t>(width_scale)});
+      const std::string& data_format = ctx->Attr<std::string>("data_format");
+      CHECK_EQ_OR_RETURN(dy_shape->NumAxes(), 4);
+      CHECK_OR_RETURN(data_format == "channels_first" || data_format == "channels_last");
+      const int32_t h_axis = data_format == "channels_first" ? 2 : 1;
+      DimVector dim_vec = dy_shape->dim_vec();
+      dim_vec.at(h_axis) /= static_cast<int32_t>(height_scale);
+      dim_vec.at(h_axis + 1) /= static_cast<int32_t>(width_scale);
+      *dx_shape = Shape(dim_vec);
       return Maybe<void>::Ok();
     })
-    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
-      ctx->NewBuilder().Split(user_op::OpArg("dy", 0), 0).Split(user_op::OpArg("dx", 0), 0).Build();
-      return Maybe<void>::Ok();
-    });
+    .SetGetSbpFn(GetUpsampleSbpSignatures);
 
 REGISTER_USER_OP_GRAD("upsample")
     .SetGenBackwardOpConfFn([](const user_op::UserOpWrapper& op, user_op::AddOpFn AddOp) {
@@ -82,6 +97,7 @@ REGISTER_USER_OP_GRAD("upsample")
                 .Output("dx")
                 .Attr("height_scale", op.attr<float>("height_scale"))
                 .Attr("width_scale", op.attr<float>("width_scale"))
+                .Attr("align_corners", op.attr<bool>("align_corners"))
                 .Attr("data_format", op.attr<std::string>("data_format"))
                 .Attr("interpolation", op.attr<std::string>("interpolation"))
                 .Build();
@@ -41,6 +41,9 @@ DEFINE_bool(strict_clustering, EnvToBool(FLAGS_strict_clustering, true),
 //               "valid, Default means using no engine.");
 DEFINE_bool(use_xla_jit, EnvToBool(FLAGS_use_xla_jit, false), "It's optional to use xla jit.");
 DEFINE_bool(use_tensorrt, EnvToBool(FLAGS_use_tensorrt, false), "It's optional to use tensorrt.");
+DEFINE_bool(use_native_fusion, EnvToBool(FLAGS_use_native_fusion, false),
+            "It's optional to fuse elementwise, broadcast and reduce ops on cpu with the native "
+            "xrt engine, which needs neither XLA nor TensorRT.");
 
 DEFINE_bool(tensorrt_fp16, EnvToBool(FLAGS_tensorrt_fp16, false),
             "Enable fp16 precision for TENSORRT engine.");
@@ -157,6 +160,8 @@ XrtEngine StringToXrtEngine(const std::string &engine) {
     return xrt::XrtEngine::XLA;
   } else if (engine == "TENSORRT") {
     return xrt::XrtEngine::TENSORRT;
+  } else if (engine == "NATIVE") {
+    return xrt::XrtEngine::NATIVE;
   } else {
     LOG(FATAL) << "Unknown engine: " << engine;
   }
@@ -190,6 +195,7 @@ std::shared_ptr<XrtGraph> BuildXrtGraph(const XrtLaunchOpConf::Function &functio
 void InitXrtConfigurations(const XrtConfig &config) {
   if (config.has_use_xla_jit()) { FLAGS_use_xla_jit = config.use_xla_jit(); }
   if (config.has_use_tensorrt()) { FLAGS_use_tensorrt = config.use_tensorrt(); }
+  if (config.has_use_native_fusion()) { FLAGS_use_native_fusion = config.use_native_fusion(); }
   // Set xla configurations.
   if (config.has_tensorrt_config()) {
     const XrtConfig::TensorRTConfig &trt_config = config.tensorrt_config();
@@ -203,7 +209,9 @@ void InitXrtConfigurations(const XrtConfig &config) {
   }
 }
 
-bool XrtCompilationEnabled() { return FLAGS_use_xla_jit || FLAGS_use_tensorrt; }
+bool XrtCompilationEnabled() {
+  return FLAGS_use_xla_jit || FLAGS_use_tensorrt || FLAGS_use_native_fusion;
+}
 
 XrtPassOptions CreateDefaultXrtPassOptions(bool train_phase) {
   ClusteringOptions options;
@@ -216,6 +224,15 @@ XrtPassOptions CreateDefaultXrtPassOptions(bool train_phase) {
   options.engine = (1U << XrtEngineOptionBit::kUseDefault);
   if (FLAGS_use_xla_jit) { options.engine |= (1U << XrtEngineOptionBit::kUseXlaJit); }
   if (FLAGS_use_tensorrt) { options.engine |= (1U << XrtEngineOptionBit::kUseTensorRT); }
+  if (FLAGS_use_native_fusion) { options.engine |= (1U << XrtEngineOptionBit::kUseNative); }
+#ifndef WITH_XLA
+  LOG_IF(WARNING, FLAGS_use_xla_jit) << "It will not use XLA since WITH_XLA was not enabled "
+                                        "when compiling the project.";
+#endif  // WITH_XLA
+#ifndef WITH_TENSORRT
+  LOG_IF(WARNING, FLAGS_use_tensorrt) << "It will not use TensorRT since WITH_TENSORRT was not "
+                                         "enabled when compiling the project.";
+#endif  // WITH_TENSORRT
 
   XrtPassOptions xrt_options;
   xrt_options.clustering_options = options;
@@ -43,16 +43,21 @@ GraphBuilder::GraphBuilder(const OpGraph *op_graph) : graph_(std::make_shared<Xr
     XrtNode *node = graph_->AddNode(op->op_conf());
     SetupXrtNode(node, op->op_conf());
     auto &input_output_keys = node_info_[node].input_output_keys;
+    // Set the data types of the inputs and outputs
+    std::vector<DataType> data_types;
     for (const std::string &bn : op->output_bns()) {
       std::string output = BlobIdToName(op->BnInOp2Lbi(bn));
       producers_[output] = node;
       input_output_keys[output] = bn;
+      data_types.push_back(op_node->LogicalBlobDesc4Lbi(op->BnInOp2Lbi(bn)).data_type());
     }
     for (const std::string &bn : op->input_bns()) {
       std::string input = BlobIdToName(op->BnInOp2Lbi(bn));
       input_output_keys[input] = bn;
       node_info_[node].inputs.insert(input);
+      data_types.push_back(op_node->LogicalBlobDesc4Lbi(op->BnInOp2Lbi(bn)).data_type());
     }
+    node->Attr("data_types", data_types);
     node_info_[node].op_node = op_node;
   });
 }
@@ -15,9 +15,48 @@ limitations under the License.
 */
 #include "oneflow/xrt/compilation_cache.h"
 
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/file_system.h"
+
 namespace oneflow {
 namespace xrt {
 
+namespace {
+
+const char kPersistentFileMagic[] = "OFXRTCC1";
+
+void AppendParameters(const std::vector<Parameter> &params, std::string *str) {
+  for (const Parameter &param : params) {
+    *str += param.name() + ":" + std::to_string(param.data_type()) + ":"
+            + param.shape().ToString() + ";";
+  }
+  *str += "\n";
+}
+
+struct AtomicCompilationCacheMetrics {
+  std::atomic<int64_t> hit_cnt{0};
+  std::atomic<int64_t> miss_cnt{0};
+  std::atomic<int64_t> eviction_cnt{0};
+  std::atomic<int64_t> persistent_hit_cnt{0};
+  std::atomic<int64_t> persistent_store_cnt{0};
+  std::mutex compile_time_mutex;
+  int64_t compile_cnt = 0;
+  double total_compile_time_us = 0;
+  double max_compile_time_us = 0;
+};
+
+AtomicCompilationCacheMetrics *MutMetrics() {
+  static AtomicCompilationCacheMetrics metrics;
+  return &metrics;
+}
+
+}  // namespace
+
 bool operator==(const Signature &lhs, const Signature &rhs) {
   return lhs.builder_name == rhs.builder_name && lhs.device_ordinal == rhs.device_ordinal
          && lhs.entry_shapes == rhs.entry_shapes;
@@ -42,25 +81,184 @@ Signature ComputeSignature(const std::string &name, const int device_ordinal,
   return std::move(signature);
 }
 
-Executable *CompilationCache::GetRecord(const Signature &signature) const {
-  Executable *record = nullptr;
+std::string ComputeFingerprint(const std::string &cluster, const std::string &options,
+                               const std::vector<Parameter> &entry_params,
+                               const std::vector<Parameter> &return_params) {
+  std::string str = cluster + "\n" + options + "\n";
+  AppendParameters(entry_params, &str);
+  AppendParameters(return_params, &str);
+  std::ostringstream fingerprint;
+  fingerprint << std::hex;
+  fingerprint.width(16);
+  fingerprint.fill('0');
+  fingerprint << StableHash(str, 14695981039346656037ULL);
+  fingerprint.width(16);
+  fingerprint << StableHash(str, 0x9e3779b97f4a7c15ULL);
+  return fingerprint.str();
+}
+
+std::string ComputeFingerprint(const std::string &fingerprint,
+                               const std::map<std::string, std::string> &weight_contents) {
+  if (weight_contents.empty()) { return fingerprint; }
+  std::string str = fingerprint + "\n";
+  for (const auto &pair : weight_contents) {
+    str += pair.first + ":" + std::to_string(pair.second.size()) + ":" + pair.second + ";";
+  }
+  return ComputeFingerprint(str, "", {}, {});
+}
+
+std::string CompilationCacheMetrics::ToString() const {
+  std::ostringstream ss;
+  ss << "hit: " << hit_cnt << ", miss: " << miss_cnt << ", eviction: " << eviction_cnt
+     << ", persistent hit: " << persistent_hit_cnt << ", persistent store: " << persistent_store_cnt
+     << ", compile: " << compile_cnt << ", total compile time: " << total_compile_time_us
+     << "us, max compile time: " << max_compile_time_us << "us";
+  return ss.str();
+}
+
+CompilationCacheMetrics GetCompilationCacheMetrics() {
+  AtomicCompilationCacheMetrics *metrics = MutMetrics();
+  CompilationCacheMetrics snapshot;
+  snapshot.hit_cnt = metrics->hit_cnt;
+  snapshot.miss_cnt = metrics->miss_cnt;
+  snapshot.eviction_cnt = metrics->eviction_cnt;
+  snapshot.persistent_hit_cnt = metrics->persistent_hit_cnt;
+  snapshot.persistent_store_cnt = metrics->persistent_store_cnt;
+  std::lock_guard<std::mutex> lock(metrics->compile_time_mutex);
+  snapshot.compile_cnt = metrics->compile_cnt;
+  snapshot.total_compile_time_us = metrics->total_compile_time_us;
+  snapshot.max_compile_time_us = metrics->max_compile_time_us;
+  return snapshot;
+}
+
+void RecordCompilationTime(double compile_time_us) {
+  AtomicCompilationCacheMetrics *metrics = MutMetrics();
+  std::lock_guard<std::mutex> lock(metrics->compile_time_mutex);
+  metrics->compile_cnt += 1;
+  metrics->total_compile_time_us += compile_time_us;
+  metrics->max_compile_time_us = std::max(metrics->max_compile_time_us, compile_time_us);
+}
+
+std::shared_ptr<CompilationRecord> CompilationCache::GetRecord(const Signature &signature) {
   // std::shared_lock<std::shared_mutex> lock(mutex_);
   std::lock_guard<std::mutex> lock(mutex_);
   const auto &it = records_.find(signature);
-  if (it != records_.end()) { record = it->second.get(); }
-  return record;
+  if (it == records_.end()) {
+    MutMetrics()->miss_cnt += 1;
+    return nullptr;
+  }
+  MutMetrics()->hit_cnt += 1;
+  lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
+  return it->second->second;
 }
 
 void CompilationCache::Record(const Signature &signature,
-                              const std::shared_ptr<Executable> &result) {
+                              const std::shared_ptr<CompilationRecord> &record) {
   // std::unique_lock<std::shared_mutex> lock(mutex_);
   std::lock_guard<std::mutex> lock(mutex_);
-  records_.emplace(signature, result);
+  const auto &it = records_.find(signature);
+  if (it != records_.end()) {
+    it->second->second = record;
+    lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
+    return;
+  }
+  lru_list_.emplace_front(signature, record);
+  records_.emplace(signature, lru_list_.begin());
+  while (capacity_ > 0 && static_cast<int64_t>(lru_list_.size()) > capacity_) {
+    records_.erase(lru_list_.back().first);
+    lru_list_.pop_back();
+    MutMetrics()->eviction_cnt += 1;
+  }
 }
 
 void CompilationCache::Release() {
-  util::Map<Signature, std::shared_ptr<Executable>, SignatureHash> empty_records;
+  std::lock_guard<std::mutex> lock(mutex_);
+  util::Map<Signature, LruList::iterator, SignatureHash> empty_records;
   records_.swap(empty_records);
+  lru_list_.clear();
+}
+
+int64_t CompilationCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return lru_list_.size();
+}
+
+PersistentCompilationCache::PersistentCompilationCache(const std::string &dir) : dir_(dir) {
+  LocalFS()->RecursivelyCreateDirIfNotExist(dir_);
+}
+
+std::string PersistentCompilationCache::FilePath(const std::string &fingerprint,
+                                                 const std::string &suffix) const {
+  return JoinPath(dir_, fingerprint + suffix);
+}
+
+bool PersistentCompilationCache::ReadFile(const std::string &path, std::string *content) const {
+  std::ifstream in(path, std::ios::in | std::ios::binary);
+  if (!in.good()) { return false; }
+  std::string magic(sizeof(kPersistentFileMagic) - 1, '\0');
+  uint64_t size = 0;
+  in.read(&magic[0], magic.size());
+  in.read(reinterpret_cast<char *>(&size), sizeof(size));
+  if (!in.good() || magic != kPersistentFileMagic) {
+    LOG(WARNING) << "Ignore the corrupted compilation cache file " << path;
+    return false;
+  }
+  content->resize(size);
+  if (size > 0) { in.read(&(*content)[0], size); }
+  if (!in.good() && size > 0) {
+    LOG(WARNING) << "Ignore the truncated compilation cache file " << path;
+    return false;
+  }
+  return true;
+}
+
+bool PersistentCompilationCache::WriteFile(const std::string &path,
+                                           const std::string &content) const {
+  const std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+  {
+    std::ofstream out(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    const uint64_t size = content.size();
+    out.write(kPersistentFileMagic, sizeof(kPersistentFileMagic) - 1);
+    out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    out.write(content.data(), size);
+    if (!out.good()) {
+      LOG(WARNING) << "Failed to write the compilation cache file " << tmp_path;
+      return false;
+    }
+  }
+  LocalFS()->RenameFile(tmp_path, path);
+  return true;
+}
+
+bool PersistentCompilationCache::Load(const std::string &fingerprint,
+                                      std::string *serialized) const {
+  if (!ReadFile(FilePath(fingerprint, ".xrt"), serialized)) { return false; }
+  MutMetrics()->persistent_hit_cnt += 1;
+  return true;
+}
+
+void PersistentCompilationCache::Store(const std::string &fingerprint,
+                                       const std::string &serialized) const {
+  if (WriteFile(FilePath(fingerprint, ".xrt"), serialized)) {
+    MutMetrics()->persistent_store_cnt += 1;
+  }
+}
+
+bool PersistentCompilationCache::LoadWeightNames(const std::string &fingerprint,
+                                                 std::vector<std::string> *names) const {
+  std::string content;
+  if (!ReadFile(FilePath(fingerprint, ".weights"), &content)) { return false; }
+  names->clear();
+  std::istringstream in(content);
+  for (std::string name; std::getline(in, name);) { names->push_back(name); }
+  return true;
+}
+
+void PersistentCompilationCache::StoreWeightNames(const std::string &fingerprint,
+                                                  const std::vector<std::string> &names) const {
+  std::string content;
+  for (const std::string &name : names) { content += name + "\n"; }
+  WriteFile(FilePath(fingerprint, ".weights"), content);
 }
 
 }  // namespace xrt
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef ONEFLOW_XRT_COMPILATION_CACHE_H_
 #define ONEFLOW_XRT_COMPILATION_CACHE_H_
 
+#include <list>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -49,18 +51,95 @@ struct SignatureHash {
 Signature ComputeSignature(const std::string &name, const int device_ordinal,
                            const std::vector<xrt::Parameter> &entry_params);
 
+// Names a compiled executable on disk. Besides the cluster and the options it was compiled with,
+// the fingerprint covers the names, shapes and data types of all the parameters, so it is stable
+// across processes and changes whenever the executable would.
+std::string ComputeFingerprint(const std::string &cluster, const std::string &options,
+                               const std::vector<xrt::Parameter> &entry_params,
+                               const std::vector<xrt::Parameter> &return_params);
+
+// Engines such as TensorRT copy some parameters into the executable as constants, so the
+// fingerprint of such an executable has to cover the contents of these weights as well, otherwise
+// a restarted process would reload an executable holding the weights of an older checkpoint.
+// `weight_contents` maps the name of each weight to its bytes.
+std::string ComputeFingerprint(const std::string &fingerprint,
+                               const std::map<std::string, std::string> &weight_contents);
+
+struct CompilationRecord {
+  std::shared_ptr<Executable> executable;
+  std::string fingerprint;
+  // Some engines could only serialize the executable after it has run once
+  bool pending_store = false;
+};
+
+// Process-wide counters of all compilation caches
+struct CompilationCacheMetrics {
+  int64_t hit_cnt = 0;
+  int64_t miss_cnt = 0;
+  int64_t eviction_cnt = 0;
+  int64_t persistent_hit_cnt = 0;
+  int64_t persistent_store_cnt = 0;
+  int64_t compile_cnt = 0;
+  double total_compile_time_us = 0;
+  double max_compile_time_us = 0;
+
+  std::string ToString() const;
+};
+
+CompilationCacheMetrics GetCompilationCacheMetrics();
+
+void RecordCompilationTime(double compile_time_us);
+
+// Keeps the records in the order of their last use and drops the least recently used one if the
+// capacity is exceeded, a capacity that is not positive means unbounded.
 class CompilationCache {
  public:
-  Executable *GetRecord(const Signature &signature) const;
+  CompilationCache() : CompilationCache(-1) {}
+  explicit CompilationCache(int64_t capacity) : capacity_(capacity) {}
 
-  void Record(const Signature &signature, const std::shared_ptr<Executable> &result);
+  std::shared_ptr<CompilationRecord> GetRecord(const Signature &signature);
+
+  void Record(const Signature &signature, const std::shared_ptr<CompilationRecord> &record);
 
   void Release();
 
+  int64_t size() const;
+
  private:
+  using LruList = util::List<std::pair<Signature, std::shared_ptr<CompilationRecord>>>;
+
+  const int64_t capacity_;
   // static std::shared_mutex mutex_;
   mutable std::mutex mutex_;
-  util::Map<Signature, std::shared_ptr<Executable>, SignatureHash> records_;
+  LruList lru_list_;
+  util::Map<Signature, LruList::iterator, SignatureHash> records_;
+};
+
+// Serialized executables in a directory, one file per fingerprint. Files are written to a
+// temporary name first and then renamed, so concurrent processes never read a partial file.
+// Next to them it keeps the names of the weights baked into the executable compiled for a
+// fingerprint without weights, which are needed to compute the full fingerprint before loading.
+class PersistentCompilationCache {
+ public:
+  explicit PersistentCompilationCache(const std::string &dir);
+
+  bool Load(const std::string &fingerprint, std::string *serialized) const;
+
+  void Store(const std::string &fingerprint, const std::string &serialized) const;
+
+  bool LoadWeightNames(const std::string &fingerprint, std::vector<std::string> *names) const;
+
+  void StoreWeightNames(const std::string &fingerprint,
+                        const std::vector<std::string> &names) const;
+
+ private:
+  std::string FilePath(const std::string &fingerprint, const std::string &suffix) const;
+
+  bool ReadFile(const std::string &path, std::string *content) const;
+
+  bool WriteFile(const std::string &path, const std::string &content) const;
+
+  std::string dir_;
 };
 
 }  // namespace xrt
@@ -0,0 +1,143 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/compilation_cache.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/file_system.h"
+
+#include <unistd.h>
+
+namespace oneflow {
+namespace xrt {
+
+namespace {
+
+class FakeExecutable : public Executable {
+ public:
+  FakeExecutable(const std::string &name, const std::string &serialized)
+      : Executable(name, XrtEngine::TENSORRT), serialized_(serialized) {}
+
+  bool Run(const std::vector<Parameter> &inputs, const ExecutableRunOptions &run_options,
+           bool block_until_done = true) override {
+    return true;
+  }
+
+  bool SupportsSerialization() const override { return true; }
+  bool SerializeTo(std::string *serialized) const override {
+    *serialized = serialized_;
+    return true;
+  }
+
+ private:
+  std::string serialized_;
+};
+
+Signature MakeSignature(int64_t batch_size) {
+  return ComputeSignature("launch", 0, {Parameter("x", nullptr, Shape({batch_size, 8}),
+                                                  DataType::kFloat)});
+}
+
+std::shared_ptr<CompilationRecord> MakeRecord(const std::string &name) {
+  std::shared_ptr<CompilationRecord> record(new CompilationRecord);
+  record->executable.reset(new FakeExecutable(name, name));
+  return record;
+}
+
+}  // namespace
+
+TEST(CompilationCache, lru_eviction) {
+  const CompilationCacheMetrics before = GetCompilationCacheMetrics();
+  CompilationCache cache(2);
+  cache.Record(MakeSignature(1), MakeRecord("1"));
+  cache.Record(MakeSignature(2), MakeRecord("2"));
+  // touching 1 makes 2 the least recently used one
+  ASSERT_EQ(cache.GetRecord(MakeSignature(1))->executable->name(), "1");
+  cache.Record(MakeSignature(4), MakeRecord("4"));
+  ASSERT_EQ(cache.size(), 2);
+  ASSERT_TRUE(cache.GetRecord(MakeSignature(2)) == nullptr);
+  ASSERT_EQ(cache.GetRecord(MakeSignature(1))->executable->name(), "1");
+  ASSERT_EQ(cache.GetRecord(MakeSignature(4))->executable->name(), "4");
+  const CompilationCacheMetrics after = GetCompilationCacheMetrics();
+  ASSERT_EQ(after.hit_cnt - before.hit_cnt, 3);
+  ASSERT_EQ(after.miss_cnt - before.miss_cnt, 1);
+  ASSERT_EQ(after.eviction_cnt - before.eviction_cnt, 1);
+}
+
+TEST(CompilationCache, unbounded) {
+  CompilationCache cache;
+  FOR_RANGE(int64_t, i, 1, 100) { cache.Record(MakeSignature(i), MakeRecord(std::to_string(i))); }
+  ASSERT_EQ(cache.size(), 99);
+  cache.Release();
+  ASSERT_EQ(cache.size(), 0);
+}
+
+TEST(CompilationCache, fingerprint) {
+  const std::vector<Parameter> entry_params = {
+      Parameter("x", nullptr, Shape({4, 8}), DataType::kFloat)};
+  const std::vector<Parameter> return_params = {
+      Parameter("y", nullptr, Shape({4, 8}), DataType::kFloat)};
+  const std::string fingerprint =
+      ComputeFingerprint("cluster", "options", entry_params, return_params);
+  ASSERT_EQ(fingerprint.size(), 32);
+  ASSERT_EQ(fingerprint, ComputeFingerprint("cluster", "options", entry_params, return_params));
+  ASSERT_NE(fingerprint, ComputeFingerprint("cluster", "fp16", entry_params, return_params));
+  ASSERT_NE(fingerprint, ComputeFingerprint("cluster", "options", entry_params, entry_params));
+  const std::vector<Parameter> half_entry_params = {
+      Parameter("x", nullptr, Shape({4, 8}), DataType::kFloat16)};
+  ASSERT_NE(fingerprint, ComputeFingerprint("cluster", "options", half_entry_params,
+                                            return_params));
+}
+
+TEST(CompilationCache, fingerprint_with_weights) {
+  const std::string fingerprint = ComputeFingerprint("cluster", "options", {}, {});
+  ASSERT_EQ(ComputeFingerprint(fingerprint, {}), fingerprint);
+  const std::string weighted = ComputeFingerprint(fingerprint, {{"w", std::string(16, '\1')}});
+  ASSERT_EQ(weighted.size(), 32);
+  ASSERT_NE(weighted, fingerprint);
+  ASSERT_EQ(weighted, ComputeFingerprint(fingerprint, {{"w", std::string(16, '\1')}}));
+  // only the contents of the weight change, as after loading another checkpoint
+  std::string retrained(16, '\1');
+  retrained.at(7) = '\2';
+  ASSERT_NE(weighted, ComputeFingerprint(fingerprint, {{"w", retrained}}));
+  ASSERT_NE(weighted, ComputeFingerprint(fingerprint, {{"v", std::string(16, '\1')}}));
+}
+
+TEST(PersistentCompilationCache, store_and_load) {
+  const std::string dir =
+      JoinPath("/tmp", "xrt_compilation_cache_test_" + std::to_string(getpid()));
+  PersistentCompilationCache persistent_cache(dir);
+  std::string serialized;
+  ASSERT_FALSE(persistent_cache.Load("absent", &serialized));
+  std::string engine(1000, '\0');
+  FOR_RANGE(size_t, i, 0, engine.size()) { engine.at(i) = static_cast<char>(i % 251); }
+  persistent_cache.Store("fingerprint", engine);
+  ASSERT_TRUE(PersistentCompilationCache(dir).Load("fingerprint", &serialized));
+  ASSERT_EQ(serialized, engine);
+  persistent_cache.Store("fingerprint", "");
+  ASSERT_TRUE(persistent_cache.Load("fingerprint", &serialized));
+  ASSERT_TRUE(serialized.empty());
+  std::vector<std::string> weight_names;
+  ASSERT_FALSE(persistent_cache.LoadWeightNames("fingerprint", &weight_names));
+  persistent_cache.StoreWeightNames("fingerprint", {"conv-weight", "fc-bias"});
+  ASSERT_TRUE(persistent_cache.LoadWeightNames("fingerprint", &weight_names));
+  ASSERT_EQ(weight_names, std::vector<std::string>({"conv-weight", "fc-bias"}));
+  // the names do not overwrite the executable of the same fingerprint
+  ASSERT_TRUE(persistent_cache.Load("fingerprint", &serialized));
+  ASSERT_TRUE(serialized.empty());
+  LocalFS()->RecursivelyDeleteDir(dir);
+}
+
+}  // namespace xrt
+}  // namespace oneflow
@@ -78,6 +78,13 @@ class Executable {
 
   const std::vector<Parameter> &Results() const { return results_; }
 
+  // Engines that could reload a compiled executable in another process override
+  // these, and `SerializeTo` returns false if the executable is not ready yet.
+  virtual bool SupportsSerialization() const { return false; }
+  virtual bool SerializeTo(std::string *serialized) const { return false; }
+  // Names of the parameters copied into the executable as constants at compile time.
+  virtual std::vector<std::string> WeightNames() const { return {}; }
+
  protected:
   // Executable name.
   std::string name_;
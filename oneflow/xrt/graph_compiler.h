@@ -67,6 +67,12 @@ class GraphCompiler {
                                                 const std::vector<Parameter> &return_params,
                                                 const std::vector<InputOutputAlias> &aliases) = 0;
 
+    // Rebuilds an executable from the output of `Executable::SerializeTo`, returns
+    // nullptr if the engine does not support it or the serialized executable is stale.
+    virtual std::shared_ptr<Executable> Deserialize(const std::string &serialized) {
+      return nullptr;
+    }
+
    protected:
     // Compiler name
     std::string name_ = "";
@@ -97,6 +103,10 @@ class GraphCompiler {
     return impl_->Compile(graph, entry_params, return_params, aliases);
   }
 
+  std::shared_ptr<Executable> Deserialize(const std::string &serialized) {
+    return impl_->Deserialize(serialized);
+  }
+
   const XrtEngine &engine() const { return engine_; }
 
  private:
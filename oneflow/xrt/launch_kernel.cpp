@@ -14,6 +14,12 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/xrt/launch_kernel.h"
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <set>
+#include <sstream>
+#include "oneflow/core/common/protobuf.h"
 #include "oneflow/xrt/api.h"
 #include "oneflow/xrt/compilation_cache.h"
 #include "oneflow/xrt/executable.h"
@@ -21,12 +27,23 @@ limitations under the License.
 #include "oneflow/xrt/platform.h"
 #include "oneflow/xrt/utility/env.h"
 
+#ifdef WITH_CUDA
+#include "cuda_runtime.h"
+#endif
+
 // General executable setup.
 DEFINE_int64(max_workspace_bytes, EnvToInt64(FLAGS_max_workspace_bytes, -1),
              "Maximum temporary workspace bytes.");
 // TENSORRT executable setup.
 DEFINE_int32(max_batch_size, EnvToInt(FLAGS_max_batch_size, 1),
              "Maximum batch size for builder of TENSORRT engine.");
+// Compilation cache setup.
+DEFINE_int64(xrt_compilation_cache_capacity, EnvToInt64(FLAGS_xrt_compilation_cache_capacity, 16),
+             "Maximum executables cached by each launch op, unbounded if not positive. Executables "
+             "are keyed by the static shapes of the inputs, so each launch op keeps at most one "
+             "executable per device and a dynamic batch size never adds entries.");
+DEFINE_string(xrt_compilation_cache_dir, EnvToString(FLAGS_xrt_compilation_cache_dir, ""),
+              "Directory to keep the serialized executables across runs, disabled if empty.");
 
 DECLARE_bool(tensorrt_fp16);
 DECLARE_bool(tensorrt_int8);
@@ -39,6 +56,46 @@ static Parameter BuildParameter(const Blob &blob, const std::string &name) {
   return Parameter(name, const_cast<void *>(blob.dptr<void>()), desc.body_shape(),
                    desc.data_type());
 }
+
+static PersistentCompilationCache *GetPersistentCompilationCache() {
+  if (FLAGS_xrt_compilation_cache_dir.empty()) { return nullptr; }
+  static PersistentCompilationCache persistent_cache(FLAGS_xrt_compilation_cache_dir);
+  return &persistent_cache;
+}
+
+// Copies the weights baked into an executable to host, since they may live in device memory
+static std::map<std::string, std::string> WeightContents(const std::vector<Parameter> &params,
+                                                         const std::vector<std::string> &names) {
+  const std::set<std::string> name_set(names.begin(), names.end());
+  std::map<std::string, std::string> weight_contents;
+  for (const Parameter &param : params) {
+    if (name_set.count(param.name()) == 0) { continue; }
+    std::string *content = &weight_contents[param.name()];
+    content->resize(param.shape().elem_cnt() * GetSizeOfDataType(param.data_type()));
+    if (content->empty()) { continue; }
+#ifdef WITH_CUDA
+    CHECK_EQ(cudaSuccess,
+             cudaMemcpy(&content->at(0), param.data(), content->size(), cudaMemcpyDefault));
+#else
+    std::memcpy(&content->at(0), param.data(), content->size());
+#endif
+  }
+  CHECK_EQ(weight_contents.size(), name_set.size());
+  return weight_contents;
+}
+
+// Everything besides the cluster and its parameters that changes the compiled executable
+static std::string CompilationOptionsToString(const XrtEngine &engine, const XrtDevice &device,
+                                              size_t num_aliases) {
+  std::ostringstream ss;
+  ss << "engine: " << engine << ", device: " << device << ", aliases: " << num_aliases
+     << ", max_workspace_bytes: " << FLAGS_max_workspace_bytes;
+  if (engine == XrtEngine::TENSORRT) {
+    ss << ", max_batch_size: " << FLAGS_max_batch_size << ", fp16: " << FLAGS_tensorrt_fp16
+       << ", int8: " << FLAGS_tensorrt_int8 << ", int8_calibration: " << FLAGS_int8_calibration;
+  }
+  return ss.str();
+}
 }  // namespace xrt
 
 template<DeviceType device_type>
@@ -62,21 +119,50 @@ void BlobDescGetter<device_type>::DumpEntryBlobDescTo(
 }
 
 template<DeviceType device_type>
-xrt::Executable *XrtLaunchKernel<device_type>::BuildExecutable(
+std::shared_ptr<xrt::CompilationRecord> XrtLaunchKernel<device_type>::BuildExecutable(
     const std::vector<xrt::Parameter> &entry_params,
     const std::vector<xrt::Parameter> &return_params,
     const std::vector<xrt::InputOutputAlias> &aliases, const int device_ordinal) const {
-  if (!compilation_cache_) { compilation_cache_.reset(new xrt::CompilationCache); }
+  if (!compilation_cache_) {
+    compilation_cache_.reset(new xrt::CompilationCache(FLAGS_xrt_compilation_cache_capacity));
+  }
 
-  xrt::Executable *executable = nullptr;
+  std::shared_ptr<xrt::CompilationRecord> record;
   xrt::Signature signature =
       xrt::ComputeSignature(this->op_conf().name(), device_ordinal, entry_params);
   bool force_compile = false;
-  if (!force_compile) { executable = compilation_cache_->GetRecord(signature); }
+  if (!force_compile) { record = compilation_cache_->GetRecord(signature); }
+  if (record) { return record; }
 
-  if (!executable) {
+  const auto &launch_conf = this->op_conf().xrt_launch_conf();
+  xrt::XrtEngine engine = xrt::StringToXrtEngine(launch_conf.engine());
+  xrt::XrtDevice device = xrt::DeviceTypeToXrtDevice(device_type);
+  xrt::GraphCompiler compiler(this->op_conf().name(), engine, device, device_ordinal);
+  record.reset(new xrt::CompilationRecord);
+  // Reuse the executable compiled by an earlier run if the engine could reload it. The weights
+  // baked into that executable are known from the earlier run, and their contents have to match
+  // the current ones, which may come from another checkpoint.
+  xrt::PersistentCompilationCache *persistent_cache = xrt::GetPersistentCompilationCache();
+  std::string fingerprint_without_weights;
+  if (persistent_cache) {
+    fingerprint_without_weights =
+        xrt::ComputeFingerprint(PbMessage2TxtString(launch_conf.function()),
+                                xrt::CompilationOptionsToString(engine, device, aliases.size()),
+                                entry_params, return_params);
+    std::vector<std::string> weight_names;
+    std::string serialized;
+    if (persistent_cache->LoadWeightNames(fingerprint_without_weights, &weight_names)) {
+      record->fingerprint = xrt::ComputeFingerprint(
+          fingerprint_without_weights, xrt::WeightContents(entry_params, weight_names));
+      if (persistent_cache->Load(record->fingerprint, &serialized)) {
+        record->executable = compiler.Deserialize(serialized);
+      }
+    }
+  }
+
+  if (!record->executable) {
     VLOG(2) << "Build executable for launch op " << this->op_conf().name();
-    const auto &launch_conf = this->op_conf().xrt_launch_conf();
+    const auto start = std::chrono::steady_clock::now();
     auto graph = xrt::BuildXrtGraph(launch_conf.function(), device_type, this->job_desc());
     {
       // Run InferShape pass
@@ -92,17 +178,24 @@ xrt::Executable *XrtLaunchKernel<device_type>::BuildExecutable(
       // xrt::RunXrtPass("UpdateArgMetaData", graph.get(), options,
       //                 &this->job_desc());
     }
-    xrt::XrtEngine engine = xrt::StringToXrtEngine(launch_conf.engine());
-    xrt::XrtDevice device = xrt::DeviceTypeToXrtDevice(device_type);
-    xrt::GraphCompiler compiler(this->op_conf().name(), engine, device, device_ordinal);
-    auto result = compiler.Compile(graph.get(), entry_params, return_params, aliases);
-    // Record new compilation result
-    compilation_cache_->Record(signature, result);
-    // Get compilation result from cache
-    executable = compilation_cache_->GetRecord(signature);
+    record->executable = compiler.Compile(graph.get(), entry_params, return_params, aliases);
+    record->pending_store = !fingerprint_without_weights.empty() && record->executable
+                            && record->executable->SupportsSerialization();
+    if (record->pending_store) {
+      const std::vector<std::string> weight_names = record->executable->WeightNames();
+      persistent_cache->StoreWeightNames(fingerprint_without_weights, weight_names);
+      record->fingerprint = xrt::ComputeFingerprint(
+          fingerprint_without_weights, xrt::WeightContents(entry_params, weight_names));
+    }
+    xrt::RecordCompilationTime(
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+            .count());
+    VLOG(2) << "Compilation cache of launch op " << this->op_conf().name() << ": "
+            << xrt::GetCompilationCacheMetrics().ToString();
   }
-
-  return std::move(executable);
+  // Record new compilation result
+  compilation_cache_->Record(signature, record);
+  return record;
 }
 
 template<DeviceType device_type>
@@ -165,7 +258,8 @@ void XrtLaunchKernel<device_type>::ForwardDataContent(
   // Mapping parameter names to function input and output names.
   MappingParamsToFunctionNames(&entry_params, &return_params);
   // Build executable.
-  auto executable = BuildExecutable(entry_params, return_params, aliases, device_ordinal);
+  auto record = BuildExecutable(entry_params, return_params, aliases, device_ordinal);
+  xrt::Executable *executable = record->executable.get();
   if (!executable) { LOG(FATAL) << "Executable is built failed."; }
   // Run executable.
   xrt::ExecutableRunOptions run_options;
@@ -186,6 +280,13 @@ void XrtLaunchKernel<device_type>::ForwardDataContent(
   }
   bool status = executable->Run(entry_params, run_options, block_until_done);
   CHECK(status) << "Executable is running failed.";
+  if (record->pending_store) {
+    std::string serialized;
+    if (executable->SerializeTo(&serialized)) {
+      xrt::GetPersistentCompilationCache()->Store(record->fingerprint, serialized);
+      record->pending_store = false;
+    }
+  }
 
   const std::vector<xrt::Parameter> &results = executable->Results();
   CHECK_EQ(results.size(), return_params.size());
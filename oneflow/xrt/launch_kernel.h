@@ -52,10 +52,10 @@ class XrtLaunchKernel : public KernelIf<device_type> {
   void ForwardDataContent(const KernelCtx &ctx,
                           std::function<Blob *(const std::string &)> BnInOp2Blob) const override;
 
-  xrt::Executable *BuildExecutable(const std::vector<xrt::Parameter> &entry_params,
-                                   const std::vector<xrt::Parameter> &return_params,
-                                   const std::vector<xrt::InputOutputAlias> &aliases,
-                                   const int device_ordinal) const;
+  std::shared_ptr<xrt::CompilationRecord> BuildExecutable(
+      const std::vector<xrt::Parameter> &entry_params,
+      const std::vector<xrt::Parameter> &return_params,
+      const std::vector<xrt::InputOutputAlias> &aliases, const int device_ordinal) const;
 
   void MakeInputOutputAlias(                            // NOLINT
       const std::vector<xrt::Parameter> &entry_params,  // NOLINT
@@ -0,0 +1,697 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/fused_program.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <sstream>
+#include <type_traits>
+#include <unordered_map>
+
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/common/shape_view.h"
+#include "oneflow/core/framework/multi_thread.h"
+#include "oneflow/xrt/parameter.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+namespace {
+
+// Elements of a tile, small enough to keep the registers of a stage in L1
+constexpr int64_t kTileSize = 256;
+
+bool IsReduction(const FusedOpCode &op_code) {
+  return op_code == FusedOpCode::kReduceSum || op_code == FusedOpCode::kReduceMean;
+}
+
+// The type a cluster of both types computes in, which holds the values of both exactly. Clusters
+// which mix integral and floating point types are never built, see IsSatisfyDataTypes.
+DataType WiderDataType(const DataType &lhs, const DataType &rhs) {
+  if (lhs == rhs) { return lhs; }
+  CHECK_EQ(IsFloatingDataType(lhs), IsFloatingDataType(rhs))
+      << "The native xrt engine does not mix integral and floating point data types, got "
+      << DataType_Name(lhs) << " and " << DataType_Name(rhs);
+  return IsFloatingDataType(lhs) ? DataType::kDouble : DataType::kInt64;
+}
+
+bool IsElementwise(const FusedOpCode &op_code) {
+  return op_code != FusedOpCode::kParameter && op_code != FusedOpCode::kView
+         && !IsReduction(op_code);
+}
+
+bool IsSupportedDataType(const DataType &data_type) {
+  switch (data_type) {
+    case DataType::kFloat:
+    case DataType::kDouble:
+    case DataType::kInt8:
+    case DataType::kInt32:
+    case DataType::kInt64:
+    case DataType::kUInt8: return true;
+    default: return false;
+  }
+}
+
+// Calls Functor<U>::Invoke with U being the c++ type of `data_type`
+template<template<typename> class Functor, typename... Args>
+void SwitchDataType(const DataType &data_type, Args &&... args) {
+  switch (data_type) {
+    case DataType::kFloat: Functor<float>::Invoke(std::forward<Args>(args)...); return;
+    case DataType::kDouble: Functor<double>::Invoke(std::forward<Args>(args)...); return;
+    case DataType::kInt8: Functor<int8_t>::Invoke(std::forward<Args>(args)...); return;
+    case DataType::kInt32: Functor<int32_t>::Invoke(std::forward<Args>(args)...); return;
+    case DataType::kInt64: Functor<int64_t>::Invoke(std::forward<Args>(args)...); return;
+    case DataType::kUInt8: Functor<uint8_t>::Invoke(std::forward<Args>(args)...); return;
+    default: LOG(FATAL) << "The native xrt engine does not support data type " << data_type;
+  }
+}
+
+DimVector DomainOf(const Shape &shape) {
+  DimVector domain = shape.dim_vec();
+  if (domain.empty()) { domain.push_back(1); }
+  return domain;
+}
+
+// Element strides of `shape` along each axis of `domain` it broadcasts to, empty if the shape is
+// laid out as the domain
+std::vector<int64_t> BroadcastStrides(const Shape &shape, const DimVector &domain) {
+  CHECK_LE(shape.NumAxes(), domain.size());
+  DimVector dims(domain.size() - shape.NumAxes(), 1);
+  dims.insert(dims.end(), shape.dim_vec().begin(), shape.dim_vec().end());
+  if (dims == domain) { return std::vector<int64_t>(); }
+  std::vector<int64_t> strides(domain.size());
+  int64_t stride = 1;
+  for (int64_t axis = domain.size() - 1; axis >= 0; --axis) {
+    CHECK(dims.at(axis) == domain.at(axis) || dims.at(axis) == 1)
+        << "Shape " << shape.ToString() << " could not be broadcast to the loop domain.";
+    strides.at(axis) = dims.at(axis) == 1 ? 0 : stride;
+    stride *= dims.at(axis);
+  }
+  return strides;
+}
+
+Shape BroadcastShape(const Shape &a, const Shape &b) {
+  const int64_t num_axes = std::max(a.NumAxes(), b.NumAxes());
+  const Shape extended_a = CreateLeftExtendedShape(ShapeView(a), num_axes);
+  const Shape extended_b = CreateLeftExtendedShape(ShapeView(b), num_axes);
+  DimVector dims(num_axes);
+  FOR_RANGE(int64_t, axis, 0, num_axes) {
+    const int64_t dim_a = extended_a.At(axis);
+    const int64_t dim_b = extended_b.At(axis);
+    CHECK(dim_a == dim_b || dim_a == 1 || dim_b == 1)
+        << "Shapes " << a.ToString() << " and " << b.ToString() << " could not be broadcast.";
+    dims.at(axis) = dim_a == 1 ? dim_b : dim_a;
+  }
+  return Shape(dims);
+}
+
+// Offsets in a slot with `strides` of the domain elements [begin, begin + n)
+void ComputeOffsets(const DimVector &domain, const std::vector<int64_t> &strides, int64_t begin,
+                    int64_t n, int64_t *offsets) {
+  const int64_t last_axis = domain.size() - 1;
+  DimVector index(domain.size());
+  int64_t offset = 0;
+  int64_t remaining = begin;
+  for (int64_t axis = last_axis; axis >= 0; --axis) {
+    index.at(axis) = remaining % domain.at(axis);
+    remaining /= domain.at(axis);
+    offset += index.at(axis) * strides.at(axis);
+  }
+  const int64_t inner_stride = strides.at(last_axis);
+  int64_t i = 0;
+  while (i < n) {
+    const int64_t run = std::min(n - i, domain.at(last_axis) - index.at(last_axis));
+    FOR_RANGE(int64_t, j, 0, run) { offsets[i + j] = offset + j * inner_stride; }
+    i += run;
+    offset += run * inner_stride;
+    index.at(last_axis) += run;
+    for (int64_t axis = last_axis; axis > 0 && index.at(axis) == domain.at(axis); --axis) {
+      offset += strides.at(axis - 1) - index.at(axis) * strides.at(axis);
+      index.at(axis) = 0;
+      index.at(axis - 1) += 1;
+    }
+  }
+}
+
+// U is the element type of the slot and T is the compute type
+template<typename U>
+struct LoadUtil {
+  template<typename T>
+  static void Invoke(const FusedInstruction &instruction, const DimVector &domain,
+                     char *const *slots, int64_t begin, int64_t n, int64_t *offsets, T *dst) {
+    const U *src = reinterpret_cast<const U *>(slots[instruction.slot]);
+    if (instruction.strides.empty()) {
+      FOR_RANGE(int64_t, i, 0, n) { dst[i] = static_cast<T>(src[begin + i]); }
+    } else {
+      ComputeOffsets(domain, instruction.strides, begin, n, offsets);
+      FOR_RANGE(int64_t, i, 0, n) { dst[i] = static_cast<T>(src[offsets[i]]); }
+    }
+  }
+};
+
+template<typename U>
+struct StoreUtil {
+  template<typename T>
+  static void Invoke(const FusedInstruction &instruction, char *const *slots, int64_t begin,
+                     int64_t n, const T *src) {
+    U *dst = reinterpret_cast<U *>(slots[instruction.slot]) + begin;
+    FOR_RANGE(int64_t, i, 0, n) { dst[i] = static_cast<U>(src[i]); }
+  }
+};
+
+// Rounds through U, the compute type could be wider
+template<typename U>
+struct CastUtil {
+  template<typename T>
+  static void Invoke(const T *x, int64_t n, T *z) {
+    FOR_RANGE(int64_t, i, 0, n) { z[i] = static_cast<T>(static_cast<U>(x[i])); }
+  }
+};
+
+template<typename U>
+struct FinalizeReductionUtil {
+  template<typename T>
+  static void Invoke(const FusedReduction &reduction, const T *acc, char *const *slots) {
+    U *out = reinterpret_cast<U *>(slots[reduction.slot]);
+    if (reduction.divisor == 1) {
+      FOR_RANGE(int64_t, i, 0, reduction.elem_cnt) { out[i] = static_cast<U>(acc[i]); }
+    } else {
+      const T divisor = static_cast<T>(reduction.divisor);
+      FOR_RANGE(int64_t, i, 0, reduction.elem_cnt) { out[i] = static_cast<U>(acc[i] / divisor); }
+    }
+  }
+};
+
+template<typename T>
+void Load(const FusedInstruction &instruction, const DimVector &domain, char *const *slots,
+          int64_t begin, int64_t n, int64_t *offsets, T *dst) {
+  SwitchDataType<LoadUtil>(instruction.data_type, instruction, domain, slots, begin, n, offsets,
+                           dst);
+}
+
+template<typename T>
+void Store(const FusedInstruction &instruction, char *const *slots, int64_t begin, int64_t n,
+           const T *src) {
+  SwitchDataType<StoreUtil>(instruction.data_type, instruction, slots, begin, n, src);
+}
+
+template<typename T>
+void Accumulate(const FusedInstruction &instruction, const DimVector &domain, char *const *slots,
+                int64_t begin, int64_t n, int64_t *offsets, const T *src) {
+  T *acc = reinterpret_cast<T *>(slots[instruction.slot]);
+  if (instruction.strides.empty()) {
+    FOR_RANGE(int64_t, i, 0, n) { acc[begin + i] += src[i]; }
+  } else {
+    ComputeOffsets(domain, instruction.strides, begin, n, offsets);
+    FOR_RANGE(int64_t, i, 0, n) { acc[offsets[i]] += src[i]; }
+  }
+}
+
+template<typename T>
+void Compute(const FusedInstruction &instruction, const T *x, const T *y, int64_t n, T *z) {
+  // Transcendental functions of integers are evaluated in double
+  using F = typename std::conditional<std::is_floating_point<T>::value, T, double>::type;
+  const T scalar = static_cast<T>(instruction.scalar);
+  switch (instruction.op_code) {
+    case FusedOpCode::kIdentity: {
+      FOR_RANGE(int64_t, i, 0, n) { z[i] = x[i]; }
+      break;
+    }
+    case FusedOpCode::kRelu: {
+      FOR_RANGE(int64_t, i, 0, n) { z[i] = x[i] > static_cast<T>(0) ? x[i] : static_cast<T>(0); }
+      break;
+    }
+    case FusedOpCode::kLeakyRelu: {
+      const F alpha = static_cast<F>(instruction.scalar);
+      FOR_RANGE(int64_t, i, 0, n) {
+        z[i] = x[i] > static_cast<T>(0) ? x[i] : static_cast<T>(static_cast<F>(x[i]) * alpha);
+      }
+      break;
+    }
+    case FusedOpCode::kSigmoid: {
+      FOR_RANGE(int64_t, i, 0, n) {
+        const F v = static_cast<F>(x[i]);
+        z[i] = static_cast<T>(static_cast<F>(1) / (static_cast<F>(1) + std::exp(-v)));
+      }
+      break;
+    }
+    case FusedOpCode::kTanh: {
+      FOR_RANGE(int64_t, i, 0, n) { z[i] = static_cast<T>(std::tanh(static_cast<F>(x[i]))); }
+      break;
+    }
+    case FusedOpCode::kGelu: {
+      const F half = static_cast<F>(0.5);
+      const F inv_sqrt2 = static_cast<F>(std::sqrt(0.5));
+      FOR_RANGE(int64_t, i, 0, n) {
+        const F v = static_cast<F>(x[i]);
+        z[i] = static_cast<T>(half * v * (static_cast<F>(1) + std::erf(v * inv_sqrt2)));
+      }
+      break;
+    }
+    case FusedOpCode::kRsqrt: {
+      FOR_RANGE(int64_t, i, 0, n) {
+        z[i] = static_cast<T>(static_cast<F>(1) / std::sqrt(static_cast<F>(x[i])));
+      }
+      break;
+    }
+    case FusedOpCode::kScalarAdd: {
+      FOR_RANGE(int64_t, i, 0, n) { z[i] = x[i] + scalar; }
+      break;
+    }
+    case FusedOpCode::kScalarMul: {
+      FOR_RANGE(int64_t, i, 0, n) { z[i] = x[i] * scalar; }
+      break;
+    }
+    case FusedOpCode::kScalarDiv: {
+      FOR_RANGE(int64_t, i, 0, n) { z[i] = x[i] / scalar; }
+      break;
+    }
+    case FusedOpCode::kCast: {
+      SwitchDataType<CastUtil>(instruction.data_type, x, n, z);
+      break;
+    }
+    case FusedOpCode::kAdd: {
+      FOR_RANGE(int64_t, i, 0, n) { z[i] = x[i] + y[i]; }
+      break;
+    }
+    case FusedOpCode::kMul: {
+      FOR_RANGE(int64_t, i, 0, n) { z[i] = x[i] * y[i]; }
+      break;
+    }
+    case FusedOpCode::kDiv: {
+      FOR_RANGE(int64_t, i, 0, n) { z[i] = x[i] / y[i]; }
+      break;
+    }
+    case FusedOpCode::kMin: {
+      FOR_RANGE(int64_t, i, 0, n) { z[i] = std::min(x[i], y[i]); }
+      break;
+    }
+    default: LOG(FATAL) << "Op code " << static_cast<int32_t>(instruction.op_code)
+                        << " is not elementwise.";
+  }
+}
+
+template<typename T>
+void RunTiles(const FusedStage &stage, char *const *slots, int64_t first_tile, int64_t last_tile) {
+  std::vector<T> registers(stage.num_registers * kTileSize);
+  std::vector<int64_t> offsets(kTileSize);
+  const auto Register = [&](int32_t reg) { return registers.data() + reg * kTileSize; };
+  FOR_RANGE(int64_t, tile, first_tile, last_tile) {
+    const int64_t begin = tile * kTileSize;
+    const int64_t n = std::min(kTileSize, stage.elem_cnt - begin);
+    for (const FusedInstruction &instruction : stage.instructions) {
+      switch (instruction.kind) {
+        case FusedInstruction::kLoad: {
+          Load<T>(instruction, stage.domain, slots, begin, n, offsets.data(),
+                  Register(instruction.dst));
+          break;
+        }
+        case FusedInstruction::kCompute: {
+          const T *y = instruction.src1 >= 0 ? Register(instruction.src1) : nullptr;
+          Compute<T>(instruction, Register(instruction.src0), y, n, Register(instruction.dst));
+          break;
+        }
+        case FusedInstruction::kStore: {
+          Store<T>(instruction, slots, begin, n, Register(instruction.src0));
+          break;
+        }
+        case FusedInstruction::kAccumulate: {
+          Accumulate<T>(instruction, stage.domain, slots, begin, n, offsets.data(),
+                        Register(instruction.src0));
+          break;
+        }
+      }
+    }
+  }
+}
+
+template<typename T>
+void RunStage(const FusedStage &stage, char *const *slots) {
+  for (const FusedReduction &reduction : stage.reductions) {
+    T *acc = reinterpret_cast<T *>(slots[reduction.acc_slot]);
+    std::fill(acc, acc + reduction.elem_cnt, static_cast<T>(0));
+  }
+  const int64_t num_tiles = (stage.elem_cnt + kTileSize - 1) / kTileSize;
+  // Tiles of a reduction may add into the same accumulator, so they run on one thread
+  if (!stage.reductions.empty()) {
+    RunTiles<T>(stage, slots, 0, num_tiles);
+  } else {
+    user_op::ParallelForEachRange(num_tiles, kTileSize, [&](int64_t begin, int64_t end) {
+      RunTiles<T>(stage, slots, begin, end);
+    });
+  }
+  for (const FusedReduction &reduction : stage.reductions) {
+    const T *acc = reinterpret_cast<const T *>(slots[reduction.acc_slot]);
+    SwitchDataType<FinalizeReductionUtil>(reduction.data_type, reduction, acc, slots);
+  }
+}
+
+template<typename T>
+struct RunStageUtil {
+  static void Invoke(const FusedStage &stage, char *const *slots) { RunStage<T>(stage, slots); }
+};
+
+// Maps the registers of a stage, one per value, onto as few registers as their live ranges allow
+int32_t AllocateRegisters(std::vector<FusedInstruction> *instructions) {
+  std::unordered_map<int32_t, int64_t> last_use;
+  FOR_RANGE(int64_t, i, 0, instructions->size()) {
+    const FusedInstruction &instruction = instructions->at(i);
+    if (instruction.src0 >= 0) { last_use[instruction.src0] = i; }
+    if (instruction.src1 >= 0) { last_use[instruction.src1] = i; }
+  }
+  std::unordered_map<int32_t, int32_t> mapping;
+  std::vector<int32_t> free_registers;
+  int32_t num_registers = 0;
+  FOR_RANGE(int64_t, i, 0, instructions->size()) {
+    FusedInstruction *instruction = &instructions->at(i);
+    // Sources are released first, all the ops read and write the same element of a tile so the
+    // destination could take the register of a source
+    const int32_t src0 = instruction->src0;
+    const int32_t src1 = instruction->src1;
+    if (src0 >= 0) { instruction->src0 = mapping.at(src0); }
+    if (src1 >= 0) { instruction->src1 = mapping.at(src1); }
+    if (src0 >= 0 && last_use.at(src0) == i) { free_registers.push_back(mapping.at(src0)); }
+    if (src1 >= 0 && src1 != src0 && last_use.at(src1) == i) {
+      free_registers.push_back(mapping.at(src1));
+    }
+    if (instruction->dst >= 0) {
+      int32_t reg = num_registers;
+      if (free_registers.empty()) {
+        num_registers += 1;
+      } else {
+        reg = free_registers.back();
+        free_registers.pop_back();
+      }
+      mapping[instruction->dst] = reg;
+      instruction->dst = reg;
+    }
+  }
+  return num_registers;
+}
+
+}  // namespace
+
+void FusedProgram::Run(const std::vector<char *> &slots) const {
+  CHECK_EQ(slots.size(), num_slots());
+  for (const FusedStage &stage : stages_) {
+    SwitchDataType<RunStageUtil>(compute_type_, stage, slots.data());
+  }
+}
+
+std::string FusedProgram::ToString() const {
+  std::ostringstream ss;
+  ss << "compute type: " << DataType_Name(compute_type_) << ", entries: " << num_entries_
+     << ", returns: " << num_returns_ << ", temporary buffers: " << temp_byte_sizes_.size();
+  FOR_RANGE(int64_t, i, 0, stages_.size()) {
+    const FusedStage &stage = stages_.at(i);
+    ss << "\nstage " << i << ": domain " << Shape(stage.domain).ToString() << ", "
+       << stage.instructions.size() << " instructions, " << stage.num_registers
+       << " registers, " << stage.reductions.size() << " reductions";
+  }
+  return ss.str();
+}
+
+int64_t FusedProgramBuilder::AddNode(FusedNode &&node) {
+  nodes_.push_back(std::move(node));
+  return nodes_.size() - 1;
+}
+
+int64_t FusedProgramBuilder::Parameter(const Shape &shape, const DataType &data_type) {
+  FusedNode node;
+  node.op_code = FusedOpCode::kParameter;
+  node.shape = shape;
+  node.data_type = data_type;
+  const int64_t value = AddNode(std::move(node));
+  params_.push_back(value);
+  return value;
+}
+
+int64_t FusedProgramBuilder::Unary(const FusedOpCode &op_code, int64_t x, double scalar) {
+  CHECK(IsElementwise(op_code) && op_code != FusedOpCode::kCast);
+  FusedNode node;
+  node.op_code = op_code;
+  node.inputs = {x};
+  node.shape = shape(x);
+  node.data_type = data_type(x);
+  node.scalar = scalar;
+  return AddNode(std::move(node));
+}
+
+int64_t FusedProgramBuilder::Cast(int64_t x, const DataType &data_type) {
+  FusedNode node;
+  node.op_code = FusedOpCode::kCast;
+  node.inputs = {x};
+  node.shape = shape(x);
+  node.data_type = data_type;
+  return AddNode(std::move(node));
+}
+
+int64_t FusedProgramBuilder::Binary(const FusedOpCode &op_code, int64_t a, int64_t b) {
+  CHECK(op_code == FusedOpCode::kAdd || op_code == FusedOpCode::kMul
+        || op_code == FusedOpCode::kDiv || op_code == FusedOpCode::kMin);
+  CHECK_EQ(data_type(a), data_type(b));
+  FusedNode node;
+  node.op_code = op_code;
+  node.inputs = {a, b};
+  node.shape = BroadcastShape(shape(a), shape(b));
+  node.data_type = data_type(a);
+  return AddNode(std::move(node));
+}
+
+int64_t FusedProgramBuilder::Reduce(const FusedOpCode &op_code, int64_t x,
+                                    std::vector<int32_t> axis, bool keepdims) {
+  CHECK(IsReduction(op_code));
+  const Shape &in_shape = shape(x);
+  // Reduce all the axes if none is given
+  if (axis.empty()) {
+    axis.resize(in_shape.NumAxes());
+    std::iota(axis.begin(), axis.end(), 0);
+  }
+  DimVector keepdims_dims = in_shape.dim_vec();
+  for (int32_t &a : axis) {
+    if (a < 0) { a += in_shape.NumAxes(); }
+    CHECK(a >= 0 && a < in_shape.NumAxes());
+    keepdims_dims.at(a) = 1;
+  }
+  DimVector out_dims;
+  FOR_RANGE(int64_t, i, 0, in_shape.NumAxes()) {
+    if (std::find(axis.begin(), axis.end(), i) == axis.end()) {
+      out_dims.push_back(in_shape.At(i));
+    }
+  }
+  FusedNode node;
+  node.op_code = op_code;
+  node.inputs = {x};
+  node.keepdims_shape = Shape(keepdims_dims);
+  if (keepdims) {
+    node.shape = node.keepdims_shape;
+  } else {
+    // Keep consistent with oneflow, which reduces all the axes into a 1-d array
+    node.shape = out_dims.empty() ? Shape({1}) : Shape(out_dims);
+  }
+  node.data_type = data_type(x);
+  return AddNode(std::move(node));
+}
+
+int64_t FusedProgramBuilder::View(int64_t x, const Shape &shape) {
+  CHECK_EQ(shape.elem_cnt(), this->shape(x).elem_cnt());
+  FusedNode node;
+  node.op_code = FusedOpCode::kView;
+  node.inputs = {x};
+  node.shape = shape;
+  node.data_type = data_type(x);
+  return AddNode(std::move(node));
+}
+
+std::shared_ptr<FusedProgram> FusedProgramBuilder::Build() {
+  // Every return parameter is written by a node of its own
+  std::vector<int64_t> outputs;
+  for (int64_t value : outputs_) {
+    const FusedOpCode &op_code = nodes_.at(value).op_code;
+    if ((!IsElementwise(op_code) && !IsReduction(op_code))
+        || std::find(outputs.begin(), outputs.end(), value) != outputs.end()) {
+      value = Unary(FusedOpCode::kIdentity, value);
+    }
+    outputs.push_back(value);
+  }
+  const int64_t num_nodes = nodes_.size();
+  std::vector<int64_t> return_index(num_nodes, -1);
+  FOR_RANGE(int64_t, i, 0, outputs.size()) { return_index.at(outputs.at(i)) = i; }
+
+  // Drop the nodes no output depends on
+  std::vector<bool> is_live(num_nodes, false);
+  for (int64_t value : outputs) { is_live.at(value) = true; }
+  for (int64_t value = num_nodes - 1; value >= 0; --value) {
+    if (!is_live.at(value)) { continue; }
+    for (int64_t input : nodes_.at(value).inputs) { is_live.at(input) = true; }
+  }
+
+  // Compute in the element type of the cluster, or in the widest type of its kind if it has
+  // several floating point or several integral types
+  DataType compute_type = DataType::kInvalidDataType;
+  FOR_RANGE(int64_t, value, 0, num_nodes) {
+    if (!is_live.at(value) && nodes_.at(value).op_code != FusedOpCode::kParameter) { continue; }
+    const DataType &data_type = nodes_.at(value).data_type;
+    CHECK(IsSupportedDataType(data_type))
+        << "The native xrt engine does not support data type " << DataType_Name(data_type);
+    compute_type = compute_type == DataType::kInvalidDataType
+                       ? data_type
+                       : WiderDataType(compute_type, data_type);
+  }
+  if (compute_type == DataType::kInvalidDataType) { compute_type = DataType::kFloat; }
+
+  const auto StorageOf = [&](int64_t value) {
+    while (nodes_.at(value).op_code == FusedOpCode::kView) {
+      value = nodes_.at(value).inputs.at(0);
+    }
+    return value;
+  };
+  const auto DomainOfNode = [&](const FusedNode &node) {
+    return DomainOf(IsReduction(node.op_code) ? shape(node.inputs.at(0)) : node.shape);
+  };
+
+  // Split the nodes into stages
+  std::vector<int64_t> stage_of(num_nodes, -1);
+  std::vector<bool> is_materialized(num_nodes, false);
+  std::vector<DimVector> stage_domains;
+  std::vector<std::vector<int64_t>> stage_values;
+  // Values of the stage are read from registers, the others from their storage
+  const auto IsReadFromRegister = [&](int64_t input, int64_t stage) {
+    return stage_of.at(input) == stage && IsElementwise(nodes_.at(input).op_code);
+  };
+  const auto CouldJoinStage = [&](const FusedNode &node, int64_t stage) {
+    if (stage < 0 || DomainOfNode(node) != stage_domains.at(stage)) { return false; }
+    for (int64_t input : node.inputs) {
+      if (IsReadFromRegister(input, stage)) { continue; }
+      if (stage_of.at(StorageOf(input)) == stage) { return false; }
+    }
+    return true;
+  };
+  FOR_RANGE(int64_t, value, 0, num_nodes) {
+    const FusedNode &node = nodes_.at(value);
+    if (!is_live.at(value) || (!IsElementwise(node.op_code) && !IsReduction(node.op_code))) {
+      continue;
+    }
+    int64_t stage = static_cast<int64_t>(stage_domains.size()) - 1;
+    if (!CouldJoinStage(node, stage)) {
+      stage_domains.push_back(DomainOfNode(node));
+      stage_values.emplace_back();
+      stage += 1;
+    }
+    stage_of.at(value) = stage;
+    stage_values.at(stage).push_back(value);
+    for (int64_t input : node.inputs) {
+      if (!IsReadFromRegister(input, stage)) { is_materialized.at(StorageOf(input)) = true; }
+    }
+    if (IsReduction(node.op_code) || return_index.at(value) >= 0) {
+      is_materialized.at(value) = true;
+    }
+  }
+
+  // Entry and return parameters take the leading slots, the other materialized values get
+  // temporary buffers
+  const int64_t num_entries = params_.size();
+  const int64_t num_returns = outputs.size();
+  std::vector<int64_t> temp_byte_sizes;
+  const auto NewTempSlot = [&](int64_t byte_size) {
+    temp_byte_sizes.push_back(byte_size);
+    return num_entries + num_returns + static_cast<int64_t>(temp_byte_sizes.size()) - 1;
+  };
+  std::vector<int64_t> slot_of(num_nodes, -1);
+  FOR_RANGE(int64_t, i, 0, num_entries) { slot_of.at(params_.at(i)) = i; }
+  FOR_RANGE(int64_t, value, 0, num_nodes) {
+    if (!is_materialized.at(value) || slot_of.at(value) >= 0) { continue; }
+    const FusedNode &node = nodes_.at(value);
+    if (return_index.at(value) >= 0) {
+      slot_of.at(value) = num_entries + return_index.at(value);
+    } else {
+      slot_of.at(value) = NewTempSlot(node.shape.elem_cnt() * SizeOf(node.data_type));
+    }
+  }
+
+  std::vector<FusedStage> stages(stage_domains.size());
+  FOR_RANGE(int64_t, i, 0, stages.size()) {
+    FusedStage &stage = stages.at(i);
+    stage.domain = stage_domains.at(i);
+    stage.elem_cnt = Shape(stage.domain).elem_cnt();
+    std::vector<FusedInstruction> &instructions = stage.instructions;
+    std::unordered_map<int64_t, int32_t> value2register;
+    int32_t num_virtual_registers = 0;
+    const auto Operand = [&](int64_t value) {
+      const auto it = value2register.find(value);
+      if (it != value2register.end()) { return it->second; }
+      const int64_t storage = StorageOf(value);
+      FusedInstruction load;
+      load.kind = FusedInstruction::kLoad;
+      load.dst = num_virtual_registers++;
+      load.data_type = nodes_.at(storage).data_type;
+      load.slot = slot_of.at(storage);
+      load.strides = BroadcastStrides(shape(value), stage.domain);
+      instructions.push_back(load);
+      value2register.emplace(value, load.dst);
+      return load.dst;
+    };
+    for (int64_t value : stage_values.at(i)) {
+      const FusedNode &node = nodes_.at(value);
+      if (IsReduction(node.op_code)) {
+        const int64_t out_elem_cnt = node.keepdims_shape.elem_cnt();
+        FusedInstruction accumulate;
+        accumulate.kind = FusedInstruction::kAccumulate;
+        accumulate.src0 = Operand(node.inputs.at(0));
+        accumulate.slot = NewTempSlot(out_elem_cnt * SizeOf(compute_type));
+        accumulate.strides = BroadcastStrides(node.keepdims_shape, stage.domain);
+        instructions.push_back(accumulate);
+        FusedReduction reduction;
+        reduction.acc_slot = accumulate.slot;
+        reduction.slot = slot_of.at(value);
+        reduction.data_type = node.data_type;
+        reduction.elem_cnt = out_elem_cnt;
+        reduction.divisor = node.op_code == FusedOpCode::kReduceMean && out_elem_cnt > 0
+                                ? std::max<int64_t>(stage.elem_cnt / out_elem_cnt, 1)
+                                : 1;
+        stage.reductions.push_back(reduction);
+        continue;
+      }
+      FusedInstruction compute;
+      compute.kind = FusedInstruction::kCompute;
+      compute.op_code = node.op_code;
+      compute.src0 = Operand(node.inputs.at(0));
+      if (node.inputs.size() > 1) { compute.src1 = Operand(node.inputs.at(1)); }
+      compute.scalar = node.scalar;
+      compute.data_type = node.data_type;
+      compute.dst = num_virtual_registers++;
+      instructions.push_back(compute);
+      value2register.emplace(value, compute.dst);
+      if (is_materialized.at(value)) {
+        FusedInstruction store;
+        store.kind = FusedInstruction::kStore;
+        store.src0 = compute.dst;
+        store.data_type = node.data_type;
+        store.slot = slot_of.at(value);
+        instructions.push_back(store);
+      }
+    }
+    stage.num_registers = AllocateRegisters(&instructions);
+  }
+  return std::make_shared<FusedProgram>(compute_type, num_entries, num_returns,
+                                        std::move(temp_byte_sizes), std::move(stages));
+}
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
@@ -0,0 +1,180 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_XRT_NATIVE_FUSED_PROGRAM_H_
+#define ONEFLOW_XRT_NATIVE_FUSED_PROGRAM_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "oneflow/core/common/data_type.pb.h"
+#include "oneflow/core/common/shape.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+enum class FusedOpCode : int32_t {
+  kParameter = 0,
+  // Reads the storage of its input with another shape of the same element count
+  kView,
+  // Elementwise ops, the binary ones broadcast as numpy does
+  kIdentity,
+  kRelu,
+  kLeakyRelu,
+  kSigmoid,
+  kTanh,
+  kGelu,
+  kRsqrt,
+  kScalarAdd,
+  kScalarMul,
+  kScalarDiv,
+  kCast,
+  kAdd,
+  kMul,
+  kDiv,
+  kMin,
+  // Reductions
+  kReduceSum,
+  kReduceMean,
+};
+
+struct FusedNode {
+  FusedOpCode op_code;
+  std::vector<int64_t> inputs;
+  Shape shape;
+  DataType data_type;
+  // Operand of the scalar ops and alpha of leaky relu
+  double scalar = 0;
+  // Input shape of a reduction with the reduced axes set to 1
+  Shape keepdims_shape;
+};
+
+struct FusedInstruction {
+  enum Kind : int32_t {
+    // Reads the elements of a tile from a slot into a register
+    kLoad = 0,
+    // Applies `op_code` on one or two registers
+    kCompute,
+    // Writes a register into a slot, which is laid out as the stage domain
+    kStore,
+    // Adds a register into the accumulator of a reduction
+    kAccumulate,
+  };
+  Kind kind;
+  FusedOpCode op_code = FusedOpCode::kIdentity;
+  int32_t dst = -1;
+  int32_t src0 = -1;
+  int32_t src1 = -1;
+  double scalar = 0;
+  // Element type of the slot, or the destination type of a cast
+  DataType data_type = DataType::kInvalidDataType;
+  int64_t slot = -1;
+  // Element strides of the slot along each axis of the stage domain, a broadcast axis has stride 0,
+  // empty if the slot is laid out as the domain
+  std::vector<int64_t> strides;
+};
+
+// The accumulator of `acc_slot` is divided by `divisor` and converted into `slot` after the stage
+struct FusedReduction {
+  int64_t acc_slot;
+  int64_t slot;
+  DataType data_type;
+  int64_t elem_cnt;
+  int64_t divisor;
+};
+
+// A loop nest over the elements of `domain`, all the instructions of a stage run on one tile of
+// the domain before moving to the next one so that the intermediate values stay in cache.
+struct FusedStage {
+  DimVector domain;
+  int64_t elem_cnt = 0;
+  int32_t num_registers = 0;
+  std::vector<FusedInstruction> instructions;
+  std::vector<FusedReduction> reductions;
+};
+
+// The lowered form of a cluster, whose slots are the entry parameters, the return parameters and
+// then the temporary buffers. It holds no storage itself and could be shared by threads.
+class FusedProgram {
+ public:
+  FusedProgram(DataType compute_type, int64_t num_entries, int64_t num_returns,
+               std::vector<int64_t> &&temp_byte_sizes, std::vector<FusedStage> &&stages)
+      : compute_type_(compute_type),
+        num_entries_(num_entries),
+        num_returns_(num_returns),
+        temp_byte_sizes_(std::move(temp_byte_sizes)),
+        stages_(std::move(stages)) {}
+  ~FusedProgram() = default;
+
+  DataType compute_type() const { return compute_type_; }
+  int64_t num_entries() const { return num_entries_; }
+  int64_t num_returns() const { return num_returns_; }
+  int64_t num_slots() const { return num_entries_ + num_returns_ + temp_byte_sizes_.size(); }
+  const std::vector<int64_t> &temp_byte_sizes() const { return temp_byte_sizes_; }
+  const std::vector<FusedStage> &stages() const { return stages_; }
+
+  // `slots` holds the data pointers of all the slots
+  void Run(const std::vector<char *> &slots) const;
+
+  std::string ToString() const;
+
+ private:
+  DataType compute_type_;
+  int64_t num_entries_;
+  int64_t num_returns_;
+  std::vector<int64_t> temp_byte_sizes_;
+  std::vector<FusedStage> stages_;
+};
+
+// Records the computation of a cluster as a dag of fused nodes in topological order, then splits
+// it into stages. A node joins the running stage if it loops over the same domain and reads no
+// value of the stage other than the elementwise results of the same shape, otherwise a new stage
+// starts and the values read across stages are kept in temporary buffers.
+class FusedProgramBuilder {
+ public:
+  FusedProgramBuilder() = default;
+  ~FusedProgramBuilder() = default;
+
+  int64_t Parameter(const Shape &shape, const DataType &data_type);
+  int64_t Unary(const FusedOpCode &op_code, int64_t x, double scalar = 0);
+  int64_t Cast(int64_t x, const DataType &data_type);
+  int64_t Binary(const FusedOpCode &op_code, int64_t a, int64_t b);
+  int64_t Reduce(const FusedOpCode &op_code, int64_t x, std::vector<int32_t> axis,
+                 bool keepdims);
+  int64_t View(int64_t x, const Shape &shape);
+
+  const Shape &shape(int64_t value) const { return nodes_.at(value).shape; }
+  const DataType &data_type(int64_t value) const { return nodes_.at(value).data_type; }
+
+  // Outputs are marked in the order of the return parameters
+  void MarkOutput(int64_t value) { outputs_.push_back(value); }
+
+  std::shared_ptr<FusedProgram> Build();
+
+ private:
+  int64_t AddNode(FusedNode &&node);
+
+  std::vector<FusedNode> nodes_;
+  std::vector<int64_t> params_;
+  std::vector<int64_t> outputs_;
+};
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
+
+#endif  // ONEFLOW_XRT_NATIVE_FUSED_PROGRAM_H_
@@ -0,0 +1,215 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <cmath>
+#include "oneflow/xrt/native/fused_program.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+namespace {
+
+// Runs `program` on host buffers the way the native executable does
+class ProgramRunner final {
+ public:
+  explicit ProgramRunner(const std::shared_ptr<FusedProgram> &program) : program_(program) {
+    for (int64_t byte_size : program_->temp_byte_sizes()) { temps_.emplace_back(byte_size); }
+  }
+
+  void Run(const std::vector<void *> &entries, const std::vector<void *> &returns) {
+    ASSERT_EQ(entries.size(), program_->num_entries());
+    ASSERT_EQ(returns.size(), program_->num_returns());
+    std::vector<char *> slots;
+    for (void *entry : entries) { slots.push_back(static_cast<char *>(entry)); }
+    for (void *ret : returns) { slots.push_back(static_cast<char *>(ret)); }
+    for (std::vector<char> &temp : temps_) { slots.push_back(temp.data()); }
+    program_->Run(slots);
+  }
+
+ private:
+  std::shared_ptr<FusedProgram> program_;
+  std::vector<std::vector<char>> temps_;
+};
+
+std::vector<float> Iota(int64_t n, float start, float step) {
+  std::vector<float> values(n);
+  FOR_RANGE(int64_t, i, 0, n) { values.at(i) = start + i * step; }
+  return values;
+}
+
+}  // namespace
+
+TEST(FusedProgram, elementwise_chain) {
+  FusedProgramBuilder builder;
+  const int64_t x = builder.Parameter(Shape({4, 100}), DataType::kFloat);
+  const int64_t y = builder.Parameter(Shape({100}), DataType::kFloat);
+  const int64_t sum = builder.Binary(FusedOpCode::kAdd, x, y);
+  const int64_t scaled = builder.Unary(FusedOpCode::kScalarMul, sum, 0.5);
+  builder.MarkOutput(builder.Unary(FusedOpCode::kRelu, scaled));
+  std::shared_ptr<FusedProgram> program = builder.Build();
+  ASSERT_EQ(program->stages().size(), 1);
+  ASSERT_TRUE(program->temp_byte_sizes().empty());
+
+  const std::vector<float> x_data = Iota(400, -100.f, 0.5f);
+  const std::vector<float> y_data = Iota(100, -10.f, 0.25f);
+  std::vector<float> z_data(400);
+  ProgramRunner runner(program);
+  runner.Run({const_cast<float *>(x_data.data()), const_cast<float *>(y_data.data())},
+             {z_data.data()});
+  FOR_RANGE(int64_t, i, 0, 400) {
+    const float expected = std::max((x_data.at(i) + y_data.at(i % 100)) * 0.5f, 0.f);
+    ASSERT_FLOAT_EQ(z_data.at(i), expected);
+  }
+}
+
+TEST(FusedProgram, reduce_then_broadcast) {
+  // x - mean(x, axis=1, keepdims=True), the mean has to be finished before the subtraction
+  FusedProgramBuilder builder;
+  const int64_t x = builder.Parameter(Shape({3, 50}), DataType::kFloat);
+  const int64_t mean = builder.Reduce(FusedOpCode::kReduceMean, x, {1}, true);
+  ASSERT_TRUE(builder.shape(mean) == Shape({3, 1}));
+  const int64_t neg_mean = builder.Unary(FusedOpCode::kScalarMul, mean, -1);
+  builder.MarkOutput(builder.Binary(FusedOpCode::kAdd, x, neg_mean));
+  builder.MarkOutput(mean);
+  std::shared_ptr<FusedProgram> program = builder.Build();
+  ASSERT_GT(program->stages().size(), 1);
+
+  const std::vector<float> x_data = Iota(150, 1.f, 1.f);
+  std::vector<float> centered(150);
+  std::vector<float> mean_data(3);
+  ProgramRunner runner(program);
+  runner.Run({const_cast<float *>(x_data.data())}, {centered.data(), mean_data.data()});
+  FOR_RANGE(int64_t, row, 0, 3) {
+    const float expected_mean = 50 * row + 25.5f;
+    ASSERT_FLOAT_EQ(mean_data.at(row), expected_mean);
+    FOR_RANGE(int64_t, col, 0, 50) {
+      ASSERT_FLOAT_EQ(centered.at(row * 50 + col), x_data.at(row * 50 + col) - expected_mean);
+    }
+  }
+}
+
+TEST(FusedProgram, reduce_sum_all) {
+  FusedProgramBuilder builder;
+  const int64_t x = builder.Parameter(Shape({2, 3, 4}), DataType::kInt32);
+  const int64_t sum = builder.Reduce(FusedOpCode::kReduceSum, x, {0, 2}, false);
+  ASSERT_TRUE(builder.shape(sum) == Shape({3}));
+  builder.MarkOutput(sum);
+  std::shared_ptr<FusedProgram> program = builder.Build();
+
+  std::vector<int32_t> x_data(24);
+  FOR_RANGE(int32_t, i, 0, 24) { x_data.at(i) = i; }
+  std::vector<int32_t> sum_data(3, -1);
+  ProgramRunner runner(program);
+  runner.Run({x_data.data()}, {sum_data.data()});
+  FOR_RANGE(int32_t, j, 0, 3) {
+    int32_t expected = 0;
+    FOR_RANGE(int32_t, i, 0, 2) {
+      FOR_RANGE(int32_t, k, 0, 4) { expected += x_data.at(i * 12 + j * 4 + k); }
+    }
+    ASSERT_EQ(sum_data.at(j), expected);
+  }
+}
+
+TEST(FusedProgram, mixed_floating_data_types) {
+  FusedProgramBuilder builder;
+  const int64_t x = builder.Parameter(Shape({64}), DataType::kFloat);
+  const int64_t casted = builder.Cast(x, DataType::kDouble);
+  builder.MarkOutput(builder.Unary(FusedOpCode::kSigmoid, casted));
+  std::shared_ptr<FusedProgram> program = builder.Build();
+  ASSERT_EQ(program->compute_type(), DataType::kDouble);
+
+  const std::vector<float> x_data = Iota(64, -8.f, 0.25f);
+  std::vector<double> sigmoid(64);
+  ProgramRunner runner(program);
+  runner.Run({const_cast<float *>(x_data.data())}, {sigmoid.data()});
+  FOR_RANGE(int32_t, i, 0, 64) {
+    ASSERT_NEAR(sigmoid.at(i), 1.0 / (1.0 + std::exp(-static_cast<double>(x_data.at(i)))), 1e-9);
+  }
+}
+
+TEST(FusedProgram, mixed_integral_data_types) {
+  // computed in int64 rather than double, which would round the values above 2^53
+  FusedProgramBuilder builder;
+  const int64_t x = builder.Parameter(Shape({64}), DataType::kInt8);
+  const int64_t y = builder.Parameter(Shape({64}), DataType::kInt64);
+  builder.MarkOutput(builder.Binary(FusedOpCode::kAdd, builder.Cast(x, DataType::kInt64), y));
+  builder.MarkOutput(builder.Unary(FusedOpCode::kScalarDiv, x, 3));
+  std::shared_ptr<FusedProgram> program = builder.Build();
+  ASSERT_EQ(program->compute_type(), DataType::kInt64);
+
+  std::vector<int8_t> x_data(64);
+  std::vector<int64_t> y_data(64);
+  FOR_RANGE(int32_t, i, 0, 64) {
+    x_data.at(i) = i - 32;
+    y_data.at(i) = (int64_t(1) << 60) + i;
+  }
+  std::vector<int64_t> sum(64);
+  std::vector<int8_t> quotient(64);
+  ProgramRunner runner(program);
+  runner.Run({x_data.data(), y_data.data()}, {sum.data(), quotient.data()});
+  FOR_RANGE(int32_t, i, 0, 64) {
+    ASSERT_EQ(sum.at(i), y_data.at(i) + x_data.at(i));
+    ASSERT_EQ(quotient.at(i), x_data.at(i) / 3);
+  }
+}
+
+TEST(FusedProgram, view_and_returned_parameter) {
+  // bias_add on axis 1 of NCHW, the bias is also returned untouched
+  FusedProgramBuilder builder;
+  const int64_t x = builder.Parameter(Shape({2, 3, 2, 2}), DataType::kFloat);
+  const int64_t bias = builder.Parameter(Shape({3}), DataType::kFloat);
+  const int64_t bias_view = builder.View(bias, Shape({1, 3, 1, 1}));
+  builder.MarkOutput(builder.Binary(FusedOpCode::kAdd, x, bias_view));
+  builder.MarkOutput(bias);
+  std::shared_ptr<FusedProgram> program = builder.Build();
+
+  const std::vector<float> x_data = Iota(24, 0.f, 1.f);
+  const std::vector<float> bias_data = {100.f, 200.f, 300.f};
+  std::vector<float> out(24);
+  std::vector<float> bias_out(3);
+  ProgramRunner runner(program);
+  runner.Run({const_cast<float *>(x_data.data()), const_cast<float *>(bias_data.data())},
+             {out.data(), bias_out.data()});
+  FOR_RANGE(int64_t, i, 0, 24) {
+    ASSERT_FLOAT_EQ(out.at(i), x_data.at(i) + bias_data.at((i / 4) % 3));
+  }
+  ASSERT_TRUE(bias_out == bias_data);
+}
+
+TEST(FusedProgram, elementwise_multi_thread) {
+  Global<ThreadPool>::New(4);
+  FusedProgramBuilder builder;
+  const int64_t x = builder.Parameter(Shape({1000, 300}), DataType::kFloat);
+  const int64_t y = builder.Parameter(Shape({1000, 1}), DataType::kFloat);
+  builder.MarkOutput(builder.Binary(FusedOpCode::kMul, x, y));
+  std::shared_ptr<FusedProgram> program = builder.Build();
+
+  const std::vector<float> x_data = Iota(300000, 0.f, 0.001f);
+  const std::vector<float> y_data = Iota(1000, 1.f, 1.f);
+  std::vector<float> z_data(300000);
+  ProgramRunner runner(program);
+  runner.Run({const_cast<float *>(x_data.data()), const_cast<float *>(y_data.data())},
+             {z_data.data()});
+  FOR_RANGE(int64_t, i, 0, 300000) {
+    ASSERT_FLOAT_EQ(z_data.at(i), x_data.at(i) * y_data.at(i / 300));
+  }
+  Global<ThreadPool>::Delete();
+}
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
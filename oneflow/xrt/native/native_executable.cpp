@@ -0,0 +1,64 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/native_executable.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+namespace {
+
+constexpr int64_t kTempBufferAlignSize = 64;
+
+}  // namespace
+
+NativeExecutable::NativeExecutable(const std::string &name,
+                                   const std::shared_ptr<FusedProgram> &program)
+    : Executable(name, XrtEngine::NATIVE), program_(program) {
+  slots_.resize(program_->num_slots(), nullptr);
+  std::vector<int64_t> offsets;
+  int64_t workspace_size = 0;
+  for (int64_t byte_size : program_->temp_byte_sizes()) {
+    offsets.push_back(workspace_size);
+    workspace_size += RoundUp(byte_size, kTempBufferAlignSize);
+  }
+  workspace_.resize(workspace_size + kTempBufferAlignSize);
+  const uintptr_t address = reinterpret_cast<uintptr_t>(workspace_.data());
+  char *base = workspace_.data() + (RoundUp(address, kTempBufferAlignSize) - address);
+  const int64_t first_temp_slot = program_->num_entries() + program_->num_returns();
+  FOR_RANGE(int64_t, i, 0, offsets.size()) {
+    slots_.at(first_temp_slot + i) = base + offsets.at(i);
+  }
+}
+
+bool NativeExecutable::Run(const std::vector<Parameter> &inputs,
+                           const ExecutableRunOptions &run_options, bool block_until_done) {
+  const std::vector<Parameter> &return_params = run_options.return_params;
+  CHECK_EQ(inputs.size(), program_->num_entries());
+  CHECK_EQ(return_params.size(), program_->num_returns());
+  FOR_RANGE(int64_t, i, 0, inputs.size()) { slots_.at(i) = inputs[i].data<char>(); }
+  FOR_RANGE(int64_t, i, 0, return_params.size()) {
+    slots_.at(program_->num_entries() + i) = return_params[i].data<char>();
+  }
+  // Runs synchronously on the calling thread, so `block_until_done` takes no effect
+  program_->Run(slots_);
+  this->results_ = return_params;
+  return true;
+}
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
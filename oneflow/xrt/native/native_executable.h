@@ -0,0 +1,52 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_XRT_NATIVE_NATIVE_EXECUTABLE_H_
+#define ONEFLOW_XRT_NATIVE_NATIVE_EXECUTABLE_H_
+
+#include <memory>
+#include <vector>
+
+#include "oneflow/xrt/executable.h"
+#include "oneflow/xrt/native/fused_program.h"
+#include "oneflow/xrt/parameter.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+// Runs the fused program of a cluster on the host. The temporary buffers are owned by the
+// executable, so it should not be run by multiple threads at the same time.
+class NativeExecutable : public Executable {
+ public:
+  NativeExecutable(const std::string &name, const std::shared_ptr<FusedProgram> &program);
+  virtual ~NativeExecutable() = default;
+
+  bool Run(const std::vector<Parameter> &inputs, const ExecutableRunOptions &run_options,
+           bool block_until_done = true) override;
+
+  const FusedProgram &program() const { return *program_; }
+
+ private:
+  std::shared_ptr<FusedProgram> program_;
+  std::vector<char> workspace_;
+  std::vector<char *> slots_;
+};
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
+
+#endif  // ONEFLOW_XRT_NATIVE_NATIVE_EXECUTABLE_H_
@@ -0,0 +1,60 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_XRT_NATIVE_NATIVE_GRAPH_COMPILER_H_
+#define ONEFLOW_XRT_NATIVE_NATIVE_GRAPH_COMPILER_H_
+
+#include "oneflow/xrt/graph_compiler.h"
+#include "oneflow/xrt/native/fused_program.h"
+#include "oneflow/xrt/native/native_executable.h"
+#include "oneflow/xrt/native/ops/op_context.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+// Lowers a cluster of elementwise, broadcast and reduce ops into a fused program, which runs the
+// whole cluster in a few passes over memory instead of one pass per op.
+class NativeGraphCompiler : public GraphCompiler::Impl {
+ public:
+  explicit NativeGraphCompiler(const std::string &name) : GraphCompiler::Impl(name) {
+    builder_ = std::make_shared<FusedProgramBuilder>();
+  }
+
+  virtual ~NativeGraphCompiler() = default;
+
+  std::shared_ptr<Executable> Compile(const XrtGraph *graph,
+                                      const std::vector<Parameter> &entry_params,
+                                      const std::vector<Parameter> &return_params,
+                                      const std::vector<InputOutputAlias> &aliases) override;
+
+ private:
+  void SetupKernelContextParam(const XrtNode *node, NativeOpContext::Param *context_param);
+
+  void PopulateEntryParams(const std::vector<Parameter> &entry_params);
+
+  Argument ArgFromParameter(const Parameter &param);
+
+ private:
+  std::shared_ptr<FusedProgramBuilder> builder_;
+
+  util::Map<Argument, int64_t> operands_;
+};
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
+
+#endif  // ONEFLOW_XRT_NATIVE_NATIVE_GRAPH_COMPILER_H_
@@ -0,0 +1,59 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_XRT_NATIVE_OPS_OP_KERNEL_H_
+#define ONEFLOW_XRT_NATIVE_OPS_OP_KERNEL_H_
+
+#include "oneflow/xrt/kernel/op_kernel.h"
+#include "oneflow/xrt/native/ops/op_context.h"
+#include "oneflow/xrt/types.h"
+#include "oneflow/xrt/utility/registry.h"
+#include "oneflow/xrt/utility/stl.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+class NativeOpKernel : public OpKernel<NativeOpContext> {
+ public:
+  virtual void Compile(NativeOpContext *ctx) = 0;
+
+  NativeOpKernel() = default;
+  virtual ~NativeOpKernel() = default;
+};
+
+using NativeOpKernelPtr = std::shared_ptr<OpKernel<NativeOpContext>>;
+
+// The native engine only runs on the host. Its kernels are pure functions of the inputs, so
+// they are enabled in the train phase as well.
+#define REGISTER_NATIVE_OP_KERNEL(OpName, KernelType)                     \
+  static OpKernelRegistrar<NativeOpContext> _native_op_kernel_##OpName##_ \
+      __attribute__((unused)) =                                           \
+          OpKernelRegistrar<NativeOpContext>(#OpName)                     \
+              .SetField(XrtEngine::NATIVE)                                \
+              .SetDevice({XrtDevice::CPU_X86})                            \
+              .EnableTrainPhase()                                         \
+              .SetFactory([]() -> OpKernel<NativeOpContext> * { return new KernelType; })
+
+inline NativeOpKernelPtr BuildOpKernel(const std::string &op_name) {
+  auto field = MakeXrtField(XrtDevice::CPU_X86, XrtEngine::NATIVE);
+  return NativeOpKernelPtr(OpKernelBuilder<NativeOpContext>()(field, op_name));
+}
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
+
+#endif  // ONEFLOW_XRT_NATIVE_OPS_OP_KERNEL_H_
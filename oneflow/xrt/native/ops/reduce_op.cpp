@@ -0,0 +1,38 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/ops/op_context.h"
+#include "oneflow/xrt/native/ops/op_kernel.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+template<FusedOpCode op_code>
+class ReduceOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    std::vector<int32_t> axis = ctx->Attr<std::vector<int32_t>>("axis");
+    bool keep_dims = ctx->Attr<bool>("keepdims");
+    ctx->SetSoleOutput(ctx->builder()->Reduce(op_code, ctx->SoleInput(), axis, keep_dims));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(ReduceSum, ReduceOp<FusedOpCode::kReduceSum>).Finalize();
+REGISTER_NATIVE_OP_KERNEL(ReduceMean, ReduceOp<FusedOpCode::kReduceMean>).Finalize();
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
@@ -0,0 +1,45 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/ops/op_context.h"
+#include "oneflow/xrt/native/ops/op_kernel.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+template<FusedOpCode op_code>
+class ScalarBinaryOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    ctx->SetSoleOutput(ctx->builder()->Unary(op_code, ctx->SoleInput(), Scalar(ctx)));
+  }
+
+  double Scalar(NativeOpContext *ctx) const {
+    if (ctx->Attr<bool>("has_int_operand")) {
+      return static_cast<double>(ctx->Attr<int64_t>("int_operand"));
+    }
+    CHECK(ctx->Attr<bool>("has_float_operand"));
+    return ctx->Attr<double>("float_operand");
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(ScalarAdd, ScalarBinaryOp<FusedOpCode::kScalarAdd>).Finalize();
+REGISTER_NATIVE_OP_KERNEL(ScalarMul, ScalarBinaryOp<FusedOpCode::kScalarMul>).Finalize();
+REGISTER_NATIVE_OP_KERNEL(ScalarDiv, ScalarBinaryOp<FusedOpCode::kScalarDiv>).Finalize();
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
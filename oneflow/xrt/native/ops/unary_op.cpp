@@ -0,0 +1,50 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/xrt/native/ops/op_context.h"
+#include "oneflow/xrt/native/ops/op_kernel.h"
+
+namespace oneflow {
+namespace xrt {
+namespace native {
+
+template<FusedOpCode op_code>
+class ApplyUnaryOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    ctx->SetSoleOutput(ctx->builder()->Unary(op_code, ctx->SoleInput()));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(Relu, ApplyUnaryOp<FusedOpCode::kRelu>).Finalize();
+REGISTER_NATIVE_OP_KERNEL(Sigmoid, ApplyUnaryOp<FusedOpCode::kSigmoid>).Finalize();
+REGISTER_NATIVE_OP_KERNEL(Tanh, ApplyUnaryOp<FusedOpCode::kTanh>).Finalize();
+REGISTER_NATIVE_OP_KERNEL(Gelu, ApplyUnaryOp<FusedOpCode::kGelu>).Finalize();
+REGISTER_NATIVE_OP_KERNEL(Rsqrt, ApplyUnaryOp<FusedOpCode::kRsqrt>).Finalize();
+REGISTER_NATIVE_OP_KERNEL(Identity, ApplyUnaryOp<FusedOpCode::kIdentity>).Finalize();
+
+class LeakyReluOp : public NativeOpKernel {
+ public:
+  void Compile(NativeOpContext *ctx) override {
+    const float alpha = ctx->Attr<float>("alpha");
+    ctx->SetSoleOutput(ctx->builder()->Unary(FusedOpCode::kLeakyRelu, ctx->SoleInput(), alpha));
+  }
+};
+
+REGISTER_NATIVE_OP_KERNEL(LeakyRelu, LeakyReluOp).Finalize();
+
+}  // namespace native
+}  // namespace xrt
+}  // namespace oneflow
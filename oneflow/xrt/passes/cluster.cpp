@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/xrt/passes/cluster.h"
+#include "oneflow/core/common/data_type.h"
 
 namespace oneflow {
 namespace xrt {
@@ -202,5 +203,25 @@ bool IsSatisfyTimeShape(const ClusterEdge *edge) {
   return edge->is_control_edge() || (edge->start_time_shape() == edge->end_time_shape());
 }
 
+bool IsSatisfyDataTypes(const XrtEngine &engine, const std::vector<const ClusterNode *> &nodes) {
+  if (engine != XrtEngine::NATIVE) { return true; }
+  bool has_integral = false;
+  bool has_floating = false;
+  for (const ClusterNode *node : nodes) {
+    for (const ClusterNode *folded_node : node->folded_nodes()) {
+      const XrtNode *xrt_node = folded_node->xrt_node();
+      if (!xrt_node->HasAttr("data_types")) { continue; }
+      for (const DataType &data_type : xrt_node->Attr<std::vector<DataType>>("data_types")) {
+        if (IsFloatingDataType(data_type)) {
+          has_floating = true;
+        } else {
+          has_integral = true;
+        }
+      }
+    }
+  }
+  return !(has_integral && has_floating);
+}
+
 }  // namespace xrt
 }  // namespace oneflow
@@ -155,6 +155,9 @@ bool IsNodeDirectChildren(const ClusterNode *parent, const ClusterNode *children
 bool IsSatisfyBackend(const ClusterEdge *edge);
 bool IsSatisfySbpPolicy(const ClusterEdge *edge);
 bool IsSatisfyTimeShape(const ClusterEdge *edge);
+// The native engine computes a cluster in one data type, so it takes no cluster which mixes
+// integral and floating point data types. Any nodes satisfy the other engines.
+bool IsSatisfyDataTypes(const XrtEngine &engine, const std::vector<const ClusterNode *> &nodes);
 
 }  // namespace xrt
 }  // namespace oneflow
@@ -96,7 +96,8 @@ void MarkClusterIdPass::ClusteringSubgraphs(const ClusteringOptions &options,
     std::vector<ClusterNode *> ordered_nodes;
     algorithm::TopologyVisit(*this, [&](ClusterNode *node) {
       if (!node->IsCompiled(engine, options.train_phase)
-          || node->IsOptimizer(engine) /* skip model update op */) {
+          || node->IsOptimizer(engine) /* skip model update op */
+          || !IsSatisfyDataTypes(engine, {node})) {
         return;
       }
       ordered_nodes.push_back(node);
@@ -110,6 +111,7 @@ void MarkClusterIdPass::ClusteringSubgraphs(const ClusteringOptions &options,
       for (ClusterNode *parent : candidate_parents) {
         if (parent->IsCompiled(engine, options.train_phase)
             && (parent->size() + node->size()) <= options.maximum_nodes
+            && IsSatisfyDataTypes(engine, {node, parent})
             && TryToFuseWithParent(node, parent, options)) {
           has_changed = true;
           root_nodes_.erase(node);
@@ -173,7 +175,7 @@ void MarkClusterIdPass::FinalizeClusterEngine(const ClusteringOptions &options,
   const int max_nodes = options.maximum_nodes;
   for (ClusterNode *node : root_nodes_) {
     if (node->IsCompiled(engine, options.train_phase) && node->size() >= min_nodes
-        && node->size() <= max_nodes) {
+        && node->size() <= max_nodes && IsSatisfyDataTypes(engine, {node})) {
       node->set_engine(engine);
     }
   }
@@ -203,6 +205,8 @@ void MarkClusterIdPass::Run(XrtGraph *graph, const XrtPassOptions &options) {
     ClusteringSubgraphs(clustering_options, XrtEngine::TENSORRT);
     ClusteringSubgraphs(clustering_options, XrtEngine::XLA);
   }
+  // The native engine only takes the nodes left by the third party engines.
+  ClusteringSubgraphs(clustering_options, XrtEngine::NATIVE);
 
   RemoveInvalidClusterNodes(clustering_options);
   RerankClusterIds();
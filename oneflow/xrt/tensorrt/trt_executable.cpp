@@ -153,6 +153,7 @@ bool TrtExecutable::Run(const std::vector<Parameter> &inputs,
   }
 
   if (run_options.tensorrt_int8 && !calibrator_) {
+    is_engine_serializable_ = false;
     auto *res = TRTInt8CalibratorResource::LookupOrCreate(this->name());
     {
       std::lock_guard<std::mutex> lock(res->mutex_);
@@ -186,6 +187,28 @@ bool TrtExecutable::Run(const std::vector<Parameter> &inputs,
                        block_until_done);
 }
 
+bool TrtExecutable::SerializeTo(std::string *serialized) const {
+  if (!engine_ || !is_engine_serializable_) { return false; }
+  nv::unique_ptr<nvinfer1::IHostMemory> engine_memory(engine_->serialize());
+  if (!engine_memory) { return false; }
+  *serialized = SerializedEngineHeader(platform::GetDeviceId(XrtDevice::GPU_CUDA));
+  serialized->append(static_cast<const char *>(engine_memory->data()), engine_memory->size());
+  return true;
+}
+
+std::vector<std::string> TrtExecutable::WeightNames() const {
+  std::vector<std::string> names;
+  for (const auto &pair : host_weights_) { names.push_back(pair.first); }
+  return names;
+}
+
+std::string SerializedEngineHeader(int device_ordinal) {
+  cudaDeviceProp prop;
+  CHECK_EQ(cudaSuccess, cudaGetDeviceProperties(&prop, device_ordinal));
+  return absl::StrCat("TensorRT ", NV_TENSORRT_MAJOR, ".", NV_TENSORRT_MINOR, ".",
+                      NV_TENSORRT_PATCH, " ", prop.name, " sm_", prop.major, prop.minor, "\n");
+}
+
 }  // namespace tensorrt
 
 }  // namespace xrt
@@ -53,6 +53,10 @@ class TrtExecutable : public Executable {
   bool Run(const std::vector<Parameter> &inputs, const ExecutableRunOptions &run_options,
            bool block_until_done = true) override;
 
+  bool SupportsSerialization() const override { return true; }
+  bool SerializeTo(std::string *serialized) const override;
+  std::vector<std::string> WeightNames() const override;
+
  private:
   nvinfer1::ICudaEngine *CreateExecutableEngine(const ExecutableRunOptions &run_options,
                                                 const int batch_size = 1,
@@ -71,8 +75,14 @@ class TrtExecutable : public Executable {
   std::shared_ptr<TRTInt8Calibrator> calibrator_;
 
   util::Map<std::string, std::shared_ptr<std::vector<uint8_t>>> host_weights_;
+
+  // False while the engine is only a stand-in for the one being calibrated
+  bool is_engine_serializable_ = true;
 };
 
+// A serialized engine only runs with the TensorRT version and on the gpu model that built it
+std::string SerializedEngineHeader(int device_ordinal);
+
 }  // namespace tensorrt
 
 }  // namespace xrt
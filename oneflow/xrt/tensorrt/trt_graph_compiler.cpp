@@ -16,6 +16,9 @@ limitations under the License.
 #include "oneflow/xrt/tensorrt/trt_graph_compiler.h"
 #include "oneflow/xrt/node_util.h"
 #include "oneflow/xrt/tensorrt/ops/op_kernel.h"
+#include "oneflow/xrt/tensorrt/trt_logger.h"
+
+#include <mutex>
 
 namespace oneflow {
 namespace xrt {
@@ -101,6 +104,24 @@ std::shared_ptr<Executable> TrtGraphCompiler::Compile(
                                          builder_->ReleaseNetwork(), builder_->host_weights());
 }
 
+std::shared_ptr<Executable> TrtGraphCompiler::Deserialize(const std::string &serialized) {
+  const std::string header = SerializedEngineHeader(device_ordinal_);
+  if (serialized.compare(0, header.size(), header) != 0) { return nullptr; }
+  // The runtime should outlive all the engines it deserialized
+  static nv::Logger logger;
+  static nv::unique_ptr<nvinfer1::IRuntime> runtime(nvinfer1::createInferRuntime(logger));
+  static std::mutex runtime_mutex;
+  nv::unique_ptr<nvinfer1::ICudaEngine> engine;
+  {
+    std::lock_guard<std::mutex> lock(runtime_mutex);
+    engine.reset(runtime->deserializeCudaEngine(serialized.data() + header.size(),
+                                                serialized.size() - header.size(), nullptr));
+  }
+  if (!engine) { return nullptr; }
+  return std::make_shared<TrtExecutable>(
+      name_, std::move(engine), util::Map<std::string, std::shared_ptr<std::vector<uint8_t>>>());
+}
+
 REGISTER_GRAPH_COMPILER(XrtEngine::TENSORRT, TrtGraphCompiler);
 
 }  // namespace tensorrt